@@ -75,7 +75,7 @@ endif ()
 
 find_package_handle_standard_args(ZSTD REQUIRED_VARS ZSTD_LIB ZSTD_INCLUDE_DIR)
 
-if (ZSTD_FOUND)
+if (ZSTD_FOUND AND NOT TARGET ZSTD::zstd)
   add_library(ZSTD::zstd UNKNOWN IMPORTED)
   set_target_properties(
     ZSTD::zstd PROPERTIES IMPORTED_LOCATION "${ZSTD_LIB}"
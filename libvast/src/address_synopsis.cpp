@@ -0,0 +1,52 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/address_synopsis.hpp"
+
+#include "vast/config.hpp"
+#include "vast/detail/narrow.hpp"
+
+#if VAST_HAVE_ARROW
+#  include "vast/arrow_table_slice.hpp"
+
+#  include <arrow/api.h>
+#endif
+
+namespace vast::detail {
+
+bool decode_arrow_addresses(const table_slice_column& x,
+                            std::vector<address>& xs) {
+  VAST_ASSERT(x.slice != nullptr);
+#if VAST_HAVE_ARROW
+  if (x.slice->implementation_id() != arrow_table_slice::class_id)
+    return false;
+  auto& slice = static_cast<const arrow_table_slice&>(*x.slice);
+  auto arr = slice.batch()->column(detail::narrow_cast<int>(x.column));
+  if (arr->type_id() != arrow::Type::FIXED_SIZE_BINARY)
+    return false;
+  auto& addrs = static_cast<const arrow::FixedSizeBinaryArray&>(*arr);
+  if (addrs.byte_width() != 16)
+    return false;
+  xs.reserve(xs.size() + addrs.length() - addrs.null_count());
+  for (int64_t row = 0; row < addrs.length(); ++row)
+    if (!addrs.IsNull(row))
+      xs.push_back(address::v6(static_cast<const void*>(addrs.GetValue(row)),
+                               address::network));
+  return true;
+#else
+  static_cast<void>(xs);
+  return false;
+#endif // VAST_HAVE_ARROW
+}
+
+} // namespace vast::detail
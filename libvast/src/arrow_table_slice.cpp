@@ -14,9 +14,11 @@
 #include "vast/arrow_table_slice.hpp"
 
 #include "vast/arrow_table_slice_builder.hpp"
+#include "vast/column_statistics.hpp"
 #include "vast/detail/narrow.hpp"
 #include "vast/detail/overload.hpp"
 #include "vast/error.hpp"
+#include "vast/ids.hpp"
 #include "vast/logger.hpp"
 #include "vast/value_index.hpp"
 
@@ -574,10 +576,12 @@ data_view value_at(const type& t, const Array& arr, size_t row) {
 
 // -- access to entire column --------------------------------------------------
 
-class index_applier {
+/// Applies a function to all non-null values of an Arrow array. The function
+/// receives the value and its row in the array.
+template <class F>
+class column_applier {
 public:
-  index_applier(size_t offset, value_index& idx)
-    : offset_(detail::narrow_cast<int64_t>(offset)), idx_(idx) {
+  explicit column_applier(F f) : f_(std::move(f)) {
     // nop
   }
 
@@ -585,7 +589,7 @@ public:
   void apply(const Array& arr, Getter f) {
     for (int64_t row = 0; row < arr.length(); ++row)
       if (!arr.IsNull(row))
-        idx_.append(f(arr, row), detail::narrow_cast<size_t>(offset_ + row));
+        f_(f(arr, row), row);
   }
 
   void operator()(const arrow::BooleanArray& arr, const bool_type&) {
@@ -663,8 +667,157 @@ public:
   }
 
 private:
-  int64_t offset_;
-  value_index& idx_;
+  F f_;
+};
+
+// -- evaluation of predicates over entire columns -----------------------------
+
+/// Evaluates a predicate over an entire Arrow array without materializing a
+/// `data_view` per row. Only handles combinations of array type, operator, and
+/// right-hand side that map to a plain comparison of the underlying values;
+/// for all others `handled()` remains `false` and the caller has to fall back
+/// to the generic implementation.
+class column_evaluator {
+public:
+  column_evaluator(size_t offset, relational_operator op, const data& rhs)
+    : op_(op), rhs_(rhs) {
+    result_.append_bits(false, offset);
+    // Null values compare the same way regardless of the row.
+    null_bit_ = evaluate_view(data_view{}, op, make_data_view(rhs));
+  }
+
+  bool handled() const {
+    return handled_;
+  }
+
+  ids& result() {
+    return result_;
+  }
+
+  void operator()(const arrow::BooleanArray& arr, const bool_type&) {
+    if (auto x = caf::get_if<bool>(&rhs_))
+      compare(arr, boolean_at, *x);
+  }
+
+  template <class T>
+  void operator()(const arrow::NumericArray<T>& arr, const real_type&) {
+    if (auto x = caf::get_if<real>(&rhs_))
+      compare(arr, real_at, *x);
+  }
+
+  template <class T>
+  void operator()(const arrow::NumericArray<T>& arr, const integer_type&) {
+    if (auto x = caf::get_if<integer>(&rhs_))
+      compare(arr, integer_at, *x);
+  }
+
+  template <class T>
+  void operator()(const arrow::NumericArray<T>& arr, const count_type&) {
+    if (auto x = caf::get_if<count>(&rhs_))
+      compare(arr, count_at, *x);
+  }
+
+  template <class T>
+  void operator()(const arrow::NumericArray<T>& arr, const duration_type&) {
+    if (auto x = caf::get_if<duration>(&rhs_))
+      compare(arr, duration_at, *x);
+  }
+
+  void operator()(const arrow::TimestampArray& arr, const time_type&) {
+    if (auto x = caf::get_if<time>(&rhs_))
+      compare(arr, timestamp_at, *x);
+  }
+
+  void operator()(const arrow::FixedSizeBinaryArray& arr, const address_type&) {
+    if (auto x = caf::get_if<address>(&rhs_)) {
+      if (op_ == equal || op_ == not_equal)
+        compare(arr, address_at, *x);
+    } else if (auto x = caf::get_if<subnet>(&rhs_)) {
+      if (op_ == in)
+        apply(arr, address_at, [&](const auto& y) { return x->contains(y); });
+      else if (op_ == not_in)
+        apply(arr, address_at, [&](const auto& y) { return !x->contains(y); });
+    }
+  }
+
+  void operator()(const arrow::StringArray& arr, const string_type&) {
+    auto x = caf::get_if<std::string>(&rhs_);
+    if (!x)
+      return;
+    auto contains = [](std::string_view haystack, std::string_view needle) {
+      return haystack.find(needle) != std::string_view::npos;
+    };
+    std::string_view rhs = *x;
+    switch (op_) {
+      default:
+        return compare(arr, string_at, rhs);
+      case in:
+        return apply(arr, string_at,
+                     [&](std::string_view y) { return contains(rhs, y); });
+      case not_in:
+        return apply(arr, string_at,
+                     [&](std::string_view y) { return !contains(rhs, y); });
+      case ni:
+        return apply(arr, string_at,
+                     [&](std::string_view y) { return contains(y, rhs); });
+      case not_ni:
+        return apply(arr, string_at,
+                     [&](std::string_view y) { return !contains(y, rhs); });
+    }
+  }
+
+  template <class Array, class T>
+  void operator()(const Array&, const T&) {
+    // Not handled; the caller falls back to the generic implementation.
+  }
+
+private:
+  template <class Array, class Getter, class T>
+  void compare(const Array& arr, Getter get, const T& rhs) {
+    switch (op_) {
+      default:
+        return;
+      case equal:
+        return apply(arr, get, [&](const auto& x) { return x == rhs; });
+      case not_equal:
+        return apply(arr, get, [&](const auto& x) { return x != rhs; });
+      case less:
+        return apply(arr, get, [&](const auto& x) { return x < rhs; });
+      case less_equal:
+        return apply(arr, get, [&](const auto& x) { return x <= rhs; });
+      case greater:
+        return apply(arr, get, [&](const auto& x) { return x > rhs; });
+      case greater_equal:
+        return apply(arr, get, [&](const auto& x) { return x >= rhs; });
+    }
+  }
+
+  /// Evaluates `pred` for all rows and appends the results to the bitmap in
+  /// blocks of 64 bits.
+  template <class Array, class Getter, class Predicate>
+  void apply(const Array& arr, Getter get, Predicate pred) {
+    using block_type = ids::block_type;
+    constexpr int64_t block_size = word<block_type>::width;
+    auto rows = arr.length();
+    auto has_nulls = arr.null_count() > 0;
+    for (int64_t first = 0; first < rows; first += block_size) {
+      auto last = std::min(first + block_size, rows);
+      block_type block = 0;
+      for (auto row = first; row < last; ++row) {
+        auto bit = has_nulls && arr.IsNull(row) ? null_bit_
+                                                 : pred(get(arr, row));
+        block |= static_cast<block_type>(bit) << (row - first);
+      }
+      result_.append_block(block, detail::narrow_cast<size_t>(last - first));
+    }
+    handled_ = true;
+  }
+
+  relational_operator op_;
+  const data& rhs_;
+  bool null_bit_;
+  bool handled_ = false;
+  ids result_;
 };
 
 } // namespace
@@ -678,11 +831,39 @@ data_view arrow_table_slice::at(size_type row, size_type col) const {
   return value_at(layout().fields[col].type, *arr, row);
 }
 
-void arrow_table_slice::append_column_to_index(size_type col,
-                                               value_index& idx) const {
-  index_applier f{offset(), idx};
+void arrow_table_slice::append_column_to_index(size_type col, value_index& idx,
+                                               column_statistics* stats) const {
+  auto append = [&, first = offset()](data_view x, int64_t row) {
+    idx.append(x, first + detail::narrow_cast<size_t>(row));
+    if (stats != nullptr)
+      stats->add(x);
+  };
+  column_applier f{append};
+  auto arr = batch_->column(detail::narrow_cast<int>(col));
+  decode(layout().fields[col].type, *arr, f);
+  // The applier skips null values.
+  if (stats != nullptr)
+    for (int64_t i = 0; i < arr->null_count(); ++i)
+      stats->add(caf::none);
+}
+
+void arrow_table_slice::for_each_in_column(
+  size_type col, const std::function<void(data_view)>& f) const {
+  VAST_ASSERT(col < columns());
+  column_applier g{[&](data_view x, int64_t) { f(std::move(x)); }};
+  auto arr = batch_->column(detail::narrow_cast<int>(col));
+  decode(layout().fields[col].type, *arr, g);
+}
+
+ids arrow_table_slice::evaluate_column(size_type col, relational_operator op,
+                                       const data& rhs) const {
+  VAST_ASSERT(col < columns());
+  column_evaluator f{offset(), op, rhs};
   auto arr = batch_->column(detail::narrow_cast<int>(col));
   decode(layout().fields[col].type, *arr, f);
+  if (f.handled())
+    return std::move(f.result());
+  return super::evaluate_column(col, op, rhs);
 }
 
 } // namespace vast
@@ -58,6 +58,48 @@ bool operator==(const bitmap& x, const bitmap& y) {
   return x.bitmap_ == y.bitmap_;
 }
 
+namespace {
+
+// The EWAH and Roaring bitmaps provide specialized binary operations when
+// both operands have the same type.
+template <bool FillLHS, bool FillRHS, class Specialized, class Operation>
+bitmap binary_dispatch(const bitmap& lhs, const bitmap& rhs,
+                       Specialized specialized, Operation op) {
+  if (auto l = caf::get_if<ewah_bitmap>(&lhs))
+    if (auto r = caf::get_if<ewah_bitmap>(&rhs))
+      return specialized(*l, *r);
+  if (auto l = caf::get_if<roaring_bitmap>(&lhs))
+    if (auto r = caf::get_if<roaring_bitmap>(&rhs))
+      return specialized(*l, *r);
+  return binary_eval<FillLHS, FillRHS>(lhs, rhs, op);
+}
+
+} // namespace
+
+bitmap binary_and(const bitmap& lhs, const bitmap& rhs) {
+  auto f = [](auto& x, auto& y) { return binary_and(x, y); };
+  auto op = [](auto x, auto y) { return x & y; };
+  return binary_dispatch<false, false>(lhs, rhs, f, op);
+}
+
+bitmap binary_or(const bitmap& lhs, const bitmap& rhs) {
+  auto f = [](auto& x, auto& y) { return binary_or(x, y); };
+  auto op = [](auto x, auto y) { return x | y; };
+  return binary_dispatch<true, true>(lhs, rhs, f, op);
+}
+
+bitmap binary_xor(const bitmap& lhs, const bitmap& rhs) {
+  auto f = [](auto& x, auto& y) { return binary_xor(x, y); };
+  auto op = [](auto x, auto y) { return x ^ y; };
+  return binary_dispatch<true, true>(lhs, rhs, f, op);
+}
+
+bitmap binary_nand(const bitmap& lhs, const bitmap& rhs) {
+  auto f = [](auto& x, auto& y) { return binary_nand(x, y); };
+  auto op = [](auto x, auto y) { return x & ~y; };
+  return binary_dispatch<true, false>(lhs, rhs, f, op);
+}
+
 bitmap_bit_range::bitmap_bit_range(const bitmap& bm) {
   auto visitor = [&](auto& b) {
     auto r = bit_range(b);
@@ -16,7 +16,16 @@
 #include <caf/deserializer.hpp>
 #include <caf/serializer.hpp>
 
+#include "vast/config.hpp"
 #include "vast/detail/assert.hpp"
+#include "vast/detail/narrow.hpp"
+#include "vast/table_slice_column.hpp"
+
+#if VAST_HAVE_ARROW
+#  include "vast/arrow_table_slice.hpp"
+
+#  include <arrow/api.h>
+#endif
 
 namespace vast {
 
@@ -32,6 +41,30 @@ void bool_synopsis::add(data_view x) {
     false_ = true;
 }
 
+void bool_synopsis::add(const table_slice_column& x) {
+  VAST_ASSERT(x.slice != nullptr);
+#if VAST_HAVE_ARROW
+  // Scan the bits of the Arrow array directly and stop as soon as we have seen
+  // both values.
+  if (x.slice->implementation_id() == arrow_table_slice::class_id) {
+    auto& slice = static_cast<const arrow_table_slice&>(*x.slice);
+    auto arr = slice.batch()->column(detail::narrow_cast<int>(x.column));
+    if (arr->type_id() == arrow::Type::BOOL) {
+      auto& bools = static_cast<const arrow::BooleanArray&>(*arr);
+      for (int64_t row = 0; row < bools.length() && !(true_ && false_); ++row)
+        if (!bools.IsNull(row))
+          (bools.Value(row) ? true_ : false_) = true;
+      return;
+    }
+  }
+#endif // VAST_HAVE_ARROW
+  if (true_ && false_)
+    return;
+  x.slice->for_each_in_column(x.column, [this](data_view y) {
+    (caf::get<view<bool>>(y) ? true_ : false_) = true;
+  });
+}
+
 caf::optional<bool> bool_synopsis::lookup(relational_operator op,
                                           data_view rhs) const {
   if (auto b = caf::get_if<view<bool>>(&rhs)) {
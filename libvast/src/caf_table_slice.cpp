@@ -14,6 +14,7 @@
 #include "vast/caf_table_slice.hpp"
 
 #include "vast/caf_table_slice_builder.hpp"
+#include "vast/column_statistics.hpp"
 #include "vast/value_index.hpp"
 
 #include <caf/deserializer.hpp>
@@ -33,10 +34,14 @@ caf::error caf_table_slice::deserialize(caf::deserializer& source) {
   return source(xs_);
 }
 
-void caf_table_slice::append_column_to_index(size_type col,
-                                             value_index& idx) const {
-  for (size_type row = 0; row < rows(); ++row)
-    idx.append(make_view(caf::get<vector>(xs_[row])[col]), offset() + row);
+void caf_table_slice::append_column_to_index(size_type col, value_index& idx,
+                                             column_statistics* stats) const {
+  for (size_type row = 0; row < rows(); ++row) {
+    auto x = make_view(caf::get<vector>(xs_[row])[col]);
+    idx.append(x, offset() + row);
+    if (stats != nullptr)
+      stats->add(x);
+  }
 }
 
 data_view caf_table_slice::at(size_type row, size_type col) const {
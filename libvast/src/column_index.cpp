@@ -13,7 +13,11 @@
 
 #include "vast/column_index.hpp"
 
+#include "vast/chunk.hpp"
 #include "vast/expression_visitors.hpp"
+#include "vast/fbs/utils.hpp"
+#include "vast/fbs/value_index.hpp"
+#include "vast/filesystem.hpp"
 #include "vast/load.hpp"
 #include "vast/logger.hpp"
 #include "vast/save.hpp"
@@ -21,6 +25,8 @@
 #include "vast/table_slice_column.hpp"
 #include "vast/value_index_factory.hpp"
 
+#include <cstdio>
+
 namespace vast {
 
 // -- free functions -----------------------------------------------------------
@@ -55,8 +61,30 @@ column_index::~column_index() {
 
 caf::error column_index::init() {
   VAST_TRACE("");
+  if (auto fname = statistics_filename(); exists(fname))
+    if (auto err = load(nullptr, fname, stats_))
+      VAST_WARNING(this, "failed to load column statistics",
+                   sys_.render(err));
   // Materialize the index when encountering persistent state.
   if (exists(filename_)) {
+    // Indexes in the flatbuffers layout get used directly from the mapped
+    // file, decoding only the bitmaps that a lookup touches.
+    auto chunk = chunk::mmap(filename_);
+    if (chunk && chunk->size() >= 8
+        && flatbuffers::BufferHasIdentifier(chunk->data(),
+                                            fbs::file_identifier)) {
+      auto flatbuf = fbs::as_flatbuffer<fbs::ValueIndex>(as_bytes(chunk));
+      if (flatbuf == nullptr)
+        return make_error(ec::format_error, "failed to verify value index");
+      if (auto err = unpack(*flatbuf, idx_, chunk)) {
+        VAST_ERROR(this, "failed to unpack value index", sys_.render(err));
+        return err;
+      }
+      last_flush_ = idx_->offset();
+      VAST_DEBUG(this, "mapped value index with offset", last_flush_);
+      return caf::none;
+    }
+    // Fall back to the CAF binary representation of earlier versions.
     if (auto err = load(nullptr, filename_, last_flush_, idx_)) {
       VAST_ERROR(this, "failed to load value index from disk", sys_.render(err));
       return err;
@@ -84,8 +112,23 @@ caf::error column_index::flush_to_disk() {
   auto offset = idx_->offset();
   VAST_DEBUG(this, "flushes index (", offset - last_flush_, '/', offset,
              "new/total bits)");
+  auto chunk = fbs::wrap(*idx_, fbs::file_identifier);
+  if (!chunk)
+    return chunk.error();
+  if (auto dir = filename_.parent(); !exists(dir))
+    if (auto res = mkdir(dir); !res)
+      return res.error();
+  // Writing to a temporary file first leaves the currently mapped file intact
+  // in case of a failure.
+  auto tmp = filename_ + ".tmp";
+  if (auto err = write(tmp, *chunk))
+    return err;
+  if (std::rename(tmp.str().c_str(), filename_.str().c_str()) != 0)
+    return make_error(ec::filesystem_error, "failed to rename", tmp);
+  if (auto err = save(nullptr, statistics_filename(), stats_))
+    return err;
   last_flush_ = offset;
-  return save(nullptr, filename_, last_flush_, idx_);
+  return caf::none;
 }
 
 // -- properties -------------------------------------------------------------
@@ -94,7 +137,7 @@ void column_index::add(const table_slice_column& x) {
   VAST_TRACE(VAST_ARG(x));
   if (has_skip_attribute_)
     return;
-  x.slice->append_column_to_index(x.column, *idx_);
+  x.slice->append_column_to_index(x.column, *idx_, &stats_);
 }
 
 caf::expected<bitmap> column_index::lookup(relational_operator op,
@@ -107,6 +150,22 @@ caf::expected<bitmap> column_index::lookup(relational_operator op,
   return result;
 }
 
+caf::expected<bitmap> column_index::lookup(relational_operator op,
+                                           data_view rhs,
+                                           const ids& candidates) {
+  VAST_TRACE(VAST_ARG(op), VAST_ARG(rhs), VAST_ARG(candidates));
+  VAST_ASSERT(idx_ != nullptr);
+  auto rep = to_internal(index_type_, rhs);
+  auto result = idx_->lookup(op, rep, candidates);
+  VAST_DEBUG(this, VAST_ARG(result));
+  return result;
+}
+
+caf::optional<double>
+column_index::selectivity(relational_operator op, data_view rhs) const {
+  return stats_.selectivity(op, to_internal(index_type_, rhs));
+}
+
 bool column_index::dirty() const noexcept {
   VAST_ASSERT(idx_ != nullptr);
   return idx_->offset() != last_flush_;
@@ -0,0 +1,213 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/column_statistics.hpp"
+
+#include "vast/concept/hashable/uhash.hpp"
+#include "vast/concept/hashable/xxhash.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/data.hpp"
+#include "vast/detail/overload.hpp"
+
+#include <algorithm>
+
+namespace vast {
+
+namespace {
+
+uint64_t digest(data_view x) {
+  return caf::visit([](auto y) -> uint64_t { return uhash<xxhash>{}(y); }, x);
+}
+
+// Only values with a meaningful total order contribute to min and max.
+bool is_ordered(data_view x) {
+  return !(caf::holds_alternative<caf::none_t>(x)
+           || caf::holds_alternative<view<pattern>>(x)
+           || caf::holds_alternative<view<vector>>(x)
+           || caf::holds_alternative<view<set>>(x)
+           || caf::holds_alternative<view<map>>(x));
+}
+
+// Maps arithmetic values onto the real line for interpolating ranges.
+caf::optional<double> to_real(data_view x) {
+  return caf::visit(
+    detail::overload(
+      [](auto) -> caf::optional<double> { return caf::none; },
+      [](integer y) -> caf::optional<double> { return y; },
+      [](vast::count y) -> caf::optional<double> { return y; },
+      [](real y) -> caf::optional<double> { return y; },
+      [](duration y) -> caf::optional<double> { return y.count(); },
+      [](time y) -> caf::optional<double> {
+        return y.time_since_epoch().count();
+      }),
+    x);
+}
+
+} // namespace
+
+column_statistics::column_statistics(size_t k) : k_{k} {
+  // nop
+}
+
+void column_statistics::add(data_view x) {
+  ++count_;
+  if (caf::holds_alternative<caf::none_t>(x)) {
+    ++nulls_;
+    return;
+  }
+  auto h = digest(x);
+  distinct_.add(h);
+  if (is_ordered(x)) {
+    if (caf::holds_alternative<caf::none_t>(min_)
+        || evaluate_view(x, less, make_view(min_)))
+      min_ = materialize(x);
+    if (caf::holds_alternative<caf::none_t>(max_)
+        || evaluate_view(x, greater, make_view(max_)))
+      max_ = materialize(x);
+  }
+  // Misra-Gries summary: count known values, take a free counter for new
+  // values, and otherwise decrement all counters.
+  auto pred = [&](const heavy_hitter& hh) { return hh.digest == h; };
+  if (auto i = std::find_if(top_.begin(), top_.end(), pred); i != top_.end()) {
+    ++i->count;
+  } else if (top_.size() < k_) {
+    top_.push_back({h, materialize(x), 1});
+  } else {
+    for (auto& hh : top_)
+      --hh.count;
+    auto is_zero = [](const heavy_hitter& hh) { return hh.count == 0; };
+    top_.erase(std::remove_if(top_.begin(), top_.end(), is_zero), top_.end());
+  }
+}
+
+void column_statistics::merge(const column_statistics& other) {
+  count_ += other.count_;
+  nulls_ += other.nulls_;
+  distinct_.merge(other.distinct_);
+  if (!caf::holds_alternative<caf::none_t>(other.min_)
+      && (caf::holds_alternative<caf::none_t>(min_) || other.min_ < min_))
+    min_ = other.min_;
+  if (!caf::holds_alternative<caf::none_t>(other.max_)
+      && (caf::holds_alternative<caf::none_t>(max_) || max_ < other.max_))
+    max_ = other.max_;
+  for (auto& x : other.top_) {
+    auto pred = [&](const heavy_hitter& hh) { return hh.digest == x.digest; };
+    if (auto i = std::find_if(top_.begin(), top_.end(), pred); i != top_.end())
+      i->count += x.count;
+    else
+      top_.push_back(x);
+  }
+  // Reduce the combined summary back to k counters by subtracting the count
+  // of the largest counter that does not fit anymore.
+  if (top_.size() > k_) {
+    auto by_count = [](const heavy_hitter& x, const heavy_hitter& y) {
+      return x.count > y.count;
+    };
+    std::sort(top_.begin(), top_.end(), by_count);
+    auto threshold = top_[k_].count;
+    top_.resize(k_);
+    for (auto& hh : top_)
+      hh.count -= threshold;
+    auto is_zero = [](const heavy_hitter& hh) { return hh.count == 0; };
+    top_.erase(std::remove_if(top_.begin(), top_.end(), is_zero), top_.end());
+  }
+}
+
+uint64_t column_statistics::distinct() const noexcept {
+  return std::min(distinct_.estimate(), count_ - nulls_);
+}
+
+std::vector<column_statistics::heavy_hitter>
+column_statistics::heavy_hitters() const {
+  auto result = top_;
+  std::stable_sort(result.begin(), result.end(), [](auto& x, auto& y) {
+    return x.count > y.count;
+  });
+  return result;
+}
+
+caf::optional<double>
+column_statistics::selectivity(relational_operator op, data_view x) const {
+  if (count_ == 0)
+    return caf::none;
+  auto n = static_cast<double>(count_);
+  auto values = count_ - nulls_;
+  auto has_range = !caf::holds_alternative<caf::none_t>(min_);
+  auto equality = [&]() -> double {
+    if (caf::holds_alternative<caf::none_t>(x))
+      return nulls_ / n;
+    if (has_range && is_ordered(x)
+        && (evaluate_view(x, less, make_view(min_))
+            || evaluate_view(x, greater, make_view(max_))))
+      return 0.0;
+    auto h = digest(x);
+    auto frequent = uint64_t{0};
+    for (auto& hh : top_) {
+      if (hh.digest == h)
+        return hh.count / n;
+      frequent += hh.count;
+    }
+    // Assume that the remaining values are distributed uniformly.
+    auto rest = values > frequent ? values - frequent : 0;
+    auto tracked = static_cast<uint64_t>(top_.size());
+    auto others = std::max(distinct(), tracked + 1) - tracked;
+    return rest / static_cast<double>(others) / n;
+  };
+  switch (op) {
+    default:
+      return caf::none;
+    case equal:
+      return equality();
+    case not_equal:
+      return 1.0 - equality();
+    case less:
+    case less_equal:
+    case greater:
+    case greater_equal: {
+      if (!has_range)
+        return caf::none;
+      auto lo = to_real(make_view(min_));
+      auto hi = to_real(make_view(max_));
+      auto y = to_real(x);
+      if (!lo || !hi || !y)
+        return caf::none;
+      if (*hi <= *lo)
+        return evaluate_view(make_view(min_), op, x) ? values / n : 0.0;
+      auto below = std::clamp((*y - *lo) / (*hi - *lo), 0.0, 1.0);
+      auto fraction = op == less || op == less_equal ? below : 1.0 - below;
+      return fraction * values / n;
+    }
+  }
+}
+
+caf::dictionary<caf::config_value> column_statistics::status() const {
+  caf::dictionary<caf::config_value> result;
+  result.emplace("count", count_);
+  result.emplace("nulls", nulls_);
+  result.emplace("distinct", distinct());
+  if (!caf::holds_alternative<caf::none_t>(min_)) {
+    result.emplace("min", to_string(min_));
+    result.emplace("max", to_string(max_));
+  }
+  caf::config_value::list xs;
+  for (auto& hh : heavy_hitters()) {
+    caf::dictionary<caf::config_value> x;
+    x.emplace("value", to_string(hh.value));
+    x.emplace("count", hh.count);
+    xs.emplace_back(std::move(x));
+  }
+  result.emplace("heavy-hitters", std::move(xs));
+  return result;
+}
+
+} // namespace vast
@@ -18,7 +18,58 @@
 #include "vast/compression.hpp"
 #include "vast/die.hpp"
 
+#include <cstring>
+
+#if VAST_HAVE_ZSTD
+#  include <zstd.h>
+#endif
+
 namespace vast {
+
+size_t compress_bound(compression method, size_t size) {
+  switch (method) {
+    case compression::null:
+      return size;
+    case compression::lz4:
+      return lz4::compress_bound(size);
+    case compression::zstd:
+      return zstd::compress_bound(size);
+  }
+  return 0;
+}
+
+size_t compress(compression method, const char* in, size_t in_size, char* out,
+                size_t out_size) {
+  switch (method) {
+    case compression::null:
+      if (out_size < in_size)
+        return 0;
+      std::memcpy(out, in, in_size);
+      return in_size;
+    case compression::lz4:
+      return lz4::compress(in, in_size, out, out_size);
+    case compression::zstd:
+      return zstd::compress(in, in_size, out, out_size);
+  }
+  return 0;
+}
+
+size_t uncompress(compression method, const char* in, size_t in_size,
+                  char* out, size_t out_size) {
+  switch (method) {
+    case compression::null:
+      if (out_size < in_size)
+        return 0;
+      std::memcpy(out, in, in_size);
+      return in_size;
+    case compression::lz4:
+      return lz4::uncompress(in, in_size, out, out_size);
+    case compression::zstd:
+      return zstd::uncompress(in, in_size, out, out_size);
+  }
+  return 0;
+}
+
 namespace lz4 {
 
 size_t compress_bound(size_t size) {
@@ -30,9 +81,55 @@ size_t compress(const char* in, size_t in_size, char* out, size_t out_size) {
 }
 
 size_t uncompress(const char* in, size_t in_size, char* out, size_t out_size) {
-  return LZ4_decompress_safe(in, out, static_cast<int>(in_size),
-                             static_cast<int>(out_size));
+  auto n = LZ4_decompress_safe(in, out, static_cast<int>(in_size),
+                               static_cast<int>(out_size));
+  // Negative values signal malformed input.
+  return n < 0 ? 0 : static_cast<size_t>(n);
 }
 
 } // namespace lz4
+
+namespace zstd {
+
+#if VAST_HAVE_ZSTD
+
+namespace {
+
+// The default level of the zstd command line tool, which trades compression
+// ratio for speed in roughly the same way as gzip's default level.
+constexpr int level = 3;
+
+} // namespace
+
+size_t compress_bound(size_t size) {
+  return ZSTD_compressBound(size);
+}
+
+size_t compress(const char* in, size_t in_size, char* out, size_t out_size) {
+  auto n = ZSTD_compress(out, out_size, in, in_size, level);
+  return ZSTD_isError(n) ? 0 : n;
+}
+
+size_t uncompress(const char* in, size_t in_size, char* out, size_t out_size) {
+  auto n = ZSTD_decompress(out, out_size, in, in_size);
+  return ZSTD_isError(n) ? 0 : n;
+}
+
+#else // VAST_HAVE_ZSTD
+
+size_t compress_bound(size_t) {
+  return 0;
+}
+
+size_t compress(const char*, size_t, char*, size_t) {
+  return 0;
+}
+
+size_t uncompress(const char*, size_t, char*, size_t) {
+  return 0;
+}
+
+#endif // VAST_HAVE_ZSTD
+
+} // namespace zstd
 } // namespace vast
@@ -14,13 +14,17 @@
 #include "vast/detail/add_message_types.hpp"
 
 #include "vast/bitmap.hpp"
+#include "vast/column_statistics.hpp"
 #include "vast/command.hpp"
 #include "vast/config.hpp"
 #include "vast/event.hpp"
 #include "vast/expression.hpp"
+#include "vast/meta_index.hpp"
 #include "vast/operator.hpp"
 #include "vast/query_options.hpp"
 #include "vast/schema.hpp"
+#include "vast/system/cancellation_token.hpp"
+#include "vast/system/compactor.hpp"
 #include "vast/system/query_status.hpp"
 #include "vast/system/report.hpp"
 #include "vast/system/tracker.hpp"
@@ -0,0 +1,325 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/detail/block_kernels.hpp"
+
+#include <atomic>
+#include <initializer_list>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  define VAST_HAVE_X86_BLOCK_KERNELS 1
+#  include <immintrin.h>
+#else
+#  define VAST_HAVE_X86_BLOCK_KERNELS 0
+#endif
+
+namespace vast::detail {
+
+namespace {
+
+using binary_kernel = void (*)(const uint64_t*, const uint64_t*, uint64_t*,
+                               size_t);
+
+struct kernel_table {
+  block_kernel_isa isa;
+  binary_kernel and_;
+  binary_kernel or_;
+  binary_kernel xor_;
+  binary_kernel and_not;
+  void (*not_)(const uint64_t*, uint64_t*, size_t);
+  uint64_t (*popcount)(const uint64_t*, size_t);
+};
+
+// -- scalar -------------------------------------------------------------------
+
+void scalar_and(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = x[i] & y[i];
+}
+
+void scalar_or(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = x[i] | y[i];
+}
+
+void scalar_xor(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = x[i] ^ y[i];
+}
+
+void scalar_and_not(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                    size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = x[i] & ~y[i];
+}
+
+void scalar_not(const uint64_t* x, uint64_t* out, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = ~x[i];
+}
+
+uint64_t scalar_popcount(const uint64_t* xs, size_t n) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < n; ++i)
+    result += __builtin_popcountll(xs[i]);
+  return result;
+}
+
+constexpr kernel_table scalar_kernels = {
+  block_kernel_isa::scalar, scalar_and, scalar_or,       scalar_xor,
+  scalar_and_not,           scalar_not, scalar_popcount,
+};
+
+#if VAST_HAVE_X86_BLOCK_KERNELS
+
+// -- SSE4.2 -------------------------------------------------------------------
+
+// Generates a kernel that processes two blocks per iteration. The functions
+// carry a target attribute so that we can compile them regardless of the
+// global -m flags and only call them after checking CPU support at runtime.
+#  define VAST_SSE_BINARY_KERNEL(name, vector_expr, scalar_expr)               \
+    __attribute__((target("sse4.2"))) void name(const uint64_t* x,             \
+                                                const uint64_t* y,             \
+                                                uint64_t* out, size_t n) {     \
+      size_t i = 0;                                                            \
+      for (; i + 2 <= n; i += 2) {                                             \
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));     \
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));     \
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), vector_expr);    \
+      }                                                                        \
+      for (; i < n; ++i) {                                                     \
+        auto a = x[i];                                                         \
+        auto b = y[i];                                                         \
+        out[i] = scalar_expr;                                                  \
+      }                                                                        \
+    }
+
+VAST_SSE_BINARY_KERNEL(sse42_and, _mm_and_si128(a, b), a & b)
+VAST_SSE_BINARY_KERNEL(sse42_or, _mm_or_si128(a, b), a | b)
+VAST_SSE_BINARY_KERNEL(sse42_xor, _mm_xor_si128(a, b), a ^ b)
+VAST_SSE_BINARY_KERNEL(sse42_and_not, _mm_andnot_si128(b, a), a & ~b)
+
+#  undef VAST_SSE_BINARY_KERNEL
+
+__attribute__((target("sse4.2"))) void
+sse42_not(const uint64_t* x, uint64_t* out, size_t n) {
+  auto ones = _mm_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_xor_si128(a, ones));
+  }
+  for (; i < n; ++i)
+    out[i] = ~x[i];
+}
+
+__attribute__((target("sse4.2,popcnt"))) uint64_t
+sse42_popcount(const uint64_t* xs, size_t n) {
+  // Four independent accumulators break the dependency chain on the result.
+  uint64_t c0 = 0;
+  uint64_t c1 = 0;
+  uint64_t c2 = 0;
+  uint64_t c3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    c0 += _mm_popcnt_u64(xs[i]);
+    c1 += _mm_popcnt_u64(xs[i + 1]);
+    c2 += _mm_popcnt_u64(xs[i + 2]);
+    c3 += _mm_popcnt_u64(xs[i + 3]);
+  }
+  for (; i < n; ++i)
+    c0 += _mm_popcnt_u64(xs[i]);
+  return c0 + c1 + c2 + c3;
+}
+
+constexpr kernel_table sse42_kernels = {
+  block_kernel_isa::sse42, sse42_and, sse42_or,       sse42_xor,
+  sse42_and_not,           sse42_not, sse42_popcount,
+};
+
+// -- AVX2 ---------------------------------------------------------------------
+
+#  define VAST_AVX2_BINARY_KERNEL(name, vector_expr, scalar_expr)              \
+    __attribute__((target("avx2"))) void name(const uint64_t* x,               \
+                                              const uint64_t* y,               \
+                                              uint64_t* out, size_t n) {       \
+      size_t i = 0;                                                            \
+      for (; i + 4 <= n; i += 4) {                                             \
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));  \
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));  \
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), vector_expr); \
+      }                                                                        \
+      for (; i < n; ++i) {                                                     \
+        auto a = x[i];                                                         \
+        auto b = y[i];                                                         \
+        out[i] = scalar_expr;                                                  \
+      }                                                                        \
+    }
+
+VAST_AVX2_BINARY_KERNEL(avx2_and, _mm256_and_si256(a, b), a & b)
+VAST_AVX2_BINARY_KERNEL(avx2_or, _mm256_or_si256(a, b), a | b)
+VAST_AVX2_BINARY_KERNEL(avx2_xor, _mm256_xor_si256(a, b), a ^ b)
+VAST_AVX2_BINARY_KERNEL(avx2_and_not, _mm256_andnot_si256(b, a), a & ~b)
+
+#  undef VAST_AVX2_BINARY_KERNEL
+
+__attribute__((target("avx2"))) void
+avx2_not(const uint64_t* x, uint64_t* out, size_t n) {
+  auto ones = _mm256_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_xor_si256(a, ones));
+  }
+  for (; i < n; ++i)
+    out[i] = ~x[i];
+}
+
+// Counts bits with a nibble lookup table via VPSHUFB and accumulates the
+// per-byte counts into 64-bit lanes via VPSADBW; see Muła, Kurz, and Lemire:
+// "Faster Population Counts Using AVX2 Instructions".
+__attribute__((target("avx2"))) uint64_t
+avx2_popcount(const uint64_t* xs, size_t n) {
+  auto lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3,
+                                 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3,
+                                 3, 4);
+  auto low_mask = _mm256_set1_epi8(0x0f);
+  auto zero = _mm256_setzero_si256();
+  auto acc = zero;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i));
+    auto lo = _mm256_and_si256(v, low_mask);
+    auto hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    auto counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                  _mm256_shuffle_epi8(lookup, hi));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(counts, zero));
+  }
+  uint64_t result = static_cast<uint64_t>(_mm256_extract_epi64(acc, 0))
+                    + static_cast<uint64_t>(_mm256_extract_epi64(acc, 1))
+                    + static_cast<uint64_t>(_mm256_extract_epi64(acc, 2))
+                    + static_cast<uint64_t>(_mm256_extract_epi64(acc, 3));
+  for (; i < n; ++i)
+    result += __builtin_popcountll(xs[i]);
+  return result;
+}
+
+constexpr kernel_table avx2_kernels = {
+  block_kernel_isa::avx2, avx2_and, avx2_or,       avx2_xor,
+  avx2_and_not,           avx2_not, avx2_popcount,
+};
+
+#endif // VAST_HAVE_X86_BLOCK_KERNELS
+
+bool supported(block_kernel_isa isa) {
+  switch (isa) {
+    case block_kernel_isa::scalar:
+      return true;
+#if VAST_HAVE_X86_BLOCK_KERNELS
+    case block_kernel_isa::sse42:
+      return __builtin_cpu_supports("sse4.2")
+             && __builtin_cpu_supports("popcnt");
+    case block_kernel_isa::avx2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+const kernel_table* table_for(block_kernel_isa isa) {
+  switch (isa) {
+#if VAST_HAVE_X86_BLOCK_KERNELS
+    case block_kernel_isa::sse42:
+      return &sse42_kernels;
+    case block_kernel_isa::avx2:
+      return &avx2_kernels;
+#endif
+    default:
+      return &scalar_kernels;
+  }
+}
+
+const kernel_table* detect() {
+  for (auto isa : {block_kernel_isa::avx2, block_kernel_isa::sse42})
+    if (supported(isa))
+      return table_for(isa);
+  return &scalar_kernels;
+}
+
+std::atomic<const kernel_table*>& active_table() {
+  static std::atomic<const kernel_table*> table{detect()};
+  return table;
+}
+
+const kernel_table& kernels() {
+  return *active_table().load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+block_kernel_isa active_block_kernels() {
+  return kernels().isa;
+}
+
+bool select_block_kernels(block_kernel_isa isa) {
+  if (!supported(isa))
+    return false;
+  active_table().store(table_for(isa), std::memory_order_relaxed);
+  return true;
+}
+
+const char* to_string(block_kernel_isa isa) {
+  switch (isa) {
+    case block_kernel_isa::scalar:
+      return "scalar";
+    case block_kernel_isa::sse42:
+      return "sse4.2";
+    case block_kernel_isa::avx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+void blocks_and(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                size_t n) {
+  kernels().and_(x, y, out, n);
+}
+
+void blocks_or(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n) {
+  kernels().or_(x, y, out, n);
+}
+
+void blocks_xor(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                size_t n) {
+  kernels().xor_(x, y, out, n);
+}
+
+void blocks_and_not(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                    size_t n) {
+  kernels().and_not(x, y, out, n);
+}
+
+void blocks_not(const uint64_t* x, uint64_t* out, size_t n) {
+  kernels().not_(x, out, n);
+}
+
+uint64_t blocks_popcount(const uint64_t* xs, size_t n) {
+  return kernels().popcount(xs, n);
+}
+
+} // namespace vast::detail
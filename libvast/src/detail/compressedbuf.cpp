@@ -175,6 +175,12 @@ void compressedbuf::compress() {
                         compressed_.data(), compressed_.size());
       break;
     }
+    case compression::zstd: {
+      compressed_.resize(zstd::compress_bound(uncompressed_.size()));
+      n = zstd::compress(uncompressed_.data(), uncompressed_.size(),
+                         compressed_.data(), compressed_.size());
+      break;
+    }
   }
   compressed_.resize(n);
   uncompressed_.resize(block_size_);
@@ -193,6 +199,11 @@ void compressedbuf::uncompress() {
                           uncompressed_.data(), uncompressed_.size());
       break;
     }
+    case compression::zstd: {
+      n = zstd::uncompress(compressed_.data(), compressed_.size(),
+                           uncompressed_.data(), uncompressed_.size());
+      break;
+    }
   }
   VAST_ASSERT(n > 0);
   uncompressed_.resize(n);
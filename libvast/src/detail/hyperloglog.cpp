@@ -0,0 +1,64 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/detail/hyperloglog.hpp"
+
+#include "vast/detail/assert.hpp"
+#include "vast/detail/bit.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vast::detail {
+
+hyperloglog::hyperloglog(uint8_t precision)
+  : precision_{precision}, registers_(size_t{1} << precision, 0) {
+  VAST_ASSERT(precision >= 4 && precision <= 18);
+}
+
+void hyperloglog::add(uint64_t digest) noexcept {
+  // The upper bits select the register, and the position of the first 1-bit
+  // in the remaining bits is the observed rank.
+  auto index = digest >> (64 - precision_);
+  auto rest = digest << precision_;
+  auto rank = static_cast<uint8_t>(
+    std::min(countl_zero(rest), 64 - precision_) + 1);
+  registers_[index] = std::max(registers_[index], rank);
+}
+
+bool hyperloglog::merge(const hyperloglog& other) noexcept {
+  if (precision_ != other.precision_)
+    return false;
+  for (size_t i = 0; i < registers_.size(); ++i)
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  return true;
+}
+
+uint64_t hyperloglog::estimate() const noexcept {
+  auto m = static_cast<double>(registers_.size());
+  auto sum = 0.0;
+  auto zeros = size_t{0};
+  for (auto x : registers_) {
+    sum += std::ldexp(1.0, -x);
+    if (x == 0)
+      ++zeros;
+  }
+  auto alpha = 0.7213 / (1.0 + 1.079 / m);
+  auto result = alpha * m * m / sum;
+  // Linear counting is more accurate for small cardinalities.
+  if (result <= 2.5 * m && zeros > 0)
+    result = m * std::log(m / zeros);
+  return static_cast<uint64_t>(std::llround(result));
+}
+
+} // namespace vast::detail
@@ -0,0 +1,577 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/detail/regex_automaton.hpp"
+
+#include "vast/detail/assert.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+namespace vast::detail {
+
+namespace {
+
+/// Signals a construct that the automaton does not support. The automaton
+/// then defers to `std::regex`.
+struct unsupported {};
+
+constexpr size_t unbounded = std::numeric_limits<size_t>::max();
+
+/// The largest bound of a counted repetition that we expand.
+constexpr size_t max_repetitions = 1000;
+
+/// The deepest nesting of groups that we accept.
+constexpr size_t max_depth = 256;
+
+} // namespace
+
+/// A node in the syntax tree of a pattern.
+struct regex_automaton::node {
+  enum kind_type { bytes, concat, alternate, repeat, begin, end };
+
+  explicit node(kind_type kind) : kind{kind} {
+    // nop
+  }
+
+  node(byte_set xs) : kind{bytes}, set{xs} {
+    // nop
+  }
+
+  kind_type kind;
+  byte_set set;
+  std::vector<node> children;
+  size_t min = 0;
+  size_t max = 0;
+};
+
+/// A recursive-descent parser for the ECMAScript subset that maps onto a
+/// finite automaton.
+class regex_automaton::parser {
+public:
+  explicit parser(std::string_view str) : str_{str} {
+    // nop
+  }
+
+  node parse() {
+    auto result = alternation();
+    if (!done())
+      throw unsupported{};
+    return result;
+  }
+
+private:
+  static byte_set single(unsigned char c) {
+    byte_set result;
+    result.set(c);
+    return result;
+  }
+
+  static byte_set digits() {
+    byte_set result;
+    for (auto c = '0'; c <= '9'; ++c)
+      result.set(c);
+    return result;
+  }
+
+  static byte_set word() {
+    auto result = digits();
+    for (auto c = 'a'; c <= 'z'; ++c)
+      result.set(c).set(std::toupper(c));
+    return result.set('_');
+  }
+
+  static byte_set space() {
+    byte_set result;
+    for (auto c : {' ', '\t', '\n', '\v', '\f', '\r'})
+      result.set(c);
+    return result;
+  }
+
+  bool done() const {
+    return i_ >= str_.size();
+  }
+
+  char peek() const {
+    return str_[i_];
+  }
+
+  char next() {
+    if (done())
+      throw unsupported{};
+    return str_[i_++];
+  }
+
+  node alternation() {
+    node result{node::alternate};
+    result.children.push_back(concatenation());
+    while (!done() && peek() == '|') {
+      ++i_;
+      result.children.push_back(concatenation());
+    }
+    if (result.children.size() == 1)
+      return std::move(result.children[0]);
+    return result;
+  }
+
+  node concatenation() {
+    node result{node::concat};
+    while (!done() && peek() != '|' && peek() != ')')
+      result.children.push_back(quantified(atom()));
+    return result;
+  }
+
+  node atom() {
+    auto c = next();
+    switch (c) {
+      default:
+        return single(c);
+      case '(': {
+        // Only non-capturing groups have a meaning beyond grouping.
+        if (!done() && peek() == '?') {
+          ++i_;
+          if (next() != ':')
+            throw unsupported{};
+        }
+        if (++depth_ > max_depth)
+          throw unsupported{};
+        auto result = alternation();
+        --depth_;
+        if (next() != ')')
+          throw unsupported{};
+        return result;
+      }
+      case ')':
+      case ']':
+      case '}':
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+        throw unsupported{};
+      case '[':
+        return char_class();
+      case '.':
+        return ~(single('\n') | single('\r'));
+      case '^':
+        return node{node::begin};
+      case '$':
+        return node{node::end};
+      case '\\':
+        return escape(false);
+    }
+  }
+
+  node quantified(node x) {
+    if (done())
+      return x;
+    size_t min = 0;
+    size_t max = 0;
+    switch (peek()) {
+      default:
+        return x;
+      case '*':
+        ++i_;
+        max = unbounded;
+        break;
+      case '+':
+        ++i_;
+        min = 1;
+        max = unbounded;
+        break;
+      case '?':
+        ++i_;
+        max = 1;
+        break;
+      case '{':
+        ++i_;
+        min = number();
+        max = min;
+        if (!done() && peek() == ',') {
+          ++i_;
+          max = !done() && peek() == '}' ? unbounded : number();
+        }
+        if (next() != '}' || max < min)
+          throw unsupported{};
+        break;
+    }
+    // Lazy quantifiers accept the same strings as greedy ones.
+    if (!done() && peek() == '?')
+      ++i_;
+    if (x.kind == node::begin || x.kind == node::end)
+      throw unsupported{};
+    node result{node::repeat};
+    result.min = min;
+    result.max = max;
+    result.children.push_back(std::move(x));
+    return result;
+  }
+
+  size_t number() {
+    size_t result = 0;
+    auto first = i_;
+    while (!done() && std::isdigit(static_cast<unsigned char>(peek()))) {
+      result = result * 10 + (next() - '0');
+      if (result > max_repetitions)
+        throw unsupported{};
+    }
+    if (i_ == first)
+      throw unsupported{};
+    return result;
+  }
+
+  unsigned char hex(size_t digits) {
+    size_t result = 0;
+    for (size_t i = 0; i < digits; ++i) {
+      auto c = static_cast<unsigned char>(next());
+      if (!std::isxdigit(c))
+        throw unsupported{};
+      result = result * 16
+               + (std::isdigit(c) ? c - '0' : std::tolower(c) - 'a' + 10);
+    }
+    if (result > 0x7f)
+      throw unsupported{};
+    return static_cast<unsigned char>(result);
+  }
+
+  byte_set escape(bool in_class) {
+    auto c = next();
+    switch (c) {
+      case 'd':
+        return digits();
+      case 'D':
+        return ~digits();
+      case 'w':
+        return word();
+      case 'W':
+        return ~word();
+      case 's':
+        return space();
+      case 'S':
+        return ~space();
+      case 'n':
+        return single('\n');
+      case 'r':
+        return single('\r');
+      case 't':
+        return single('\t');
+      case 'f':
+        return single('\f');
+      case 'v':
+        return single('\v');
+      case 'x':
+        return single(hex(2));
+      case 'u':
+        return single(hex(4));
+      case 'b':
+        // Outside of a class, \b is a word boundary.
+        if (in_class)
+          return single('\b');
+        throw unsupported{};
+      default:
+        // Back references, control characters, and unknown escapes.
+        if (std::isalnum(static_cast<unsigned char>(c)))
+          throw unsupported{};
+        return single(c);
+    }
+  }
+
+  /// Parses a single class member, which is either one byte or a class escape.
+  byte_set class_atom() {
+    auto c = next();
+    if (c == '\\')
+      return escape(true);
+    // POSIX classes, equivalence classes, and collating elements.
+    if (c == '[' && !done()
+        && (peek() == ':' || peek() == '=' || peek() == '.'))
+      throw unsupported{};
+    return single(c);
+  }
+
+  node char_class() {
+    auto negate = !done() && peek() == '^';
+    if (negate)
+      ++i_;
+    if (!done() && peek() == ']')
+      throw unsupported{};
+    byte_set result;
+    while (next() != ']') {
+      --i_;
+      auto lo = class_atom();
+      if (i_ + 1 < str_.size() && peek() == '-' && str_[i_ + 1] != ']') {
+        ++i_;
+        auto hi = class_atom();
+        // Ranges between bytes beyond ASCII depend on the signedness of char.
+        auto first = ascii(lo);
+        auto last = ascii(hi);
+        if (last < first)
+          throw unsupported{};
+        for (auto x = first; x <= last; ++x)
+          result.set(x);
+      } else {
+        result |= lo;
+      }
+    }
+    if (negate)
+      result.flip();
+    return result;
+  }
+
+  static size_t ascii(const byte_set& xs) {
+    if (xs.count() != 1)
+      throw unsupported{};
+    for (size_t i = 0; i < 128; ++i)
+      if (xs.test(i))
+        return i;
+    throw unsupported{};
+  }
+
+  std::string_view str_;
+  size_t i_ = 0;
+  size_t depth_ = 0;
+};
+
+regex_automaton::regex_automaton(std::string_view pattern)
+  : source_{pattern} {
+  try {
+    auto root = parser{pattern}.parse();
+    auto accept = add(nfa_state{nfa_state::accept, {}});
+    start_ = compile(root, accept);
+    // Every match begins with the bytes of the leading singletons.
+    auto prefix_of = [&](const node& x) {
+      if (x.kind == node::bytes && x.set.count() == 1)
+        for (size_t i = 0; i < x.set.size(); ++i)
+          if (x.set.test(i)) {
+            prefix_ += static_cast<char>(i);
+            return true;
+          }
+      return false;
+    };
+    if (root.kind == node::concat) {
+      for (auto& child : root.children)
+        if (!prefix_of(child))
+          break;
+    } else {
+      prefix_of(root);
+    }
+  } catch (const unsupported&) {
+    nfa_.clear();
+    prefix_.clear();
+    try {
+      fallback_.emplace(source_);
+    } catch (const std::regex_error&) {
+      // Matching constructs the regex again to report the error.
+    }
+    return;
+  }
+  restart_ = closure({start_}, false, false);
+}
+
+bool regex_automaton::match(std::string_view str) const {
+  if (!native()) {
+    if (!fallback_)
+      // Reports the syntax error of the pattern.
+      std::regex{source_};
+    return std::regex_match(str.begin(), str.end(), *fallback_);
+  }
+  if (str.substr(0, prefix_.size()) != prefix_)
+    return false;
+  std::lock_guard<std::mutex> lock{mutex_};
+  return run(anchored_, false, str, true);
+}
+
+bool regex_automaton::search(std::string_view str) const {
+  if (!native()) {
+    if (!fallback_)
+      std::regex{source_};
+    return std::regex_search(str.begin(), str.end(), *fallback_);
+  }
+  // A match can only begin where the literal prefix occurs.
+  auto pos = str.find(prefix_);
+  if (pos == std::string_view::npos)
+    return false;
+  std::lock_guard<std::mutex> lock{mutex_};
+  return run(unanchored_, true, str.substr(pos), pos == 0);
+}
+
+bool regex_automaton::native() const {
+  return !nfa_.empty();
+}
+
+std::string_view regex_automaton::literal_prefix() const {
+  return prefix_;
+}
+
+size_t regex_automaton::dfa_states() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return anchored_.states.size() + unanchored_.states.size();
+}
+
+uint32_t regex_automaton::add(nfa_state x) {
+  if (nfa_.size() == max_nfa_states)
+    throw unsupported{};
+  nfa_.push_back(std::move(x));
+  return static_cast<uint32_t>(nfa_.size() - 1);
+}
+
+uint32_t regex_automaton::compile(const node& x, uint32_t next) {
+  switch (x.kind) {
+    case node::bytes:
+      return add(nfa_state{nfa_state::byte, x.set, next});
+    case node::concat:
+      for (auto i = x.children.rbegin(); i != x.children.rend(); ++i)
+        next = compile(*i, next);
+      return next;
+    case node::alternate: {
+      auto result = compile(x.children.back(), next);
+      for (auto i = x.children.size() - 1; i > 0; --i) {
+        auto alternative = compile(x.children[i - 1], next);
+        result = add(nfa_state{nfa_state::split, {}, alternative, result});
+      }
+      return result;
+    }
+    case node::repeat: {
+      auto& child = x.children.front();
+      auto result = next;
+      if (x.max == unbounded) {
+        // The loop state needs to exist before the body that jumps back to it.
+        result = add(nfa_state{nfa_state::split, {}, 0, next});
+        auto body = compile(child, result);
+        nfa_[result].out = body;
+      } else {
+        for (auto i = x.min; i < x.max; ++i) {
+          auto body = compile(child, result);
+          result = add(nfa_state{nfa_state::split, {}, body, next});
+        }
+      }
+      for (size_t i = 0; i < x.min; ++i)
+        result = compile(child, result);
+      return result;
+    }
+    case node::begin:
+      return add(nfa_state{nfa_state::begin, {}, next});
+    case node::end:
+      return add(nfa_state{nfa_state::end, {}, next});
+  }
+  VAST_ASSERT(!"missing case");
+  return next;
+}
+
+regex_automaton::nfa_set
+regex_automaton::closure(nfa_set xs, bool at_start, bool at_end) const {
+  nfa_set result;
+  std::vector<bool> visited(nfa_.size());
+  while (!xs.empty()) {
+    auto x = xs.back();
+    xs.pop_back();
+    if (visited[x])
+      continue;
+    visited[x] = true;
+    auto& state = nfa_[x];
+    switch (state.kind) {
+      case nfa_state::byte:
+      case nfa_state::accept:
+        result.push_back(x);
+        break;
+      case nfa_state::split:
+        xs.push_back(state.out2);
+        xs.push_back(state.out);
+        break;
+      case nfa_state::begin:
+        if (at_start)
+          xs.push_back(state.out);
+        break;
+      case nfa_state::end:
+        // Unsatisfied end assertions remain part of the set, so that we can
+        // follow them once the input is exhausted.
+        if (at_end)
+          xs.push_back(state.out);
+        else
+          result.push_back(x);
+        break;
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+int32_t regex_automaton::add(dfa& d, nfa_set xs) const {
+  if (auto i = d.ids.find(xs); i != d.ids.end())
+    return i->second;
+  if (d.states.size() == max_dfa_states) {
+    auto generation = d.generation + 1;
+    d = dfa{};
+    d.generation = generation;
+  }
+  auto is_accept = [&](uint32_t x) {
+    return nfa_[x].kind == nfa_state::accept;
+  };
+  dfa_state state;
+  state.next.fill(-1);
+  state.accepting = std::any_of(xs.begin(), xs.end(), is_accept);
+  auto final = closure(xs, false, true);
+  state.accepting_at_end = std::any_of(final.begin(), final.end(), is_accept);
+  auto id = static_cast<int32_t>(d.states.size());
+  d.ids.emplace(xs, id);
+  state.nfa = std::move(xs);
+  d.states.push_back(std::move(state));
+  return id;
+}
+
+int32_t regex_automaton::step(dfa& d, bool unanchored, int32_t s,
+                              unsigned char c) const {
+  if (auto next = d.states[s].next[c]; next >= 0)
+    return next;
+  nfa_set targets;
+  for (auto x : d.states[s].nfa)
+    if (nfa_[x].kind == nfa_state::byte && nfa_[x].bytes.test(c))
+      targets.push_back(nfa_[x].out);
+  auto xs = closure(std::move(targets), false, false);
+  // Without an anchor, a new match attempt begins at every position.
+  if (unanchored) {
+    xs.insert(xs.end(), restart_.begin(), restart_.end());
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+  }
+  auto generation = d.generation;
+  auto next = add(d, std::move(xs));
+  // Only remember the transition if the cache did not start over.
+  if (generation == d.generation)
+    d.states[s].next[c] = next;
+  return next;
+}
+
+bool regex_automaton::run(dfa& d, bool unanchored, std::string_view str,
+                          bool at_start) const {
+  if (str.empty() && at_start) {
+    auto xs = closure({start_}, true, true);
+    return std::any_of(xs.begin(), xs.end(), [&](uint32_t x) {
+      return nfa_[x].kind == nfa_state::accept;
+    });
+  }
+  auto& start = at_start ? d.start : d.restart;
+  if (start < 0)
+    start = add(d, at_start ? closure({start_}, true, false) : restart_);
+  auto s = start;
+  for (auto c : str) {
+    if (unanchored && d.states[s].accepting)
+      return true;
+    s = step(d, unanchored, s, static_cast<unsigned char>(c));
+    if (!unanchored && d.states[s].nfa.empty())
+      return false;
+  }
+  return d.states[s].accepting_at_end;
+}
+
+} // namespace vast::detail
@@ -0,0 +1,110 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/detail/work_stealing_pool.hpp"
+
+#include "vast/detail/assert.hpp"
+
+namespace vast::detail {
+
+namespace {
+
+/// The pool of the current worker thread, if any.
+thread_local const work_stealing_pool* current_pool = nullptr;
+
+/// The queue index of the current worker thread.
+thread_local size_t current_queue = 0;
+
+} // namespace
+
+work_stealing_pool::work_stealing_pool(size_t size) {
+  VAST_ASSERT(size > 0);
+  queues_.reserve(size);
+  for (size_t i = 0; i < size; ++i)
+    queues_.push_back(std::make_unique<queue>());
+  threads_.reserve(size);
+  for (size_t i = 0; i < size; ++i)
+    threads_.emplace_back([this, i] { run(i); });
+}
+
+work_stealing_pool::~work_stealing_pool() {
+  {
+    std::lock_guard<std::mutex> guard{mtx_};
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& t : threads_)
+    t.join();
+}
+
+void work_stealing_pool::submit(job f) {
+  auto i = current_pool == this ? current_queue
+                                : next_++ % queues_.size();
+  // Count the job before publishing it, because a running worker may take it
+  // and decrement the counter as soon as it is in a queue. Incrementing the
+  // counter under the lock guarantees that no idle thread misses the wakeup
+  // between checking its predicate and going to sleep.
+  {
+    std::lock_guard<std::mutex> guard{mtx_};
+    ++pending_;
+  }
+  {
+    auto& q = *queues_[i];
+    std::lock_guard<std::mutex> guard{q.mtx};
+    q.jobs.push_back(std::move(f));
+  }
+  cv_.notify_one();
+}
+
+bool work_stealing_pool::pop(size_t i, job& f) {
+  auto& q = *queues_[i];
+  std::lock_guard<std::mutex> guard{q.mtx};
+  if (q.jobs.empty())
+    return false;
+  f = std::move(q.jobs.back());
+  q.jobs.pop_back();
+  return true;
+}
+
+bool work_stealing_pool::steal(size_t i, job& f) {
+  for (size_t n = 1; n < queues_.size(); ++n) {
+    auto& q = *queues_[(i + n) % queues_.size()];
+    std::lock_guard<std::mutex> guard{q.mtx};
+    if (!q.jobs.empty()) {
+      f = std::move(q.jobs.front());
+      q.jobs.pop_front();
+      ++steals_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void work_stealing_pool::run(size_t i) {
+  current_pool = this;
+  current_queue = i;
+  for (;;) {
+    job f;
+    if (pop(i, f) || steal(i, f)) {
+      --pending_;
+      f();
+      continue;
+    }
+    std::unique_lock<std::mutex> guard{mtx_};
+    cv_.wait(guard, [&] { return stopping_ || pending_ > 0; });
+    if (stopping_ && pending_ == 0)
+      return;
+  }
+}
+
+} // namespace vast::detail
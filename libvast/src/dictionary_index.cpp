@@ -0,0 +1,169 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/dictionary_index.hpp"
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/detail/overload.hpp"
+#include "vast/error.hpp"
+
+#include <iterator>
+#include <optional>
+#include <regex>
+#include <string_view>
+#include <vector>
+
+namespace vast {
+
+namespace {
+
+/// Checks whether a pattern consists of a literal prefix followed by `.*`.
+/// @returns the prefix of *pattern* if it has this shape.
+std::optional<std::string_view> literal_prefix(std::string_view pattern) {
+  if (pattern.size() < 2 || pattern.substr(pattern.size() - 2) != ".*")
+    return std::nullopt;
+  auto prefix = pattern.substr(0, pattern.size() - 2);
+  if (prefix.find_first_of("\\^$.|?*+()[]{}") != std::string_view::npos)
+    return std::nullopt;
+  return prefix;
+}
+
+} // namespace
+
+dictionary_index::dictionary_index(vast::type t, caf::settings opts)
+  : value_index{std::move(t), std::move(opts)} {
+  // nop
+}
+
+size_t dictionary_index::cardinality() const {
+  return dictionary_.size();
+}
+
+caf::error dictionary_index::serialize(caf::serializer& sink) const {
+  return caf::error::eval([&] { return value_index::serialize(sink); },
+                          [&] { return sink(dictionary_); });
+}
+
+caf::error dictionary_index::deserialize(caf::deserializer& source) {
+  return caf::error::eval([&] { return value_index::deserialize(source); },
+                          [&] { return source(dictionary_); });
+}
+
+bool dictionary_index::append_impl(data_view x, id pos) {
+  auto str = caf::get_if<view<std::string>>(&x);
+  if (!str)
+    return false;
+  auto i = dictionary_.find(*str);
+  if (i == dictionary_.end())
+    i = dictionary_.emplace(std::string{*str}, ewah_bitmap{}).first;
+  auto& bm = i->second;
+  bm.append_bits(false, pos - bm.size());
+  bm.append_bit(true);
+  return true;
+}
+
+template <class Iterator, class Predicate>
+ids dictionary_index::collect(Iterator first, Iterator last, Predicate pred,
+                             bool negate) const {
+  std::vector<const ewah_bitmap*> operands;
+  for (; first != last; ++first)
+    if (pred(first->first))
+      operands.push_back(&first->second);
+  auto result = nary_or(operands.begin(), operands.end());
+  // The bitmaps only extend up to the last occurrence of their value.
+  result.append_bits(false, offset() - result.size());
+  if (negate)
+    result.flip();
+  return result;
+}
+
+caf::expected<ids>
+dictionary_index::lookup_impl(relational_operator op, data_view x) const {
+  auto any_value = [](const std::string&) { return true; };
+  auto container_lookup = [&](auto xs) -> caf::expected<ids> {
+    if (!(op == in || op == not_in))
+      return make_error(ec::unsupported_operator, op);
+    // Every value of the RHS costs a single dictionary lookup.
+    std::vector<const ewah_bitmap*> operands;
+    for (auto y : xs)
+      if (auto str = caf::get_if<view<std::string>>(&y))
+        if (auto i = dictionary_.find(*str); i != dictionary_.end())
+          operands.push_back(&i->second);
+    auto result = nary_or(operands.begin(), operands.end());
+    result.append_bits(false, offset() - result.size());
+    if (op == not_in)
+      result.flip();
+    return ids{std::move(result)};
+  };
+  return caf::visit(
+    detail::overload(
+      [&](auto x) -> caf::expected<ids> {
+        return make_error(ec::type_clash, materialize(x));
+      },
+      [&](view<std::string> str) -> caf::expected<ids> {
+        switch (op) {
+          default:
+            return make_error(ec::unsupported_operator, op);
+          case equal:
+          case not_equal: {
+            auto first = dictionary_.find(str);
+            auto last = first == dictionary_.end() ? first : std::next(first);
+            return collect(first, last, any_value, op == not_equal);
+          }
+          case ni:
+          case not_ni: {
+            auto contains = [&](const std::string& value) {
+              return value.find(str) != std::string::npos;
+            };
+            return collect(dictionary_.begin(), dictionary_.end(), contains,
+                          op == not_ni);
+          }
+        }
+      },
+      [&](view<pattern> pat) -> caf::expected<ids> {
+        if (!(op == match || op == not_match))
+          return make_error(ec::unsupported_operator, op);
+        auto negate = op == not_match;
+        // A pattern of the form `prefix.*` selects a contiguous range of the
+        // dictionary. Because `.` does not match line terminators, values
+        // with a line break after the prefix do not qualify.
+        if (auto prefix = literal_prefix(pat.string())) {
+          auto first = dictionary_.lower_bound(*prefix);
+          auto last = first;
+          while (last != dictionary_.end()
+                 && std::string_view{last->first}.substr(0, prefix->size())
+                      == *prefix)
+            ++last;
+          auto single_line = [&](const std::string& value) {
+            return value.find_first_of("\n\r", prefix->size())
+                   == std::string::npos;
+          };
+          return collect(first, last, single_line, negate);
+        }
+        // Otherwise we test every distinct value once.
+        try {
+          auto matches = [&](const std::string& value) {
+            return pat.match(value);
+          };
+          return collect(dictionary_.begin(), dictionary_.end(), matches,
+                        negate);
+        } catch (const std::regex_error& e) {
+          return make_error(ec::syntax_error, "invalid pattern", e.what());
+        }
+      },
+      [&](view<vector> xs) { return container_lookup(xs); },
+      [&](view<set> xs) { return container_lookup(xs); }),
+    x);
+}
+
+} // namespace vast
@@ -13,8 +13,189 @@
 
 #include "vast/ewah_bitmap.hpp"
 
+#include "vast/detail/assert.hpp"
+#include "vast/detail/block_kernels.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
 namespace vast {
 
+namespace {
+
+using word_type = ewah_bitmap::word_type;
+using block_type = ewah_bitmap::block_type;
+using size_type = ewah_bitmap::size_type;
+
+// Walks an EWAH bitmap as a sequence of full words, grouped into runs of clean
+// words and runs of dirty (literal) words. The final block counts as a literal
+// word whose unused bits are 0. Once exhausted, the cursor yields an infinite
+// run of clean 0-words, which lets us combine bitmaps of different sizes.
+class word_cursor {
+public:
+  explicit word_cursor(const ewah_bitmap& bm) : blocks_{bm.blocks()} {
+    load();
+  }
+
+  /// @returns `true` if the cursor points to a run of clean words.
+  bool clean() const {
+    return num_clean_ > 0;
+  }
+
+  /// @returns the type of the current clean run.
+  /// @pre `clean()`
+  bool fill() const {
+    return fill_;
+  }
+
+  /// @returns the current dirty run.
+  /// @pre `!clean()`
+  const block_type* literals() const {
+    return literals_;
+  }
+
+  /// @returns the number of words remaining in the current run.
+  size_type length() const {
+    return clean() ? num_clean_ : num_literals_;
+  }
+
+  /// Moves the cursor forward by *n* words.
+  /// @pre `n <= length()`
+  void advance(size_type n) {
+    if (clean()) {
+      num_clean_ -= n;
+    } else {
+      literals_ += n;
+      num_literals_ -= n;
+    }
+    load();
+  }
+
+private:
+  void load() {
+    while (num_clean_ == 0 && num_literals_ == 0) {
+      if (next_ + 1 < blocks_.size()) {
+        // A marker, possibly with an empty clean run.
+        auto marker = blocks_[next_];
+        fill_ = word_type::marker_type(marker);
+        num_clean_ = word_type::marker_num_clean(marker);
+        num_literals_ = word_type::marker_num_dirty(marker);
+        literals_ = blocks_.data() + next_ + 1;
+        next_ += num_literals_ + 1;
+      } else if (next_ + 1 == blocks_.size()) {
+        // The last block, which the markers never account for.
+        literals_ = blocks_.data() + next_;
+        num_literals_ = 1;
+        ++next_;
+      } else {
+        fill_ = false;
+        num_clean_ = std::numeric_limits<size_type>::max();
+      }
+    }
+  }
+
+  const ewah_bitmap::block_vector& blocks_;
+  size_type next_ = 0;
+  bool fill_ = false;
+  size_type num_clean_ = 0;
+  const block_type* literals_ = nullptr;
+  size_type num_literals_ = 0;
+};
+
+// Appends full words to a bitmap and truncates the very last one to the
+// number of bits that remain.
+class word_builder {
+public:
+  word_builder(ewah_bitmap& bm, size_type num_bits)
+    : bm_{bm},
+      words_left_{(num_bits + word_type::width - 1) / word_type::width},
+      last_bits_{num_bits - (words_left_ - 1) * word_type::width} {
+    VAST_ASSERT(num_bits > 0);
+  }
+
+  size_type words_left() const {
+    return words_left_;
+  }
+
+  void fill(bool bit, size_type n) {
+    VAST_ASSERT(n <= words_left_);
+    words_left_ -= n;
+    auto bits = n * word_type::width;
+    if (words_left_ == 0)
+      bits -= word_type::width - last_bits_;
+    bm_.append_bits(bit, bits);
+  }
+
+  void literals(const block_type* xs, size_type n) {
+    VAST_ASSERT(n <= words_left_);
+    words_left_ -= n;
+    if (words_left_ > 0) {
+      bm_.append_blocks(xs, n);
+    } else {
+      bm_.append_blocks(xs, n - 1);
+      bm_.append_block(xs[n - 1], last_bits_);
+    }
+  }
+
+private:
+  ewah_bitmap& bm_;
+  size_type words_left_;
+  size_type last_bits_;
+};
+
+using block_kernel = void (*)(const uint64_t*, const uint64_t*, uint64_t*,
+                              size_t);
+
+// Combines two bitmaps run by run. The function `bit` describes the operation
+// on a single pair of bits and `kernel` the same operation on literal runs.
+// All supported operations map 0-bits to 0-bits, which makes padding the
+// shorter operand with 0-words equivalent to the generic `binary_eval`.
+template <class Bit>
+ewah_bitmap merge(const ewah_bitmap& lhs, const ewah_bitmap& rhs, Bit bit,
+                  block_kernel kernel) {
+  static_assert(std::is_same_v<block_type, uint64_t>);
+  ewah_bitmap result;
+  auto num_bits = std::max(lhs.size(), rhs.size());
+  if (num_bits == 0)
+    return result;
+  word_builder builder{result, num_bits};
+  word_cursor l{lhs};
+  word_cursor r{rhs};
+  std::vector<block_type> buffer;
+  while (builder.words_left() > 0) {
+    auto n = std::min({l.length(), r.length(), builder.words_left()});
+    if (l.clean() && r.clean()) {
+      builder.fill(bit(l.fill(), r.fill()), n);
+    } else if (l.clean() || r.clean()) {
+      // With one side clean, the result is either clean as well, or a copy or
+      // the complement of the dirty side.
+      auto& dirty = l.clean() ? r : l;
+      auto zero = l.clean() ? bit(l.fill(), false) : bit(false, r.fill());
+      auto one = l.clean() ? bit(l.fill(), true) : bit(true, r.fill());
+      if (zero == one) {
+        builder.fill(zero, n);
+      } else if (one) {
+        builder.literals(dirty.literals(), n);
+      } else {
+        buffer.resize(n);
+        detail::blocks_not(dirty.literals(), buffer.data(), n);
+        builder.literals(buffer.data(), n);
+      }
+    } else {
+      buffer.resize(n);
+      kernel(l.literals(), r.literals(), buffer.data(), n);
+      builder.literals(buffer.data(), n);
+    }
+    l.advance(n);
+    r.advance(n);
+  }
+  return result;
+}
+
+} // namespace
+
 ewah_bitmap::ewah_bitmap(size_type n, bool bit) {
   append_bits(bit, n);
 }
@@ -31,6 +212,22 @@ const ewah_bitmap::block_vector& ewah_bitmap::blocks() const {
   return blocks_;
 }
 
+ewah_bitmap::size_type ewah_bitmap::cardinality() const {
+  if (blocks_.empty())
+    return 0;
+  auto result = size_type{0};
+  auto last = blocks_.size() - 1;
+  for (auto i = size_type{0}; i < last;) {
+    auto marker = blocks_[i];
+    if (word_type::marker_type(marker))
+      result += word_type::marker_num_clean(marker) * word_type::width;
+    auto num_dirty = word_type::marker_num_dirty(marker);
+    result += detail::blocks_popcount(blocks_.data() + i + 1, num_dirty);
+    i += num_dirty + 1;
+  }
+  return result + word_type::popcount(blocks_.back());
+}
+
 void ewah_bitmap::append_bit(bool bit) {
   auto partial = num_bits_ % word_type::width;
   if (blocks_.empty()) {
@@ -148,6 +345,28 @@ void ewah_bitmap::append_block(block_type value, size_type bits) {
   }
 }
 
+void ewah_bitmap::append_blocks(const block_type* xs, size_type n) {
+  VAST_ASSERT(num_bits_ % word_type::width == 0);
+  for (size_type i = 0; i < n;) {
+    // Clean blocks may coalesce with the last marker, so they take the
+    // regular path.
+    if (blocks_.empty() || word_type::all_or_none(xs[i])) {
+      append_block(xs[i++]);
+      continue;
+    }
+    integrate_last_block();
+    blocks_.push_back(xs[i++]);
+    num_bits_ += word_type::width;
+    // For consecutive dirty blocks, integrating the previous block boils down
+    // to bumping the dirty count.
+    for (; i < n && !word_type::all_or_none(xs[i]); ++i) {
+      bump_dirty_count();
+      blocks_.push_back(xs[i]);
+      num_bits_ += word_type::width;
+    }
+  }
+}
+
 void ewah_bitmap::flip() {
   if (blocks_.empty())
     return;
@@ -240,6 +459,26 @@ bool operator==(const ewah_bitmap& x, const ewah_bitmap& y) {
   return x.blocks_ == y.blocks_ && x.num_bits_ == y.num_bits_;
 }
 
+ewah_bitmap binary_and(const ewah_bitmap& lhs, const ewah_bitmap& rhs) {
+  auto bit = [](bool x, bool y) { return x && y; };
+  return merge(lhs, rhs, bit, detail::blocks_and);
+}
+
+ewah_bitmap binary_or(const ewah_bitmap& lhs, const ewah_bitmap& rhs) {
+  auto bit = [](bool x, bool y) { return x || y; };
+  return merge(lhs, rhs, bit, detail::blocks_or);
+}
+
+ewah_bitmap binary_xor(const ewah_bitmap& lhs, const ewah_bitmap& rhs) {
+  auto bit = [](bool x, bool y) { return x != y; };
+  return merge(lhs, rhs, bit, detail::blocks_xor);
+}
+
+ewah_bitmap binary_nand(const ewah_bitmap& lhs, const ewah_bitmap& rhs) {
+  auto bit = [](bool x, bool y) { return x && !y; };
+  return merge(lhs, rhs, bit, detail::blocks_and_not);
+}
+
 ewah_bitmap_range::ewah_bitmap_range(const ewah_bitmap& bm)
   : bm_{&bm} {
   if (!bm_->empty())
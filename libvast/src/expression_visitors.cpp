@@ -628,14 +628,92 @@ bool evaluate_at(const table_slice& slice, size_t row, const expression& expr) {
   return caf::visit(table_slice_row_evaluator{slice, row}, expr);
 }
 
-ids evaluate(const table_slice& slice, const expression& expr) {
-  ids result;
-  result.append(false, slice.offset());
-  for (size_t row = 0; row != slice.rows(); ++row)
-    result.append_bit(evaluate_at(slice, row, expr));
+table_slice_column_evaluator::table_slice_column_evaluator(
+  const table_slice& slice)
+  : slice_(slice) {
+  // nop
+}
+
+ids table_slice_column_evaluator::operator()(caf::none_t) {
+  return none();
+}
+
+ids table_slice_column_evaluator::operator()(const conjunction& c) {
+  VAST_ASSERT(!c.empty());
+  auto result = caf::visit(*this, c[0]);
+  for (size_t i = 1; i < c.size() && any(result); ++i)
+    result &= caf::visit(*this, c[i]);
+  return result;
+}
+
+ids table_slice_column_evaluator::operator()(const disjunction& d) {
+  VAST_ASSERT(!d.empty());
+  auto result = caf::visit(*this, d[0]);
+  for (size_t i = 1; i < d.size() && rank(result) < slice_.rows(); ++i)
+    result |= caf::visit(*this, d[i]);
+  return result;
+}
+
+ids table_slice_column_evaluator::operator()(const negation& n) {
+  return all() - caf::visit(*this, n.expr());
+}
+
+ids table_slice_column_evaluator::operator()(const predicate& p) {
+  op_ = p.op;
+  return caf::visit(*this, p.lhs, p.rhs);
+}
+
+ids table_slice_column_evaluator::operator()(const attribute_extractor& e,
+                                             const data& d) {
+  if (e.attr == atom::type_v)
+    return evaluate(slice_.layout().name(), op_, d) ? all() : none();
+  if (e.attr == atom::timestamp_v) {
+    auto pred = [](auto& x) {
+      return caf::holds_alternative<time_type>(x.type)
+             && has_attribute(x.type, "timestamp");
+    };
+    auto& fs = slice_.layout().fields;
+    auto i = std::find_if(fs.begin(), fs.end(), pred);
+    if (i == fs.end())
+      return none();
+    auto pos = static_cast<size_t>(std::distance(fs.begin(), i));
+    return slice_.evaluate_column(pos, op_, d);
+  }
+  return none();
+}
+
+ids table_slice_column_evaluator::operator()(const type_extractor&,
+                                             const data&) {
+  die("type extractor should have been resolved at this point");
+}
+
+ids table_slice_column_evaluator::operator()(const key_extractor&,
+                                             const data&) {
+  die("key extractor should have been resolved at this point");
+}
+
+ids table_slice_column_evaluator::operator()(const data_extractor& e,
+                                             const data& d) {
+  if (e.type != slice_.layout())
+    return none();
+  VAST_ASSERT(e.offset.size() == 1);
+  return slice_.evaluate_column(e.offset[0], op_, d);
+}
+
+ids table_slice_column_evaluator::none() const {
+  return ids(slice_.offset() + slice_.rows(), false);
+}
+
+ids table_slice_column_evaluator::all() const {
+  auto result = ids(slice_.offset(), false);
+  result.append_bits(true, slice_.rows());
   return result;
 }
 
+ids evaluate(const table_slice& slice, const expression& expr) {
+  return caf::visit(table_slice_column_evaluator{slice}, expr);
+}
+
 matcher::matcher(const type& t) : type_{t} {
   // nop
 }
@@ -319,6 +319,14 @@ bool file::write(const void* source, size_t bytes, size_t* put) {
   return is_open_ && detail::write(handle_, source, bytes, put);
 }
 
+bool file::sync() {
+#ifdef VAST_POSIX
+  return is_open_ && ::fsync(handle_) == 0;
+#else
+  return false;
+#endif // VAST_POSIX
+}
+
 bool file::seek(size_t bytes) {
   if (!is_open_ || seek_failed_)
     return false;
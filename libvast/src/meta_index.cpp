@@ -14,44 +14,64 @@
 #include "vast/meta_index.hpp"
 
 #include "vast/data.hpp"
+#include "vast/defaults.hpp"
 #include "vast/detail/overload.hpp"
 #include "vast/detail/set_operations.hpp"
 #include "vast/detail/string.hpp"
+#include "vast/detail/thread_pool.hpp"
 #include "vast/expression.hpp"
 #include "vast/fwd.hpp"
 #include "vast/logger.hpp"
 #include "vast/synopsis_factory.hpp"
 #include "vast/table_slice.hpp"
+#include "vast/table_slice_column.hpp"
 #include "vast/time.hpp"
+#include "vast/time_synopsis.hpp"
 
 #include <caf/binary_deserializer.hpp>
 #include <caf/binary_serializer.hpp>
 
+#include <algorithm>
+#include <future>
+#include <thread>
+
 namespace vast {
 
-void meta_index::add(const uuid& partition, const table_slice& slice) {
+namespace {
+
+/// Runs the chunks of parallel lookups. A shared pool spares every lookup the
+/// cost of creating threads and bounds the number of threads for concurrent
+/// lookups. The calling thread probes a chunk on its own, hence one thread
+/// less than the hardware offers.
+detail::thread_pool& probe_pool() {
+  static detail::thread_pool pool{
+    std::max(1u, std::thread::hardware_concurrency()) - 1};
+  return pool;
+}
+
+} // namespace
+
+void meta_index::add(const uuid& partition, const table_slice_ptr& slice) {
   auto make_synopsis = [&](const record_field& field) -> synopsis_ptr {
     return has_skip_attribute(field.type)
              ? nullptr
              : factory<synopsis>::make(field.type, synopsis_options_);
   };
   auto& part_syn = synopses_[partition];
-  for (size_t col = 0; col < slice.columns(); ++col) {
+  auto& layout = slice->layout();
+  for (size_t col = 0; col < slice->columns(); ++col) {
     // Locate the relevant synopsis.
-    auto& field = slice.layout().fields[col];
-    auto key = qualified_record_field{slice.layout().name(), field};
+    auto& field = layout.fields[col];
+    auto key = qualified_record_field{layout.name(), field};
     auto it = part_syn.find(key);
-    if (it == part_syn.end())
+    if (it == part_syn.end()) {
       // Attempt to create a synopsis if we have never seen this key before.
-      it = part_syn.emplace(std::move(key), make_synopsis(field)).first;
-    // If there exists a synopsis for a field, add the entire column.
-    if (auto& syn = it->second) {
-      for (size_t row = 0; row < slice.rows(); ++row) {
-        auto view = slice.at(row, col);
-        if (!caf::holds_alternative<caf::none_t>(view))
-          syn->add(std::move(view));
-      }
+      it = part_syn.emplace(key, make_synopsis(field)).first;
+      catalog_[std::move(key)].emplace_back(partition, it->second);
     }
+    // If there exists a synopsis for a field, add the entire column.
+    if (auto& syn = it->second)
+      syn->add(table_slice_column{slice, col});
   }
 }
 
@@ -119,25 +139,18 @@ std::vector<uuid> meta_index::lookup(const expression& expr) const {
       auto search = [&](auto match) {
         VAST_ASSERT(caf::holds_alternative<data>(x.rhs));
         auto& rhs = caf::get<data>(x.rhs);
-        result_type result;
-        auto found_matching_synopsis = false;
-        for (auto& [part_id, part_syn] : synopses_) {
-          VAST_DEBUG(this, "checks", part_id, "for predicate", x);
-          for (auto& [field, syn] : part_syn) {
-            if (syn && match(field)) {
-              found_matching_synopsis = true;
-              auto opt = syn->lookup(x.op, make_view(rhs));
-              if (!opt || *opt) {
-                VAST_DEBUG(this, "selects", part_id, "at predicate", x);
-                result.push_back(part_id);
-                break;
-              }
-            }
-          }
-        }
-        // Re-establish potentially violated invariant.
-        std::sort(result.begin(), result.end());
-        return found_matching_synopsis ? result : all_partitions();
+        // Resolve the matching columns once for all partitions.
+        std::vector<const catalog_entry*> entries;
+        for (auto& [field, column] : catalog_)
+          if (match(field))
+            for (auto& entry : column)
+              if (entry.second)
+                entries.push_back(&entry);
+        if (entries.empty())
+          return all_partitions();
+        VAST_DEBUG(this, "checks", entries.size(), "synopses for predicate",
+                   x);
+        return probe(entries, x.op, rhs);
       };
       auto extract_expr = detail::overload(
         [&](const attribute_extractor& lhs, const data& d) -> result_type {
@@ -150,21 +163,20 @@ std::vector<uuid> meta_index::lookup(const expression& expr) const {
             // We don't have to look into the synopses for type queries, just
             // at the layout names.
             result_type result;
-            for (auto& [part_id, part_syn] : synopses_) {
-              for (auto& pair : part_syn) {
-                // TODO: provide an overload for view of evaluate() so that
-                // we can use string_view here. Fortunately type names are
-                // short, so we're probably not hitting the allocator due to
-                // SSO.
-                auto type_name = data{pair.first.layout_name};
-                if (evaluate(type_name, x.op, d)) {
-                  result.push_back(part_id);
-                  break;
-                }
-              }
+            for (auto& [field, column] : catalog_) {
+              // TODO: provide an overload for view of evaluate() so that
+              // we can use string_view here. Fortunately type names are
+              // short, so we're probably not hitting the allocator due to
+              // SSO.
+              auto type_name = data{field.layout_name};
+              if (evaluate(type_name, x.op, d))
+                for (auto& entry : column)
+                  result.push_back(entry.first);
             }
             // Re-establish potentially violated invariant.
             std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()),
+                         result.end());
             return result;
           }
           VAST_WARNING(this, "cannot process attribute extractor:", lhs.attr);
@@ -194,10 +206,99 @@ std::vector<uuid> meta_index::lookup(const expression& expr) const {
   return caf::visit(f, expr);
 }
 
+caf::optional<meta_index::time_bounds>
+meta_index::bounds(const uuid& partition) const {
+  auto i = synopses_.find(partition);
+  if (i == synopses_.end())
+    return caf::none;
+  auto result = time_bounds{time::max(), time::min()};
+  for (auto& [field, syn] : i->second)
+    if (has_attribute(field.type, "timestamp"))
+      if (auto ts = dynamic_cast<const time_synopsis*>(syn.get())) {
+        result.first = std::min(result.first, ts->min());
+        result.last = std::max(result.last, ts->max());
+      }
+  // A synopsis without any values has inverted bounds.
+  if (result.first > result.last)
+    return caf::none;
+  return result;
+}
+
 caf::settings& meta_index::factory_options() {
   return synopsis_options_;
 }
 
+std::vector<uuid> meta_index::partitions() const {
+  std::vector<uuid> result;
+  result.reserve(synopses_.size());
+  for (auto& kvp : synopses_)
+    result.push_back(kvp.first);
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+void meta_index::erase(const uuid& partition) {
+  if (synopses_.erase(partition) > 0)
+    rebuild_catalog();
+}
+
+void meta_index::merge(const meta_index& other) {
+  for (auto& [part_id, part_syn] : other.synopses_)
+    synopses_.insert_or_assign(part_id, part_syn);
+  rebuild_catalog();
+}
+
+void meta_index::rebuild_catalog() {
+  catalog_.clear();
+  for (auto& [part_id, part_syn] : synopses_)
+    for (auto& [field, syn] : part_syn)
+      catalog_[field].emplace_back(part_id, syn);
+}
+
+std::vector<uuid>
+meta_index::probe(const std::vector<const catalog_entry*>& entries,
+                  relational_operator op, const data& rhs) const {
+  auto probe_range = [&](size_t first, size_t last) {
+    std::vector<uuid> result;
+    auto rhs_view = make_view(rhs);
+    for (auto i = first; i < last; ++i) {
+      auto& [part_id, syn] = *entries[i];
+      auto opt = syn->lookup(op, rhs_view);
+      if (!opt || *opt)
+        result.push_back(part_id);
+    }
+    return result;
+  };
+  namespace sd = defaults::system;
+  auto num_threads
+    = std::min(size_t{std::max(1u, std::thread::hardware_concurrency())},
+               entries.size() / sd::meta_index_parallel_lookup_threshold);
+  std::vector<uuid> result;
+  if (num_threads <= 1) {
+    result = probe_range(0, entries.size());
+  } else {
+    // Every synopsis occurs at most once in `entries`, so the chunks touch
+    // disjoint sets of synopses and can be probed independently.
+    auto chunk_size = (entries.size() + num_threads - 1) / num_threads;
+    std::vector<std::future<std::vector<uuid>>> futures;
+    for (size_t first = chunk_size; first < entries.size();
+         first += chunk_size) {
+      auto last = std::min(first + chunk_size, entries.size());
+      futures.push_back(probe_pool().submit(
+        [&probe_range, first, last] { return probe_range(first, last); }));
+    }
+    result = probe_range(0, std::min(chunk_size, entries.size()));
+    for (auto& future : futures) {
+      auto xs = future.get();
+      result.insert(result.end(), xs.begin(), xs.end());
+    }
+  }
+  // A partition may qualify through multiple columns.
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
 caf::expected<flatbuffers::Offset<fbs::MetaIndex>>
 pack(flatbuffers::FlatBufferBuilder& builder, const meta_index& x) {
   std::vector<char> buffer;
@@ -13,6 +13,7 @@
 
 #include "vast/msgpack_table_slice.hpp"
 
+#include "vast/column_statistics.hpp"
 #include "vast/msgpack.hpp"
 
 #include <caf/binary_deserializer.hpp>
@@ -25,6 +26,7 @@
 #include <vast/detail/narrow.hpp>
 #include <vast/detail/overload.hpp>
 #include <vast/detail/type_traits.hpp>
+#include <vast/ids.hpp>
 #include <vast/logger.hpp>
 #include <vast/value_index.hpp>
 
@@ -316,8 +318,8 @@ msgpack_map_view::value_type msgpack_map_view::at(size_type i) const {
 
 // There are only small gains we can get here from doing this manually since
 // MsgPack is a row-oriented format.
-void msgpack_table_slice::append_column_to_index(size_type col,
-                                                 value_index& idx) const {
+void msgpack_table_slice::append_column_to_index(
+  size_type col, value_index& idx, column_statistics* stats) const {
   for (size_t row = 0; row < rows(); ++row) {
     auto row_offset = offset_table_[row];
     auto xs = msgpack::overlay{buffer_.subspan(row_offset)};
@@ -327,9 +329,50 @@ void msgpack_table_slice::append_column_to_index(size_type col,
     }
     auto x = decode(xs, layout().fields[col].type);
     idx.append(x, offset() + row);
+    if (stats != nullptr)
+      stats->add(x);
   }
 }
 
+void msgpack_table_slice::for_each_in_column(
+  size_type col, const std::function<void(data_view)>& f) const {
+  VAST_ASSERT(col < columns());
+  auto& fields = layout().fields;
+  for (size_t row = 0; row < rows(); ++row) {
+    auto xs = msgpack::overlay{buffer_.subspan(offset_table_[row])};
+    for (size_t i = 0; i < col; ++i) {
+      auto n = skip(xs, fields[i].type);
+      VAST_ASSERT(n > 0);
+    }
+    auto x = decode(xs, fields[col].type);
+    if (!caf::holds_alternative<caf::none_t>(x))
+      f(std::move(x));
+  }
+}
+
+// Since MsgPack is row-oriented, evaluating a column still has to skip to the
+// column in every row. But we avoid the virtual dispatch of `at` and decode
+// the value only once per row.
+ids msgpack_table_slice::evaluate_column(size_type col, relational_operator op,
+                                         const data& rhs) const {
+  VAST_ASSERT(col < columns());
+  auto& fields = layout().fields;
+  auto& t = fields[col].type;
+  auto rhs_view = make_data_view(rhs);
+  ids result;
+  result.append_bits(false, offset());
+  for (size_t row = 0; row < rows(); ++row) {
+    auto xs = msgpack::overlay{buffer_.subspan(offset_table_[row])};
+    for (size_t i = 0; i < col; ++i) {
+      auto n = skip(xs, fields[i].type);
+      VAST_ASSERT(n > 0);
+    }
+    auto x = to_canonical(t, decode(xs, t));
+    result.append_bit(evaluate_view(x, op, rhs_view));
+  }
+  return result;
+}
+
 caf::atom_value msgpack_table_slice::implementation_id() const noexcept {
   return class_id;
 }
@@ -11,10 +11,9 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
-#include <regex>
-
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/pattern.hpp"
+#include "vast/detail/regex_automaton.hpp"
 #include "vast/json.hpp"
 #include "vast/pattern.hpp"
 
@@ -22,21 +21,39 @@ namespace vast {
 
 pattern pattern::glob(std::string_view str) {
   std::string rx;
-  std::regex_replace(std::back_inserter(rx), str.begin(), str.end(),
-                     std::regex("\\."), "\\.");
-  rx = std::regex_replace(rx, std::regex("\\*"), ".*");
-  return pattern{std::regex_replace(rx, std::regex("\\?"), ".")};
+  rx.reserve(str.size());
+  for (auto c : str) {
+    if (c == '.')
+      rx += "\\.";
+    else if (c == '*')
+      rx += ".*";
+    else if (c == '?')
+      rx += '.';
+    else
+      rx += c;
+  }
+  return pattern{std::move(rx)};
 }
 
 pattern::pattern(std::string str) : str_(std::move(str)) {
+  compile();
 }
 
 bool pattern::match(std::string_view str) const {
-  return std::regex_match(str.begin(), str.end(), std::regex{str_});
+  // A default-constructed pattern is empty and only matches the empty string.
+  if (!automaton_)
+    return str.empty();
+  return automaton_->match(str);
 }
 
 bool pattern::search(std::string_view str) const {
-  return std::regex_search(str.begin(), str.end(), std::regex{str_});
+  if (!automaton_)
+    return true;
+  return automaton_->search(str);
+}
+
+void pattern::compile() {
+  automaton_ = std::make_shared<const detail::regex_automaton>(str_);
 }
 
 const std::string& pattern::string() const {
@@ -49,6 +66,7 @@ pattern& pattern::operator+=(const pattern& other) {
 
 pattern& pattern::operator+=(std::string_view other) {
   str_ += other;
+  compile();
   return *this;
 }
 
@@ -61,6 +79,7 @@ pattern& pattern::operator|=(std::string_view other) {
   str_ += ")|(";
   str_.append(other.begin(), other.end());
   str_ += ')';
+  compile();
   return *this;
 }
 
@@ -73,6 +92,7 @@ pattern& pattern::operator&=(std::string_view other) {
   str_ += ")(";
   str_.append(other.begin(), other.end());
   str_ += ')';
+  compile();
   return *this;
 }
 
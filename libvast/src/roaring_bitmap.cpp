@@ -0,0 +1,669 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/roaring_bitmap.hpp"
+
+#include "vast/detail/assert.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace vast {
+
+namespace {
+
+using block_type = roaring_bitmap::block_type;
+using container = roaring_bitmap::container;
+using container_kind = roaring_bitmap::container_kind;
+using size_type = roaring_bitmap::size_type;
+using word_type = roaring_bitmap::word_type;
+
+constexpr auto container_bits = roaring_bitmap::container_bits;
+constexpr auto container_blocks = roaring_bitmap::container_blocks;
+constexpr auto max_array_cardinality = roaring_bitmap::max_array_cardinality;
+
+/// The size of a bitset container in units of 16-bit values. Array and run
+/// containers that would grow beyond this size are converted to bitsets.
+constexpr size_t bitset_size = container_blocks * sizeof(block_type) / 2;
+
+using block_vector = std::vector<block_type>;
+
+/// Sets the bits in *[first, last)* of a bitset.
+void set_range(block_type* xs, uint32_t first, uint32_t last) {
+  if (first == last)
+    return;
+  auto i = first / word_type::width;
+  auto j = (last - 1) / word_type::width;
+  auto lo = word_type::all << (first % word_type::width);
+  auto hi = word_type::lsb_fill((last - 1) % word_type::width + 1);
+  if (i == j) {
+    xs[i] |= lo & hi;
+    return;
+  }
+  xs[i] |= lo;
+  std::fill(xs + i + 1, xs + j, word_type::all);
+  xs[j] |= hi;
+}
+
+/// Writes the 1-bits of a container into a bitset of `container_blocks`
+/// blocks.
+void materialize(const container& x, block_type* xs) {
+  if (x.kind == container_kind::bitset) {
+    std::copy(x.blocks.begin(), x.blocks.end(), xs);
+    return;
+  }
+  std::fill(xs, xs + container_blocks, word_type::none);
+  if (x.kind == container_kind::array) {
+    for (auto v : x.values)
+      xs[v / word_type::width] |= word_type::mask(v % word_type::width);
+  } else {
+    for (size_t i = 0; i < x.values.size(); i += 2)
+      set_range(xs, x.values[i], uint32_t{x.values[i + 1]} + 1);
+  }
+}
+
+/// Counts the runs of 1-bits in a bitset.
+size_t count_runs(const block_type* xs) {
+  size_t result = 0;
+  block_type carry = 0;
+  for (size_t i = 0; i < container_blocks; ++i) {
+    // A run starts at every 1-bit whose predecessor is a 0-bit.
+    result += word_type::popcount(xs[i] & ~((xs[i] << 1) | carry));
+    carry = xs[i] >> (word_type::width - 1);
+  }
+  return result;
+}
+
+size_t count_runs(const container& x) {
+  switch (x.kind) {
+    case container_kind::array: {
+      size_t result = x.values.empty() ? 0 : 1;
+      for (size_t i = 1; i < x.values.size(); ++i)
+        if (x.values[i] != x.values[i - 1] + 1)
+          ++result;
+      return result;
+    }
+    case container_kind::bitset:
+      return count_runs(x.blocks.data());
+    case container_kind::run:
+      break;
+  }
+  return x.values.size() / 2;
+}
+
+/// Picks the most compact representation for a container.
+container_kind best_kind(uint32_t cardinality, size_t runs) {
+  auto run_size = 2 * runs;
+  if (run_size < cardinality && run_size < bitset_size)
+    return container_kind::run;
+  if (cardinality <= max_array_cardinality)
+    return container_kind::array;
+  return container_kind::bitset;
+}
+
+/// Replaces the representation of a container with one of the given kind.
+/// @pre `x.cardinality` matches the number of 1-bits in *xs*.
+void assign(container& x, const block_type* xs, container_kind kind) {
+  x.kind = kind;
+  x.values.clear();
+  x.blocks.clear();
+  switch (kind) {
+    case container_kind::array: {
+      x.values.reserve(x.cardinality);
+      for (size_t i = 0; i < container_blocks; ++i)
+        for (auto b = xs[i]; b != 0; b &= b - 1) {
+          auto v = i * word_type::width + word_type::count_trailing_zeros(b);
+          x.values.push_back(static_cast<uint16_t>(v));
+        }
+      break;
+    }
+    case container_kind::bitset: {
+      x.blocks.assign(xs, xs + container_blocks);
+      break;
+    }
+    case container_kind::run: {
+      auto first = uint32_t{0};
+      auto in_run = false;
+      auto toggle = [&](uint32_t i, bool bit) {
+        if (bit && !in_run) {
+          first = i;
+          in_run = true;
+        } else if (!bit && in_run) {
+          x.values.push_back(static_cast<uint16_t>(first));
+          x.values.push_back(static_cast<uint16_t>(i - 1));
+          in_run = false;
+        }
+      };
+      for (uint32_t i = 0; i < container_blocks; ++i) {
+        auto base = i * static_cast<uint32_t>(word_type::width);
+        auto b = xs[i];
+        if (word_type::all_or_none(b))
+          toggle(base, b != 0);
+        else
+          for (uint32_t j = 0; j < word_type::width; ++j)
+            toggle(base + j, word_type::test(b, j));
+      }
+      toggle(container_bits, false);
+      break;
+    }
+  }
+}
+
+/// Creates a container from a bitset, picking the most compact
+/// representation. The result is empty if no bit in *xs* is set.
+container make_container(size_type key, const block_type* xs) {
+  container result;
+  result.key = key;
+  for (size_t i = 0; i < container_blocks; ++i)
+    result.cardinality += word_type::popcount(xs[i]);
+  if (result.cardinality > 0)
+    assign(result, xs, best_kind(result.cardinality, count_runs(xs)));
+  return result;
+}
+
+/// Converts a container into another representation.
+void convert(container& x, container_kind kind) {
+  if (x.kind == kind)
+    return;
+  block_vector xs(container_blocks);
+  materialize(x, xs.data());
+  assign(x, xs.data(), kind);
+}
+
+/// Converts a container into its most compact representation.
+void optimize(container& x) {
+  convert(x, best_kind(x.cardinality, count_runs(x)));
+}
+
+/// Checks whether a container contains a given offset.
+bool contains(const container& x, uint16_t v) {
+  switch (x.kind) {
+    case container_kind::array:
+      return std::binary_search(x.values.begin(), x.values.end(), v);
+    case container_kind::bitset:
+      return word_type::test(x.blocks[v / word_type::width],
+                             v % word_type::width);
+    case container_kind::run:
+      break;
+  }
+  // Find the first run that starts after *v*; its predecessor is the only
+  // run that may contain *v*.
+  size_t lo = 0;
+  size_t hi = x.values.size() / 2;
+  while (lo < hi) {
+    auto mid = lo + (hi - lo) / 2;
+    if (x.values[2 * mid] <= v)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo > 0 && v <= x.values[2 * (lo - 1) + 1];
+}
+
+/// Counts the 1-bits of a container in *[0, v]*.
+uint32_t count_until(const container& x, uint16_t v) {
+  switch (x.kind) {
+    case container_kind::array: {
+      auto i = std::upper_bound(x.values.begin(), x.values.end(), v);
+      return static_cast<uint32_t>(i - x.values.begin());
+    }
+    case container_kind::bitset: {
+      auto result = uint32_t{0};
+      auto last = v / word_type::width;
+      for (size_t i = 0; i < last; ++i)
+        result += word_type::popcount(x.blocks[i]);
+      auto mask = word_type::lsb_fill(v % word_type::width + 1);
+      return result + word_type::popcount(x.blocks[last] & mask);
+    }
+    case container_kind::run:
+      break;
+  }
+  auto result = uint32_t{0};
+  for (size_t i = 0; i < x.values.size() && x.values[i] <= v; i += 2)
+    result += std::min(x.values[i + 1], v) - x.values[i] + 1;
+  return result;
+}
+
+/// Appends the 1-bits in *[first, last)* to a container.
+/// @pre `first < last` and all existing 1-bits are less than *first*.
+void append_run(container& x, uint32_t first, uint32_t last) {
+  VAST_ASSERT(first < last && last <= container_bits);
+  switch (x.kind) {
+    case container_kind::array: {
+      if (last - first == 1 && x.cardinality < max_array_cardinality) {
+        x.values.push_back(static_cast<uint16_t>(first));
+        break;
+      }
+      auto runs = count_runs(x) + 1;
+      convert(x, 2 * runs <= bitset_size ? container_kind::run
+                                         : container_kind::bitset);
+      append_run(x, first, last);
+      return;
+    }
+    case container_kind::bitset: {
+      set_range(x.blocks.data(), first, last);
+      break;
+    }
+    case container_kind::run: {
+      if (!x.values.empty() && x.values.back() + 1u == first) {
+        x.values.back() = static_cast<uint16_t>(last - 1);
+      } else if (x.values.size() + 2 <= bitset_size) {
+        x.values.push_back(static_cast<uint16_t>(first));
+        x.values.push_back(static_cast<uint16_t>(last - 1));
+      } else {
+        convert(x, container_kind::bitset);
+        append_run(x, first, last);
+        return;
+      }
+      break;
+    }
+  }
+  x.cardinality += last - first;
+}
+
+/// Combines two containers with the same key block by block.
+template <class Operation>
+container combine(const container& x, const container& y, Operation op) {
+  VAST_ASSERT(x.key == y.key);
+  block_vector xs(container_blocks);
+  block_vector ys(container_blocks);
+  materialize(x, xs.data());
+  materialize(y, ys.data());
+  for (size_t i = 0; i < container_blocks; ++i)
+    xs[i] = op(xs[i], ys[i]);
+  return make_container(x.key, xs.data());
+}
+
+/// Combines two array containers with a set algorithm that writes its result
+/// to an output iterator.
+template <class Algorithm>
+container combine_arrays(const container& x, const container& y,
+                         Algorithm algo) {
+  VAST_ASSERT(x.kind == container_kind::array);
+  VAST_ASSERT(y.kind == container_kind::array);
+  container result;
+  result.key = x.key;
+  algo(x.values.begin(), x.values.end(), y.values.begin(), y.values.end(),
+       std::back_inserter(result.values));
+  result.cardinality = static_cast<uint32_t>(result.values.size());
+  return result;
+}
+
+/// Keeps the offsets of an array container for which membership in another
+/// container equals *bit*.
+container filter(const container& x, const container& y, bool bit) {
+  VAST_ASSERT(x.kind == container_kind::array);
+  container result;
+  result.key = x.key;
+  for (auto v : x.values)
+    if (contains(y, v) == bit)
+      result.values.push_back(v);
+  result.cardinality = static_cast<uint32_t>(result.values.size());
+  return result;
+}
+
+bool is_array(const container& x) {
+  return x.kind == container_kind::array;
+}
+
+/// Locates the first container with a key not less than *key*.
+auto find_container(const roaring_bitmap::container_vector& xs,
+                    size_type key) {
+  auto cmp = [](const container& x, size_type k) { return x.key < k; };
+  return std::lower_bound(xs.begin(), xs.end(), key, cmp);
+}
+
+} // namespace
+
+bool operator==(const roaring_bitmap::container& x,
+                const roaring_bitmap::container& y) {
+  if (x.key != y.key || x.cardinality != y.cardinality)
+    return false;
+  if (x.kind == y.kind)
+    return x.values == y.values && x.blocks == y.blocks;
+  block_vector xs(container_blocks);
+  block_vector ys(container_blocks);
+  materialize(x, xs.data());
+  materialize(y, ys.data());
+  return xs == ys;
+}
+
+roaring_bitmap::roaring_bitmap(size_type n, bool bit) {
+  append_bits(bit, n);
+}
+
+bool roaring_bitmap::empty() const {
+  return num_bits_ == 0;
+}
+
+roaring_bitmap::size_type roaring_bitmap::size() const {
+  return num_bits_;
+}
+
+const roaring_bitmap::container_vector& roaring_bitmap::containers() const {
+  return containers_;
+}
+
+roaring_bitmap::size_type roaring_bitmap::cardinality() const {
+  auto result = size_type{0};
+  for (auto& x : containers_)
+    result += x.cardinality;
+  return result;
+}
+
+roaring_bitmap::size_type roaring_bitmap::cardinality(size_type i) const {
+  VAST_ASSERT(i < num_bits_);
+  auto key = i / container_bits;
+  auto result = size_type{0};
+  for (auto& x : containers_) {
+    if (x.key > key)
+      break;
+    if (x.key < key)
+      result += x.cardinality;
+    else
+      result += count_until(x, static_cast<uint16_t>(i % container_bits));
+  }
+  return result;
+}
+
+bool roaring_bitmap::operator[](size_type i) const {
+  VAST_ASSERT(i < num_bits_);
+  auto key = i / container_bits;
+  auto x = find_container(containers_, key);
+  return x != containers_.end() && x->key == key
+         && contains(*x, static_cast<uint16_t>(i % container_bits));
+}
+
+void roaring_bitmap::append_bit(bool bit) {
+  append_bits(bit, 1);
+}
+
+void roaring_bitmap::append_bits(bool bit, size_type n) {
+  VAST_ASSERT(max_size - num_bits_ >= n);
+  if (bit) {
+    auto pos = num_bits_;
+    auto remaining = n;
+    while (remaining > 0) {
+      auto offset = pos % container_bits;
+      auto k = std::min(remaining, container_bits - offset);
+      append_run(tail(pos / container_bits), static_cast<uint32_t>(offset),
+                 static_cast<uint32_t>(offset + k));
+      pos += k;
+      remaining -= k;
+    }
+  }
+  num_bits_ += n;
+}
+
+void roaring_bitmap::append_block(block_type bits, size_type n) {
+  VAST_ASSERT(n <= word_type::width);
+  VAST_ASSERT(max_size - num_bits_ >= n);
+  if (n < word_type::width)
+    bits &= word_type::lsb_mask(n);
+  for (; bits != 0; bits &= bits - 1) {
+    auto pos = num_bits_ + word_type::count_trailing_zeros(bits);
+    auto offset = static_cast<uint32_t>(pos % container_bits);
+    append_run(tail(pos / container_bits), offset, offset + 1);
+  }
+  num_bits_ += n;
+}
+
+void roaring_bitmap::flip() {
+  if (num_bits_ == 0)
+    return;
+  container_vector result;
+  block_vector xs(container_blocks);
+  auto last_key = (num_bits_ - 1) / container_bits;
+  auto x = containers_.begin();
+  for (size_type key = 0; key <= last_key; ++key) {
+    // The last chunk may be partial.
+    auto n = key == last_key ? num_bits_ - key * container_bits
+                             : container_bits;
+    if (x == containers_.end() || x->key != key) {
+      auto& full = result.emplace_back();
+      full.key = key;
+      full.cardinality = static_cast<uint32_t>(n);
+      full.kind = container_kind::run;
+      full.values = {0, static_cast<uint16_t>(n - 1)};
+      continue;
+    }
+    materialize(*x++, xs.data());
+    for (auto& block : xs)
+      block = ~block;
+    if (n < container_bits) {
+      auto i = n / word_type::width;
+      if (n % word_type::width != 0)
+        xs[i++] &= word_type::lsb_mask(n % word_type::width);
+      std::fill(xs.begin() + i, xs.end(), word_type::none);
+    }
+    auto y = make_container(key, xs.data());
+    if (y.cardinality > 0)
+      result.push_back(std::move(y));
+  }
+  containers_ = std::move(result);
+}
+
+roaring_bitmap& roaring_bitmap::operator&=(const roaring_bitmap& other) {
+  *this = binary_and(*this, other);
+  return *this;
+}
+
+roaring_bitmap& roaring_bitmap::operator|=(const roaring_bitmap& other) {
+  *this = binary_or(*this, other);
+  return *this;
+}
+
+roaring_bitmap& roaring_bitmap::operator^=(const roaring_bitmap& other) {
+  *this = binary_xor(*this, other);
+  return *this;
+}
+
+roaring_bitmap& roaring_bitmap::operator-=(const roaring_bitmap& other) {
+  *this = binary_nand(*this, other);
+  return *this;
+}
+
+bool operator==(const roaring_bitmap& x, const roaring_bitmap& y) {
+  return x.num_bits_ == y.num_bits_ && x.containers_ == y.containers_;
+}
+
+roaring_bitmap::container& roaring_bitmap::tail(size_type key) {
+  if (containers_.empty() || containers_.back().key != key) {
+    VAST_ASSERT(containers_.empty() || containers_.back().key < key);
+    // The previous container is complete, so we can settle its
+    // representation.
+    if (!containers_.empty())
+      optimize(containers_.back());
+    containers_.emplace_back().key = key;
+  }
+  return containers_.back();
+}
+
+template <bool KeepLhs, bool KeepRhs, class Combine>
+roaring_bitmap roaring_bitmap::merge(const roaring_bitmap& lhs,
+                                     const roaring_bitmap& rhs, Combine f) {
+  roaring_bitmap result;
+  result.num_bits_ = std::max(lhs.num_bits_, rhs.num_bits_);
+  auto& out = result.containers_;
+  auto l = lhs.containers_.begin();
+  auto l_end = lhs.containers_.end();
+  auto r = rhs.containers_.begin();
+  auto r_end = rhs.containers_.end();
+  while (l != l_end && r != r_end) {
+    if (l->key < r->key) {
+      if constexpr (KeepLhs)
+        out.push_back(*l);
+      ++l;
+    } else if (r->key < l->key) {
+      if constexpr (KeepRhs)
+        out.push_back(*r);
+      ++r;
+    } else {
+      auto x = f(*l++, *r++);
+      if (x.cardinality > 0)
+        out.push_back(std::move(x));
+    }
+  }
+  if constexpr (KeepLhs)
+    out.insert(out.end(), l, l_end);
+  if constexpr (KeepRhs)
+    out.insert(out.end(), r, r_end);
+  return result;
+}
+
+roaring_bitmap
+binary_and(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  auto f = [](const container& x, const container& y) {
+    if (is_array(x) && is_array(y))
+      return combine_arrays(x, y, [](auto... xs) {
+        return std::set_intersection(xs...);
+      });
+    if (is_array(x))
+      return filter(x, y, true);
+    if (is_array(y))
+      return filter(y, x, true);
+    return combine(x, y, [](auto a, auto b) { return a & b; });
+  };
+  return roaring_bitmap::merge<false, false>(lhs, rhs, f);
+}
+
+roaring_bitmap binary_or(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  auto f = [](const container& x, const container& y) {
+    if (is_array(x) && is_array(y)
+        && x.cardinality + y.cardinality <= max_array_cardinality)
+      return combine_arrays(x, y, [](auto... xs) {
+        return std::set_union(xs...);
+      });
+    return combine(x, y, [](auto a, auto b) { return a | b; });
+  };
+  return roaring_bitmap::merge<true, true>(lhs, rhs, f);
+}
+
+roaring_bitmap
+binary_xor(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  auto f = [](const container& x, const container& y) {
+    if (is_array(x) && is_array(y)
+        && x.cardinality + y.cardinality <= max_array_cardinality)
+      return combine_arrays(x, y, [](auto... xs) {
+        return std::set_symmetric_difference(xs...);
+      });
+    return combine(x, y, [](auto a, auto b) { return a ^ b; });
+  };
+  return roaring_bitmap::merge<true, true>(lhs, rhs, f);
+}
+
+roaring_bitmap
+binary_nand(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  auto f = [](const container& x, const container& y) {
+    if (is_array(x))
+      return filter(x, y, false);
+    return combine(x, y, [](auto a, auto b) { return a & ~b; });
+  };
+  return roaring_bitmap::merge<true, false>(lhs, rhs, f);
+}
+
+roaring_bitmap_range::roaring_bitmap_range(const roaring_bitmap& bm)
+  : bm_{&bm},
+    container_{bm.containers_.begin()},
+    blocks_(roaring_bitmap::container_blocks),
+    done_{bm.empty()} {
+  if (!done_)
+    scan();
+}
+
+void roaring_bitmap_range::next() {
+  if (pos_ == bm_->size())
+    done_ = true;
+  else
+    scan();
+}
+
+bool roaring_bitmap_range::done() const {
+  return done_;
+}
+
+bool roaring_bitmap_range::seek() {
+  auto key = pos_ / container_bits;
+  auto end = bm_->containers_.end();
+  while (container_ != end && container_->key < key)
+    ++container_;
+  if (container_ == end || container_->key != key)
+    return false;
+  if (key_ != key) {
+    materialize(*container_, blocks_.data());
+    key_ = key;
+  }
+  return true;
+}
+
+void roaring_bitmap_range::scan() {
+  auto size = bm_->size();
+  VAST_ASSERT(pos_ < size);
+  VAST_ASSERT(pos_ % word_type::width == 0);
+  auto end = bm_->containers_.end();
+  // Without a container, all bits up to the next container are 0.
+  auto next_container = [&] {
+    return container_ == end ? size
+                             : std::min(size, container_->key * container_bits);
+  };
+  if (!seek()) {
+    auto next = next_container();
+    bits_ = {word_type::none, next - pos_};
+    pos_ = next;
+    return;
+  }
+  auto block = blocks_[(pos_ % container_bits) / word_type::width];
+  if (size - pos_ <= word_type::width) {
+    bits_ = {block, size - pos_};
+    pos_ = size;
+    return;
+  }
+  pos_ += word_type::width;
+  if (!word_type::all_or_none(block)) {
+    bits_ = {block, word_type::width};
+    return;
+  }
+  // Merge consecutive homogeneous blocks into a single run.
+  auto n = word_type::width;
+  while (pos_ < size) {
+    if (!seek()) {
+      if (block != word_type::none)
+        break;
+      auto next = next_container();
+      n += next - pos_;
+      pos_ = next;
+      continue;
+    }
+    auto x = blocks_[(pos_ % container_bits) / word_type::width];
+    auto remaining = size - pos_;
+    if (remaining < word_type::width) {
+      auto mask = word_type::lsb_mask(remaining);
+      if ((x & mask) == (block & mask)) {
+        n += remaining;
+        pos_ = size;
+      }
+      break;
+    }
+    if (x != block)
+      break;
+    n += word_type::width;
+    pos_ += word_type::width;
+  }
+  bits_ = {block, n};
+}
+
+roaring_bitmap_range bit_range(const roaring_bitmap& bm) {
+  return roaring_bitmap_range{bm};
+}
+
+} // namespace vast
@@ -27,14 +27,14 @@
 
 namespace vast {
 
-segment_builder::segment_builder() {
+segment_builder::segment_builder(compression method) : method_{method} {
   reset();
 }
 
 caf::error segment_builder::add(table_slice_ptr x) {
   if (x->offset() < min_table_slice_offset_)
     return make_error(ec::unspecified, "slice offsets not increasing");
-  auto slice = pack(builder_, x);
+  auto slice = pack(builder_, x, method_);
   if (!slice)
     return slice.error();
   flat_slices_.push_back(*slice);
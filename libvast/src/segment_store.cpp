@@ -15,6 +15,7 @@
 
 #include "vast/bitmap_algorithms.hpp"
 #include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/compression.hpp"
 #include "vast/concept/printable/vast/error.hpp"
 #include "vast/concept/printable/vast/filesystem.hpp"
 #include "vast/concept/printable/vast/uuid.hpp"
@@ -23,7 +24,9 @@
 #include "vast/fbs/segment.hpp"
 #include "vast/fbs/utils.hpp"
 #include "vast/ids.hpp"
+#include "vast/load.hpp"
 #include "vast/logger.hpp"
+#include "vast/save.hpp"
 #include "vast/segment_store.hpp"
 #include "vast/table_slice.hpp"
 #include "vast/to_events.hpp"
@@ -32,26 +35,68 @@
 #include <caf/dictionary.hpp>
 #include <caf/settings.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <optional>
+#include <tuple>
+#include <unordered_set>
+
 namespace vast {
 
+namespace {
+
+/// Removes erased events from table slices.
+std::vector<table_slice_ptr>
+hide_tombstones(std::vector<table_slice_ptr> xs, const ids& tombstones) {
+  std::vector<table_slice_ptr> result;
+  result.reserve(xs.size());
+  for (auto& x : xs) {
+    auto slice_ids = make_ids(*x);
+    if (rank(slice_ids & tombstones) == 0)
+      result.push_back(std::move(x));
+    else
+      select(result, x, slice_ids - tombstones);
+  }
+  return result;
+}
+
+} // namespace
+
 // TODO: return expected<segment_store_ptr> for better error propagation.
 segment_store_ptr segment_store::make(path dir, size_t max_segment_size,
-                                      size_t in_memory_segments) {
+                                      size_t max_cache_size,
+                                      compression method) {
   VAST_TRACE(VAST_ARG(dir), VAST_ARG(max_segment_size),
-             VAST_ARG(in_memory_segments));
+             VAST_ARG(max_cache_size));
   VAST_ASSERT(max_segment_size > 0);
-  auto result = segment_store_ptr{
-    new segment_store{std::move(dir), max_segment_size, in_memory_segments}};
+  VAST_ASSERT(max_cache_size > 0);
+  auto result = segment_store_ptr{new segment_store{
+    std::move(dir), max_segment_size, max_cache_size, method}};
   if (auto err = result->register_segments())
     return nullptr;
+  if (exists(result->tombstone_path())) {
+    auto& tombstones = result->tombstones_;
+    if (auto err = load(nullptr, result->tombstone_path(), tombstones))
+      return nullptr;
+    // Tombstones outside of the registered segments belong to events that
+    // `reclaim` already removed, so they no longer count.
+    ids registered;
+    for (auto x : result->segments_)
+      registered |= make_ids({{x.left, x.right}});
+    tombstones &= registered;
+    result->num_events_ -= std::min(rank(tombstones), result->num_events_);
+  }
   return result;
 }
 
 segment_store::segment_store(path dir, uint64_t max_segment_size,
-                             size_t in_memory_segments)
+                             size_t max_cache_size, compression method)
   : dir_{std::move(dir)},
     max_segment_size_{max_segment_size},
-    cache_{in_memory_segments} {
+    cache_{max_cache_size},
+    builder_{method} {
   // nop
 }
 
@@ -62,11 +107,19 @@ segment_store::~segment_store() {
 caf::error segment_store::put(table_slice_ptr xs) {
   VAST_TRACE(VAST_ARG(xs));
   VAST_DEBUG(this, "adds a table slice");
+  // Replaying the write-ahead log of the IMPORTER may deliver slices that we
+  // already stored before a crash.
+  if (segments_.lookup(xs->offset()) != nullptr) {
+    VAST_DEBUG(this, "skips already stored table slice at", xs->offset());
+    next_ = std::max(next_, xs->offset() + xs->rows());
+    return caf::none;
+  }
   if (auto error = builder_.add(xs))
     return error;
   if (!segments_.inject(xs->offset(), xs->offset() + xs->rows(), builder_.id()))
     return make_error(ec::unspecified, "failed to update range_map");
   num_events_ += xs->rows();
+  next_ = std::max(next_, xs->offset() + xs->rows());
   if (builder_.table_slice_bytes() < max_segment_size_)
     return caf::none;
   // We have exceeded our maximum segment size and now finish.
@@ -78,11 +131,28 @@ std::unique_ptr<store::lookup> segment_store::extract(const ids& xs) const {
   public:
     using uuid_iterator = std::vector<uuid>::iterator;
 
-    lookup(const segment_store& store, ids xs, std::vector<uuid>&& candidates)
-      : store_{store}, xs_{std::move(xs)}, candidates_{std::move(candidates)} {
+    /// A segment together with the slices that qualify for the lookup.
+    struct loaded_segment {
+      segment seg;
+      std::vector<table_slice_ptr> slices;
+      duration time;
+    };
+
+    using load_result = caf::expected<loaded_segment>;
+
+    lookup(const segment_store& store, ids xs, std::vector<uuid>&& candidates,
+           std::optional<ids> tombstones)
+      : store_{store},
+        xs_{std::make_shared<const ids>(std::move(xs))},
+        candidates_{std::move(candidates)},
+        tombstones_{std::move(tombstones)} {
       // nop
     }
 
+    ~lookup() override {
+      store_.reads_.in_flight -= pending_.size();
+    }
+
     caf::expected<table_slice_ptr> next() override {
       // Update the buffer if it has been consumed or the previous
       // refresh return an error.
@@ -91,172 +161,257 @@ std::unique_ptr<store::lookup> segment_store::extract(const ids& xs) const {
         if (!buffer_)
           // Either an error occurred, or the list of candidates is exhausted.
           return buffer_.error();
+        if (tombstones_)
+          buffer_ = hide_tombstones(std::move(*buffer_), *tombstones_);
         it_ = buffer_->begin();
       }
       return *it_++;
     }
 
   private:
+    /// Reads and decodes a segment. Runs on the I/O threads of the store when
+    /// prefetching, and therefore must not access the store.
+    static load_result load(const path& filename, const ids& xs) {
+      auto start = std::chrono::steady_clock::now();
+      VAST_DEBUG_ANON("mmaps segment from", filename);
+      auto chk = chunk::mmap(filename);
+      if (!chk)
+        return make_error(ec::filesystem_error, "failed to mmap chunk",
+                          filename);
+      auto seg = segment::make(std::move(chk));
+      if (!seg)
+        return seg.error();
+      auto slices = seg->lookup(xs);
+      if (!slices)
+        return slices.error();
+      auto time = std::chrono::duration_cast<duration>(
+        std::chrono::steady_clock::now() - start);
+      return loaded_segment{std::move(*seg), std::move(*slices), time};
+    }
+
+    /// Schedules loads for the upcoming candidates that are neither active nor
+    /// cached, until reaching the limit of loads in flight.
+    void prefetch() {
+      if (!store_.readers_)
+        return;
+      if (prefetched_ < first_)
+        prefetched_ = first_;
+      while (pending_.size() < store_.max_in_flight_
+             && prefetched_ != candidates_.end()) {
+        auto& cand = *prefetched_++;
+        if (cand == store_.builder_.id() || store_.cached(cand))
+          continue;
+        VAST_DEBUG(this, "prefetches segment", cand);
+        auto job = [filename = store_.segment_path() / to_string(cand),
+                    xs = xs_] { return load(filename, *xs); };
+        pending_.emplace_back(cand, store_.readers_->submit(std::move(job)));
+        ++store_.reads_.in_flight;
+      }
+    }
+
     caf::expected<std::vector<table_slice_ptr>> handle_segment() {
+      prefetch();
       if (first_ == candidates_.end())
         return caf::no_error;
       auto& cand = *first_++;
       if (cand == store_.builder_.id()) {
         VAST_DEBUG(this, "looks into the active segement", cand);
-        return store_.builder_.lookup(xs_);
+        return store_.builder_.lookup(*xs_);
       }
+      auto prefetched = !pending_.empty() && pending_.front().first == cand;
       auto i = store_.cache_.find(cand);
       if (i != store_.cache_.end()) {
         VAST_DEBUG(this, "got cache hit for segment", cand);
-        return i->second.lookup(xs_);
+        if (prefetched) {
+          pending_.pop_front();
+          --store_.reads_.in_flight;
+        }
+        return i->second.lookup(*xs_);
       }
       VAST_DEBUG(this, "got cache miss for segment", cand);
-      auto s = store_.load_segment(cand);
-      if (!s)
-        return s.error();
-      store_.cache_.emplace(cand, *s);
-      return s->lookup(xs_);
+      if (prefetched) {
+        auto result = pending_.front().second.get();
+        pending_.pop_front();
+        --store_.reads_.in_flight;
+        prefetch();
+        return finish(cand, std::move(result));
+      }
+      return finish(cand, load(store_.segment_path() / to_string(cand), *xs_));
+    }
+
+    caf::expected<std::vector<table_slice_ptr>>
+    finish(const uuid& cand, load_result x) {
+      if (!x)
+        return x.error();
+      auto& reads = store_.reads_;
+      ++reads.segments;
+      reads.bytes += x->seg.chunk()->size();
+      reads.time += x->time;
+      store_.cache_.emplace(cand, std::move(x->seg));
+      return std::move(x->slices);
     }
 
     const segment_store& store_;
-    ids xs_;
+    std::shared_ptr<const ids> xs_;
     std::vector<uuid> candidates_;
+    std::optional<ids> tombstones_;
     uuid_iterator first_ = candidates_.begin();
+    uuid_iterator prefetched_ = candidates_.begin();
+    std::deque<std::pair<uuid, std::future<load_result>>> pending_;
     caf::expected<std::vector<table_slice_ptr>> buffer_{caf::no_error};
     std::vector<table_slice_ptr>::iterator it_;
   };
 
   VAST_TRACE(VAST_ARG(xs));
+  // Skip segments that only hold erased events for this selection, and take a
+  // snapshot of the tombstones for filtering the remaining ones.
+  std::optional<ids> tombstones;
+  auto selection = xs;
+  if (rank(tombstones_) > 0) {
+    tombstones = tombstones_;
+    selection -= tombstones_;
+  }
   // Collect candidate segments by seeking through the ID set and
   // probing each ID interval.
   std::vector<uuid> candidates;
-  if (auto err = select_segments(xs, candidates)) {
+  if (auto err = select_segments(selection, candidates)) {
     VAST_WARNING(this, "failed to get candidates for ids", xs);
     return nullptr;
   }
   VAST_DEBUG(this, "processes", candidates.size(), "candidates");
   std::partition(candidates.begin(), candidates.end(), [&](const auto& id) {
-    return id == builder_.id() || cache_.find(id) != cache_.end();
+    return id == builder_.id() || cached(id);
   });
-  return std::make_unique<lookup>(*this, std::move(xs), std::move(candidates));
+  return std::make_unique<lookup>(*this, std::move(selection),
+                                  std::move(candidates), std::move(tombstones));
+}
+
+void segment_store::prefetch(size_t threads, size_t max_in_flight) {
+  VAST_TRACE(VAST_ARG(threads), VAST_ARG(max_in_flight));
+  if (threads == 0 || max_in_flight == 0) {
+    readers_.reset();
+    max_in_flight_ = 0;
+    return;
+  }
+  readers_ = std::make_unique<detail::thread_pool>(threads);
+  max_in_flight_ = max_in_flight;
+}
+
+template <class Segment>
+uint64_t segment_store::erase_from(Segment& seg, const ids& xs) {
+  // This algorithm removes all events with IDs in `xs` from a segment. For
+  // existing segments, we create a new segment that contains all table slices
+  // that remain after erasing `xs` from the input segment. For builders, we
+  // update the builder directly by replacing the set of table slices. In any
+  // case, we have to update `segments_` to point to the new segment ID.
+  uint64_t erased_events = 0;
+  auto segment_id = seg.id();
+  // Get all slices in the segment and generate a new segment that contains
+  // only what's left after dropping the selection.
+  auto segment_ids = seg.ids();
+  // Check whether we can drop the entire segment.
+  if (is_subset(segment_ids, xs))
+    return drop(seg);
+  std::vector<table_slice_ptr> slices;
+  if (auto maybe_slices = seg.lookup(segment_ids)) {
+    slices = std::move(*maybe_slices);
+    if (slices.empty()) {
+      VAST_WARNING(this, "got no slices after lookup for segment", segment_id,
+                   "=> erases entire segment!");
+      return drop(seg);
+    }
+  } else {
+    VAST_WARNING(this, "was unable to get table slice for segment",
+                 segment_id, "=> erases entire segment!");
+    return drop(seg);
+  }
+  VAST_ASSERT(slices.size() > 0);
+  // We have IDs we wish to delete in `xs`, but we need a bitmap of what to
+  // keep for `select` in order to fill `new_slices` with the table slices
+  // that remain after dropping all deleted IDs from the segment.
+  auto keep_mask = ~xs;
+  std::vector<table_slice_ptr> new_slices;
+  for (auto& slice : slices) {
+    // Expand keep_mask on-the-fly if needed.
+    auto max_id = slice->offset() + slice->rows();
+    if (keep_mask.size() < max_id)
+      keep_mask.append_bits(true, max_id - keep_mask.size());
+    size_t new_slices_size_before = new_slices.size();
+    select(new_slices, slice, keep_mask);
+    size_t remaining_rows = 0;
+    for (size_t i = new_slices_size_before; i < new_slices.size(); ++i)
+      remaining_rows += new_slices[i]->rows();
+    erased_events += slice->rows() - remaining_rows;
+  }
+  if (new_slices.empty()) {
+    VAST_WARNING(this, "was unable to generate any new slice for segment",
+                 segment_id, "=> erases entire segment!");
+    return erased_events + drop(seg);
+  }
+  VAST_DEBUG(this, "shrinks segment", segment_id, "from", slices.size(), "to",
+             new_slices.size(), "slices");
+  // Remove stale state.
+  segments_.erase_value(segment_id);
+  // Create a new segment from the remaining slices.
+  segment_builder tmp_builder{builder_.method()};
+  segment_builder* builder = &tmp_builder;
+  if constexpr (std::is_same_v<decltype(seg), segment_builder&>) {
+    // If `erase_from` got called with a builder then we simply use that by
+    // resetting it and filling it with new content. Otherwise, we fill
+    // `tmp_builder` instead and replace the the segment `seg` in the next
+    // `if constexpr` block.
+    seg.reset();
+    builder = &seg;
+  }
+  for (auto& slice : new_slices) {
+    if (auto err = builder->add(slice)) {
+      VAST_ERROR(this, "failed to add slice to builder:", err);
+    } else if (!segments_.inject(slice->offset(),
+                                 slice->offset() + slice->rows(),
+                                 builder->id()))
+      VAST_ERROR(this, "failed to update range_map");
+  }
+  // Flush the new segment and remove the previous segment.
+  if constexpr (std::is_same_v<decltype(seg), segment&>) {
+    auto new_segment = builder->finish();
+    auto filename = segment_path() / to_string(new_segment.id());
+    if (auto err = write(filename, new_segment.chunk()))
+      VAST_ERROR(this, "failed to persist the new segment");
+    auto stale_filename = segment_path() / to_string(segment_id);
+    // Schedule deletion of the segment file when releasing the chunk.
+    seg.chunk()->add_deletion_step([=] { rm(stale_filename); });
+  }
+  // else: nothing to do, since we can continue filling the active segment.
+  return erased_events;
 }
 
 caf::error segment_store::erase(const ids& xs) {
   VAST_TRACE(VAST_ARG(xs));
-  // Get affected segments.
-  std::vector<uuid> candidates;
-  if (auto err = select_segments(xs, candidates))
-    return err;
-  if (candidates.empty())
-    return caf::none;
-  auto is_subset_of_xs = [&](const ids& ys) { return is_subset(ys, xs); };
-  // Counts number of total erased events for user-facing output.
+  // Erasing from the active segment only touches memory, so we do it right
+  // away. For persisted segments we merely record tombstones that lookups
+  // filter out, and leave rewriting the segments to `reclaim`.
+  auto fresh = xs - tombstones_;
+  auto erases_active = false;
   uint64_t erased_events = 0;
-  // Implements the body of the for-loop below. This lambda must be generic,
-  // because the argument is either a `segment` or a `segment_builder`. This
-  // algorithm removes all events with IDs in `xs` from a segment. For existing
-  // segments, we create a new segment that contains all table slices that
-  // remain after erasing `xs` from the input segment. For builders, we update
-  // the builder directly by replacing the set of table slices. In any case, we
-  // have to update `segments_` to point to the new segment ID.
-  auto impl = [&](auto& seg) {
-    auto segment_id = seg.id();
-    // Get all slices in the segment and generate a new segment that contains
-    // only what's left after dropping the selection.
-    auto segment_ids = seg.ids();
-    // Check whether we can drop the entire segment.
-    if (is_subset_of_xs(segment_ids)) {
-      erased_events += drop(seg);
-      return;
-    }
-    std::vector<table_slice_ptr> slices;
-    if (auto maybe_slices = seg.lookup(segment_ids)) {
-      slices = std::move(*maybe_slices);
-      if (slices.empty()) {
-        VAST_WARNING(this, "got no slices after lookup for segment", segment_id,
-                     "=> erases entire segment!");
-        erased_events += drop(seg);
-        return;
-      }
+  auto f = [](auto x) { return std::pair{x.left, x.right}; };
+  auto g = [&](auto x) {
+    if (x.value == builder_.id()) {
+      erases_active = true;
     } else {
-      VAST_WARNING(this, "was unable to get table slice for segment",
-                   segment_id, "=> erases entire segment!");
-      erased_events += drop(seg);
-      return;
+      auto hidden = fresh & make_ids({{x.left, x.right}});
+      erased_events += rank(hidden);
+      tombstones_ |= hidden;
     }
-    VAST_ASSERT(slices.size() > 0);
-    // We have IDs we wish to delete in `xs`, but we need a bitmap of what to
-    // keep for `select` in order to fill `new_slices` with the table slices
-    // that remain after dropping all deleted IDs from the segment.
-    auto keep_mask = ~xs;
-    std::vector<table_slice_ptr> new_slices;
-    for (auto& slice : slices) {
-      // Expand keep_mask on-the-fly if needed.
-      auto max_id = slice->offset() + slice->rows();
-      if (keep_mask.size() < max_id)
-        keep_mask.append_bits(true, max_id - keep_mask.size());
-      size_t new_slices_size_before = new_slices.size();
-      select(new_slices, slice, keep_mask);
-      size_t remaining_rows = 0;
-      for (size_t i = new_slices_size_before; i < new_slices.size(); ++i)
-        remaining_rows += new_slices[i]->rows();
-      erased_events += slice->rows() - remaining_rows;
-    }
-    if (new_slices.empty()) {
-      VAST_WARNING(this, "was unable to generate any new slice for segment",
-                   segment_id, "=> erases entire segment!");
-      erased_events += drop(seg);
-      return;
-    }
-    VAST_DEBUG(this, "shrinks segment", segment_id, "from", slices.size(), "to",
-               new_slices.size(), "slices");
-    // Remove stale state.
-    segments_.erase_value(segment_id);
-    // Create a new segment from the remaining slices.
-    segment_builder tmp_builder;
-    segment_builder* builder = &tmp_builder;
-    if constexpr (std::is_same_v<decltype(seg), segment_builder&>) {
-      // If `update` got called with a builder then we simply use that by
-      // resetting it and filling it with new content. Otherwise, we fill
-      // `tmp_builder` instead and replace the the segment `seg` in the next
-      // `if constexpr` block.
-      seg.reset();
-      builder = &seg;
-    }
-    for (auto& slice : new_slices) {
-      if (auto err = builder->add(slice)) {
-        VAST_ERROR(this, "failed to add slice to builder:", err);
-      } else if (!segments_.inject(slice->offset(),
-                                   slice->offset() + slice->rows(),
-                                   builder->id()))
-        VAST_ERROR(this, "failed to update range_map");
-    }
-    // Flush the new segment and remove the previous segment.
-    if constexpr (std::is_same_v<decltype(seg), segment&>) {
-      auto new_segment = builder->finish();
-      auto filename = segment_path() / to_string(new_segment.id());
-      if (auto err = write(filename, new_segment.chunk()))
-        VAST_ERROR(this, "failed to persist the new segment");
-      auto stale_filename = segment_path() / to_string(segment_id);
-      // Schedule deletion of the segment file when releasing the chunk.
-      seg.chunk()->add_deletion_step([=] { rm(stale_filename); });
-    }
-    // else: nothing to do, since we can continue filling the active segment.
+    return caf::none;
   };
-  // Iterate affected segments.
-  for (auto& candidate : candidates) {
-    auto j = cache_.find(candidate);
-    if (j != cache_.end()) {
-      VAST_DEBUG(this, "erases from the cached segement", candidate);
-      impl(j->second);
-      cache_.erase(j);
-    } else if (candidate == builder_.id()) {
-      VAST_DEBUG(this, "erases from the active segement", candidate);
-      impl(builder_);
-    } else if (auto s = load_segment(candidate)) {
-      VAST_DEBUG(this, "erases from the segement", candidate);
-      impl(*s);
-    }
+  if (auto err = select_with(fresh, segments_.begin(), segments_.end(), f, g))
+    return err;
+  if (erased_events > 0)
+    if (auto err = save(nullptr, tombstone_path(), tombstones_))
+      return err;
+  if (erases_active) {
+    VAST_DEBUG(this, "erases from the active segement", builder_.id());
+    erased_events += erase_from(builder_, fresh);
   }
   if (erased_events > 0) {
     VAST_ASSERT(erased_events <= num_events_);
@@ -266,25 +421,73 @@ caf::error segment_store::erase(const ids& xs) {
   return caf::none;
 }
 
+caf::expected<uint64_t> segment_store::reclaim(uint64_t max_bytes) {
+  VAST_TRACE(VAST_ARG(max_bytes));
+  if (rank(tombstones_) == 0)
+    return 0;
+  std::vector<uuid> candidates;
+  if (auto err = select_segments(tombstones_, candidates))
+    return err;
+  uint64_t bytes = 0;
+  auto remaining = candidates.size();
+  for (auto& candidate : candidates) {
+    if (bytes >= max_bytes)
+      break;
+    --remaining;
+    // The active segment never contains tombstoned events.
+    if (candidate == builder_.id())
+      continue;
+    caf::expected<segment> seg{caf::no_error};
+    if (auto i = cache_.find(candidate); i != cache_.end()) {
+      seg = std::move(i->second);
+      cache_.erase(i);
+    } else {
+      seg = load_segment(candidate);
+      if (!seg)
+        return seg.error();
+    }
+    VAST_DEBUG(this, "rewrites segment", candidate, "without erased events");
+    bytes += seg->chunk()->size();
+    auto segment_ids = seg->ids();
+    erase_from(*seg, tombstones_);
+    tombstones_ -= segment_ids;
+    // The stale file disappears with the last reference to `seg`, so we
+    // persist the tombstones first. Otherwise, a crash in between would leave
+    // tombstones for events that are already gone, and `make` would subtract
+    // them from the number of events twice.
+    if (auto err = save(nullptr, tombstone_path(), tombstones_))
+      return err;
+  }
+  // Once all segments are rewritten, no tombstones may remain.
+  if (remaining == 0 && rank(tombstones_) > 0) {
+    tombstones_ = ids{};
+    if (auto err = save(nullptr, tombstone_path(), tombstones_))
+      return err;
+  }
+  return bytes;
+}
+
 caf::expected<std::vector<table_slice_ptr>> segment_store::get(const ids& xs) {
   VAST_TRACE(VAST_ARG(xs));
+  auto erased = rank(tombstones_) > 0;
+  auto selection = erased ? xs - tombstones_ : xs;
   // Collect candidate segments by seeking through the ID set and
   // probing each ID interval.
   std::vector<uuid> candidates;
-  if (auto err = select_segments(xs, candidates))
+  if (auto err = select_segments(selection, candidates))
     return err;
   // Process candidates in reverse order for maximum LRU cache hits.
   std::vector<table_slice_ptr> result;
   VAST_DEBUG(this, "processes", candidates.size(), "candidates");
   std::partition(candidates.begin(), candidates.end(), [&](const auto& id) {
-    return id == builder_.id() || cache_.find(id) != cache_.end();
+    return id == builder_.id() || cached(id);
   });
   for (auto cand = candidates.begin(); cand != candidates.end(); ++cand) {
     auto& id = *cand;
     caf::expected<std::vector<table_slice_ptr>> slices{caf::no_error};
     if (id == builder_.id()) {
       VAST_DEBUG(this, "looks into the active segement", id);
-      slices = builder_.lookup(xs);
+      slices = builder_.lookup(selection);
     } else {
       auto i = cache_.find(id);
       if (i == cache_.end()) {
@@ -297,16 +500,130 @@ caf::expected<std::vector<table_slice_ptr>> segment_store::get(const ids& xs) {
         VAST_DEBUG(this, "got cache hit for segment", id);
       }
       VAST_DEBUG(this, "looks into segment", id);
-      slices = i->second.lookup(xs);
+      slices = i->second.lookup(selection);
     }
     if (!slices)
       return slices.error();
+    if (erased)
+      slices = hide_tombstones(std::move(*slices), tombstones_);
     result.reserve(result.size() + slices->size());
     result.insert(result.end(), slices->begin(), slices->end());
   }
   return result;
 }
 
+caf::expected<uint64_t> segment_store::compact(uint64_t max_bytes) {
+  VAST_TRACE(VAST_ARG(max_bytes));
+  auto& x = compaction_;
+  // A segment that a previous step picked may have disappeared since, e.g.,
+  // because `reclaim` rewrote it.
+  auto registered = [&](const uuid& segment_id, id first) {
+    auto ptr = segments_.lookup(first);
+    return ptr != nullptr && *ptr == segment_id;
+  };
+  auto abandon = [&] {
+    VAST_DEBUG(this, "abandons merging", x.sources.size() + x.pending.size(),
+               "segments that changed in the meantime");
+    x = {};
+  };
+  auto loaded = [&](const segment& seg) {
+    return registered(seg.id(), select(seg.ids(), 1));
+  };
+  if (!std::all_of(x.sources.begin(), x.sources.end(), loaded))
+    abandon();
+  if (x.pending.empty() && x.sources.empty()) {
+    // Collect the persisted segments in ID order together with their size.
+    std::vector<std::tuple<uuid, id, uintmax_t>> xs;
+    std::unordered_set<uuid> seen;
+    for (auto i = segments_.begin(); i != segments_.end(); ++i) {
+      auto segment_id = (*i).value;
+      if (segment_id == builder_.id() || !seen.insert(segment_id).second)
+        continue;
+      auto size = file_size(segment_path() / to_string(segment_id));
+      if (!size)
+        return size.error();
+      xs.emplace_back(segment_id, (*i).left, *size);
+    }
+    // Find the first run of small segments that fits into a single one.
+    auto threshold = max_segment_size_ / 2;
+    auto small = [&](size_t i) { return std::get<2>(xs[i]) < threshold; };
+    for (size_t first = 0; first < xs.size() && x.pending.empty(); ++first) {
+      if (!small(first))
+        continue;
+      auto last = first;
+      uintmax_t bytes = 0;
+      while (last < xs.size() && small(last)
+             && bytes + std::get<2>(xs[last]) <= max_segment_size_)
+        bytes += std::get<2>(xs[last++]);
+      if (last - first < 2)
+        continue;
+      for (auto i = last; i > first; --i)
+        x.pending.emplace_back(std::get<0>(xs[i - 1]), std::get<1>(xs[i - 1]));
+    }
+    if (x.pending.empty())
+      return 0;
+  }
+  // Load the segments of the run until we exhaust the budget.
+  uint64_t bytes = 0;
+  while (!x.pending.empty()) {
+    if (bytes >= max_bytes)
+      return bytes;
+    auto [segment_id, first] = x.pending.back();
+    if (!registered(segment_id, first)) {
+      abandon();
+      return bytes;
+    }
+    x.pending.pop_back();
+    if (auto i = cache_.find(segment_id); i != cache_.end()) {
+      x.sources.push_back(i->second);
+    } else {
+      auto seg = load_segment(segment_id);
+      if (!seg) {
+        x = {};
+        return seg.error();
+      }
+      x.sources.push_back(std::move(*seg));
+    }
+    bytes += x.sources.back().chunk()->size();
+  }
+  // Merge the run after loading its last segment.
+  auto sources = std::move(x.sources);
+  x = {};
+  std::vector<table_slice_ptr> slices;
+  for (auto& source : sources) {
+    auto source_slices = source.lookup(source.ids());
+    if (!source_slices)
+      return source_slices.error();
+    slices.insert(slices.end(), source_slices->begin(), source_slices->end());
+  }
+  std::sort(slices.begin(), slices.end(), [](auto& x, auto& y) {
+    return x->offset() < y->offset();
+  });
+  segment_builder builder{builder_.method()};
+  for (auto& slice : slices)
+    if (auto err = builder.add(slice))
+      return err;
+  auto seg = builder.finish();
+  auto filename = segment_path() / to_string(seg.id());
+  if (auto err = write(filename, seg.chunk()))
+    return err;
+  // Switch over to the new segment only after it safely resides on disk.
+  for (auto& source : sources) {
+    auto stale_filename = segment_path() / to_string(source.id());
+    segments_.erase_value(source.id());
+    cache_.erase(source.id());
+    // Schedule deletion of the segment file when releasing the chunk.
+    source.chunk()->add_deletion_step([=] { rm(stale_filename); });
+  }
+  for (auto& slice : slices)
+    if (!segments_.inject(slice->offset(), slice->offset() + slice->rows(),
+                          seg.id()))
+      return make_error(ec::unspecified, "failed to update range_map");
+  bytes += seg.chunk()->size();
+  VAST_VERBOSE(this, "merged", sources.size(), "segments into", seg.id());
+  return bytes;
+}
+
 caf::error segment_store::flush() {
   if (!dirty())
     return caf::none;
@@ -321,11 +638,18 @@ caf::error segment_store::flush() {
   return caf::none;
 }
 
+id segment_store::watermark() const {
+  auto& slices = builder_.table_slices();
+  return slices.empty() ? next_ : slices.front()->offset();
+}
+
 void segment_store::inspect_status(caf::settings& dict) {
   using caf::put;
   put(dict, "segment-path", segment_path().str());
   put(dict, "max-segment-size", max_segment_size_);
+  put(dict, "compression", to_string(builder_.method()));
   put(dict, "num-events", num_events_);
+  put(dict, "num-erased-events-on-disk", rank(tombstones_));
   // Note: `for (auto& kvp : segments_)` does not compile.
   // FIXME: This is too slow for large archives and blocks the node.
   // auto& segments = put_dictionary(dict, "segments");
@@ -337,12 +661,40 @@ void segment_store::inspect_status(caf::settings& dict) {
   //   range += ")";
   //   put(segments, range, to_string(i->value));
   // }
-  auto& cached = put_list(dict, "cached");
+  auto& cache = put_dictionary(dict, "cache");
+  put(cache, "capacity", cache_.capacity());
+  put(cache, "bytes", cache_.weight());
+  put(cache, "hits", cache_.stats().hits);
+  put(cache, "misses", cache_.stats().misses);
+  put(cache, "evictions", cache_.stats().evictions);
+  auto& cached = put_list(cache, "segments");
   for (auto& kvp : cache_)
     cached.emplace_back(to_string(kvp.first));
   auto& current = put_dictionary(dict, "current-segment");
   put(current, "id", to_string(builder_.id()));
   put(current, "size", builder_.table_slice_bytes());
+  // The read rate relates to the time spent loading, which overlaps between
+  // multiple I/O threads.
+  auto& reads = put_dictionary(dict, "reads");
+  put(reads, "io-threads", readers_ ? readers_->size() : size_t{0});
+  put(reads, "max-in-flight", max_in_flight_);
+  put(reads, "queue-depth", reads_.in_flight);
+  put(reads, "segments", reads_.segments);
+  put(reads, "bytes", reads_.bytes);
+  auto seconds = std::chrono::duration<double>{reads_.time}.count();
+  put(reads, "bytes-per-second", seconds > 0 ? reads_.bytes / seconds : 0.0);
+}
+
+void segment_store::append_report(system::report& r) const {
+  auto& stats = cache_.stats();
+  r.push_back({"segment-store.cache.hits", stats.hits});
+  r.push_back({"segment-store.cache.misses", stats.misses});
+  r.push_back({"segment-store.cache.evictions", stats.evictions});
+  r.push_back({"segment-store.cache.segments", uint64_t{cache_.size()}});
+  r.push_back({"segment-store.cache.bytes", uint64_t{cache_.weight()}});
+  if (auto lookups = stats.hits + stats.misses; lookups > 0)
+    r.push_back({"segment-store.cache.hit-rate",
+                 static_cast<double>(stats.hits) / lookups});
 }
 
 caf::error segment_store::register_segments() {
@@ -364,7 +716,11 @@ caf::error segment_store::register_segment(const path& filename) {
   VAST_DEBUG(this, "found segment", segment_uuid);
   for (auto interval : *s->ids())
     if (!segments_.inject(interval->begin(), interval->end(), segment_uuid))
-      return make_error(ec::unspecified, "failed to update range_map");
+      // A crash during compaction may leave the merged segments behind next
+      // to the new one, so every event has a second copy that we can ignore.
+      VAST_WARNING(this, "ignores events [", interval->begin(), ",",
+                   interval->end(), ") of segment", segment_uuid,
+                   "that another segment holds already");
   return caf::none;
 }
 
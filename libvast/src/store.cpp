@@ -23,4 +23,8 @@ store::lookup::~lookup() {
   // nop
 }
 
+void store::append_report(system::report&) const {
+  // nop
+}
+
 } // namespace vast
@@ -23,8 +23,10 @@
 #include "vast/error.hpp"
 #include "vast/logger.hpp"
 #include "vast/synopsis_factory.hpp"
+#include "vast/table_slice_column.hpp"
 #include "vast/time_synopsis.hpp"
 
+#include "vast/detail/assert.hpp"
 #include "vast/detail/overload.hpp"
 
 namespace vast {
@@ -37,6 +39,12 @@ synopsis::~synopsis() {
   // nop
 }
 
+void synopsis::add(const table_slice_column& x) {
+  VAST_ASSERT(x.slice != nullptr);
+  x.slice->for_each_in_column(x.column,
+                              [this](data_view y) { add(std::move(y)); });
+}
+
 const vast::type& synopsis::type() const {
   return type_;
 }
@@ -64,7 +64,13 @@ command::opts_builder add_index_opts(command::opts_builder ob) {
                                             "partitions")
     .add<size_t>("max-taste-partitions", "maximum number of immediately "
                                          "scheduled partitions")
-    .add<size_t>("max-queries,q", "maximum number of concurrent queries");
+    .add<size_t>("max-queries,q", "maximum number of concurrent queries")
+    .add<size_t>("partition-loaders", "number of threads for loading "
+                                      "partitions from disk")
+    .add<size_t>("indexing-threads", "number of threads for indexing "
+                                     "columns (0 = one actor per column)")
+    .add<size_t>("query-cache-size", "maximum memory for cached query "
+                                     "results in MiB (0 = disabled)");
 }
 
 auto make_root_command(std::string_view path) {
@@ -98,7 +104,25 @@ auto make_root_command(std::string_view path) {
                                         "definitions")
         .add<std::string>("aging-frequency", "interval between two aging "
                                              "cycles")
-        .add<std::string>("aging-query", "query for aging out obsolete data");
+        .add<std::string>("aging-query", "query for aging out obsolete data")
+        .add<std::string>("compaction-interval", "interval between two "
+                                                 "compaction rounds")
+        .add<std::string>("segment-compression", "compression algorithm for "
+                                                 "archive segments (null, "
+                                                 "lz4, zstd)")
+        .add<size_t>("archive-io-threads", "number of threads for loading "
+                                           "archive segments")
+        .add<size_t>("archive-prefetch", "maximum number of archive segment "
+                                         "loads in flight per query")
+        .add<size_t>("reclaim-rate", "maximum rate for rewriting archive "
+                                     "segments with erased events in MiB/s")
+        .add<bool>("write-ahead-log", "log imported events to disk until "
+                                      "they are archived and indexed")
+        .add<size_t>("write-ahead-log-file-size", "maximum size of a "
+                                                  "write-ahead log file in MiB")
+        .add<std::string>("write-ahead-log-sync-interval", "interval between "
+                                                           "two syncs of the "
+                                                           "write-ahead log");
   return std::make_unique<command>(path, "", documentation::vast,
                                    add_index_opts(std::move(ob)));
 }
@@ -134,6 +158,8 @@ auto make_export_command() {
       .add<bool>("continuous,c", "marks a query as continuous")
       .add<bool>("unified,u", "marks a query as unified")
       .add<size_t>("max-events,n", "maximum number of results")
+      .add<bool>("oldest-first", "evaluate older partitions first")
+      .add<bool>("batch", "yield to interactive queries")
       .add<std::string>("read,r", "path for reading the query"));
   export_->add_subcommand("zeek", "exports query results in Zeek format",
                           documentation::vast_export_zeek,
@@ -316,7 +342,9 @@ auto make_spawn_command() {
   spawn->add_subcommand(
     "archive", "creates a new archive", "",
     opts()
-      .add<size_t>("segments,s", "number of cached segments")
+      .add<size_t>("cache-size,c", "maximum size of cached segments in MB")
+      .add<size_t>("segments,s", "number of cached segments (deprecated, "
+                                 "use cache-size instead)")
       .add<size_t>("max-segment-size,m", "maximum segment size in MB"));
   spawn->add_subcommand(
     "explorer", "creates a new explorer", "",
@@ -401,6 +429,7 @@ auto make_command_factory() {
     {"send", remote_command},
     {"spawn accountant", remote_command},
     {"spawn archive", remote_command},
+    {"spawn compactor", remote_command},
     {"spawn eraser", remote_command},
     {"spawn exporter", remote_command},
     {"spawn explorer", remote_command},
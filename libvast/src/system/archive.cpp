@@ -13,6 +13,8 @@
 
 #include "vast/system/archive.hpp"
 
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/compression.hpp"
 #include "vast/concept/printable/std/chrono.hpp"
 #include "vast/concept/printable/stream.hpp"
 #include "vast/concept/printable/to_string.hpp"
@@ -23,6 +25,7 @@
 #include "vast/event.hpp"
 #include "vast/logger.hpp"
 #include "vast/segment_store.hpp"
+#include "vast/si_literals.hpp"
 #include "vast/store.hpp"
 #include "vast/table_slice.hpp"
 #include "vast/to_events.hpp"
@@ -32,41 +35,75 @@
 #include <caf/settings.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <limits>
 
 using namespace caf;
+using namespace vast::binary_byte_literals;
 
 namespace vast::system {
 
 void archive_state::next_session() {
-  // No requester means no work to do.
-  if (requesters.empty()) {
+  session = nullptr;
+  participants.clear();
+  // Every entry in the requesters queue stands for one pending ids request.
+  // Each requester contributes its oldest request, and the remaining entries
+  // wait for later sessions.
+  ids merged;
+  for (auto i = requesters.begin(); i != requesters.end();) {
+    auto addr = (*i)->address();
+    // Skip the work for exporters that went away or cancelled their query.
+    if (!is_active(addr)) {
+      VAST_TRACE(self, "dismisses the ids queue for an inactive requester");
+      drop(addr);
+      i = requesters.erase(i);
+      continue;
+    }
+    auto already_participates = [&](const participant& x) {
+      return x.requester->address() == addr;
+    };
+    if (std::any_of(participants.begin(), participants.end(),
+                    already_participates)) {
+      ++i;
+      continue;
+    }
+    auto it = unhandled_ids.find(addr);
+    if (it == unhandled_ids.end() || it->second.empty()) {
+      VAST_TRACE(self, "found no ids queue for a requester");
+      if (it != unhandled_ids.end())
+        unhandled_ids.erase(it);
+      i = requesters.erase(i);
+      continue;
+    }
+    merged |= it->second.front();
+    participants.push_back({*i, std::move(it->second.front())});
+    it->second.pop();
+    i = requesters.erase(i);
+  }
+  // No participant means no work to do.
+  if (participants.empty()) {
     VAST_TRACE(self, "has no requesters");
-    session = nullptr;
     return;
   }
-  // Find the work queue for our current requester.
-  const auto& current_requester = requesters.front();
-  auto it = unhandled_ids.find(current_requester->address());
-  // There is no ids queue for our current requester. Let's dismiss the
-  // requester and try again.
-  if (it == unhandled_ids.end()) {
-    VAST_TRACE(self, "could not find an ids queue for the current requester");
-    requesters.pop();
+  VAST_DEBUG(self, "starts a session for", participants.size(), "requesters");
+  session = store->extract(merged);
+  if (!session) {
+    for (auto& x : participants)
+      self->send(x.requester, atom::done_v,
+                 make_error(ec::lookup_error, "failed to extract ids"));
     return next_session();
   }
-  // There is a work queue for our current requester, but it is empty. Let's
-  // clean house, dismiss the requester and try again.
-  if (it->second.empty()) {
-    VAST_TRACE(self, "found an empty ids queue for the current requester");
-    unhandled_ids.erase(it);
-    requesters.pop();
-    return next_session();
-  }
-  // Start working on the next ids for the next requester.
-  auto& next_ids = it->second.front();
-  session = store->extract(next_ids);
-  self->send(self, next_ids, current_requester, ++session_id);
-  it->second.pop();
+  self->send(self, atom::extract_v, ++session_id);
+}
+
+bool archive_state::is_active(const caf::actor_addr& exporter) const {
+  auto i = active_exporters.find(exporter);
+  return i != active_exporters.end() && !i->second.cancelled();
+}
+
+void archive_state::drop(const caf::actor_addr& exporter) {
+  active_exporters.erase(exporter);
+  unhandled_ids.erase(exporter);
 }
 
 void archive_state::send_report() {
@@ -86,28 +123,62 @@ void archive_state::send_report() {
     measurement = vast::system::measurement{};
     self->send(accountant, std::move(r));
   }
+  if (accountant) {
+    auto r = report{};
+    store->append_report(r);
+    if (!r.empty())
+      self->send(accountant, std::move(r));
+  }
 }
 
 archive_type::behavior_type
 archive(archive_type::stateful_pointer<archive_state> self, path dir,
-        size_t capacity, size_t max_segment_size) {
+        size_t max_cache_size, size_t max_segment_size) {
   // TODO: make the choice of store configurable. For most flexibility, it
   // probably makes sense to pass a unique_ptr<stor> directory to the spawn
   // arguments of the actor. This way, users can provide their own store
   // implementation conveniently.
-  VAST_DEBUG(self, "spawned:", VAST_ARG(capacity), VAST_ARG(max_segment_size));
+  VAST_DEBUG(self, "spawned:", VAST_ARG(max_cache_size),
+             VAST_ARG(max_segment_size));
   self->state.self = self;
-  self->state.store = segment_store::make(dir, max_segment_size, capacity);
-  VAST_ASSERT(self->state.store != nullptr);
+  auto method_name
+    = get_or(self->system().config(), "system.segment-compression",
+             defaults::system::segment_compression);
+  auto method = to<compression>(method_name);
+  if (!method) {
+    VAST_WARNING(self, "got an invalid segment-compression", method_name,
+                 "and does not compress segments");
+    method = compression::null;
+  } else if (*method == compression::zstd && !VAST_HAVE_ZSTD) {
+    VAST_WARNING(self, "lacks Zstandard support and compresses segments "
+                       "with LZ4 instead");
+    method = compression::lz4;
+  }
+  auto store = segment_store::make(dir, max_segment_size, max_cache_size,
+                                   *method);
+  VAST_ASSERT(store != nullptr);
+  store->prefetch(get_or(self->system().config(), "system.archive-io-threads",
+                         defaults::system::archive_io_threads),
+                  get_or(self->system().config(), "system.archive-prefetch",
+                         defaults::system::archive_prefetch));
+  self->state.store = std::move(store);
+  self->state.reclaim_rate
+    = 1_MiB
+      * get_or(self->system().config(), "system.reclaim-rate",
+               defaults::system::reclaim_rate);
+  if (self->state.reclaim_rate > 0)
+    self->send(self, atom::reclaim_v);
   self->set_exit_handler([=](const exit_msg& msg) {
     self->state.send_report();
+    // Drop the session first, because it refers to the store.
+    self->state.session.reset();
     self->state.store->flush();
     self->state.store.reset();
     self->quit(msg.reason);
   });
   self->set_down_handler([=](const down_msg& msg) {
     VAST_DEBUG(self, "received DOWN from", msg.source);
-    self->state.active_exporters.erase(msg.source);
+    self->state.drop(msg.source);
   });
   if (auto a = self->system().registry().get(atom::accountant_v)) {
     namespace defs = defaults::system;
@@ -128,27 +199,45 @@ archive(archive_type::stateful_pointer<archive_state> self, path dir,
     },
     [=](const ids& xs, receiver_type requester) {
       auto& st = self->state;
-      if (st.active_exporters.count(requester->address()) == 0) {
+      if (!st.is_active(requester->address())) {
         VAST_DEBUG(self, "dismisses query for inactive sender");
         return;
       }
-      st.requesters.push(requester);
+      st.requesters.push_back(requester);
       st.unhandled_ids[requester->address()].push(xs);
+      // Start the session only after handling the requests that are already
+      // in the mailbox, so that a burst of queries shares it.
+      if (!st.session && !st.session_scheduled) {
+        st.session_scheduled = true;
+        self->send(self, atom::extract_v);
+      }
+    },
+    [=](atom::extract) {
+      auto& st = self->state;
+      st.session_scheduled = false;
       if (!st.session)
         st.next_session();
     },
-    [=](const ids& xs, receiver_type requester, uint64_t session_id) {
+    [=](atom::extract, uint64_t session_id) {
       auto& st = self->state;
-      // If the export has since shut down, we need to invalidate the session.
-      if (st.active_exporters.count(requester->address()) == 0) {
-        VAST_DEBUG(self, "invalidates running query session for", requester);
-        st.next_session();
+      if (!st.session || st.session_id != session_id) {
+        VAST_DEBUG(self, "ignores extraction for invalidated session");
         return;
       }
-      if (!st.session || st.session_id != session_id) {
-        VAST_DEBUG(self, "considers extraction finished for invalidated "
-                         "session");
-        self->send(requester, atom::done_v, make_error(ec::no_error));
+      // If an exporter has since shut down or cancelled its query, it no
+      // longer takes part in the session.
+      auto inactive = [&](const archive_state::participant& x) {
+        auto addr = x.requester->address();
+        if (st.is_active(addr))
+          return false;
+        VAST_DEBUG(self, "removes", x.requester, "from the running session");
+        st.drop(addr);
+        return true;
+      };
+      st.participants.erase(std::remove_if(st.participants.begin(),
+                                           st.participants.end(), inactive),
+                            st.participants.end());
+      if (st.participants.empty()) {
         st.next_session();
         return;
       }
@@ -158,15 +247,17 @@ archive(archive_type::stateful_pointer<archive_state> self, path dir,
         auto err
           = slice.error() ? std::move(slice.error()) : make_error(ec::no_error);
         VAST_DEBUG(self, "finished extraction from the current session:", err);
-        self->send(requester, atom::done_v, std::move(err));
+        for (auto& x : st.participants)
+          self->send(x.requester, atom::done_v, err);
         st.next_session();
         return;
       }
-      // The slice may contain entries that are not selected by xs.
-      for (auto& sub_slice : select(*slice, xs))
-        self->send(requester, sub_slice);
+      // The slice may contain entries that are not selected by a requester.
+      for (auto& x : st.participants)
+        for (auto& sub_slice : select(*slice, x.xs))
+          self->send(x.requester, sub_slice);
       // Continue working on the current session.
-      self->send(self, xs, requester, session_id);
+      self->send(self, atom::extract_v, session_id);
     },
     [=](stream<table_slice_ptr> in) {
       self->make_sink(
@@ -195,7 +286,13 @@ archive(archive_type::stateful_pointer<archive_state> self, path dir,
     },
     [=](atom::exporter, const actor& exporter) {
       auto sender_addr = self->current_sender()->address();
-      self->state.active_exporters.insert(sender_addr);
+      self->state.active_exporters.emplace(sender_addr, cancellation_token{});
+      self->monitor<caf::message_priority::high>(exporter);
+    },
+    [=](atom::exporter, const actor& exporter,
+        const cancellation_token& token) {
+      auto sender_addr = self->current_sender()->address();
+      self->state.active_exporters.insert_or_assign(sender_addr, token);
       self->monitor<caf::message_priority::high>(exporter);
     },
     [=](atom::status) {
@@ -213,6 +310,72 @@ archive(archive_type::stateful_pointer<archive_state> self, path dir,
       if (auto err = self->state.store->erase(xs))
         VAST_ERROR(self, "failed to erase events:", self->system().render(err));
     },
+    [=](atom::checkpoint) -> id { return self->state.store->watermark(); },
+    [=](atom::compact) {
+      auto& st = self->state;
+      // The COMPACTOR asks us every round, whereas the remaining steps of a
+      // running compaction come from ourselves.
+      if (st.compacting && self->current_sender() != self->ctrl())
+        return;
+      st.compacting = true;
+      auto delay = defaults::system::reclaim_interval;
+      // Merging segments invalidates the segment IDs of a running session, so
+      // we try again later.
+      if (st.session) {
+        VAST_DEBUG(self, "postpones compaction during an extraction");
+      } else {
+        // Compaction shares the rate limit with reclaiming space, and runs
+        // without a limit if reclaiming is disabled.
+        using seconds = std::chrono::duration<double>;
+        auto budget
+          = st.reclaim_rate > 0
+              ? static_cast<uint64_t>(
+                st.reclaim_rate
+                * std::chrono::duration_cast<seconds>(delay).count())
+              : std::numeric_limits<uint64_t>::max();
+        auto bytes = st.store->compact(budget);
+        if (!bytes || *bytes == 0) {
+          if (!bytes)
+            VAST_ERROR(self, "failed to compact the store:",
+                       self->system().render(bytes.error()));
+          st.compacting = false;
+          return;
+        }
+        VAST_VERBOSE(self, "compacted", *bytes, "bytes of segments");
+        if (st.reclaim_rate > 0) {
+          auto elapsed = seconds{static_cast<double>(*bytes) / st.reclaim_rate};
+          delay = std::max(
+            delay, std::chrono::duration_cast<caf::timespan>(elapsed));
+        }
+      }
+      self->delayed_send(self, delay, atom::compact_v);
+    },
+    [=](atom::reclaim) {
+      auto& st = self->state;
+      auto delay = defaults::system::reclaim_interval;
+      // Rewriting segments invalidates the segment IDs of a running session,
+      // so we try again later.
+      if (st.session) {
+        VAST_DEBUG(self, "postpones reclaiming space during an extraction");
+      } else {
+        using seconds = std::chrono::duration<double>;
+        auto budget = static_cast<uint64_t>(
+          st.reclaim_rate * std::chrono::duration_cast<seconds>(delay).count());
+        auto bytes = st.store->reclaim(budget);
+        if (!bytes) {
+          VAST_ERROR(self, "failed to reclaim space of erased events:",
+                     self->system().render(bytes.error()));
+        } else if (*bytes > 0) {
+          VAST_VERBOSE(self, "rewrote", *bytes, "bytes of segments");
+          // Rewriting a large segment may exceed the budget, so we pause until
+          // the rate catches up.
+          auto elapsed = seconds{static_cast<double>(*bytes) / st.reclaim_rate};
+          delay = std::max(
+            delay, std::chrono::duration_cast<caf::timespan>(elapsed));
+        }
+      }
+      self->delayed_send(self, delay, atom::reclaim_v);
+    },
   };
 }
 
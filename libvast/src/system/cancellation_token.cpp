@@ -0,0 +1,24 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/system/cancellation_token.hpp"
+
+namespace vast::system {
+
+cancellation_token cancellation_token::make() {
+  cancellation_token result;
+  result.flag_ = std::make_shared<std::atomic<bool>>(false);
+  return result;
+}
+
+} // namespace vast::system
@@ -0,0 +1,256 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/system/compactor.hpp"
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/column_index.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/uuid.hpp"
+#include "vast/error.hpp"
+#include "vast/logger.hpp"
+#include "vast/qualified_record_field.hpp"
+#include "vast/save.hpp"
+#include "vast/system/partition.hpp"
+#include "vast/table_slice.hpp"
+#include "vast/table_slice_column.hpp"
+
+#include <caf/event_based_actor.hpp>
+
+#include <algorithm>
+
+namespace vast::system {
+
+namespace {
+
+caf::expected<compactor_state::partition_summary>
+summarize(const path& meta_file) {
+  auto meta = partition::load_meta_data(meta_file);
+  if (!meta)
+    return meta.error();
+  compactor_state::partition_summary result{max_id, 0, 0};
+  for (auto& [name, xs] : meta->type_ids) {
+    auto n = rank(xs);
+    if (n == 0)
+      continue;
+    result.first = std::min(result.first, select(xs, 1));
+    result.last = std::max(result.last, xs.size());
+    result.events += n;
+  }
+  return result;
+}
+
+} // namespace
+
+void compactor_state::run() {
+  self->delayed_send(self, interval, atom::run_v);
+  // The ARCHIVE merges its segments on its own, so we only need to nudge it.
+  self->send(archive, atom::compact_v);
+  if (busy)
+    return;
+  busy = true;
+  self->request(index, caf::infinite, atom::compact_v)
+    .then([=](compaction_candidates& xs) { plan(std::move(xs)); },
+          [=](caf::error& err) {
+            VAST_WARNING(self, "failed to retrieve compaction candidates:",
+                         self->system().render(err));
+            finish();
+          });
+}
+
+void compactor_state::plan(compaction_candidates xs) {
+  candidates = std::move(xs);
+  // Summarize new partitions and forget the ones that disappeared.
+  std::unordered_map<uuid, partition_summary> current;
+  for (auto& id : candidates.partitions) {
+    if (auto i = summaries.find(id); i != summaries.end()) {
+      current.emplace(*i);
+      continue;
+    }
+    auto summary = summarize(candidates.dir / to_string(id) / "meta");
+    if (!summary) {
+      VAST_DEBUG(self, "skips partition", id, "without meta data:",
+                 summary.error());
+      continue;
+    }
+    if (summary->events > 0)
+      current.emplace(id, *summary);
+  }
+  summaries = std::move(current);
+  // Partitions cover disjoint ID ranges, so sorting them by their first ID
+  // puts partitions with consecutive events next to each other. We merge the
+  // first run of at least two small neighbors that fits into one partition.
+  std::vector<std::pair<uuid, partition_summary>> parts(summaries.begin(),
+                                                        summaries.end());
+  std::sort(parts.begin(), parts.end(), [](auto& x, auto& y) {
+    return x.second.first < y.second.first;
+  });
+  auto max_events = candidates.max_partition_size;
+  auto small = [&](auto& x) { return x.second.events < max_events / 2; };
+  auto first = parts.end();
+  auto last = parts.end();
+  uint64_t events = 0;
+  for (auto i = parts.begin(); i != parts.end(); ++i) {
+    if (!small(*i))
+      continue;
+    auto j = i;
+    uint64_t n = 0;
+    while (j != parts.end() && small(*j) && n + j->second.events <= max_events)
+      n += (j++)->second.events;
+    if (j - i >= 2) {
+      first = i;
+      last = j;
+      events = n;
+      break;
+    }
+  }
+  if (first == parts.end()) {
+    VAST_DEBUG(self, "found no partitions to merge");
+    return finish();
+  }
+  // Fetch all events of the selected partitions from the ARCHIVE.
+  sources.clear();
+  ids selection;
+  for (auto i = first; i != last; ++i) {
+    sources.push_back(i->first);
+    selection.append_bits(false, i->second.first - selection.size());
+    selection.append_bits(true, i->second.last - i->second.first);
+  }
+  VAST_DEBUG(self, "fetches", events, "events of", sources.size(),
+             "partitions");
+  slices.clear();
+  self->send(archive, std::move(selection));
+}
+
+void compactor_state::build() {
+  auto new_id = uuid::random();
+  auto part_dir = candidates.dir / to_string(new_id);
+  auto fail = [&](const caf::error& err) {
+    VAST_ERROR(self, "failed to write partition", new_id, ":",
+               self->system().render(err));
+    rm(part_dir);
+    finish();
+  };
+  std::sort(slices.begin(), slices.end(), [](auto& x, auto& y) {
+    return x->offset() < y->offset();
+  });
+  partition::meta_data meta;
+  std::unordered_map<qualified_record_field, column_index_ptr> columns;
+  meta_index synopses;
+  synopses.factory_options() = candidates.synopsis_options;
+  // If the ARCHIVE no longer has any of the events, we drop the partitions
+  // without a replacement.
+  if (!slices.empty())
+    if (auto res = mkdir(part_dir); !res)
+      return fail(res.error());
+  for (auto& slice : slices) {
+    auto& layout = slice->layout();
+    meta.layouts.emplace(layout);
+    auto& xs = meta.type_ids[layout.name()];
+    VAST_ASSERT(slice->offset() >= xs.size());
+    xs.append_bits(false, slice->offset() - xs.size());
+    xs.append_bits(true, slice->rows());
+    for (size_t col = 0; col < layout.fields.size(); ++col) {
+      auto fqf = qualified_record_field{layout.name(), layout.fields[col]};
+      auto i = columns.find(fqf);
+      if (i == columns.end()) {
+        auto filename = part_dir / (fqf.fqn() + "-" + to_digest(fqf.type));
+        caf::settings index_opts;
+        index_opts["cardinality"] = candidates.max_partition_size;
+        auto x = make_column_index(self->system(), std::move(filename),
+                                   fqf.type, std::move(index_opts));
+        if (!x)
+          return fail(x.error());
+        i = columns.emplace(std::move(fqf), std::move(*x)).first;
+      }
+      i->second->add(table_slice_column{slice, col});
+    }
+    synopses.add(new_id, slice);
+  }
+  if (!slices.empty()) {
+    record_type combined_type;
+    for (auto& [fqf, col] : columns) {
+      if (auto err = col->flush_to_disk())
+        return fail(err);
+      combined_type.fields.push_back(as_record_field(fqf));
+    }
+    if (auto err = save(nullptr, part_dir / "meta", meta, combined_type))
+      return fail(err);
+  }
+  auto num_slices = slices.size();
+  slices.clear();
+  compacted_partition result{new_id, sources, std::move(synopses)};
+  self->request(index, caf::infinite, atom::compact_v, std::move(result))
+    .then(
+      [=](bool accepted) {
+        if (accepted) {
+          VAST_VERBOSE(self, "merged", sources.size(), "partitions into",
+                       new_id);
+          for (auto& source : sources)
+            summaries.erase(source);
+        } else {
+          VAST_DEBUG(self, "discards partition", new_id,
+                     "after the INDEX rejected it");
+          rm(part_dir);
+        }
+        finish();
+      },
+      [=](caf::error& err) {
+        VAST_ERROR(self, "failed to replace partitions:",
+                   self->system().render(err));
+        rm(part_dir);
+        finish();
+      });
+  VAST_DEBUG(self, "wrote partition", new_id, "from", num_slices, "slices");
+}
+
+void compactor_state::finish() {
+  busy = false;
+  candidates = {};
+  sources.clear();
+  slices.clear();
+}
+
+caf::behavior
+compactor(caf::stateful_actor<compactor_state>* self, caf::timespan interval,
+          caf::actor index, caf::actor archive) {
+  VAST_TRACE(VAST_ARG(interval), VAST_ARG(index), VAST_ARG(archive));
+  auto& st = self->state;
+  st.self = self;
+  st.interval = interval;
+  st.index = std::move(index);
+  st.archive = std::move(archive);
+  // Register as receiver for events, which the ARCHIVE requires before
+  // answering ID lookups.
+  self->send(st.archive, atom::exporter_v, caf::actor_cast<caf::actor>(self));
+  self->delayed_send(self, interval, atom::run_v);
+  return {
+    [=](atom::run) { self->state.run(); },
+    [=](table_slice_ptr& slice) {
+      self->state.slices.push_back(std::move(slice));
+    },
+    [=](atom::done, const caf::error& err) {
+      auto& st = self->state;
+      if (st.sources.empty())
+        return;
+      if (err) {
+        VAST_WARNING(self, "failed to fetch events from the archive:",
+                     self->system().render(err));
+        return st.finish();
+      }
+      st.build();
+    },
+  };
+}
+
+} // namespace vast::system
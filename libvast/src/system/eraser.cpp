@@ -15,14 +15,20 @@
 
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/error.hpp"
 #include "vast/expression.hpp"
+#include "vast/expression_visitors.hpp"
 #include "vast/fwd.hpp"
 #include "vast/logger.hpp"
+#include "vast/query_options.hpp"
+#include "vast/table_slice.hpp"
 
 #include <caf/event_based_actor.hpp>
 #include <caf/stateful_actor.hpp>
 #include <caf/timespan.hpp>
 
+#include <utility>
+
 namespace vast::system {
 
 eraser_state::eraser_state(caf::event_based_actor* self) : super{self} {
@@ -38,6 +44,9 @@ void eraser_state::init(caf::timespan interval, std::string query,
   query_ = std::move(query);
   index_ = std::move(index);
   archive_ = std::move(archive);
+  // Register as receiver for events, which the ARCHIVE requires before
+  // answering ID lookups.
+  self_->send(archive_, atom::exporter_v, caf::actor_cast<caf::actor>(self_));
   // Override the behavior for the idle state.
   behaviors_[idle].assign([=](atom::run) {
     if (self_->current_sender() != self_->ctrl())
@@ -51,7 +60,10 @@ void eraser_state::init(caf::timespan interval, std::string query,
       VAST_ERROR(self_, "failed to normalize and validate", query_);
       return;
     }
-    self_->send(index_, std::move(*expr));
+    expr_ = *expr;
+    checkers_.clear();
+    // Aging must not delay the queries of users.
+    self_->send(index_, std::move(*expr), historical + background);
     transition_to(await_query_id);
   });
   // Trigger the delayed send message.
@@ -85,12 +97,54 @@ void eraser_state::process_end_of_hits() {
     request_more_hits(n);
     return;
   }
-  // Tell the ARCHIVE to erase all hits.
-  using std::swap;
-  ids all_hits;
-  swap(all_hits, hits_);
-  self_->send(archive_, atom::erase_v, std::move(all_hits));
-  transition_to(idle);
+  if (!any(hits_)) {
+    self_->send(archive_, atom::erase_v, std::exchange(hits_, {}));
+    transition_to(idle);
+    return;
+  }
+  verify_hits();
+}
+
+void eraser_state::verify_hits() {
+  VAST_DEBUG(self_, "checks", rank(hits_), "hits against the archive");
+  verified_ = {};
+  self_->send(archive_, hits_);
+  // We remain in the state for collecting hits, where the default handler
+  // skips all other messages, until the ARCHIVE delivered all events.
+  self_->become(
+    [=](table_slice_ptr slice) { verify(*slice); },
+    [=](atom::done, const caf::error& err) {
+      hits_ = {};
+      if (err) {
+        // Erasing unchecked hits could remove events that do not match, so
+        // we rather try again in the next cycle.
+        VAST_ERROR(self_, "failed to check hits against the archive:",
+                   self_->system().render(err));
+        verified_ = {};
+        transition_to(idle);
+        return;
+      }
+      // Tell the ARCHIVE to erase all matching hits.
+      self_->send(archive_, atom::erase_v, std::exchange(verified_, {}));
+      transition_to(idle);
+    });
+}
+
+void eraser_state::verify(const table_slice& slice) {
+  type layout = slice.layout();
+  auto i = checkers_.find(layout);
+  if (i == checkers_.end()) {
+    auto x = tailor(expr_, layout);
+    if (!x) {
+      VAST_WARNING(self_, "keeps events of type", layout.name(),
+                   "because it failed to tailor the query:",
+                   self_->system().render(x.error()));
+      x = expression{};
+    }
+    // An empty expression selects no rows.
+    i = checkers_.emplace(std::move(layout), std::move(*x)).first;
+  }
+  verified_ |= evaluate(slice, i->second) & hits_;
 }
 
 caf::behavior
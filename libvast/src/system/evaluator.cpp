@@ -13,8 +13,11 @@
 
 #include "vast/system/evaluator.hpp"
 
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/detail/overload.hpp"
 #include "vast/expression_visitors.hpp"
 #include "vast/fwd.hpp"
+#include "vast/ids.hpp"
 #include "vast/logger.hpp"
 #include "vast/system/index_common.hpp"
 
@@ -23,6 +26,9 @@
 #include <caf/event_based_actor.hpp>
 #include <caf/stateful_actor.hpp>
 
+#include <algorithm>
+#include <vector>
+
 namespace vast::system {
 
 namespace {
@@ -31,8 +37,14 @@ namespace {
 /// conjunctions, disjunctions, and negations.
 class ids_evaluator {
 public:
-  ids_evaluator(const evaluator_state::predicate_hits_map& xs) : hits_(xs) {
-    push();
+  /// @param xs The hits per predicate.
+  /// @param position The offset of the evaluated expression in the full
+  ///                 query, e.g., `{0, i}` for the *i*-th operand of a
+  ///                 top-level connective.
+  explicit ids_evaluator(const evaluator_state::predicate_hits_map& xs,
+                         offset position = {0})
+    : hits_(xs), position_(std::move(position)) {
+    // nop
   }
 
   ids operator()(caf::none_t) {
@@ -42,19 +54,24 @@ public:
   template <class Connective>
   ids operator()(const Connective& xs) {
     VAST_ASSERT(xs.size() > 0);
+    // Disjunctions combine their operands in a single n-way merge, whereas
+    // conjunctions fold them pairwise because their intermediate results
+    // shrink quickly.
+    std::vector<ids> operands;
+    operands.reserve(xs.size());
     push();
-    auto result = caf::visit(*this, xs[0]);
+    operands.push_back(caf::visit(*this, xs[0]));
     for (size_t index = 1; index < xs.size(); ++index) {
       next();
-      if constexpr (std::is_same_v<Connective, conjunction>) {
-        result &= caf::visit(*this, xs[index]);
-      } else {
-        static_assert(std::is_same_v<Connective, disjunction>);
-        result |= caf::visit(*this, xs[index]);
-      }
+      operands.push_back(caf::visit(*this, xs[index]));
     }
     pop();
-    return result;
+    if constexpr (std::is_same_v<Connective, conjunction>) {
+      return nary_and(operands.begin(), operands.end());
+    } else {
+      static_assert(std::is_same_v<Connective, disjunction>);
+      return nary_or(operands.begin(), operands.end());
+    }
   }
 
   ids operator()(const negation& n) {
@@ -90,19 +107,65 @@ private:
 
 } // namespace
 
+double estimate_selectivity(const curried_predicate& pred) {
+  // This is a coarse heuristic based on the operator and the type of the
+  // value: equality lookups for addresses and strings usually single out a
+  // few events, whereas negations match almost everything.
+  switch (pred.op) {
+    default:
+      break;
+    case not_match:
+    case not_in:
+    case not_ni:
+    case not_equal:
+      return 0.99;
+    case less:
+    case less_equal:
+    case greater:
+    case greater_equal:
+      return 0.3;
+  }
+  auto is_equality = pred.op == equal || pred.op == in;
+  return caf::visit(detail::overload(
+                      [](const auto&) { return 0.1; },
+                      [](bool) { return 0.5; },
+                      [&](const address&) { return is_equality ? 0.01 : 0.1; },
+                      [&](const std::string&) {
+                        return is_equality ? 0.01 : 0.05;
+                      }),
+                    pred.rhs);
+}
+
 evaluator_state::evaluator_state(caf::event_based_actor* self) : self(self) {
   // nop
 }
 
 void evaluator_state::init(caf::actor client, expression expr,
-                           caf::response_promise promise) {
+                           caf::response_promise promise,
+                           cancellation_token token) {
   VAST_TRACE(VAST_ARG(client), VAST_ARG(expr), VAST_ARG(promise));
   this->client = std::move(client);
   this->expr = std::move(expr);
   this->promise = std::move(promise);
+  this->token = std::move(token);
+}
+
+bool evaluator_state::abandon() {
+  if (abandoned)
+    return true;
+  if (!token.cancelled())
+    return false;
+  VAST_DEBUG(self, "abandons its cancelled query with", pending_responses,
+             "pending responses");
+  abandoned = true;
+  stages.clear();
+  promise.deliver(atom::done_v);
+  return true;
 }
 
 void evaluator_state::handle_result(const offset& position, const ids& result) {
+  if (abandon())
+    return;
   VAST_DEBUG(self, "got", result.size(), "new hits for predicate at position",
              position);
   auto ptr = hits_for(position);
@@ -118,9 +181,12 @@ void evaluator_state::handle_result(const offset& position, const ids& result) {
 
 void evaluator_state::handle_missing_result(const offset& position,
                                             const caf::error& err) {
+  if (abandon())
+    return;
   VAST_IGNORE_UNUSED(err);
   VAST_WARNING(self, "INDEXER returned", self->system().render(err),
                "instead of a result for predicate at position", position);
+  complete = false;
   auto ptr = hits_for(position);
   VAST_ASSERT(ptr != nullptr);
   if (--ptr->first == 0) {
@@ -141,9 +207,14 @@ void evaluator_state::evaluate() {
 }
 
 void evaluator_state::decrement_pending() {
+  --pending_responses;
+  if (stage_responses > 0 && --stage_responses == 0)
+    next_stage();
   // We're done evaluating if all INDEXER actors have reported their hits.
-  if (--pending_responses == 0) {
+  if (pending_responses == 0) {
     VAST_DEBUG(self, "completed expression evaluation");
+    if (hits_listener && complete)
+      self->send(hits_listener, atom::store_v, partition_id, expr, hits);
     promise.deliver(atom::done_v);
   }
 }
@@ -154,36 +225,160 @@ evaluator_state::hits_for(const offset& position) {
   return i != predicate_hits.end() ? &i->second : nullptr;
 }
 
+void evaluator_state::schedule(const evaluation_triples& triples,
+                               const ids* candidates) {
+  using std::get;
+  for (auto& triple : triples) {
+    // No strucutured bindings available due to subsequent lambda. :-/
+    // TODO: C++20
+    auto& pos = get<0>(triple);
+    auto& curried_pred = get<1>(triple);
+    auto& indexer = get<2>(triple);
+    auto on_hits = [=](const ids& hits) {
+      self->state.handle_result(pos, hits);
+    };
+    auto on_error = [=](const caf::error& err) {
+      self->state.handle_missing_result(pos, err);
+    };
+    // Only pass the token along if there is something to cancel, which
+    // allows the INDEXER to skip lookups for abandoned queries.
+    if (candidates && token)
+      self->request(indexer, caf::infinite, curried_pred, *candidates, token)
+        .then(on_hits, on_error);
+    else if (candidates)
+      self->request(indexer, caf::infinite, curried_pred, *candidates)
+        .then(on_hits, on_error);
+    else if (token)
+      self->request(indexer, caf::infinite, curried_pred, token)
+        .then(on_hits, on_error);
+    else
+      self->request(indexer, caf::infinite, curried_pred)
+        .then(on_hits, on_error);
+  }
+}
+
+void evaluator_state::start_stages() {
+  if (abandon())
+    return;
+  // The stages run from back to front, so sorting by descending selectivity
+  // starts with the most selective operand.
+  std::stable_sort(stages.begin(), stages.end(), [](auto& x, auto& y) {
+    return x.selectivity > y.selectivity;
+  });
+  auto x = std::move(stages.back());
+  stages.pop_back();
+  completed_operands.push_back(x.operand);
+  stage_responses = x.triples.size();
+  schedule(x.triples, nullptr);
+}
+
+void evaluator_state::next_stage() {
+  if (stages.empty())
+    return;
+  VAST_ASSERT(caf::holds_alternative<conjunction>(expr));
+  auto& conj = caf::get<conjunction>(expr);
+  std::vector<ids> operands;
+  operands.reserve(completed_operands.size());
+  for (auto i : completed_operands)
+    operands.push_back(
+      caf::visit(ids_evaluator{predicate_hits, offset{0, i}}, conj[i]));
+  auto candidates = nary_and(operands.begin(), operands.end());
+  if (!any<1>(candidates)) {
+    // No event can satisfy the conjunction anymore.
+    VAST_DEBUG(self, "skips", stages.size(), "stages without candidates");
+    for (auto& x : stages)
+      pending_responses -= x.triples.size();
+    stages.clear();
+    return;
+  }
+  auto x = std::move(stages.back());
+  stages.pop_back();
+  VAST_DEBUG(self, "evaluates operand", x.operand, "for", rank(candidates),
+             "candidates");
+  completed_operands.push_back(x.operand);
+  stage_responses = x.triples.size();
+  schedule(x.triples, &candidates);
+}
+
 caf::behavior evaluator(caf::stateful_actor<evaluator_state>* self,
                         expression expr, evaluation_triples eval) {
   VAST_TRACE(VAST_ARG(expr), VAST_ARG(eval));
   VAST_ASSERT(!eval.empty());
   using std::get;
   using std::move;
-  return {[=, expr{move(expr)}, eval{move(eval)}](caf::actor client) {
+  auto start = [=, expr{move(expr)}, eval{move(eval)}](
+                 caf::actor client, cancellation_token token) {
     auto& st = self->state;
-    st.init(client, move(expr), self->make_response_promise());
+    st.init(client, move(expr), self->make_response_promise(),
+            std::move(token));
+    if (st.abandon())
+      return;
     st.pending_responses += eval.size();
-    for (auto& triple : eval) {
-      // No strucutured bindings available due to subsequent lambda. :-/
-      // TODO: C++20
-      auto& pos = get<0>(triple);
-      auto& curried_pred = get<1>(triple);
-      auto& indexer = get<2>(triple);
-      ++st.predicate_hits[pos].first;
-      self->request(indexer, caf::infinite, curried_pred)
-        .then([=](const ids& hits) { self->state.handle_result(pos, hits); },
-              [=](const caf::error& err) {
-                self->state.handle_missing_result(pos, err);
-              });
+    for (auto& triple : eval)
+      ++st.predicate_hits[get<0>(triple)].first;
+    // Group the lookups of a top-level conjunction by operand, such that we
+    // can evaluate the operands one after another and restrict each lookup to
+    // the events that satisfy all previous operands.
+    if (caf::holds_alternative<conjunction>(st.expr)) {
+      for (auto& triple : eval) {
+        auto& pos = get<0>(triple);
+        VAST_ASSERT(pos.size() > 1);
+        auto pred = [&](auto& x) { return x.operand == pos[1]; };
+        auto i = std::find_if(st.stages.begin(), st.stages.end(), pred);
+        if (i == st.stages.end())
+          st.stages.push_back({pos[1], 0.0, {triple}});
+        else
+          i->triples.push_back(triple);
+      }
+      if (st.stages.size() < 2)
+        st.stages.clear();
+    }
+    if (st.stages.empty()) {
+      st.schedule(eval, nullptr);
+    } else {
+      // Collect the selectivity estimates from the column statistics of the
+      // INDEXER actors before deciding on the order of the stages. This costs
+      // one extra round trip before the first lookup. The requests are all in
+      // flight at once and the INDEXER actors answer them from memory without
+      // touching their value indexes.
+      st.pending_estimates = eval.size();
+      for (auto& stage : st.stages) {
+        for (auto& triple : stage.triples) {
+          auto operand = stage.operand;
+          auto& curried_pred = get<1>(triple);
+          auto update = [=](double selectivity) {
+            auto& state = self->state;
+            for (auto& x : state.stages)
+              if (x.operand == operand)
+                x.selectivity = std::max(x.selectivity, selectivity);
+            if (--state.pending_estimates == 0)
+              state.start_stages();
+          };
+          self
+            ->request(get<2>(triple), caf::infinite, atom::statistics_v,
+                      curried_pred)
+            .then(update, [=](const caf::error&) {
+              update(estimate_selectivity(curried_pred));
+            });
+        }
+      }
     }
     if (st.pending_responses == 0) {
       VAST_DEBUG(self, "has nothing to evaluate for expression");
       st.promise.deliver(atom::done_v);
     }
-    // We can only deal with exactly one expression/client at the moment.
-    self->unbecome();
-  }};
+  };
+  return {
+    [=](caf::actor client) {
+      start(std::move(client), cancellation_token{});
+      // We can only deal with exactly one expression/client at the moment.
+      self->unbecome();
+    },
+    [=](caf::actor client, cancellation_token token) {
+      start(std::move(client), std::move(token));
+      self->unbecome();
+    },
+  };
 }
 
 } // namespace vast::system
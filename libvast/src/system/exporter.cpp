@@ -34,6 +34,8 @@
 #include <caf/event_based_actor.hpp>
 #include <caf/settings.hpp>
 
+#include <utility>
+
 using namespace std::chrono;
 using namespace std::string_literals;
 using namespace caf;
@@ -104,6 +106,16 @@ void shutdown(stateful_actor<exporter_state>* self) {
   self->send_exit(self, exit_reason::normal);
 }
 
+void lookup_deferred_hits(stateful_actor<exporter_state>* self) {
+  auto& st = self->state;
+  if (st.query.requested == 0 || rank(st.deferred_hits) == 0)
+    return;
+  VAST_DEBUG(self, "forwards", rank(st.deferred_hits),
+             "deferred hits to archive");
+  ++st.query.lookups_issued;
+  self->send(st.archive, std::exchange(st.deferred_hits, ids{}));
+}
+
 void request_more_hits(stateful_actor<exporter_state>* self) {
   auto& st = self->state;
   // Sanity check.
@@ -111,7 +123,9 @@ void request_more_hits(stateful_actor<exporter_state>* self) {
     VAST_WARNING(self, "requested more hits for continuous query");
     return;
   }
-  // Do nothing if we already shipped everything the client asked for.
+  // Do nothing if we already shipped everything the client asked for. This
+  // stops scheduling further partitions as soon as the client has enough
+  // results, e.g., after reaching max-events.
   if (st.query.requested == 0) {
     VAST_DEBUG(self, "shipped", self->state.query.shipped,
                "results and waits for client to request more");
@@ -169,6 +183,9 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
   self->state.expr = std::move(expr);
   if (has_continuous_option(options))
     VAST_DEBUG(self, "has continuous query option");
+  // Cancel the query regardless of how the EXPORTER terminates.
+  self->attach_functor(
+    [token = self->state.token](const caf::error&) { token.cancel(); });
   self->set_exit_handler(
     [=](const exit_msg& msg) {
       VAST_DEBUG(self, "received exit from", msg.source, "with reason:", msg.reason);
@@ -256,10 +273,16 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
         VAST_DEBUG(self, "got", count, "index hits in [", (select(hits, 1)),
                    ',', (select(hits, -1) + 1), ')');
         st.hits |= hits;
-        VAST_DEBUG(self, "forwards hits to archive");
-        // FIXME: restrict according to configured limit.
-        ++st.query.lookups_issued;
-        self->send(st.archive, std::move(hits));
+        if (st.query.requested == 0) {
+          // Hits of already scheduled partitions may arrive after we shipped
+          // everything the client asked for.
+          VAST_DEBUG(self, "defers archive lookup until client asks for more");
+          st.deferred_hits |= hits;
+        } else {
+          VAST_DEBUG(self, "forwards hits to archive");
+          ++st.query.lookups_issued;
+          self->send(st.archive, std::move(hits));
+        }
       }
       return caf::unit;
     },
@@ -318,6 +341,7 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
       // Configure state to get all remaining partition results.
       qs.requested = max_events;
       ship_results(self);
+      lookup_deferred_hits(self);
       request_more_hits(self);
     },
     [=](atom::extract, uint64_t requested_results) {
@@ -339,6 +363,7 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
                  "pending results");
       qs.requested += n;
       ship_results(self);
+      lookup_deferred_hits(self);
       request_more_hits(self);
     },
     [=](atom::status) {
@@ -353,7 +378,7 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
         self->monitor(archive);
       // Register self at the archive
       if (has_historical_option(self->state.options))
-        self->send(archive, atom::exporter_v, self);
+        self->send(archive, atom::exporter_v, self, self->state.token);
     },
     [=](atom::index, const actor& index) {
       VAST_DEBUG(self, "registers index", index);
@@ -377,7 +402,8 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
       self->state.start = system_clock::now();
       if (!has_historical_option(self->state.options))
         return;
-      self->request(self->state.index, infinite, self->state.expr)
+      self->request(self->state.index, infinite, self->state.expr,
+                    self->state.options, self->state.token)
         .then(
           [=](const uuid& lookup, uint32_t partitions, uint32_t scheduled) {
             VAST_DEBUG(self, "got lookup handle", lookup, ", scheduled",
@@ -13,6 +13,8 @@
 
 #include "vast/system/importer.hpp"
 
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/time.hpp"
 #include "vast/concept/printable/numeric/integral.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/error.hpp"
@@ -24,13 +26,16 @@
 #include "vast/si_literals.hpp"
 #include "vast/system/type_registry.hpp"
 #include "vast/table_slice.hpp"
+#include "vast/write_ahead_log.hpp"
 
 #include <caf/atom.hpp>
 #include <caf/attach_continuous_stream_stage.hpp>
 #include <caf/config_value.hpp>
 #include <caf/settings.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
 
 namespace vast::system {
 
@@ -113,11 +118,54 @@ caf::dictionary<caf::config_value> importer_state::status() const {
   caf::put(result, "ids.available", to_string(available_ids()));
   caf::put(result, "ids.block.next", to_string(current.next));
   caf::put(result, "ids.block.end", to_string(current.end));
+  if (wal)
+    wal->inspect_status(put_dictionary(result, "write-ahead-log"));
   // General state such as open streams.
   detail::fill_status_map(result, self);
   return result;
 }
 
+void importer_state::log(const table_slice_ptr& x) {
+  if (auto err = wal->append(x))
+    VAST_ERROR(self, "failed to append to the write-ahead log:",
+               self->system().render(err));
+  if (!sync_scheduled) {
+    sync_scheduled = true;
+    self->delayed_send(self, sync_interval, atom::flush_v);
+  }
+}
+
+void importer_state::checkpoint() {
+  if (checkpointing || wal->sealed_files() == 0 || !archive
+      || index_actors.empty())
+    return;
+  checkpointing = true;
+  // Every component reports the ID below which it persisted all events, and
+  // the smallest of them tells how much of the log is no longer needed.
+  auto watermark = std::make_shared<id>(max_id);
+  auto pending = std::make_shared<size_t>(1 + index_actors.size());
+  auto complete = [=](id x) {
+    *watermark = std::min(*watermark, x);
+    if (--*pending > 0)
+      return;
+    checkpointing = false;
+    VAST_DEBUG(self, "truncates the write-ahead log up to", *watermark);
+    if (auto err = wal->truncate(*watermark))
+      VAST_ERROR(self, "failed to truncate the write-ahead log:",
+                 self->system().render(err));
+  };
+  auto fail = [=](caf::error& err) {
+    VAST_WARNING(self, "failed to retrieve a watermark:",
+                 self->system().render(err));
+    complete(0);
+  };
+  self->request(archive, caf::infinite, atom::checkpoint_v)
+    .then(complete, fail);
+  for (auto& index : index_actors)
+    self->request(index, caf::infinite, atom::checkpoint_v)
+      .then(complete, fail);
+}
+
 void importer_state::send_report() {
   auto now = stopwatch::now();
   if (measurement_.events > 0) {
@@ -143,6 +191,32 @@ caf::behavior importer(importer_actor* self, path dir, archive_type archive,
     return {};
   }
   namespace defs = defaults::system;
+  auto& cfg = self->system().config();
+  if (get_or(cfg, "system.write-ahead-log", defs::write_ahead_log)) {
+    using namespace binary_byte_literals;
+    auto file_size = 1_MiB
+                     * get_or(cfg, "system.write-ahead-log-file-size",
+                              defs::write_ahead_log_file_size);
+    if (auto str = caf::get_if<std::string>(&cfg, "system.write-ahead-log-"
+                                                  "sync-interval")) {
+      auto interval = to<duration>(*str);
+      if (!interval) {
+        VAST_ERROR(self, "got an invalid write-ahead log sync interval:",
+                   *str);
+        self->quit(std::move(interval.error()));
+        return {};
+      }
+      self->state.sync_interval = *interval;
+    }
+    auto wal = write_ahead_log::make(dir / "wal", file_size);
+    if (!wal) {
+      VAST_ERROR(self, "failed to open the write-ahead log:",
+                 self->system().render(wal.error()));
+      self->quit(std::move(wal.error()));
+      return {};
+    }
+    self->state.wal = std::move(*wal);
+  }
   if (auto a = self->system().registry().get(atom::accountant_v)) {
     self->state.accountant = caf::actor_cast<accountant_type>(a);
     self->send(self->state.accountant, atom::announce_v, self->name());
@@ -166,6 +240,8 @@ caf::behavior importer(importer_actor* self, path dir, archive_type archive,
       VAST_ASSERT(x->rows() <= static_cast<size_t>(st.available_ids()));
       auto events = x->rows();
       x.unshared().offset(st.next_id(events));
+      if (st.wal)
+        st.log(x);
       out.push(std::move(x));
       t.stop(events);
     },
@@ -174,15 +250,35 @@ caf::behavior importer(importer_actor* self, path dir, archive_type archive,
     });
   if (type_registry)
     self->state.stg->add_outbound_path(type_registry);
-  if (archive)
+  if (archive) {
+    self->state.archive = archive;
     self->state.stg->add_outbound_path(archive);
+  }
   if (index) {
     self->state.index_actors.emplace_back(index);
     self->state.stg->add_outbound_path(index);
   }
+  if (self->state.wal) {
+    // Send all events that did not become durable before the last shutdown
+    // downstream again, with the IDs they got back then. The ARCHIVE and the
+    // INDEX skip the slices that they persisted before.
+    auto& st = self->state;
+    auto replayed = st.wal->replay(
+      [&](table_slice_ptr x) { st.stg->out().push(std::move(x)); });
+    if (!replayed) {
+      VAST_ERROR(self, "failed to replay the write-ahead log:",
+                 self->system().render(replayed.error()));
+      self->quit(std::move(replayed.error()));
+      return {};
+    }
+    if (*replayed > 0)
+      VAST_INFO(self, "replays", *replayed, "table slices from the "
+                                             "write-ahead log");
+  }
   return {
     [=](const archive_type& archive) {
       VAST_DEBUG(self, "registers archive", archive);
+      self->state.archive = archive;
       return self->state.stg->add_outbound_path(archive);
     },
     [=](atom::index, const caf::actor& index) {
@@ -220,6 +316,14 @@ caf::behavior importer(importer_actor* self, path dir, archive_type archive,
       for (auto& next : st.index_actors)
         self->send(next, atom::subscribe_v, atom::flush_v, listener);
     },
+    [=](atom::flush) {
+      auto& st = self->state;
+      st.sync_scheduled = false;
+      if (auto err = st.wal->sync())
+        VAST_ERROR(self, "failed to sync the write-ahead log:",
+                   self->system().render(err));
+      st.checkpoint();
+    },
     [=](atom::status) { return self->state.status(); },
     [=](atom::telemetry) {
       self->state.send_report();
@@ -15,6 +15,7 @@
 
 #include "vast/chunk.hpp"
 #include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/uuid.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/bitmap.hpp"
 #include "vast/concept/printable/vast/error.hpp"
@@ -36,22 +37,31 @@
 #include "vast/load.hpp"
 #include "vast/logger.hpp"
 #include "vast/save.hpp"
+#include "vast/si_literals.hpp"
 #include "vast/system/accountant.hpp"
+#include "vast/system/compactor.hpp"
 #include "vast/system/evaluator.hpp"
 #include "vast/system/index_common.hpp"
 #include "vast/system/partition.hpp"
+#include "vast/system/query_cache.hpp"
 #include "vast/system/query_supervisor.hpp"
+#include "vast/system/report.hpp"
 #include "vast/system/spawn_indexer.hpp"
 #include "vast/table_slice.hpp"
 
 #include <caf/make_counted.hpp>
+#include <caf/send.hpp>
 #include <caf/stateful_actor.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <deque>
+#include <future>
+#include <memory>
 #include <unordered_set>
 
 using namespace std::chrono;
+using namespace vast::binary_byte_literals;
 
 namespace vast::system {
 
@@ -64,6 +74,23 @@ auto make_index_stage(index_state* st) {
   return result;
 }
 
+/// Answers an INDEX worker like an EVALUATOR, but with the hits from the
+/// query cache.
+caf::behavior cached_evaluator(caf::event_based_actor* self, ids hits) {
+  return {
+    [=](const caf::actor& client) {
+      if (any<1>(hits))
+        self->send(client, hits);
+      return atom::done_v;
+    },
+    [=](const caf::actor& client, const cancellation_token& token) {
+      if (!token.cancelled() && any<1>(hits))
+        self->send(client, hits);
+      return atom::done_v;
+    },
+  };
+}
+
 } // namespace
 
 partition_ptr index_state::partition_factory::operator()(const uuid& id) const {
@@ -82,6 +109,9 @@ partition_ptr index_state::partition_factory::operator()(const uuid& id) const {
 
 index_state::index_state(caf::stateful_actor<index_state>* self)
   : self(self),
+    scheduler({defaults::system::interactive_query_weight,
+               defaults::system::batch_query_weight,
+               defaults::system::background_query_weight}),
     factory(spawn_indexer),
     lru_partitions(10, partition_lookup{}, partition_factory{this}) {
   // nop
@@ -108,6 +138,21 @@ index_state::init(const path& dir, size_t max_partition_size,
   this->max_partition_size = max_partition_size;
   this->lru_partitions.size(in_mem_partitions);
   this->taste_partitions = taste_partitions;
+  auto cache_size = get_or(self->system().config(), "system.query-cache-size",
+                           defaults::system::query_cache_size);
+  this->result_cache.max_bytes(cache_size * 1_MiB);
+  auto num_loaders = get_or(self->system().config(), "system.partition-loaders",
+                            defaults::system::partition_loaders);
+  this->loaders = std::make_unique<detail::thread_pool>(num_loaders);
+  auto num_indexing_threads
+    = get_or(self->system().config(), "system.indexing-threads",
+             defaults::system::indexing_threads);
+  if (num_indexing_threads > 0) {
+    VAST_VERBOSE(self, "indexes columns with", num_indexing_threads,
+                 "threads");
+    this->indexing_pool
+      = std::make_unique<detail::work_stealing_pool>(num_indexing_threads);
+  }
   if (auto a = self->system().registry().get(atom::accountant_v)) {
     namespace defs = defaults::system;
     this->accountant = caf::actor_cast<accountant_type>(a);
@@ -119,6 +164,9 @@ index_state::init(const path& dir, size_t max_partition_size,
     return err;
   // Spin up the stream manager.
   stage = make_index_stage(this);
+  if (indexing_pool != nullptr)
+    stage->out().pool_capacity(
+      detail::narrow<int32_t>(defaults::system::indexing_backlog));
   return caf::none;
 }
 
@@ -138,6 +186,22 @@ caf::error index_state::load_from_disk() {
     }
     VAST_DEBUG(self, "loaded statistics");
   }
+  if (auto fname = column_statistics_filename(); exists(fname)) {
+    VAST_VERBOSE(self, "loads column statistics from", fname);
+    if (auto err = load(&self->system(), fname, column_stats)) {
+      VAST_ERROR(self, "failed to load column statistics:",
+                 self->system().render(err));
+      return err;
+    }
+  }
+  if (auto fname = persisted_ids_filename(); exists(fname)) {
+    VAST_VERBOSE(self, "loads persisted IDs from", fname);
+    if (auto err = load(&self->system(), fname, persisted_ids)) {
+      VAST_ERROR(self, "failed to load persisted IDs:",
+                 self->system().render(err));
+      return err;
+    }
+  }
   if (auto fname = meta_index_filename(); exists(fname)) {
     VAST_VERBOSE(self, "loads meta index from", fname);
     auto buffer = io::read(fname);
@@ -164,7 +228,14 @@ caf::error index_state::flush_meta_index() {
 
 caf::error index_state::flush_statistics() {
   VAST_VERBOSE(self, "writes statistics to", statistics_filename());
-  return save(&self->system(), statistics_filename(), stats);
+  if (auto err = save(&self->system(), statistics_filename(), stats))
+    return err;
+  return save(&self->system(), column_statistics_filename(), column_stats);
+}
+
+caf::error index_state::flush_persisted_ids() {
+  VAST_VERBOSE(self, "writes persisted IDs to", persisted_ids_filename());
+  return save(&self->system(), persisted_ids_filename(), persisted_ids);
 }
 
 caf::error index_state::flush_to_disk() {
@@ -186,7 +257,11 @@ caf::error index_state::flush_to_disk() {
     for (auto& kvp : unpersisted)
       if (auto err = kvp.first->flush_to_disk())
         return err;
-    return caf::none;
+    // We cannot know whether the INDEXER actors of the active and unpersisted
+    // partitions write all of their events before shutting down. Hence, we
+    // only record partitions that confirmed persisting, and the IMPORTER
+    // replays the remaining events after a restart.
+    return flush_persisted_ids();
   };
   if (auto err = flush_all()) {
     VAST_ERROR(self, "failed to flush state:", self->system().render(err));
@@ -199,10 +274,18 @@ path index_state::statistics_filename() const {
   return dir / "statistics";
 }
 
+path index_state::column_statistics_filename() const {
+  return dir / "column-statistics";
+}
+
 path index_state::meta_index_filename() const {
   return dir / "meta";
 }
 
+path index_state::persisted_ids_filename() const {
+  return dir / "persisted-ids";
+}
+
 bool index_state::worker_available() {
   return !idle_workers.empty();
 }
@@ -213,6 +296,24 @@ caf::actor index_state::next_worker() {
   return result;
 }
 
+void index_state::release_worker(caf::actor worker) {
+  worker_pins.erase(worker);
+  idle_workers.emplace_back(std::move(worker));
+  dispatch();
+}
+
+void index_state::schedule(const caf::actor_addr& client, query_priority prio,
+                           uint32_t cost, query_scheduler::job f) {
+  scheduler.enqueue(client, prio, cost, std::move(f));
+  dispatch();
+}
+
+void index_state::dispatch() {
+  // A job may return its worker right away, e.g., for cancelled queries.
+  while (worker_available() && !scheduler.empty())
+    scheduler.dequeue()();
+}
+
 caf::dictionary<caf::config_value> index_state::status() const {
   using caf::put_dictionary;
   using caf::put_list;
@@ -230,6 +331,9 @@ caf::dictionary<caf::config_value> index_state::status() const {
     // Hence the fallback to low-level primitives.
     layout_object.insert_or_assign(name, std::move(xs));
   }
+  auto& column_object = put_dictionary(stats_object, "columns");
+  for (auto& [fqn, column_stats] : this->column_stats)
+    column_object.insert_or_assign(fqn, column_stats.status());
   // Resident partitions.
   auto& partitions = put_dictionary(result, "partitions");
   if (active != nullptr)
@@ -240,6 +344,51 @@ caf::dictionary<caf::config_value> index_state::status() const {
   auto& unpersisted = put_list(partitions, "unpersisted");
   for (auto& kvp : this->unpersisted)
     unpersisted.emplace_back(to_string(kvp.first->id()));
+  auto& loads = put_dictionary(partitions, "loading");
+  loads.emplace("in-flight", loading.size());
+  loads.emplace("completed", load_stats.count);
+  loads.emplace("failed", load_stats.failed);
+  if (load_stats.count > 0) {
+    auto n = detail::narrow<caf::timespan::rep>(load_stats.count);
+    loads.emplace("mean-latency", load_stats.total / n);
+    loads.emplace("max-latency", load_stats.max);
+  }
+  // Column indexing.
+  auto& indexing = put_dictionary(result, "indexing");
+  if (indexing_pool != nullptr) {
+    indexing.emplace("threads", indexing_pool->size());
+    indexing.emplace("pending-tasks", indexing_pool->pending());
+    indexing.emplace("steals", indexing_pool->steals());
+  } else {
+    indexing.emplace("threads", size_t{0});
+  }
+  // Query cache.
+  auto& cache = put_dictionary(result, "query-cache");
+  cache.emplace("entries", result_cache.size());
+  cache.emplace("bytes", result_cache.bytes());
+  cache.emplace("max-bytes", result_cache.max_bytes());
+  cache.emplace("hits", result_cache.stats().hits);
+  cache.emplace("misses", result_cache.stats().misses);
+  cache.emplace("evictions", result_cache.stats().evictions);
+  // Query scheduling.
+  auto& scheduling = put_dictionary(result, "scheduler");
+  scheduling.emplace("idle-workers", idle_workers.size());
+  for (size_t i = 0; i < num_query_priorities; ++i) {
+    auto prio = static_cast<query_priority>(i);
+    auto& stats = scheduler.stats(prio);
+    auto xs = caf::dictionary<caf::config_value>{};
+    xs.emplace("weight", scheduler.weight(prio));
+    xs.emplace("queued", scheduler.size(prio));
+    xs.emplace("admitted", stats.admitted);
+    xs.emplace("dispatched", stats.dispatched);
+    xs.emplace("partitions", stats.partitions);
+    if (stats.dispatched > 0) {
+      auto n = detail::narrow<caf::timespan::rep>(stats.dispatched);
+      xs.emplace("mean-wait", stats.total_wait / n);
+      xs.emplace("max-wait", stats.max_wait);
+    }
+    scheduling.insert_or_assign(to_string(prio), std::move(xs));
+  }
   // General state such as open streams.
   detail::fill_status_map(result, self);
   return result;
@@ -307,7 +456,11 @@ void index_state::decrement_indexer_count(uuid partition_id) {
                  "received done from unknown indexer:", self->current_sender());
     if (--i->second == 0) {
       VAST_DEBUG(self, "successfully persisted", partition_id);
+      add_persisted_ids(*i->first);
       unpersisted.erase(i);
+      if (auto err = flush_persisted_ids())
+        VAST_ERROR(self, "failed to write the persisted IDs:",
+                   self->system().render(err));
     }
   }
 }
@@ -318,22 +471,222 @@ partition* index_state::find_unpersisted(const uuid& id) {
   return i != unpersisted.end() ? i->first.get() : nullptr;
 }
 
+bool index_state::is_resident(const uuid& id) {
+  return (active != nullptr && active->id() == id)
+         || find_unpersisted(id) != nullptr || lru_partitions.contains(id);
+}
+
+id index_state::watermark() const {
+  // Partitions fill up in ID order, so everything below the first ID of the
+  // oldest unpersisted partition is durable. Without such a partition, all
+  // events that we know of are durable, which also covers the events that
+  // the IMPORTER replayed after a restart.
+  auto result = active != nullptr ? active->first_id() : max_id;
+  for (auto& kvp : unpersisted)
+    result = std::min(result, kvp.first->first_id());
+  return result == max_id ? persisted_ids.size() : result;
+}
+
+bool index_state::is_persisted(const uuid& id) {
+  return (active == nullptr || active->id() != id)
+         && find_unpersisted(id) == nullptr;
+}
+
+bool index_state::is_persisted(const table_slice& slice) const {
+  // The IMPORTER replays whole table slices, and partitions consist of whole
+  // table slices, so any overlap means the INDEX saw the slice before.
+  if (slice.offset() >= persisted_ids.size())
+    return false;
+  auto range = make_ids({{slice.offset(), slice.offset() + slice.rows()}});
+  return any<1>(persisted_ids & range);
+}
+
+void index_state::add_persisted_ids(const partition& part) {
+  for (auto& kvp : part.meta_data_.type_ids)
+    persisted_ids |= kvp.second;
+}
+
+index_state::partition_pin index_state::pin(std::vector<uuid> ids) {
+  auto& counts = *pinned_partitions;
+  for (auto& id : ids)
+    ++counts[id];
+  auto unpin = [counts = pinned_partitions](const std::vector<uuid>* xs) {
+    for (auto& id : *xs)
+      if (auto i = counts->find(id); i != counts->end() && --i->second == 0)
+        counts->erase(i);
+    delete xs;
+  };
+  return partition_pin{new std::vector<uuid>(std::move(ids)), unpin};
+}
+
+bool index_state::is_pinned(const uuid& id) const {
+  return pinned_partitions->count(id) > 0;
+}
+
+void index_state::remove_orphaned_partitions() {
+  auto known = meta_idx.partitions();
+  for (auto& entry : directory{dir}) {
+    if (!entry.is_directory())
+      continue;
+    auto id = to<uuid>(entry.basename().str());
+    if (!id || std::binary_search(known.begin(), known.end(), *id)
+        || is_resident(*id) || loading.count(*id) > 0 || is_pinned(*id))
+      continue;
+    VAST_VERBOSE(self, "removes orphaned partition", *id);
+    rm(entry);
+  }
+}
+
+bool index_state::replace_partitions(compacted_partition& x) {
+  auto known = meta_idx.partitions();
+  for (auto& source : x.sources)
+    if (!std::binary_search(known.begin(), known.end(), source)
+        || !is_persisted(source) || loading.count(source) > 0) {
+      VAST_DEBUG(self, "rejects compacted partition", x.id,
+                 "because partition", source, "is unknown or in use");
+      return false;
+    }
+  meta_idx.merge(x.synopses);
+  auto& cached = lru_partitions.elements();
+  for (auto& source : x.sources) {
+    meta_idx.erase(source);
+    result_cache.erase(source);
+    auto is_source = [&](auto& part) { return part->id() == source; };
+    cached.erase(std::remove_if(cached.begin(), cached.end(), is_source),
+                 cached.end());
+  }
+  // The replaced partitions stay on disk until the next compaction round
+  // finds them orphaned, so that running queries can finish.
+  if (auto err = flush_meta_index())
+    VAST_ERROR(self, "failed to persist the meta index:",
+               self->system().render(err));
+  VAST_VERBOSE(self, "replaced", x.sources.size(), "partitions with", x.id);
+  return true;
+}
+
+void index_state::order_candidates(std::vector<uuid>& xs,
+                                   query_options opts) {
+  struct candidate {
+    uuid id;
+    caf::optional<meta_index::time_bounds> bounds;
+    bool resident;
+  };
+  std::vector<candidate> candidates;
+  candidates.reserve(xs.size());
+  for (auto& x : xs)
+    candidates.push_back({x, meta_idx.bounds(x), is_resident(x)});
+  auto oldest_first = has_oldest_first_option(opts);
+  auto before = [&](const candidate& x, const candidate& y) {
+    if (x.bounds && y.bounds) {
+      if (oldest_first && x.bounds->first != y.bounds->first)
+        return x.bounds->first < y.bounds->first;
+      if (!oldest_first && x.bounds->last != y.bounds->last)
+        return x.bounds->last > y.bounds->last;
+    } else if (x.bounds || y.bounds) {
+      return static_cast<bool>(x.bounds);
+    }
+    return x.resident && !y.resident;
+  };
+  std::stable_sort(candidates.begin(), candidates.end(), before);
+  for (size_t i = 0; i < xs.size(); ++i)
+    xs[i] = candidates[i].id;
+}
+
+std::vector<uuid> index_state::cold_partitions(const lookup_state& lookup,
+                                               uint32_t num_partitions) {
+  std::vector<uuid> result;
+  auto n = std::min(size_t{num_partitions}, lookup.partitions.size());
+  // Partitions with cached results need no loading.
+  std::copy_if(lookup.partitions.begin(), lookup.partitions.begin() + n,
+               std::back_inserter(result), [&](const uuid& x) {
+                 return !is_resident(x)
+                        && !result_cache.contains(lookup.cache_key, x);
+               });
+  return result;
+}
+
+void index_state::load_partitions(const std::vector<uuid>& ids,
+                                  std::function<void()> f) {
+  if (ids.empty()) {
+    f();
+    return;
+  }
+  // Call the continuation after the last partition arrived.
+  auto barrier = std::make_shared<std::pair<size_t, std::function<void()>>>(
+    ids.size(), std::move(f));
+  auto g = [barrier] {
+    if (--barrier->first == 0)
+      barrier->second();
+  };
+  for (auto& id : ids) {
+    auto i = loading.find(id);
+    if (i == loading.end()) {
+      VAST_DEBUG(self, "schedules loading partition", id);
+      auto part = std::make_unique<partition>(this, id, max_partition_size);
+      auto promise
+        = std::make_shared<std::promise<caf::expected<partition::meta_data>>>();
+      auto load = partition_load{};
+      load.meta_data = promise->get_future();
+      load.start = steady_clock::now();
+      // The loader thread must not touch the partition itself, because it
+      // refers to our state.
+      loaders->submit([promise, file = part->meta_file(), id,
+                       hdl = caf::actor_cast<caf::actor>(self)] {
+        promise->set_value(partition::load_meta_data(file));
+        caf::anon_send(hdl, atom::load_v, id);
+      });
+      load.part = std::move(part);
+      i = loading.emplace(id, std::move(load)).first;
+    }
+    i->second.continuations.emplace_back(g);
+  }
+}
+
+void index_state::handle_loaded_partition(const uuid& id) {
+  auto i = loading.find(id);
+  if (i == loading.end()) {
+    VAST_WARNING(self, "got a load notification for unknown partition", id);
+    return;
+  }
+  auto load = std::move(i->second);
+  loading.erase(i);
+  auto latency
+    = duration_cast<caf::timespan>(steady_clock::now() - load.start);
+  ++load_stats.count;
+  load_stats.total += latency;
+  load_stats.max = std::max(load_stats.max, latency);
+  // Never blocks, since the loader thread fulfills the promise before
+  // notifying us.
+  if (auto meta_data = load.meta_data.get()) {
+    load.part->init(std::move(*meta_data));
+  } else {
+    ++load_stats.failed;
+    VAST_ERROR(self, "unable to load partition state from disk:", id,
+               self->system().render(meta_data.error()));
+  }
+  // A synchronous fallback in build_query_map may have loaded the partition
+  // in the meantime.
+  if (!lru_partitions.contains(id))
+    lru_partitions.add(std::move(load.part));
+  for (auto& f : load.continuations)
+    f();
+}
+
 index_state::pending_query_map
 index_state::build_query_map(lookup_state& lookup, uint32_t num_partitions) {
   VAST_TRACE(VAST_ARG(lookup), VAST_ARG(num_partitions));
   if (num_partitions == 0 || lookup.partitions.empty())
     return {};
-  // Prefer partitions that are already available in RAM.
-  std::partition(lookup.partitions.begin(), lookup.partitions.end(),
-                 [&](const uuid& candidate) {
-                   return (active != nullptr && active->id() == candidate)
-                          || find_unpersisted(candidate) != nullptr
-                          || lru_partitions.contains(candidate);
-                 });
   // Maps partition IDs to the EVALUATOR actors we are going to spawn.
   pending_query_map result;
   // Helper function to spin up EVALUATOR actors for a single partition.
   auto spin_up = [&](const uuid& partition_id) {
+    // An empty evaluation map tells `launch_evaluators` to use the cached
+    // result, which saves us from touching the partition at all.
+    if (result_cache.contains(lookup.cache_key, partition_id)) {
+      result.emplace(partition_id, evaluation_triples{});
+      return;
+    }
     // We need to first check whether the ID is the active partition or one
     // of our unpersistet ones. Only then can we dispatch to our LRU cache.
     partition* part;
@@ -364,12 +717,30 @@ index_state::build_query_map(lookup_state& lookup, uint32_t num_partitions) {
   return result;
 }
 
-query_map
-index_state::launch_evaluators(pending_query_map pqm, expression expr) {
+query_map index_state::launch_evaluators(pending_query_map pqm,
+                                         const lookup_state& lookup) {
   query_map result;
   for (auto& [id, eval] : pqm) {
-    std::vector<caf::actor> xs{self->spawn(evaluator, expr, std::move(eval))};
-    result.emplace(id, std::move(xs));
+    caf::actor hdl;
+    if (!result_cache.enabled() || !is_persisted(id)) {
+      hdl = self->spawn(evaluator, lookup.expr, std::move(eval));
+    } else if (auto hits = result_cache.lookup(lookup.cache_key, id)) {
+      VAST_DEBUG(self, "uses cached result for partition", id);
+      hdl = self->spawn(cached_evaluator, *hits);
+    } else {
+      // Let the EVALUATOR report its final hits back to us for caching.
+      VAST_ASSERT(!eval.empty());
+      auto partition_id = id;
+      auto listener = caf::actor_cast<caf::actor>(self);
+      hdl = self->spawn(
+        [=, expr = lookup.expr, eval = std::move(eval)](
+          caf::stateful_actor<evaluator_state>* ev) {
+          ev->state.hits_listener = listener;
+          ev->state.partition_id = partition_id;
+          return evaluator(ev, expr, eval);
+        });
+    }
+    result.emplace(id, std::vector<caf::actor>{std::move(hdl)});
   }
   return result;
 }
@@ -380,6 +751,35 @@ void index_state::add_flush_listener(caf::actor listener) {
   detail::notify_listeners_if_clean(*this, *stage);
 }
 
+void index_state::send_report() {
+  if (!accountant)
+    return;
+  auto r = report{};
+  if (result_cache.enabled()) {
+    auto& stats = result_cache.stats();
+    r.push_back({"index.query-cache.hits", stats.hits});
+    r.push_back({"index.query-cache.misses", stats.misses});
+    r.push_back({"index.query-cache.evictions", stats.evictions});
+    r.push_back({"index.query-cache.entries", uint64_t{result_cache.size()}});
+    r.push_back({"index.query-cache.bytes", uint64_t{result_cache.bytes()}});
+    if (auto lookups = stats.hits + stats.misses; lookups > 0)
+      r.push_back({"index.query-cache.hit-rate",
+                   static_cast<double>(stats.hits) / lookups});
+  }
+  for (size_t i = 0; i < num_query_priorities; ++i) {
+    auto prio = static_cast<query_priority>(i);
+    auto& stats = scheduler.stats(prio);
+    auto key = std::string{"index.scheduler."} + to_string(prio);
+    r.push_back({key + ".queue-depth", uint64_t{scheduler.size(prio)}});
+    if (stats.dispatched > 0) {
+      auto n = detail::narrow<caf::timespan::rep>(stats.dispatched);
+      r.push_back({key + ".mean-wait", duration{stats.total_wait / n}});
+      r.push_back({key + ".max-wait", duration{stats.max_wait}});
+    }
+  }
+  self->send(accountant, std::move(r));
+}
+
 void index_state::notify_flush_listeners() {
   VAST_DEBUG(self, "sends 'flush' messages to", flush_listeners.size(),
              "listeners");
@@ -411,75 +811,124 @@ caf::behavior index(caf::stateful_actor<index_state>* self, const path& dir,
   // Launch workers for resolving queries.
   for (size_t i = 0; i < num_workers; ++i)
     self->spawn(query_supervisor, self);
-  // We switch between has_worker behavior and the default behavior (which
-  // simply waits for a worker).
-  self->set_default_handler(caf::skip);
-  self->state.has_worker.assign(
-    [=](expression& expr) {
-      auto respond = [&](auto&&... xs) {
-        auto mid = self->current_message_id();
-        unsafe_response(self, self->current_sender(), {}, mid.response_id(),
-                        std::forward<decltype(xs)>(xs)...);
-      };
-      // Sanity check.
-      if (self->current_sender() == nullptr) {
-        VAST_ERROR(self, "got an anonymous query (ignored)");
-        respond(caf::sec::invalid_argument);
-        return;
-      }
+  // Handles a query, where the options determine the scheduling order and
+  // the priority.
+  auto handle_query = [=](expression& expr, query_options opts,
+                          cancellation_token token) {
+    // Loading partitions from disk may defer the response, hence the
+    // promise.
+    auto rp = self->make_response_promise();
+    // Sanity check.
+    if (self->current_sender() == nullptr) {
+      VAST_ERROR(self, "got an anonymous query (ignored)");
+      rp.deliver(caf::sec::invalid_argument);
+      return;
+    }
+    auto& st = self->state;
+    auto client = caf::actor_cast<caf::actor>(self->current_sender());
+    // Convenience function for dropping out without producing hits. Makes
+    // sure that clients always receive a 'done' message.
+    auto no_result = [=]() mutable {
+      rp.deliver(uuid::nil(), uint32_t{0}, uint32_t{0});
+      self->send(client, atom::done_v);
+      self->state.scheduler.forget(client->address());
+    };
+    // Get all potentially matching partitions.
+    auto candidates = st.meta_idx.lookup(expr);
+    // Report no result if no candidates are found.
+    if (candidates.empty()) {
+      VAST_DEBUG(self, "returns without result: no partitions qualify");
+      no_result();
+      return;
+    }
+    st.order_candidates(candidates, opts);
+    // Compaction must not delete the candidates while the query waits in
+    // line, loads partitions, or evaluates them.
+    auto pin = st.pin(candidates);
+    auto lookup = index_state::lookup_state{
+      expr, std::move(candidates), {}, token, priority(opts), std::move(pin)};
+    if (st.result_cache.enabled())
+      lookup.cache_key = normalize(expr);
+    auto cost = std::min(st.taste_partitions,
+                         detail::narrow<uint32_t>(lookup.partitions.size()));
+    // Wait for a worker in line with the other queries.
+    st.schedule(client->address(), lookup.priority, cost, [=]() mutable {
       auto& st = self->state;
-      auto client = caf::actor_cast<caf::actor>(self->current_sender());
-      // Convenience function for dropping out without producing hits. Makes
-      // sure that clients always receive a 'done' message.
-      auto no_result = [&] {
-        respond(uuid::nil(), uint32_t{0}, uint32_t{0});
-        self->send(client, atom::done_v);
-      };
-      // Get all potentially matching partitions.
-      auto candidates = st.meta_idx.lookup(expr);
-      // Report no result if no candidates are found.
-      if (candidates.empty()) {
-        VAST_DEBUG(self, "returns without result: no partitions qualify");
+      // The client may have gone away while waiting.
+      if (token.cancelled()) {
+        VAST_DEBUG(self, "returns without result: query got cancelled");
         no_result();
         return;
       }
-      // Allows the client to query further results after initial taste.
-      auto query_id = uuid::random();
-      auto lookup = index_state::lookup_state{expr, std::move(candidates)};
-      auto pqm = st.build_query_map(lookup, st.taste_partitions);
-      if (pqm.empty()) {
-        VAST_ASSERT(lookup.partitions.empty());
-        VAST_DEBUG(self, "returns without result: no partitions qualify");
-        no_result();
-        return;
-      }
-      auto hits = pqm.size() + lookup.partitions.size();
-      auto scheduling = std::min(taste_partitions, hits);
-      // Notify the client that we don't have more hits.
-      if (scheduling == hits)
-        query_id = uuid::nil();
-      respond(query_id, detail::narrow<uint32_t>(hits),
-              detail::narrow<uint32_t>(scheduling));
-      auto qm = st.launch_evaluators(pqm, expr);
-      VAST_DEBUG(self, "scheduled", qm.size(), "/", hits,
-                 "partitions for query", expr);
-      if (!lookup.partitions.empty()) {
-        [[maybe_unused]] auto result
-          = st.pending.emplace(query_id, std::move(lookup));
-        VAST_ASSERT(result.second);
-      }
-      // Delegate to query supervisor (uses up this worker) and report
-      // query ID + some stats to the client.
-      self->send(st.next_worker(), std::move(expr), std::move(qm), client);
-      if (!st.worker_available())
-        self->unbecome();
+      // Reserve a worker right away, because we keep handling other queries
+      // while loading partitions.
+      auto worker = st.next_worker();
+      auto cold = st.cold_partitions(lookup, st.taste_partitions);
+      st.load_partitions(cold, [=]() mutable {
+        auto& st = self->state;
+        // The client may have gone away while we were loading.
+        if (token.cancelled()) {
+          VAST_DEBUG(self, "returns without result: query got cancelled");
+          st.release_worker(std::move(worker));
+          no_result();
+          return;
+        }
+        // Allows the client to query further results after initial taste.
+        auto query_id = uuid::random();
+        auto pqm = st.build_query_map(lookup, st.taste_partitions);
+        if (pqm.empty()) {
+          VAST_ASSERT(lookup.partitions.empty());
+          VAST_DEBUG(self, "returns without result: no partitions qualify");
+          st.release_worker(std::move(worker));
+          no_result();
+          return;
+        }
+        auto hits = pqm.size() + lookup.partitions.size();
+        auto scheduling = std::min(taste_partitions, hits);
+        // Notify the client that we don't have more hits.
+        if (scheduling == hits)
+          query_id = uuid::nil();
+        rp.deliver(query_id, detail::narrow<uint32_t>(hits),
+                   detail::narrow<uint32_t>(scheduling));
+        auto qm = st.launch_evaluators(pqm, lookup);
+        st.worker_pins[worker] = lookup.pin;
+        VAST_DEBUG(self, "scheduled", qm.size(), "/", hits,
+                   "partitions for query", expr);
+        if (!lookup.partitions.empty()) {
+          [[maybe_unused]] auto result
+            = st.pending.emplace(query_id, std::move(lookup));
+          VAST_ASSERT(result.second);
+        } else {
+          st.scheduler.forget(client->address());
+        }
+        // Delegate to query supervisor (uses up this worker) and report
+        // query ID + some stats to the client.
+        self->send(worker, std::move(expr), std::move(qm), token, client);
+      });
+    });
+  };
+  return {
+    [=](expression& expr) {
+      handle_query(expr, historical, cancellation_token{});
+    },
+    [=](expression& expr, query_options opts) {
+      handle_query(expr, opts, cancellation_token{});
+    },
+    [=](expression& expr, query_options opts, cancellation_token& token) {
+      handle_query(expr, opts, std::move(token));
     },
     [=](const uuid& query_id, uint32_t num_partitions) {
       auto& st = self->state;
       // A zero as second argument means the client drops further results.
       if (num_partitions == 0) {
         VAST_DEBUG(self, "dropped remaining results for query ID", query_id);
-        st.pending.erase(query_id);
+        if (auto iter = st.pending.find(query_id); iter != st.pending.end()) {
+          // Also stop working on the partitions that are in flight.
+          iter->second.token.cancel();
+          st.pending.erase(iter);
+        }
+        if (auto sender = self->current_sender())
+          st.scheduler.forget(sender->address());
         return;
       }
       // Sanity checks.
@@ -494,31 +943,95 @@ caf::behavior index(caf::stateful_actor<index_state>* self, const path& dir,
         self->send(client, atom::done_v);
         return;
       }
-      auto pqm = st.build_query_map(iter->second, num_partitions);
-      if (pqm.empty()) {
-        VAST_ASSERT(iter->second.partitions.empty());
-        st.pending.erase(iter);
-        VAST_DEBUG(self, "returns without result: no partitions qualify");
-        self->send(client, atom::done_v);
-        return;
-      }
-      auto qm = st.launch_evaluators(pqm, iter->second.expr);
-      // Delegate to query supervisor (uses up this worker) and report
-      // query ID + some stats to the client.
-      VAST_DEBUG(self, "schedules", qm.size(), "more partition(s) for query",
-                 iter->first, "with", iter->second.partitions.size(),
-                 "remaining");
-      self->send(st.next_worker(), iter->second.expr, std::move(qm), client);
-      // Cleanup if we exhausted all candidates.
-      if (iter->second.partitions.empty())
-        st.pending.erase(iter);
+      // Wait for a worker in line with the other queries.
+      auto prio = iter->second.priority;
+      st.schedule(client->address(), prio, num_partitions, [=]() mutable {
+        auto& st = self->state;
+        // The client may have dropped the query while waiting.
+        auto iter = st.pending.find(query_id);
+        if (iter == st.pending.end() || iter->second.token.cancelled()) {
+          if (iter != st.pending.end())
+            st.pending.erase(iter);
+          self->send(client, atom::done_v);
+          st.scheduler.forget(client->address());
+          return;
+        }
+        auto worker = st.next_worker();
+        auto cold = st.cold_partitions(iter->second, num_partitions);
+        st.load_partitions(cold, [=]() mutable {
+          auto& st = self->state;
+          // The client may have dropped the query while we were loading.
+          auto iter = st.pending.find(query_id);
+          if (iter != st.pending.end() && iter->second.token.cancelled()) {
+            st.pending.erase(iter);
+            iter = st.pending.end();
+          }
+          if (iter == st.pending.end()) {
+            st.release_worker(std::move(worker));
+            self->send(client, atom::done_v);
+            st.scheduler.forget(client->address());
+            return;
+          }
+          auto pqm = st.build_query_map(iter->second, num_partitions);
+          if (pqm.empty()) {
+            VAST_ASSERT(iter->second.partitions.empty());
+            st.pending.erase(iter);
+            VAST_DEBUG(self, "returns without result: no partitions qualify");
+            st.release_worker(std::move(worker));
+            self->send(client, atom::done_v);
+            st.scheduler.forget(client->address());
+            return;
+          }
+          auto qm = st.launch_evaluators(pqm, iter->second);
+          // Delegate to query supervisor (uses up this worker) and report
+          // query ID + some stats to the client.
+          VAST_DEBUG(self, "schedules", qm.size(),
+                     "more partition(s) for query", iter->first, "with",
+                     iter->second.partitions.size(), "remaining");
+          st.worker_pins[worker] = iter->second.pin;
+          self->send(worker, iter->second.expr, std::move(qm),
+                     iter->second.token, client);
+          // Cleanup if we exhausted all candidates.
+          if (iter->second.partitions.empty()) {
+            st.pending.erase(iter);
+            st.scheduler.forget(client->address());
+          }
+        });
+      });
     },
     [=](atom::worker, caf::actor& worker) {
-      self->state.idle_workers.emplace_back(std::move(worker));
+      self->state.release_worker(std::move(worker));
     },
     [=](atom::done, uuid partition_id) {
       self->state.decrement_indexer_count(partition_id);
     },
+    [=](atom::statistics, const std::string& fqn,
+        const column_statistics& column_stats) {
+      self->state.column_stats[fqn].merge(column_stats);
+    },
+    [=](atom::statistics,
+        const std::string& fqn) -> caf::result<column_statistics> {
+      auto& xs = self->state.column_stats;
+      if (auto i = xs.find(fqn); i != xs.end())
+        return i->second;
+      return make_error(ec::lookup_error, "no statistics for column", fqn);
+    },
+    [=](atom::load, const uuid& partition_id) {
+      self->state.handle_loaded_partition(partition_id);
+    },
+    [=](atom::progress) {
+      // The indexing pool caught up with its backlog.
+      self->state.stage->push();
+    },
+    [=](atom::store, const uuid& partition_id, const expression& expr,
+        const ids& hits) {
+      self->state.result_cache.add(normalize(expr), partition_id, hits);
+    },
+    [=](atom::telemetry) {
+      self->state.send_report();
+      self->delayed_send(self, defaults::system::telemetry_rate,
+                         atom::telemetry_v);
+    },
     [=](caf::stream<table_slice_ptr> in) {
       VAST_DEBUG(self, "got a new source");
       return self->state.stage->add_inbound_path(in);
@@ -528,25 +1041,24 @@ caf::behavior index(caf::stateful_actor<index_state>* self, const path& dir,
     },
     [=](atom::subscribe, atom::flush, caf::actor& listener) {
       self->state.add_flush_listener(std::move(listener));
-    });
-  return {[=](atom::worker, caf::actor& worker) {
-            auto& st = self->state;
-            st.idle_workers.emplace_back(std::move(worker));
-            self->become(caf::keep_behavior, st.has_worker);
-          },
-          [=](atom::done, uuid partition_id) {
-            self->state.decrement_indexer_count(partition_id);
-          },
-          [=](caf::stream<table_slice_ptr> in) {
-            VAST_DEBUG(self, "got a new source");
-            return self->state.stage->add_inbound_path(in);
-          },
-          [=](atom::status) -> caf::config_value::dictionary {
-            return self->state.status();
-          },
-          [=](atom::subscribe, atom::flush, caf::actor& listener) {
-            self->state.add_flush_listener(std::move(listener));
-          }};
+    },
+    [=](atom::checkpoint) -> id { return self->state.watermark(); },
+    [=](atom::compact) -> compaction_candidates {
+      auto& st = self->state;
+      st.remove_orphaned_partitions();
+      compaction_candidates result;
+      result.dir = st.dir;
+      result.max_partition_size = st.max_partition_size;
+      result.synopsis_options = st.meta_idx.factory_options();
+      for (auto& id : st.meta_idx.partitions())
+        if (st.is_persisted(id) && st.loading.count(id) == 0)
+          result.partitions.push_back(id);
+      return result;
+    },
+    [=](atom::compact, compacted_partition& x) {
+      return self->state.replace_partitions(x);
+    },
+  };
 }
 
 } // namespace vast::system
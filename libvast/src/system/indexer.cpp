@@ -13,15 +13,19 @@
 
 #include "vast/system/indexer.hpp"
 
+#include "vast/bitmap_algorithms.hpp"
 #include "vast/concept/printable/stream.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
 #include "vast/defaults.hpp"
 #include "vast/detail/assert.hpp"
+#include "vast/error.hpp"
 #include "vast/expression.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/fwd.hpp"
+#include "vast/ids.hpp"
 #include "vast/logger.hpp"
 #include "vast/system/accountant.hpp"
+#include "vast/system/cancellation_token.hpp"
 #include "vast/system/instrumentation.hpp"
 #include "vast/system/report.hpp"
 #include "vast/table_slice_column.hpp"
@@ -95,6 +99,33 @@ caf::behavior indexer(caf::stateful_actor<indexer_state>* self, path filename,
       VAST_DEBUG(self, "got predicate:", pred);
       return self->state.col.lookup(pred.op, make_view(pred.rhs));
     },
+    [=](const curried_predicate& pred, const ids& candidates) {
+      VAST_DEBUG(self, "got predicate:", pred, "for", rank(candidates),
+                 "candidates");
+      return self->state.col.lookup(pred.op, make_view(pred.rhs), candidates);
+    },
+    [=](const curried_predicate& pred,
+        const cancellation_token& token) -> caf::expected<bitmap> {
+      if (token.cancelled())
+        return make_error(ec::cancelled, "skipped lookup");
+      VAST_DEBUG(self, "got predicate:", pred);
+      return self->state.col.lookup(pred.op, make_view(pred.rhs));
+    },
+    [=](const curried_predicate& pred, const ids& candidates,
+        const cancellation_token& token) -> caf::expected<bitmap> {
+      if (token.cancelled())
+        return make_error(ec::cancelled, "skipped lookup");
+      VAST_DEBUG(self, "got predicate:", pred, "for", rank(candidates),
+                 "candidates");
+      return self->state.col.lookup(pred.op, make_view(pred.rhs), candidates);
+    },
+    [=](atom::statistics) { return self->state.col.statistics(); },
+    [=](atom::statistics,
+        const curried_predicate& pred) -> caf::result<double> {
+      if (auto x = self->state.col.selectivity(pred.op, make_view(pred.rhs)))
+        return *x;
+      return make_error(ec::lookup_error, "no selectivity estimate");
+    },
     [=](atom::persist) -> caf::result<void> {
       if (auto err = self->state.col.flush_to_disk(); err != caf::none)
         return err;
@@ -125,6 +156,8 @@ caf::behavior indexer(caf::stateful_actor<indexer_state>* self, path filename,
             VAST_ERROR(self, "got a stream error:", self->system().render(err));
             return;
           }
+          self->send(st.index, atom::statistics_v, st.fqn,
+                     st.col.statistics());
           self->send(st.index, atom::done_v, st.partition_id);
         });
     },
@@ -37,6 +37,8 @@ size_t indexer_downstream_manager::buffered(partition& p) const noexcept {
   // We have a buffered table slices in the partition, but also an additional
   // buffer at each path. We return the maximum size to reflect the current
   // worst case.
+  if (p.pooled())
+    return p.inbound_.size() + p.pool_backlog();
   size_t max_path_buf = 0;
   for (auto& ip : p.indexers_)
     max_path_buf = std::max(max_path_buf, ip.second.buf.size());
@@ -92,6 +94,9 @@ int32_t indexer_downstream_manager::max_capacity() const noexcept {
     if (mc > 0)
       result = std::min(result, mc);
   }
+  // The indexing pool accepts only a limited backlog of slices.
+  if (pool_capacity_ > 0)
+    result = std::min(result, pool_capacity_);
   return result;
 }
 
@@ -144,6 +149,12 @@ indexer_downstream_manager::buffer_type& indexer_downstream_manager::buf() {
 }
 
 void indexer_downstream_manager::cleanup_partition(partition& p) {
+  // Pooled partitions have no paths, but the pool needs to know that no more
+  // slices arrive.
+  if (p.pooled()) {
+    p.seal();
+    return;
+  }
   // This is all about managing the paths_ array, just do nothing if it is
   // already empty.
   if (paths_.empty())
@@ -199,11 +210,33 @@ indexer_downstream_manager::try_remove_partition(set_type::iterator it) {
   return std::next(it);
 }
 
+void indexer_downstream_manager::emit_to_pool(partition& p) {
+  // Hand over as many slices as the backlog of the pool allows. The pool
+  // sends a notification to the INDEX once it caught up, which pushes the
+  // remainder.
+  auto capacity = static_cast<size_t>(pool_capacity_);
+  auto backlog = p.pool_backlog();
+  auto& buf = p.inbound_;
+  auto chunk = std::min(capacity > backlog ? capacity - backlog : 0u,
+                        buf.size());
+  if (chunk == 0u)
+    return;
+  auto last = buf.begin() + chunk;
+  for (auto i = buf.begin(); i < last; ++i)
+    p.index_in_pool(*i);
+  buf.erase(buf.begin(), last);
+}
+
 void indexer_downstream_manager::emit_batches_impl(bool force_underfull) {
-  if (this->paths_.empty())
+  if (this->paths_.empty() && pool_capacity_ == 0)
     return;
   for (auto it = partitions.begin(); it != partitions.end();) {
     auto pptr = *it;
+    if (pptr->pooled()) {
+      emit_to_pool(*pptr);
+      it = try_remove_partition(it);
+      continue;
+    }
     // Calculate the chunk size, i.e., how many more items we can put to our
     // caches at the most.
     size_t chunk = chunk_size(*pptr);
@@ -44,10 +44,17 @@ void indexer_stage_driver::process(downstream_type&, batch_type& slices) {
   VAST_ASSERT(!slices.empty());
   auto& st = self_->state;
   for (auto& slice : slices) {
+    // Replaying the write-ahead log of the IMPORTER may deliver slices that we
+    // already indexed before a crash.
+    if (st.is_persisted(*slice)) {
+      VAST_DEBUG(self_, "skips already indexed table slice at",
+                 slice->offset());
+      continue;
+    }
     auto& layout = slice->layout();
     st.stats.layouts[layout.name()].count += slice->rows();
     auto part = st.get_or_add_partition(slice);
-    st.meta_idx.add(part->id(), *slice);
+    st.meta_idx.add(part->id(), slice);
     part->add(std::move(slice));
   }
 }
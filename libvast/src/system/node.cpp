@@ -37,6 +37,7 @@
 #include "vast/system/spawn_archive.hpp"
 #include "vast/system/spawn_arguments.hpp"
 #include "vast/system/spawn_counter.hpp"
+#include "vast/system/spawn_compactor.hpp"
 #include "vast/system/spawn_eraser.hpp"
 #include "vast/system/spawn_explorer.hpp"
 #include "vast/system/spawn_exporter.hpp"
@@ -267,6 +268,7 @@ auto make_component_factory() {
   return node_state::named_component_factory{
     {"spawn accountant", lift_component_factory<spawn_accountant>()},
       {"spawn archive", lift_component_factory<spawn_archive>()},
+      {"spawn compactor", lift_component_factory<spawn_compactor>()},
       {"spawn counter", lift_component_factory<spawn_counter>()},
       {"spawn eraser", lift_component_factory<spawn_eraser>()},
       {"spawn exporter", lift_component_factory<spawn_exporter>()},
@@ -316,6 +318,7 @@ auto make_command_factory() {
     {"send", send_command},
     {"spawn accountant", node_state::spawn_command},
     {"spawn archive", node_state::spawn_command},
+    {"spawn compactor", node_state::spawn_command},
     {"spawn counter", node_state::spawn_command},
     {"spawn eraser", node_state::spawn_command},
     {"spawn explorer", node_state::spawn_command},
@@ -18,7 +18,9 @@
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
 #include "vast/concept/printable/vast/uuid.hpp"
+#include "vast/defaults.hpp"
 #include "vast/detail/assert.hpp"
+#include "vast/error.hpp"
 #include "vast/event.hpp"
 #include "vast/expression_visitors.hpp"
 #include "vast/fwd.hpp"
@@ -27,9 +29,11 @@
 #include "vast/logger.hpp"
 #include "vast/qualified_record_field.hpp"
 #include "vast/save.hpp"
+#include "vast/system/cancellation_token.hpp"
 #include "vast/system/index.hpp"
 #include "vast/system/index_common.hpp"
 #include "vast/system/indexer_stage_driver.hpp"
+#include "vast/system/pooled_indexer.hpp"
 #include "vast/system/spawn_indexer.hpp"
 #include "vast/table_slice_column.hpp"
 #include "vast/time.hpp"
@@ -40,6 +44,8 @@
 #include <caf/make_counted.hpp>
 #include <caf/stateful_actor.hpp>
 
+#include <algorithm>
+
 using namespace std::chrono;
 using namespace caf;
 
@@ -66,21 +72,34 @@ indexer_downstream_manager& partition::out() const {
 
 caf::error partition::init() {
   VAST_TRACE("");
-  auto file_path = meta_file();
-  if (!exists(file_path))
-    return ec::no_such_file;
-  auto partition_type = record_type{};
-  if (auto err = load(nullptr, file_path, meta_data_, partition_type))
-    return err;
-  VAST_DEBUG(state_->self, "loaded partition", id_, "from disk with",
-             meta_data_.layouts.size(), "layouts and",
-             partition_type.fields.size(), "columns");
+  auto x = load_meta_data(meta_file());
+  if (!x)
+    return x.error();
+  init(std::move(*x));
+  return caf::none;
+}
+
+void partition::init(meta_data x) {
+  meta_data_ = std::move(x);
   for (auto& layout : meta_data_.layouts)
     for (auto& field : layout.fields) {
       qualified_record_field fqf{layout.name(), field};
       indexers_.emplace(std::move(fqf), wrapped_indexer{});
     }
-  return caf::none;
+  VAST_DEBUG(state_->self, "loaded partition", id_, "from disk with",
+             meta_data_.layouts.size(), "layouts and", indexers_.size(),
+             "columns");
+}
+
+caf::expected<partition::meta_data>
+partition::load_meta_data(const path& file) {
+  if (!exists(file))
+    return make_error(ec::no_such_file, file.str());
+  auto result = meta_data{};
+  auto partition_type = record_type{};
+  if (auto err = load(nullptr, file, result, partition_type))
+    return err;
+  return result;
 }
 
 caf::error partition::flush_to_disk() {
@@ -97,8 +116,11 @@ caf::actor& partition::indexer_at(size_t position) {
   VAST_ASSERT(position < indexers_.size());
   auto& [fqf, ip] = as_vector(indexers_)[position];
   if (!ip.indexer) {
-    ip.indexer
-      = state().make_indexer(column_file(fqf), fqf.type, id(), fqf.fqn());
+    if (ip.column != nullptr)
+      ip.indexer = state_->self->spawn(pooled_indexer, ip.column);
+    else
+      ip.indexer
+        = state().make_indexer(column_file(fqf), fqf.type, id(), fqf.fqn());
     VAST_ASSERT(ip.indexer != nullptr);
   }
   return ip.indexer;
@@ -112,6 +134,7 @@ void partition::add(table_slice_ptr slice) {
   meta_data_.dirty = true;
   auto first = slice->offset();
   auto last = slice->offset() + slice->rows();
+  first_id_ = std::min(first_id_, first);
   auto& layout = slice->layout();
   bool is_new = meta_data_.layouts.emplace(layout).second;
   auto it = meta_data_.type_ids.emplace(layout.name(), vast::ids{}).first;
@@ -119,7 +142,40 @@ void partition::add(table_slice_ptr slice) {
   VAST_ASSERT(first >= ids.size());
   ids.append_bits(false, first - ids.size());
   ids.append_bits(true, last - first);
-  if (is_new) {
+  if (is_new && pooled()) {
+    // Split the columns of the new type into ranges for the indexing pool.
+    std::vector<pooled_column_ptr> columns;
+    columns.reserve(layout.fields.size());
+    for (auto& field : layout.fields) {
+      auto fqf = qualified_record_field{layout.name(), field};
+      auto& ip = indexers_.emplace(fqf, wrapped_indexer{}).first->second;
+      if (ip.column == nullptr) {
+        ip.column = std::make_shared<pooled_column>();
+        ip.column->fqn = fqf.fqn();
+        caf::settings index_opts;
+        index_opts["cardinality"] = state_->max_partition_size;
+        if (auto col = make_column_index(state_->self->system(),
+                                         column_file(fqf), fqf.type,
+                                         std::move(index_opts)))
+          ip.column->col = std::move(*col);
+        else
+          VAST_ERROR(state_->self, "failed to create column", fqf.fqn(), ":",
+                     col.error());
+      }
+      columns.push_back(ip.column);
+    }
+    auto& ranges = ranges_[layout];
+    auto step = defaults::system::indexing_task_columns;
+    for (size_t i = 0; i < columns.size(); i += step) {
+      auto j = std::min(i + step, columns.size());
+      ranges.push_back(std::make_shared<column_range>(
+        *state_->indexing_pool, caf::actor_cast<caf::actor>(state_->self),
+        id(), i,
+        std::vector<pooled_column_ptr>(columns.begin() + i,
+                                       columns.begin() + j)));
+      state_->active_partition_indexers++;
+    }
+  } else if (is_new) {
     // Insert new type.
     for (auto& field : layout.fields) {
       auto fqf = qualified_record_field{layout.name(), field};
@@ -146,6 +202,32 @@ void partition::add(table_slice_ptr slice) {
   inbound_.push_back(std::move(slice));
 }
 
+bool partition::pooled() const noexcept {
+  return state_->indexing_pool != nullptr;
+}
+
+void partition::index_in_pool(const table_slice_ptr& slice) {
+  VAST_ASSERT(pooled());
+  auto i = ranges_.find(slice->layout());
+  VAST_ASSERT(i != ranges_.end());
+  for (auto& range : i->second)
+    range->add(slice);
+}
+
+size_t partition::pool_backlog() const noexcept {
+  size_t result = 0;
+  for (auto& kvp : ranges_)
+    for (auto& range : kvp.second)
+      result = std::max(result, range->backlog());
+  return result;
+}
+
+void partition::seal() {
+  for (auto& kvp : ranges_)
+    for (auto& range : kvp.second)
+      range->seal();
+}
+
 record_type partition::combined_type() const {
   record_type result;
   for (auto& kvp : indexers_) {
@@ -185,8 +267,22 @@ caf::actor partition::fetch_indexer(const attribute_extractor& ex,
         row_ids |= ids;
     // TODO: Spawning a one-shot actor is quite expensive. Maybe the
     //       partition could instead maintain this actor lazily.
+    // The answer is already at hand, so there is no point in skipping the
+    // lookup for cancelled queries.
     return state_->self->spawn([row_ids]() -> caf::behavior {
-      return [=](const curried_predicate&) { return row_ids; };
+      // The staged evaluation of conjunctions restricts later operands to
+      // the candidates of the previous ones.
+      return {
+        [=](const curried_predicate&) { return row_ids; },
+        [=](const curried_predicate&, const ids& candidates) {
+          return row_ids & candidates;
+        },
+        [=](const curried_predicate&, const cancellation_token&) {
+          return row_ids;
+        },
+        [=](const curried_predicate&, const ids& candidates,
+            const cancellation_token&) { return row_ids & candidates; },
+      };
     });
   }
   VAST_WARNING(state_->self, "got unsupported attribute:", ex.attr);
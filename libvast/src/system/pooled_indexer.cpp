@@ -0,0 +1,166 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/system/pooled_indexer.hpp"
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/concept/printable/stream.hpp"
+#include "vast/concept/printable/vast/error.hpp"
+#include "vast/concept/printable/vast/expression.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/work_stealing_pool.hpp"
+#include "vast/error.hpp"
+#include "vast/expression.hpp"
+#include "vast/ids.hpp"
+#include "vast/logger.hpp"
+#include "vast/system/cancellation_token.hpp"
+#include "vast/table_slice.hpp"
+#include "vast/table_slice_column.hpp"
+#include "vast/view.hpp"
+
+#include <caf/send.hpp>
+
+namespace vast::system {
+
+column_range::column_range(detail::work_stealing_pool& pool, caf::actor index,
+                           uuid partition_id, size_t first,
+                           std::vector<pooled_column_ptr> columns)
+  : pool_{pool},
+    index_{std::move(index)},
+    partition_id_{partition_id},
+    first_{first},
+    columns_{std::move(columns)} {
+  for (auto& column : columns_) {
+    std::lock_guard<std::mutex> guard{column->mtx};
+    ++column->writers;
+  }
+}
+
+void column_range::add(table_slice_ptr slice) {
+  VAST_ASSERT(slice != nullptr);
+  ++backlog_;
+  std::lock_guard<std::mutex> guard{mtx_};
+  VAST_ASSERT(!sealed_);
+  queue_.push_back(std::move(slice));
+  schedule();
+}
+
+void column_range::seal() {
+  std::lock_guard<std::mutex> guard{mtx_};
+  if (sealed_)
+    return;
+  sealed_ = true;
+  schedule();
+}
+
+void column_range::schedule() {
+  // Requires holding mtx_. At most one task per range exists at any time,
+  // which keeps the slices in order.
+  if (scheduled_)
+    return;
+  scheduled_ = true;
+  pool_.submit([self = shared_from_this()] { self->run(); });
+}
+
+void column_range::run() {
+  for (;;) {
+    std::unique_lock<std::mutex> guard{mtx_};
+    if (queue_.empty()) {
+      scheduled_ = false;
+      auto sealed = sealed_;
+      guard.unlock();
+      caf::anon_send(index_, atom::progress_v);
+      if (sealed)
+        finish();
+      return;
+    }
+    auto slice = std::move(queue_.front());
+    queue_.pop_front();
+    guard.unlock();
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      auto& column = *columns_[i];
+      std::lock_guard<std::mutex> column_guard{column.mtx};
+      if (column.col != nullptr)
+        column.col->add(table_slice_column{slice, first_ + i});
+    }
+    --backlog_;
+  }
+}
+
+void column_range::finish() {
+  // A column may belong to the ranges of multiple layouts, in which case the
+  // last range to finish persists it and reports its statistics.
+  for (auto& column : columns_) {
+    std::lock_guard<std::mutex> guard{column->mtx};
+    if (--column->writers > 0 || column->col == nullptr)
+      continue;
+    if (auto err = column->col->flush_to_disk())
+      VAST_WARNING_ANON("column_range failed to persist column", column->fqn,
+                        ":", err);
+    caf::anon_send(index_, atom::statistics_v, column->fqn,
+                   column->col->statistics());
+  }
+  caf::anon_send(index_, atom::done_v, partition_id_);
+}
+
+caf::behavior pooled_indexer(caf::event_based_actor* self,
+                             pooled_column_ptr column) {
+  if (column->col == nullptr) {
+    self->quit(make_error(ec::unspecified, "no index for column",
+                          column->fqn));
+    return {};
+  }
+  return {
+    [=](const curried_predicate& pred) {
+      VAST_DEBUG(self, "got predicate:", pred);
+      std::lock_guard<std::mutex> guard{column->mtx};
+      return column->col->lookup(pred.op, make_view(pred.rhs));
+    },
+    [=](const curried_predicate& pred, const ids& candidates) {
+      VAST_DEBUG(self, "got predicate:", pred, "for", rank(candidates),
+                 "candidates");
+      std::lock_guard<std::mutex> guard{column->mtx};
+      return column->col->lookup(pred.op, make_view(pred.rhs), candidates);
+    },
+    [=](const curried_predicate& pred,
+        const cancellation_token& token) -> caf::expected<bitmap> {
+      if (token.cancelled())
+        return make_error(ec::cancelled, "skipped lookup");
+      VAST_DEBUG(self, "got predicate:", pred);
+      std::lock_guard<std::mutex> guard{column->mtx};
+      return column->col->lookup(pred.op, make_view(pred.rhs));
+    },
+    [=](const curried_predicate& pred, const ids& candidates,
+        const cancellation_token& token) -> caf::expected<bitmap> {
+      if (token.cancelled())
+        return make_error(ec::cancelled, "skipped lookup");
+      VAST_DEBUG(self, "got predicate:", pred, "for", rank(candidates),
+                 "candidates");
+      std::lock_guard<std::mutex> guard{column->mtx};
+      return column->col->lookup(pred.op, make_view(pred.rhs), candidates);
+    },
+    [=](atom::statistics) {
+      std::lock_guard<std::mutex> guard{column->mtx};
+      return column->col->statistics();
+    },
+    [=](atom::statistics,
+        const curried_predicate& pred) -> caf::result<double> {
+      std::lock_guard<std::mutex> guard{column->mtx};
+      if (auto x = column->col->selectivity(pred.op, make_view(pred.rhs)))
+        return *x;
+      return make_error(ec::lookup_error, "no selectivity estimate");
+    },
+  };
+}
+
+} // namespace vast::system
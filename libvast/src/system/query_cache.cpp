@@ -0,0 +1,106 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/system/query_cache.hpp"
+
+#include "vast/detail/overload.hpp"
+#include "vast/ewah_bitmap.hpp"
+#include "vast/null_bitmap.hpp"
+#include "vast/roaring_bitmap.hpp"
+#include "vast/wah_bitmap.hpp"
+
+#include <functional>
+
+namespace vast::system {
+
+size_t memusage(const ids& xs) {
+  auto f = detail::overload(
+    [](const null_bitmap& x) { return (x.size() + 7) / 8; },
+    [](const roaring_bitmap& x) {
+      size_t result = 0;
+      for (auto& c : x.containers())
+        result += sizeof(c) + c.values.size() * sizeof(uint16_t)
+                  + c.blocks.size() * sizeof(ids::block_type);
+      return result;
+    },
+    [](const auto& x) { return x.blocks().size() * sizeof(ids::block_type); });
+  return sizeof(ids) + caf::visit(f, xs);
+}
+
+size_t query_cache::key_hash::operator()(const key& x) const {
+  auto h = std::hash<expression>{}(x.expr);
+  return h ^ (std::hash<uuid>{}(x.partition) + 0x9e3779b97f4a7c15 + (h << 6)
+              + (h >> 2));
+}
+
+query_cache::query_cache(size_t max_bytes) : max_bytes_{max_bytes} {
+  // nop
+}
+
+void query_cache::max_bytes(size_t x) {
+  max_bytes_ = x;
+  shrink();
+}
+
+bool query_cache::contains(const expression& expr,
+                           const uuid& partition) const {
+  return index_.count(key{expr, partition}) > 0;
+}
+
+const ids* query_cache::lookup(const expression& expr,
+                               const uuid& partition) {
+  auto i = index_.find(key{expr, partition});
+  if (i == index_.end()) {
+    ++stats_.misses;
+    return nullptr;
+  }
+  ++stats_.hits;
+  entries_.splice(entries_.begin(), entries_, i->second);
+  return &i->second->hits;
+}
+
+void query_cache::add(expression expr, uuid partition, ids hits) {
+  auto k = key{std::move(expr), partition};
+  if (auto i = index_.find(k); i != index_.end())
+    remove(i->second);
+  auto n = memusage(hits);
+  if (n > max_bytes_)
+    return;
+  entries_.push_front({k, std::move(hits), n});
+  index_.emplace(std::move(k), entries_.begin());
+  bytes_ += n;
+  shrink();
+}
+
+void query_cache::erase(const uuid& partition) {
+  for (auto i = entries_.begin(); i != entries_.end();) {
+    auto j = i++;
+    if (j->k.partition == partition)
+      remove(j);
+  }
+}
+
+void query_cache::remove(entry_list::iterator i) {
+  bytes_ -= i->bytes;
+  index_.erase(i->k);
+  entries_.erase(i);
+}
+
+void query_cache::shrink() {
+  while (bytes_ > max_bytes_ && !entries_.empty()) {
+    remove(std::prev(entries_.end()));
+    ++stats_.evictions;
+  }
+}
+
+} // namespace vast::system
@@ -0,0 +1,137 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/system/query_scheduler.hpp"
+
+#include "vast/detail/assert.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace vast::system {
+
+query_priority priority(query_options opts) {
+  if (has_background_option(opts))
+    return query_priority::background;
+  if (has_batch_option(opts))
+    return query_priority::batch;
+  return query_priority::interactive;
+}
+
+const char* to_string(query_priority x) {
+  switch (x) {
+    case query_priority::interactive:
+      return "interactive";
+    case query_priority::batch:
+      return "batch";
+    case query_priority::background:
+      return "background";
+  }
+  return "unknown";
+}
+
+query_scheduler::query_scheduler(weights_type weights) {
+  for (size_t i = 0; i < num_query_priorities; ++i) {
+    VAST_ASSERT(weights[i] > 0);
+    classes_[i].weight = weights[i];
+  }
+}
+
+size_t query_scheduler::size(query_priority prio) const {
+  return classes_[static_cast<size_t>(prio)].size;
+}
+
+uint32_t query_scheduler::weight(query_priority prio) const {
+  return classes_[static_cast<size_t>(prio)].weight;
+}
+
+const query_scheduler::statistics&
+query_scheduler::stats(query_priority prio) const {
+  return classes_[static_cast<size_t>(prio)].stats;
+}
+
+void query_scheduler::enqueue(const caf::actor_addr& client,
+                              query_priority prio, uint32_t cost, job f) {
+  auto& cls = classes_[static_cast<size_t>(prio)];
+  // A class or client that waited for a while must not catch up on the shares
+  // it did not use in the meantime, so we lift its account to the lowest one
+  // among its competitors.
+  if (cls.size == 0) {
+    auto lowest = std::numeric_limits<double>::max();
+    for (auto& other : classes_)
+      if (other.size > 0)
+        lowest = std::min(lowest, other.vtime);
+    if (lowest != std::numeric_limits<double>::max())
+      cls.vtime = std::max(cls.vtime, lowest);
+  }
+  auto& st = cls.clients[client];
+  if (st.jobs.empty()) {
+    auto lowest = std::numeric_limits<uint64_t>::max();
+    for (auto& [addr, other] : cls.clients)
+      if (!other.jobs.empty())
+        lowest = std::min(lowest, other.usage);
+    if (lowest != std::numeric_limits<uint64_t>::max())
+      st.usage = std::max(st.usage, lowest);
+  }
+  st.jobs.push_back({next_seq_++, std::max(cost, uint32_t{1}), clock::now(),
+                     std::move(f)});
+  ++cls.size;
+  ++cls.stats.admitted;
+  ++size_;
+}
+
+query_scheduler::job query_scheduler::dequeue() {
+  VAST_ASSERT(!empty());
+  // Select the class with the smallest share relative to its weight. Ties go
+  // to the higher priority.
+  priority_class* cls = nullptr;
+  for (auto& x : classes_)
+    if (x.size > 0 && (cls == nullptr || x.vtime < cls->vtime))
+      cls = &x;
+  VAST_ASSERT(cls != nullptr);
+  // Select the client with the fewest evaluated partitions. Ties go to the
+  // client that waits the longest.
+  client_state* st = nullptr;
+  for (auto& [addr, x] : cls->clients) {
+    if (x.jobs.empty())
+      continue;
+    if (st == nullptr || x.usage < st->usage
+        || (x.usage == st->usage && x.jobs.front().seq < st->jobs.front().seq))
+      st = &x;
+  }
+  VAST_ASSERT(st != nullptr);
+  auto x = std::move(st->jobs.front());
+  st->jobs.pop_front();
+  // Charge the job.
+  st->usage += x.cost;
+  cls->vtime += static_cast<double>(x.cost) / cls->weight;
+  --cls->size;
+  --size_;
+  // Update statistics.
+  auto wait = std::chrono::duration_cast<caf::timespan>(clock::now()
+                                                        - x.enqueued);
+  ++cls->stats.dispatched;
+  cls->stats.partitions += x.cost;
+  cls->stats.total_wait += wait;
+  cls->stats.max_wait = std::max(cls->stats.max_wait, wait);
+  return std::move(x.f);
+}
+
+void query_scheduler::forget(const caf::actor_addr& client) {
+  for (auto& cls : classes_)
+    if (auto i = cls.clients.find(client);
+        i != cls.clients.end() && i->second.jobs.empty())
+      cls.clients.erase(i);
+}
+
+} // namespace vast::system
@@ -16,6 +16,7 @@
 #include "vast/expression.hpp"
 #include "vast/fwd.hpp"
 #include "vast/logger.hpp"
+#include "vast/system/cancellation_token.hpp"
 
 #include <caf/event_based_actor.hpp>
 #include <caf/local_actor.hpp>
@@ -47,35 +48,57 @@ query_supervisor(caf::stateful_actor<query_supervisor_state>* self,
                  caf::actor master) {
   // Ask master for initial work.
   self->send(master, atom::worker_v, self);
-  return {
-    [=](const expression&, const query_map& qm, const caf::actor& client) {
-      VAST_DEBUG(self, "got a new query for", qm.size(), "partitions:",
-                 get_ids(qm));
-      VAST_ASSERT(!qm.empty());
-      VAST_ASSERT(self->state.open_requests.empty());
-      for (auto& kvp : qm) {
-        auto& id = kvp.first;
-        auto& evaluators = kvp.second;
-        VAST_DEBUG(self, "asks", evaluators.size(),
-                   "EVALUATOR actor(s) for partition", id);
-        self->state.open_requests.emplace(id, evaluators.size());
-        for (auto& evaluator : evaluators)
-          self->request(evaluator, caf::infinite, client).then([=](atom::done) {
-            auto& num_evaluators = self->state.open_requests[id];
-            if (--num_evaluators == 0) {
-              VAST_DEBUG(self, "collected all results for partition", id);
-              self->state.open_requests.erase(id);
-              // Ask master for more work after receiving the last sub
-              // result.
-              if (self->state.open_requests.empty()) {
-                VAST_DEBUG(self, "collected all results for all partitions");
-                self->send(client, atom::done_v);
-                self->send(master, atom::worker_v, self);
-              }
+  auto run = [=](const query_map& qm, const cancellation_token& token,
+                 const caf::actor& client) {
+    VAST_DEBUG(self, "got a new query for", qm.size(), "partitions:",
+               get_ids(qm));
+    VAST_ASSERT(!qm.empty());
+    VAST_ASSERT(self->state.open_requests.empty());
+    // The client may have gone away while the query was waiting for a worker.
+    if (token.cancelled()) {
+      VAST_DEBUG(self, "drops a cancelled query");
+      self->send(client, atom::done_v);
+      self->send(master, atom::worker_v, self);
+      return;
+    }
+    for (auto& kvp : qm) {
+      auto& id = kvp.first;
+      auto& evaluators = kvp.second;
+      VAST_DEBUG(self, "asks", evaluators.size(),
+                 "EVALUATOR actor(s) for partition", id);
+      self->state.open_requests.emplace(id, evaluators.size());
+      for (auto& evaluator : evaluators) {
+        auto on_done = [=](atom::done) {
+          auto& num_evaluators = self->state.open_requests[id];
+          if (--num_evaluators == 0) {
+            VAST_DEBUG(self, "collected all results for partition", id);
+            self->state.open_requests.erase(id);
+            // Ask master for more work after receiving the last sub
+            // result.
+            if (self->state.open_requests.empty()) {
+              VAST_DEBUG(self, "collected all results for all partitions");
+              self->send(client, atom::done_v);
+              self->send(master, atom::worker_v, self);
             }
-          });
+          }
+        };
+        // Only pass the token along if there is something to cancel.
+        if (token)
+          self->request(evaluator, caf::infinite, client, token).then(on_done);
+        else
+          self->request(evaluator, caf::infinite, client).then(on_done);
       }
-    }};
+    }
+  };
+  return {
+    [=](const expression&, const query_map& qm, const caf::actor& client) {
+      run(qm, cancellation_token{}, client);
+    },
+    [=](const expression&, const query_map& qm,
+        const cancellation_token& token, const caf::actor& client) {
+      run(qm, token, client);
+    },
+  };
 }
 
 } // namespace vast::system
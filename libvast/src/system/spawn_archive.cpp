@@ -15,6 +15,7 @@
 
 #include "vast/defaults.hpp"
 #include "vast/filesystem.hpp"
+#include "vast/logger.hpp"
 #include "vast/si_literals.hpp"
 #include "vast/system/archive.hpp"
 #include "vast/system/node.hpp"
@@ -35,11 +36,16 @@ maybe_actor spawn_archive(node_actor* self, spawn_arguments& args) {
   namespace sd = vast::defaults::system;
   if (!args.empty())
     return unexpected_arguments(args);
-  auto segments = get_or(args.inv.options, "segments", sd::segments);
+  if (caf::get_if<size_t>(&args.inv.options, "segments"))
+    VAST_WARNING(self, "ignores the deprecated option 'segments', use "
+                       "'cache-size' instead");
+  auto cache_size
+    = 1_MiB
+      * get_or(args.inv.options, "cache-size", sd::segment_cache_size);
   auto mss
     = 1_MiB
       * get_or(args.inv.options, "max-segment-size", sd::max_segment_size);
-  auto a = self->spawn(archive, args.dir / args.label, segments, mss);
+  auto a = self->spawn(archive, args.dir / args.label, cache_size, mss);
   self->state.archive = a;
   return caf::actor_cast<caf::actor>(a);
 }
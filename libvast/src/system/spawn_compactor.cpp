@@ -0,0 +1,60 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/system/spawn_compactor.hpp"
+
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/time.hpp"
+#include "vast/defaults.hpp"
+#include "vast/error.hpp"
+#include "vast/logger.hpp"
+#include "vast/system/compactor.hpp"
+#include "vast/system/node.hpp"
+#include "vast/system/spawn_arguments.hpp"
+
+#include <caf/settings.hpp>
+
+namespace vast::system {
+
+maybe_actor
+spawn_compactor(system::node_actor* self, system::spawn_arguments& args) {
+  VAST_TRACE(VAST_ARG(self), VAST_ARG(args));
+  // We require the COMPACTOR to be started after INDEX and ARCHIVE components.
+  VAST_ASSERT(self->state.index);
+  VAST_ASSERT(self->state.archive);
+  // Parse options.
+  auto compaction_interval = defaults::system::compaction_interval;
+  if (auto str = caf::get_if<std::string>(&args.inv.options, "system."
+                                                             "compaction-"
+                                                             "interval")) {
+    auto parsed = to<duration>(*str);
+    if (!parsed)
+      return parsed.error();
+    compaction_interval = *parsed;
+  }
+  if (compaction_interval <= duration::zero()) {
+    VAST_VERBOSE(self, "has compaction disabled and skips starting the "
+                       "compactor");
+    return ec::no_error;
+  }
+  // Spawn the COMPACTOR. It reads and writes partitions, so we keep it off
+  // the scheduler threads.
+  auto res = self->spawn<caf::detached>(
+    compactor, compaction_interval, self->state.index,
+    caf::actor_cast<caf::actor>(self->state.archive));
+  if (res)
+    self->system().registry().put(atom::compactor_v, res);
+  return res;
+}
+
+} // namespace vast::system
@@ -42,6 +42,10 @@ maybe_actor spawn_exporter(node_actor* self, spawn_arguments& args) {
   // Default to historical if no options provided.
   if (query_opts == no_query_options)
     query_opts = historical;
+  if (get_or(args.inv.options, "export.oldest-first", false))
+    query_opts = query_opts + oldest_first;
+  if (get_or(args.inv.options, "export.batch", false))
+    query_opts = query_opts + batch;
   auto exp = self->spawn(exporter, std::move(*expr), query_opts);
   // Setting max-events to 0 means infinite.
   auto max_events = get_or(args.inv.options, "export.max-events",
@@ -56,7 +56,7 @@ spawn_node(caf::scoped_actor& self, const caf::settings& opts) {
     return result;
   };
   std::list components
-    = {"type-registry", "archive", "index", "importer", "eraser"};
+    = {"type-registry", "archive", "index", "importer", "compactor", "eraser"};
   if (accounting)
     components.push_front("accountant");
   for (auto& c : components) {
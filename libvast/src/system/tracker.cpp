@@ -69,7 +69,7 @@ void register_component(scheduled_actor* self, tracker_state& st,
 // Checks whether a component can be spawned at most once.
 bool is_singleton(const std::string& component) {
   const char* singletons[]
-    = {"archive", "importer", "index", "type-registry", "eraser"};
+    = {"archive", "importer", "index", "type-registry", "eraser", "compactor"};
   auto pred = [&](const char* lhs) { return lhs == component; };
   return std::any_of(std::begin(singletons), std::end(singletons), pred);
 }
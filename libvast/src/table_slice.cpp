@@ -16,6 +16,7 @@
 #include "vast/caf_table_slice.hpp"
 #include "vast/caf_table_slice_builder.hpp"
 #include "vast/chunk.hpp"
+#include "vast/column_statistics.hpp"
 #include "vast/defaults.hpp"
 #include "vast/detail/assert.hpp"
 #include "vast/detail/byte_swap.hpp"
@@ -24,7 +25,9 @@
 #include "vast/event.hpp"
 #include "vast/factory.hpp"
 #include "vast/format/test.hpp"
+#include "vast/ids.hpp"
 #include "vast/logger.hpp"
+#include "vast/si_literals.hpp"
 #include "vast/table_slice_builder.hpp"
 #include "vast/table_slice_factory.hpp"
 #include "vast/value.hpp"
@@ -42,6 +45,7 @@
 #include <caf/sum_type.hpp>
 
 #include <unordered_map>
+#include <vector>
 
 #include <vast/table_slice_builder_factory.hpp>
 
@@ -122,7 +126,8 @@ table_slice::column(std::string_view name) const {
 // slice and then calling GetTableSlice(buf). But until we touch the table
 // slice internals, we use this helper.
 caf::expected<flatbuffers::Offset<fbs::TableSliceBuffer>>
-pack(flatbuffers::FlatBufferBuilder& builder, table_slice_ptr x) {
+pack(flatbuffers::FlatBufferBuilder& builder, table_slice_ptr x,
+     compression method) {
   // This local builder instance will vanish once we can access the underlying
   // chunk of a table slice.
   flatbuffers::FlatBufferBuilder local_builder;
@@ -146,6 +151,21 @@ pack(flatbuffers::FlatBufferBuilder& builder, table_slice_ptr x) {
   auto encoding = transform(x->implementation_id());
   if (!encoding)
     return encoding.error();
+  // Compress the data, unless that fails or does not pay off. The layout
+  // stays uncompressed, because it is small.
+  auto uncompressed_size = data_buffer.size();
+  auto flat_compression = fbs::Compression::Null;
+  if (method != compression::null) {
+    std::vector<char> compressed(compress_bound(method, data_buffer.size()));
+    auto n = compress(method, data_buffer.data(), data_buffer.size(),
+                      compressed.data(), compressed.size());
+    if (n > 0 && n < data_buffer.size()) {
+      compressed.resize(n);
+      data_buffer = std::move(compressed);
+      flat_compression = method == compression::lz4 ? fbs::Compression::LZ4
+                                                    : fbs::Compression::Zstd;
+    }
+  }
   auto layout_ptr = reinterpret_cast<const uint8_t*>(layout_buffer.data());
   auto layout = local_builder.CreateVector(layout_ptr, layout_buffer.size());
   auto data_ptr = reinterpret_cast<const uint8_t*>(data_buffer.data());
@@ -156,6 +176,8 @@ pack(flatbuffers::FlatBufferBuilder& builder, table_slice_ptr x) {
   table_slice_builder.add_layout(layout);
   table_slice_builder.add_encoding(*encoding);
   table_slice_builder.add_data(data);
+  table_slice_builder.add_compression(flat_compression);
+  table_slice_builder.add_uncompressed_size(uncompressed_size);
   auto flat_slice = table_slice_builder.Finish();
   local_builder.Finish(flat_slice);
   auto buffer = span<const uint8_t>{local_builder.GetBufferPointer(),
@@ -171,7 +193,26 @@ pack(flatbuffers::FlatBufferBuilder& builder, table_slice_ptr x) {
 // TODO: The dual to the note above applies here.
 caf::error unpack(const fbs::TableSlice& x, table_slice_ptr& y) {
   auto ptr = reinterpret_cast<const char*>(x.data()->Data());
-  caf::binary_deserializer source{nullptr, ptr, x.data()->size()};
+  auto size = size_t{x.data()->size()};
+  std::vector<char> buffer;
+  if (x.compression() != fbs::Compression::Null) {
+    auto method = x.compression() == fbs::Compression::LZ4 ? compression::lz4
+                                                           : compression::zstd;
+    // Don't trust the size on disk before allocating for it.
+    using namespace binary_byte_literals;
+    auto max_size = 1_MiB * defaults::system::max_table_slice_size;
+    if (x.uncompressed_size() > max_size)
+      return make_error(ec::format_error,
+                        "uncompressed table slice size exceeds limit:",
+                        x.uncompressed_size());
+    buffer.resize(x.uncompressed_size());
+    auto n = uncompress(method, ptr, size, buffer.data(), buffer.size());
+    if (n != buffer.size())
+      return make_error(ec::format_error, "failed to decompress table slice");
+    ptr = buffer.data();
+    size = buffer.size();
+  }
+  caf::binary_deserializer source{nullptr, ptr, size};
   return source(y);
 }
 
@@ -182,10 +223,37 @@ caf::error table_slice::load(chunk_ptr chunk) {
   return deserialize(source);
 }
 
-void table_slice::append_column_to_index(size_type col,
-                                         value_index& idx) const {
+void table_slice::append_column_to_index(size_type col, value_index& idx,
+                                         column_statistics* stats) const {
+  for (size_type row = 0; row < rows(); ++row) {
+    auto x = at(row, col);
+    idx.append(x, offset() + row);
+    if (stats != nullptr)
+      stats->add(x);
+  }
+}
+
+void table_slice::for_each_in_column(
+  size_type col, const std::function<void(data_view)>& f) const {
+  VAST_ASSERT(col < columns());
+  for (size_type row = 0; row < rows(); ++row) {
+    auto x = at(row, col);
+    if (!caf::holds_alternative<caf::none_t>(x))
+      f(std::move(x));
+  }
+}
+
+ids table_slice::evaluate_column(size_type col, relational_operator op,
+                                 const data& rhs) const {
+  VAST_ASSERT(col < columns());
+  auto& t = layout().fields[col].type;
+  auto rhs_view = make_data_view(rhs);
+  ids result;
+  result.append_bits(false, offset());
   for (size_type row = 0; row < rows(); ++row)
-    idx.append(at(row, col), offset() + row);
+    result.append_bit(evaluate_view(to_canonical(t, at(row, col)), op,
+                                    rhs_view));
+  return result;
 }
 
 caf::expected<std::vector<table_slice_ptr>>
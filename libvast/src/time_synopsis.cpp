@@ -13,13 +13,86 @@
 
 #include "vast/time_synopsis.hpp"
 
+#include "vast/config.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/narrow.hpp"
+#include "vast/table_slice_column.hpp"
+
+#if VAST_HAVE_ARROW
+#  include "vast/arrow_table_slice.hpp"
+
+#  include <arrow/api.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
 namespace vast {
 
+namespace {
+
+#if VAST_HAVE_ARROW
+
+time to_time(int64_t x, arrow::TimeUnit::type unit) {
+  using namespace std::chrono;
+  switch (unit) {
+    case arrow::TimeUnit::SECOND:
+      return time{duration_cast<duration>(seconds{x})};
+    case arrow::TimeUnit::MILLI:
+      return time{duration_cast<duration>(milliseconds{x})};
+    case arrow::TimeUnit::MICRO:
+      return time{duration_cast<duration>(microseconds{x})};
+    case arrow::TimeUnit::NANO:
+      break;
+  }
+  return time{duration{x}};
+}
+
+#endif // VAST_HAVE_ARROW
+
+} // namespace
+
 time_synopsis::time_synopsis(vast::type x)
   : min_max_synopsis<time>{std::move(x), time::max(), time::min()} {
   // nop
 }
 
+void time_synopsis::add(const table_slice_column& x) {
+  VAST_ASSERT(x.slice != nullptr);
+#if VAST_HAVE_ARROW
+  // Arrow stores timestamps as plain integers of a fixed unit, so we can find
+  // the extrema on the raw values and only convert those two.
+  if (x.slice->implementation_id() == arrow_table_slice::class_id) {
+    auto& slice = static_cast<const arrow_table_slice&>(*x.slice);
+    auto arr = slice.batch()->column(detail::narrow_cast<int>(x.column));
+    if (arr->type_id() == arrow::Type::TIMESTAMP) {
+      auto& ts = static_cast<const arrow::TimestampArray&>(*arr);
+      auto values = ts.raw_values();
+      auto lo = std::numeric_limits<int64_t>::max();
+      auto hi = std::numeric_limits<int64_t>::min();
+      auto found = false;
+      for (int64_t row = 0; row < ts.length(); ++row) {
+        if (ts.IsNull(row))
+          continue;
+        lo = std::min(lo, values[row]);
+        hi = std::max(hi, values[row]);
+        found = true;
+      }
+      if (found) {
+        auto unit = static_cast<const arrow::TimestampType&>(*ts.type()).unit();
+        update(to_time(lo, unit), to_time(hi, unit));
+      }
+      return;
+    }
+  }
+#endif // VAST_HAVE_ARROW
+  x.slice->for_each_in_column(x.column, [this](data_view y) {
+    auto t = caf::get<view<time>>(y);
+    update(t, t);
+  });
+}
+
 bool time_synopsis::equals(const synopsis& other) const noexcept {
   if (typeid(other) != typeid(time_synopsis))
     return false;
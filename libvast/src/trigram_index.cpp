@@ -0,0 +1,330 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/trigram_index.hpp"
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/detail/overload.hpp"
+#include "vast/error.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace vast {
+
+namespace {
+
+/// The effect of a quantifier on the preceding atom of a regular expression.
+enum class repetition { once, optional, repeated };
+
+} // namespace
+
+trigram_index::trigram_index(vast::type t, caf::settings opts)
+  : value_index{std::move(t), std::move(opts)},
+    exact_{string_type{}, options()} {
+  // nop
+}
+
+std::vector<trigram_index::trigram_type>
+trigram_index::trigrams(std::string_view str) {
+  std::vector<trigram_type> result;
+  if (str.size() < 3)
+    return result;
+  result.reserve(str.size() - 2);
+  for (size_t i = 0; i + 3 <= str.size(); ++i) {
+    auto byte = [&](size_t j) {
+      return static_cast<trigram_type>(static_cast<unsigned char>(str[i + j]));
+    };
+    result.push_back(byte(0) << 16 | byte(1) << 8 | byte(2));
+  }
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+std::vector<std::string>
+trigram_index::required_literals(std::string_view pattern) {
+  std::vector<std::string> result;
+  std::string run;
+  auto flush = [&] {
+    if (!run.empty())
+      result.push_back(std::move(run));
+    run.clear();
+  };
+  auto n = pattern.size();
+  size_t i = 0;
+  auto skip_class = [&] {
+    ++i;
+    if (i < n && pattern[i] == '^')
+      ++i;
+    if (i < n && pattern[i] == ']')
+      ++i;
+    while (i < n && pattern[i] != ']')
+      i += pattern[i] == '\\' ? 2 : 1;
+    ++i;
+  };
+  auto skip_group = [&] {
+    size_t depth = 0;
+    while (i < n) {
+      switch (pattern[i]) {
+        default:
+          ++i;
+          break;
+        case '\\':
+          i += 2;
+          break;
+        case '[':
+          skip_class();
+          break;
+        case '(':
+          ++depth;
+          ++i;
+          break;
+        case ')':
+          ++i;
+          if (--depth == 0)
+            return;
+          break;
+      }
+    }
+  };
+  auto skip_quantifier = [&] {
+    auto result = repetition::once;
+    if (i >= n)
+      return result;
+    switch (pattern[i]) {
+      default:
+        return result;
+      case '?':
+      case '*':
+        result = repetition::optional;
+        ++i;
+        break;
+      case '+':
+        result = repetition::repeated;
+        ++i;
+        break;
+      case '{':
+        result = i + 1 < n && pattern[i + 1] == '0' ? repetition::optional
+                                                    : repetition::repeated;
+        while (i < n && pattern[i] != '}')
+          ++i;
+        ++i;
+        break;
+    }
+    // Skip the modifier of a lazy quantifier.
+    if (i < n && pattern[i] == '?')
+      ++i;
+    return result;
+  };
+  auto literal = [&](char c) {
+    switch (skip_quantifier()) {
+      case repetition::once:
+        run += c;
+        break;
+      case repetition::optional:
+        flush();
+        break;
+      case repetition::repeated:
+        // The last repetition of the character still precedes the rest.
+        run += c;
+        flush();
+        run += c;
+        break;
+    }
+  };
+  while (i < n) {
+    auto c = pattern[i];
+    switch (c) {
+      default:
+        ++i;
+        literal(c);
+        break;
+      case '|':
+        // A top-level alternation makes every substring optional.
+        return {};
+      case '(':
+        skip_group();
+        skip_quantifier();
+        flush();
+        break;
+      case '[':
+        skip_class();
+        skip_quantifier();
+        flush();
+        break;
+      case '.':
+      case '^':
+      case '$':
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+        ++i;
+        skip_quantifier();
+        flush();
+        break;
+      case '\\': {
+        if (i + 1 >= n) {
+          i = n;
+          break;
+        }
+        auto escaped = pattern[i + 1];
+        i += 2;
+        if (std::ispunct(static_cast<unsigned char>(escaped))) {
+          literal(escaped);
+          break;
+        }
+        if (escaped == 'n' || escaped == 'r' || escaped == 't') {
+          literal(escaped == 'n' ? '\n' : escaped == 'r' ? '\r' : '\t');
+          break;
+        }
+        // Character classes, assertions, back references, and numeric
+        // escapes: skip the operands of the latter two.
+        if (escaped == 'x')
+          i += 2;
+        else if (escaped == 'u')
+          i += 4;
+        else if (escaped == 'c')
+          i += 1;
+        else if (std::isdigit(static_cast<unsigned char>(escaped)))
+          while (i < n && std::isdigit(static_cast<unsigned char>(pattern[i])))
+            ++i;
+        skip_quantifier();
+        flush();
+        break;
+      }
+    }
+  }
+  flush();
+  return result;
+}
+
+size_t trigram_index::cardinality() const {
+  return postings_.size();
+}
+
+caf::error trigram_index::serialize(caf::serializer& sink) const {
+  return caf::error::eval([&] { return value_index::serialize(sink); },
+                          [&] { return sink(exact_, postings_); });
+}
+
+caf::error trigram_index::deserialize(caf::deserializer& source) {
+  return caf::error::eval([&] { return value_index::deserialize(source); },
+                          [&] { return source(exact_, postings_); });
+}
+
+caf::error trigram_index::pack_impl(value_index_packer& f) const {
+  return f(exact_, postings_);
+}
+
+caf::error trigram_index::unpack_impl(value_index_unpacker& f) {
+  return f(exact_, postings_);
+}
+
+bool trigram_index::append_impl(data_view x, id pos) {
+  auto str = caf::get_if<view<std::string>>(&x);
+  if (!str)
+    return false;
+  if (!exact_.append(x, pos))
+    return false;
+  for (auto trigram : trigrams(*str)) {
+    auto& bm = postings_[trigram];
+    bm.append_bits(false, pos - bm.size());
+    bm.append_bit(true);
+  }
+  return true;
+}
+
+ids trigram_index::candidates(const std::vector<trigram_type>& xs) const {
+  if (xs.empty())
+    return everything();
+  std::vector<const ewah_bitmap*> operands;
+  operands.reserve(xs.size());
+  for (auto x : xs) {
+    auto i = postings_.find(x);
+    if (i == postings_.end())
+      return ids{offset(), false};
+    operands.push_back(&i->second);
+  }
+  auto result = nary_and(operands.begin(), operands.end());
+  result.append_bits(false, offset() - result.size());
+  return result;
+}
+
+caf::expected<ids>
+trigram_index::exact_lookup(relational_operator op, data_view x) const {
+  auto result = exact_.lookup(op, x);
+  if (!result)
+    return result;
+  // The exact index never sees nil values and may thus be shorter.
+  result->append_bits(false, offset() - result->size());
+  return result;
+}
+
+ids trigram_index::everything() const {
+  return ids{offset(), true};
+}
+
+caf::expected<ids>
+trigram_index::lookup_impl(relational_operator op, data_view x) const {
+  return caf::visit(
+    detail::overload(
+      [&](auto x) -> caf::expected<ids> {
+        return make_error(ec::type_clash, materialize(x));
+      },
+      [&](view<std::string> str) -> caf::expected<ids> {
+        switch (op) {
+          default:
+            return make_error(ec::unsupported_operator, op);
+          case equal:
+          case not_equal:
+          case not_ni:
+            return exact_lookup(op, x);
+          case ni:
+            // Needles without a trigram have no posting list to consult.
+            if (str.size() < 3)
+              return exact_lookup(op, x);
+            return candidates(trigrams(str));
+        }
+      },
+      [&](view<pattern> pat) -> caf::expected<ids> {
+        switch (op) {
+          default:
+            return make_error(ec::unsupported_operator, op);
+          case equal:
+          case match:
+          case ni: {
+            std::vector<trigram_type> xs;
+            for (auto& literal : required_literals(pat.string())) {
+              auto ys = trigrams(literal);
+              xs.insert(xs.end(), ys.begin(), ys.end());
+            }
+            std::sort(xs.begin(), xs.end());
+            xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+            return candidates(xs);
+          }
+          case not_equal:
+          case not_match:
+          case not_ni:
+            // The complement of a candidate set is not a superset of the
+            // complement of the actual result, so every value qualifies.
+            return everything();
+        }
+      },
+      [&](view<vector>) { return exact_lookup(op, x); },
+      [&](view<set>) { return exact_lookup(op, x); }),
+    x);
+}
+
+} // namespace vast
@@ -68,7 +68,38 @@ value_index::lookup(relational_operator op, data_view x) const {
     return result;
   }
   // If x is not nil, we dispatch to the concrete implementation.
-  auto result = lookup_impl(op, x);
+  auto result = finish_lookup(op, lookup_impl(op, x));
+  if (auto err = decode_error())
+    return err;
+  return result;
+}
+
+caf::expected<ids> value_index::lookup(relational_operator op, data_view x,
+                                       const ids& candidates) const {
+  if (!any<1>(candidates))
+    return ids{offset(), false};
+  auto result = caf::holds_alternative<caf::none_t>(x)
+                  ? lookup(op, x)
+                  : finish_lookup(op,
+                                  restricted_lookup_impl(op, x, candidates));
+  if (!result)
+    return result;
+  if (auto err = decode_error())
+    return err;
+  *result &= candidates;
+  if (result->size() < offset())
+    result->append_bits(false, offset() - result->size());
+  return std::move(*result);
+}
+
+caf::expected<ids>
+value_index::restricted_lookup_impl(relational_operator op, data_view x,
+                                    const ids&) const {
+  return lookup_impl(op, x);
+}
+
+caf::expected<ids> value_index::finish_lookup(relational_operator op,
+                                              caf::expected<ids> result) const {
   if (!result)
     return result;
   // The result can only have mass (i.e., 1-bits) where actual IDs exist.
@@ -88,6 +119,12 @@ value_index::lookup(relational_operator op, data_view x) const {
   return std::move(*result);
 }
 
+caf::error value_index::decode_error() const {
+  if (decode_status_ == nullptr)
+    return caf::none;
+  return decode_status_->error();
+}
+
 value_index::size_type value_index::offset() const {
   return std::max(none_.size(), mask_.size());
 }
@@ -108,6 +145,14 @@ caf::error value_index::deserialize(caf::deserializer& source) {
   return source(mask_, none_);
 }
 
+caf::error value_index::pack_impl(value_index_packer& f) const {
+  return serialize(f.state());
+}
+
+caf::error value_index::unpack_impl(value_index_unpacker& f) {
+  return deserialize(f.state());
+}
+
 const ewah_bitmap& value_index::mask() const {
   return mask_;
 }
@@ -149,6 +194,20 @@ caf::error inspect(caf::deserializer& source, value_index_ptr& x) {
   return x->deserialize(source);
 }
 
+caf::expected<flatbuffers::Offset<fbs::ValueIndex>>
+pack(flatbuffers::FlatBufferBuilder& builder, const value_index& x) {
+  return value_index_packer::pack(builder, x);
+}
+
+caf::error unpack(const fbs::ValueIndex& x, value_index_ptr& y,
+                  chunk_ptr chunk) {
+  auto result = value_index_unpacker::unpack(x, std::move(chunk));
+  if (!result)
+    return result.error();
+  y = std::move(*result);
+  return caf::none;
+}
+
 // -- string_index -------------------------------------------------------------
 
 string_index::string_index(vast::type t, caf::settings opts)
@@ -169,6 +228,14 @@ caf::error string_index::deserialize(caf::deserializer& source) {
                           [&] { return source(max_length_, length_, chars_); });
 }
 
+caf::error string_index::pack_impl(value_index_packer& f) const {
+  return f(max_length_, length_, chars_);
+}
+
+caf::error string_index::unpack_impl(value_index_unpacker& f) {
+  return f(max_length_, length_, chars_);
+}
+
 bool string_index::append_impl(data_view x, id pos) {
   auto str = caf::get_if<view<std::string>>(&x);
   if (!str)
@@ -189,6 +256,18 @@ bool string_index::append_impl(data_view x, id pos) {
 
 caf::expected<ids>
 string_index::lookup_impl(relational_operator op, data_view x) const {
+  return lookup_string(op, x, nullptr);
+}
+
+caf::expected<ids>
+string_index::restricted_lookup_impl(relational_operator op, data_view x,
+                                     const ids& candidates) const {
+  return lookup_string(op, x, &candidates);
+}
+
+caf::expected<ids> string_index::lookup_string(relational_operator op,
+                                               data_view x,
+                                               const ids* candidates) const {
   return caf::visit(
     detail::overload(
       [&](auto x) -> caf::expected<ids> {
@@ -212,6 +291,10 @@ string_index::lookup_impl(relational_operator op, data_view x) const {
             if (str_size > chars_.size())
               return ids{offset(), op == not_equal};
             auto result = length_.lookup(less_equal, str_size);
+            // Restricting the result to the candidates up front lets the
+            // loop below stop as soon as no candidate matches anymore.
+            if (candidates)
+              result &= *candidates;
             if (all<0>(result))
               return ids{offset(), op == not_equal};
             for (auto i = 0u; i < str_size; ++i) {
@@ -275,6 +358,14 @@ caf::error enumeration_index::deserialize(caf::deserializer& source) {
                           [&] { return source(index_); });
 }
 
+caf::error enumeration_index::pack_impl(value_index_packer& f) const {
+  return f(index_);
+}
+
+caf::error enumeration_index::unpack_impl(value_index_unpacker& f) {
+  return f(index_);
+}
+
 bool enumeration_index::append_impl(data_view x, id pos) {
   if (auto e = caf::get_if<view<enumeration>>(&x)) {
     index_.skip(pos - index_.size());
@@ -318,6 +409,14 @@ caf::error address_index::deserialize(caf::deserializer& source) {
                           [&] { return source(bytes_, v4_); });
 }
 
+caf::error address_index::pack_impl(value_index_packer& f) const {
+  return f(bytes_, v4_);
+}
+
+caf::error address_index::unpack_impl(value_index_unpacker& f) {
+  return f(bytes_, v4_);
+}
+
 bool address_index::append_impl(data_view x, id pos) {
   auto addr = caf::get_if<view<address>>(&x);
   if (!addr)
@@ -334,6 +433,18 @@ bool address_index::append_impl(data_view x, id pos) {
 
 caf::expected<ids>
 address_index::lookup_impl(relational_operator op, data_view d) const {
+  return lookup_address(op, d, nullptr);
+}
+
+caf::expected<ids>
+address_index::restricted_lookup_impl(relational_operator op, data_view d,
+                                      const ids& candidates) const {
+  return lookup_address(op, d, &candidates);
+}
+
+caf::expected<ids> address_index::lookup_address(relational_operator op,
+                                                 data_view d,
+                                                 const ids* candidates) const {
   return caf::visit(
     detail::overload(
       [&](auto x) -> caf::expected<ids> {
@@ -343,6 +454,8 @@ address_index::lookup_impl(relational_operator op, data_view d) const {
         if (!(op == equal || op == not_equal))
           return make_error(ec::unsupported_operator, op);
         auto result = x.is_v4() ? v4_.coder().storage() : ids{offset(), true};
+        if (candidates)
+          result &= *candidates;
         for (auto i = x.is_v4() ? 12u : 0u; i < 16; ++i) {
           auto bm = bytes_[i].lookup(equal, x.data()[i]);
           result &= bm;
@@ -364,12 +477,18 @@ address_index::lookup_impl(relational_operator op, data_view d) const {
         if ((is_v4 ? topk + 96 : topk) == 128)
           // Asking for /32 or /128 membership is equivalent to an equality
           // lookup.
-          return lookup_impl(op == in ? equal : not_equal, x.network());
+          return lookup_address(op == in ? equal : not_equal, x.network(),
+                                candidates);
         auto result = is_v4 ? v4_.coder().storage() : ids{offset(), true};
+        if (candidates)
+          result &= *candidates;
         auto& bytes = x.network().data();
         size_t i = is_v4 ? 12 : 0;
-        for (; i < 16 && topk >= 8; ++i, topk -= 8)
+        for (; i < 16 && topk >= 8; ++i, topk -= 8) {
+          if (all<0>(result))
+            return ids{offset(), op == not_in};
           result &= bytes_[i].lookup(equal, bytes[i]);
+        }
         for (auto j = 0u; j < topk; ++j) {
           auto bit = 7 - j;
           auto& bm = bytes_[i].coder().storage()[bit];
@@ -403,6 +522,14 @@ caf::error subnet_index::deserialize(caf::deserializer& source) {
                           [&] { return source(network_, length_); });
 }
 
+caf::error subnet_index::pack_impl(value_index_packer& f) const {
+  return f(network_, length_);
+}
+
+caf::error subnet_index::unpack_impl(value_index_unpacker& f) {
+  return f(network_, length_);
+}
+
 bool subnet_index::append_impl(data_view x, id pos) {
   if (auto sn = caf::get_if<view<subnet>>(&x)) {
     length_.skip(pos - length_.size());
@@ -510,6 +637,14 @@ caf::error port_index::deserialize(caf::deserializer& source) {
                           [&] { return source(num_, proto_); });
 }
 
+caf::error port_index::pack_impl(value_index_packer& f) const {
+  return f(num_, proto_);
+}
+
+caf::error port_index::unpack_impl(value_index_unpacker& f) {
+  return f(num_, proto_);
+}
+
 bool port_index::append_impl(data_view x, id pos) {
   if (auto p = caf::get_if<view<port>>(&x)) {
     num_.skip(pos - num_.size());
@@ -18,8 +18,10 @@
 #include "vast/concept/parseable/vast/base.hpp"
 #include "vast/detail/bit.hpp"
 #include "vast/detail/type_traits.hpp"
+#include "vast/dictionary_index.hpp"
 #include "vast/hash_index.hpp"
 #include "vast/logger.hpp"
+#include "vast/trigram_index.hpp"
 #include "vast/type.hpp"
 #include "vast/value_index.hpp"
 
@@ -56,6 +58,17 @@ value_index_ptr make(type x, caf::settings opts) {
     }
   }
   if (auto a = find_attribute(x, "index")) {
+    if (auto value = a->value; value && *value == "dictionary"sv) {
+      if constexpr (std::is_same_v<T, string_index>)
+        return std::make_unique<dictionary_index>(std::move(x),
+                                                  std::move(opts));
+      VAST_WARNING_ANON(__func__, "ignores #index=dictionary for type", x);
+    }
+    if (auto value = a->value; value && *value == "trigram"sv) {
+      if constexpr (std::is_same_v<T, string_index>)
+        return std::make_unique<trigram_index>(std::move(x), std::move(opts));
+      VAST_WARNING_ANON(__func__, "ignores #index=trigram for type", x);
+    }
     if (auto value = a->value)
       if (*value == "hash"sv) {
         auto i = opts.find("cardinality");
@@ -0,0 +1,171 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/value_index_packer.hpp"
+
+#include "vast/factory.hpp"
+#include "vast/fbs/utils.hpp"
+#include "vast/type.hpp"
+#include "vast/value_index.hpp"
+#include "vast/value_index_factory.hpp"
+
+#include <caf/settings.hpp>
+
+namespace vast {
+
+// -- value_index_packer -------------------------------------------------------
+
+caf::expected<flatbuffers::Offset<fbs::ValueIndex>>
+value_index_packer::pack(flatbuffers::FlatBufferBuilder& builder,
+                         const value_index& x, bool with_header) {
+  // Packing the coders decodes all deferred bitmaps of a previously unpacked
+  // index, so afterwards the index no longer references its source buffer.
+  value_index_packer f{builder};
+  if (auto err = x.pack_impl(f))
+    return err;
+  auto mask = f.pack_bitmap(x.mask_);
+  if (!mask)
+    return mask.error();
+  auto none = f.pack_bitmap(x.none_);
+  if (!none)
+    return none.error();
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t>> header;
+  if (with_header) {
+    std::vector<char> buffer;
+    caf::binary_serializer sink{nullptr, buffer};
+    if (auto err = sink(x.type(), x.options()))
+      return err;
+    auto header_ptr = reinterpret_cast<const uint8_t*>(buffer.data());
+    header = builder.CreateVector(header_ptr, buffer.size());
+  }
+  auto coders = builder.CreateVector(f.coders_);
+  auto state_ptr = reinterpret_cast<const uint8_t*>(f.state_buffer_.data());
+  auto state = builder.CreateVector(state_ptr, f.state_buffer_.size());
+  auto children = builder.CreateVector(f.children_);
+  fbs::ValueIndexBuilder value_index_builder{builder};
+  value_index_builder.add_version(fbs::Version::v0);
+  if (with_header)
+    value_index_builder.add_header(header);
+  value_index_builder.add_mask(*mask);
+  value_index_builder.add_none(*none);
+  value_index_builder.add_coders(coders);
+  value_index_builder.add_state(state);
+  value_index_builder.add_children(children);
+  return value_index_builder.Finish();
+}
+
+value_index_packer::value_index_packer(flatbuffers::FlatBufferBuilder& builder)
+  : builder_{builder}, state_{nullptr, state_buffer_} {
+  // nop
+}
+
+caf::serializer& value_index_packer::state() {
+  return state_;
+}
+
+caf::error value_index_packer::apply_index(const value_index& x) {
+  auto child = pack(builder_, x, false);
+  if (!child)
+    return child.error();
+  children_.push_back(*child);
+  return caf::none;
+}
+
+flatbuffers::Offset<fbs::Bitmap>
+value_index_packer::finish_bitmap(const std::vector<char>& buffer) {
+  auto data_ptr = reinterpret_cast<const uint8_t*>(buffer.data());
+  auto data = builder_.CreateVector(data_ptr, buffer.size());
+  fbs::BitmapBuilder bitmap_builder{builder_};
+  bitmap_builder.add_data(data);
+  return bitmap_builder.Finish();
+}
+
+flatbuffers::Offset<fbs::Coder> value_index_packer::finish_coder(
+  uint64_t size, const std::vector<flatbuffers::Offset<fbs::Bitmap>>& bitmaps,
+  const std::vector<flatbuffers::Offset<fbs::Coder>>& components) {
+  auto bitmaps_offset = builder_.CreateVector(bitmaps);
+  auto components_offset = builder_.CreateVector(components);
+  fbs::CoderBuilder coder_builder{builder_};
+  coder_builder.add_size(size);
+  coder_builder.add_bitmaps(bitmaps_offset);
+  coder_builder.add_components(components_offset);
+  return coder_builder.Finish();
+}
+
+// -- value_index_unpacker -----------------------------------------------------
+
+caf::expected<value_index_ptr>
+value_index_unpacker::unpack(const fbs::ValueIndex& x, chunk_ptr chunk) {
+  if (x.header() == nullptr)
+    return make_error(ec::format_error, "missing value index header");
+  auto header_ptr = reinterpret_cast<const char*>(x.header()->data());
+  caf::binary_deserializer source{nullptr, header_ptr, x.header()->size()};
+  type t;
+  caf::settings opts;
+  if (auto err = source(t, opts))
+    return err;
+  auto result = factory<value_index>::make(std::move(t), std::move(opts));
+  if (result == nullptr)
+    return make_error(ec::unspecified, "failed to construct value index");
+  if (auto err = unpack(x, *result, std::move(chunk)))
+    return err;
+  return result;
+}
+
+caf::error value_index_unpacker::unpack(const fbs::ValueIndex& x,
+                                        value_index& y, chunk_ptr chunk) {
+  if (auto err = fbs::check_version(x.version(), fbs::Version::v0))
+    return err;
+  if (x.mask() == nullptr || x.none() == nullptr)
+    return make_error(ec::format_error, "missing value index mask");
+  // The mask takes part in every lookup, so we decode it right away.
+  if (auto err = unpack_bitmap(*x.mask(), y.mask_))
+    return err;
+  if (auto err = unpack_bitmap(*x.none(), y.none_))
+    return err;
+  value_index_unpacker f{x, std::move(chunk)};
+  y.decode_status_ = std::make_shared<detail::decode_status>();
+  f.status_ = y.decode_status_;
+  return y.unpack_impl(f);
+}
+
+value_index_unpacker::value_index_unpacker(const fbs::ValueIndex& x,
+                                           chunk_ptr chunk)
+  : index_{x},
+    chunk_{std::move(chunk)},
+    state_{nullptr,
+           x.state() ? reinterpret_cast<const char*>(x.state()->data())
+                     : nullptr,
+           x.state() ? x.state()->size() : 0} {
+  // nop
+}
+
+caf::deserializer& value_index_unpacker::state() {
+  return state_;
+}
+
+caf::error value_index_unpacker::apply_index(value_index& x) {
+  auto children = index_.children();
+  if (children == nullptr || next_child_ >= children->size())
+    return make_error(ec::format_error, "missing nested value index");
+  return unpack(*children->Get(next_child_++), x, chunk_);
+}
+
+caf::expected<const fbs::Coder*> value_index_unpacker::next_coder() {
+  auto coders = index_.coders();
+  if (coders == nullptr || next_coder_ >= coders->size())
+    return make_error(ec::format_error, "missing coder");
+  return coders->Get(next_coder_++);
+}
+
+} // namespace vast
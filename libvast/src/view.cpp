@@ -15,16 +15,17 @@
 
 #include "vast/detail/narrow.hpp"
 #include "vast/detail/overload.hpp"
+#include "vast/detail/regex_automaton.hpp"
 #include "vast/type.hpp"
 
 #include <algorithm>
-#include <regex>
 
 namespace vast {
 
 // -- pattern_view ------------------------------------------------------------
 
-pattern_view::pattern_view(const pattern& x) : pattern_{x.string()} {
+pattern_view::pattern_view(const pattern& x)
+  : pattern_{x.string()}, automaton_{x.automaton_.get()} {
   // nop
 }
 
@@ -37,13 +38,16 @@ std::string_view pattern_view::string() const {
 }
 
 bool pattern_view::match(std::string_view x) const {
-  return std::regex_match(x.begin(), x.end(),
-                          std::regex{pattern_.begin(), pattern_.end()});
+  // Views that do not originate from a pattern compile on every call.
+  if (automaton_)
+    return automaton_->match(x);
+  return detail::regex_automaton{pattern_}.match(x);
 }
 
 bool pattern_view::search(std::string_view x) const {
-  return std::regex_search(x.begin(), x.end(),
-                           std::regex{pattern_.begin(), pattern_.end()});
+  if (automaton_)
+    return automaton_->search(x);
+  return detail::regex_automaton{pattern_}.search(x);
 }
 
 bool operator==(pattern_view x, pattern_view y) noexcept {
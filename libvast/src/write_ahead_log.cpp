@@ -0,0 +1,238 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/write_ahead_log.hpp"
+
+#include "vast/concept/hashable/xxhash.hpp"
+#include "vast/concept/parseable/core.hpp"
+#include "vast/concept/parseable/numeric/integral.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/error.hpp"
+#include "vast/concept/printable/vast/filesystem.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/narrow.hpp"
+#include "vast/error.hpp"
+#include "vast/io/write.hpp"
+#include "vast/load.hpp"
+#include "vast/logger.hpp"
+#include "vast/save.hpp"
+#include "vast/span.hpp"
+#include "vast/table_slice.hpp"
+
+#include <caf/settings.hpp>
+#include <caf/streambuf.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace vast {
+
+namespace {
+
+uint64_t checksum(const char* data, size_t size) {
+  xxhash64 h;
+  h(data, size);
+  return static_cast<uint64_t>(h);
+}
+
+} // namespace
+
+caf::expected<write_ahead_log_ptr>
+write_ahead_log::make(path dir, size_t max_file_size) {
+  VAST_TRACE(VAST_ARG(dir), VAST_ARG(max_file_size));
+  VAST_ASSERT(max_file_size > 0);
+  if (!exists(dir))
+    if (auto res = mkdir(dir); !res)
+      return res.error();
+  auto result = write_ahead_log_ptr{
+    new write_ahead_log{std::move(dir), max_file_size}};
+  if (auto err = result->register_files())
+    return err;
+  return result;
+}
+
+write_ahead_log::write_ahead_log(path dir, size_t max_file_size)
+  : dir_{std::move(dir)}, max_file_size_{max_file_size} {
+  // nop
+}
+
+write_ahead_log::~write_ahead_log() {
+  if (auto err = sync())
+    VAST_ERROR(this, "failed to sync on shutdown:", err);
+}
+
+caf::expected<size_t> write_ahead_log::replay(const replay_function& f) {
+  size_t result = 0;
+  for (auto i = sealed_.begin(); i != sealed_.end();) {
+    auto& filename = i->second;
+    auto contents = load_contents(filename);
+    if (!contents)
+      return contents.error();
+    auto& buf = *contents;
+    size_t pos = 0;
+    while (pos < buf.size()) {
+      uint32_t size;
+      uint64_t digest;
+      if (buf.size() - pos < header_size)
+        break;
+      std::memcpy(&size, buf.data() + pos, sizeof(size));
+      std::memcpy(&digest, buf.data() + pos + sizeof(size), sizeof(digest));
+      if (buf.size() - pos - header_size < size)
+        break;
+      auto payload = buf.data() + pos + header_size;
+      if (checksum(payload, size) != digest)
+        break;
+      caf::arraybuf<char> source{payload, size};
+      table_slice_ptr slice;
+      if (auto err = load(nullptr, source, slice)) {
+        VAST_WARNING(this, "failed to deserialize record in", filename, ":",
+                     err);
+        break;
+      }
+      pos += header_size + size;
+      sealed_end_ = slice->offset() + slice->rows();
+      f(std::move(slice));
+      ++result;
+    }
+    if (pos == buf.size()) {
+      ++i;
+      continue;
+    }
+    // The remainder never made it to the device completely, so we cut it off
+    // to not trip over it again.
+    VAST_WARNING(this, "discards", buf.size() - pos,
+                 "bytes of a torn or corrupted record in", filename);
+    if (pos == 0) {
+      if (!rm(filename))
+        return make_error(ec::filesystem_error, "failed to remove", filename);
+      i = sealed_.erase(i);
+      continue;
+    }
+    auto tmp = filename + ".tmp";
+    auto prefix = as_bytes(span<const char>{buf.data(), pos});
+    if (auto err = io::write(tmp, prefix))
+      return err;
+    if (std::rename(tmp.str().c_str(), filename.str().c_str()) != 0)
+      return make_error(ec::filesystem_error, "failed to rename to", filename);
+    ++i;
+  }
+  VAST_VERBOSE(this, "replayed", result, "table slices from", dir_);
+  return result;
+}
+
+caf::error write_ahead_log::append(const table_slice_ptr& x) {
+  VAST_ASSERT(x != nullptr);
+  if (!active_.is_open()) {
+    active_ = file{dir_ / std::to_string(x->offset())};
+    if (auto res = active_.open(file::write_only, true); !res)
+      return std::move(res.error());
+    active_first_ = x->offset();
+    active_size_ = 0;
+  }
+  buffer_.clear();
+  buffer_.resize(header_size);
+  if (auto err = save(nullptr, buffer_, x))
+    return err;
+  auto size = detail::narrow_cast<uint32_t>(buffer_.size() - header_size);
+  auto digest = checksum(buffer_.data() + header_size, size);
+  std::memcpy(buffer_.data(), &size, sizeof(size));
+  std::memcpy(buffer_.data() + sizeof(size), &digest, sizeof(digest));
+  size_t written = 0;
+  dirty_ = true;
+  if (!active_.write(buffer_.data(), buffer_.size(), &written)
+      || written != buffer_.size()) {
+    // Never append behind a partial record.
+    auto err = make_error(ec::filesystem_error, "failed to append to",
+                          active_.path());
+    if (auto rotate_err = rotate())
+      VAST_ERROR(this, "failed to seal", active_.path(), ":", rotate_err);
+    return err;
+  }
+  active_size_ += written;
+  active_end_ = x->offset() + x->rows();
+  if (active_size_ >= max_file_size_)
+    return rotate();
+  return caf::none;
+}
+
+caf::error write_ahead_log::sync() {
+  if (!dirty_)
+    return caf::none;
+  if (!active_.sync())
+    return make_error(ec::filesystem_error, "failed to sync", active_.path());
+  dirty_ = false;
+  return caf::none;
+}
+
+caf::error write_ahead_log::rotate() {
+  if (!active_.is_open())
+    return caf::none;
+  auto err = sync();
+  if (!active_.close() && !err)
+    err = make_error(ec::filesystem_error, "failed to close", active_.path());
+  dirty_ = false;
+  VAST_DEBUG(this, "seals", active_.path(), "with", active_size_, "bytes");
+  sealed_.emplace_back(active_first_, active_.path());
+  sealed_end_ = active_end_;
+  active_first_ = invalid_id;
+  active_end_ = invalid_id;
+  active_size_ = 0;
+  return err;
+}
+
+caf::error write_ahead_log::truncate(id watermark) {
+  // A sealed file ends where its successor begins.
+  auto end_of = [&](size_t i) {
+    return i + 1 < sealed_.size() ? sealed_[i + 1].first : sealed_end_;
+  };
+  size_t n = 0;
+  while (n < sealed_.size() && end_of(n) != invalid_id
+         && end_of(n) <= watermark) {
+    VAST_DEBUG(this, "removes durable log file", sealed_[n].second);
+    if (!rm(sealed_[n].second)) {
+      sealed_.erase(sealed_.begin(), sealed_.begin() + n);
+      return make_error(ec::filesystem_error, "failed to remove",
+                        sealed_.front().second);
+    }
+    ++n;
+  }
+  sealed_.erase(sealed_.begin(), sealed_.begin() + n);
+  return caf::none;
+}
+
+void write_ahead_log::inspect_status(caf::settings& dict) const {
+  using caf::put;
+  put(dict, "path", dir_.str());
+  put(dict, "max-file-size", max_file_size_);
+  put(dict, "sealed-files", sealed_.size());
+  put(dict, "active-file-size", active_size_);
+}
+
+caf::error write_ahead_log::register_files() {
+  using parsers::u64;
+  for (auto filename : directory{dir_}) {
+    auto name = filename.basename().str();
+    id first = 0;
+    if (!filename.is_regular_file() || !u64(name, first)) {
+      VAST_DEBUG(this, "ignores unexpected file", filename);
+      continue;
+    }
+    sealed_.emplace_back(first, std::move(filename));
+  }
+  std::sort(sealed_.begin(), sealed_.end());
+  return caf::none;
+}
+
+} // namespace vast
@@ -19,20 +19,29 @@
 #include <caf/actor_system_config.hpp>
 
 #include <vast/address.hpp>
+#include <vast/caf_table_slice.hpp>
 #include <vast/concept/hashable/hash_append.hpp>
 #include <vast/concept/hashable/xxhash.hpp>
 #include <vast/concept/parseable/to.hpp>
 #include <vast/concept/parseable/vast/address.hpp>
+#include <vast/config.hpp>
 #include <vast/load.hpp>
+#include <vast/msgpack_table_slice.hpp>
 #include <vast/save.hpp>
 #include <vast/si_literals.hpp>
 #include <vast/synopsis.hpp>
 #include <vast/synopsis_factory.hpp>
+#include <vast/table_slice_builder_factory.hpp>
+#include <vast/table_slice_column.hpp>
 #include <vast/test/fixtures/actor_system.hpp>
 #include <vast/test/synopsis.hpp>
 #include <vast/test/test.hpp>
 #include <vast/type.hpp>
 
+#if VAST_HAVE_ARROW
+#  include <vast/arrow_table_slice.hpp>
+#endif
+
 using namespace std::string_literals;
 using namespace caf;
 using namespace vast;
@@ -88,4 +97,40 @@ TEST(construction based on partition size) {
   CHECK_ROUNDTRIP_DEREF(ptr);
 }
 
+TEST(column ingestion) {
+  factory<table_slice_builder>::initialize();
+  auto t = address_type{}.attributes({{"synopsis", "bloomfilter(100,0.1)"}});
+  auto layout = record_type{{"addr", t}}.name("test");
+  std::vector<caf::atom_value> impls{caf_table_slice::class_id,
+                                     msgpack_table_slice::class_id};
+#if VAST_HAVE_ARROW
+  impls.push_back(arrow_table_slice::class_id);
+#endif
+  auto addrs = std::vector{unbox(to<address>("10.0.0.1")),
+                           unbox(to<address>("192.168.0.1")),
+                           unbox(to<address>("::1"))};
+  for (auto impl : impls) {
+    MESSAGE("ingest the address column of a " << to_string(impl) << " slice");
+    auto builder = factory<table_slice_builder>::make(impl, layout);
+    REQUIRE_NOT_EQUAL(builder, nullptr);
+    CHECK(builder->add(make_data_view(addrs[0])));
+    CHECK(builder->add(make_data_view(caf::none)));
+    CHECK(builder->add(make_data_view(addrs[1])));
+    CHECK(builder->add(make_data_view(addrs[2])));
+    auto slice = builder->finish();
+    REQUIRE_NOT_EQUAL(slice, nullptr);
+    auto expected = factory<synopsis>::make(t, opts);
+    auto x = factory<synopsis>::make(t, opts);
+    REQUIRE_NOT_EQUAL(expected, nullptr);
+    REQUIRE_NOT_EQUAL(x, nullptr);
+    for (auto& addr : addrs)
+      expected->add(make_data_view(addr));
+    x->add(table_slice_column{slice, 0});
+    CHECK(*x == *expected);
+    for (auto& addr : addrs)
+      CHECK_EQUAL(x->lookup(equal, make_data_view(addr)),
+                  caf::optional<bool>{true});
+  }
+}
+
 FIXTURE_SCOPE_END()
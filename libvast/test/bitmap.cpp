@@ -15,12 +15,20 @@
 #include "vast/ewah_bitmap.hpp"
 #include "vast/ids.hpp"
 #include "vast/null_bitmap.hpp"
+#include "vast/roaring_bitmap.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/bitmap.hpp"
+#include "vast/detail/block_kernels.hpp"
 
 #define SUITE bitmap
 #include "vast/test/test.hpp"
 
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include <chrono>
+#include <random>
+
 using namespace vast;
 using namespace std::string_literals;
 
@@ -174,6 +182,14 @@ struct bitmap_test_harness {
     auto begin = bitmaps.begin();
     auto end = bitmaps.end();
     CHECK_EQUAL(nary_and(begin, end), x & y & z0 & z1);
+    MESSAGE("nary OR");
+    CHECK_EQUAL(to_string(nary_or(begin, end)), to_string(x | y | z0 | z1));
+    MESSAGE("nary AND/OR over bitmap pointers");
+    auto ptrs = std::vector<const Bitmap*>{&x, &y, &z0};
+    CHECK_EQUAL(to_string(nary_and(ptrs.begin(), ptrs.end())),
+                to_string(x & y & z0));
+    CHECK_EQUAL(to_string(nary_or(ptrs.begin(), ptrs.end())),
+                to_string(x | y | z0));
   }
 
   void test_rank() {
@@ -476,6 +492,14 @@ TEST(wah_bitmap) {
 
 FIXTURE_SCOPE_END()
 
+FIXTURE_SCOPE(roaring_bitmap_tests, bitmap_test_harness<roaring_bitmap>)
+
+TEST(roaring_bitmap) {
+  execute();
+}
+
+FIXTURE_SCOPE_END()
+
 FIXTURE_SCOPE(bitmap_tests, bitmap_test_harness<bitmap>)
 
 TEST(bitmap) {
@@ -912,3 +936,202 @@ TEST(EWAH RLE print 2) {
   //CHECK_EQUAL(str, "1F1T421F2T");
   CHECK_EQUAL(str, "1F1T62F320F39F2T");
 }
+
+TEST(Roaring containers) {
+  using kind = roaring_bitmap::container_kind;
+  auto chunk = roaring_bitmap::container_bits;
+  roaring_bitmap bm;
+  MESSAGE("sparse bits form an array container");
+  for (auto i = 0; i < 100; ++i) {
+    bm.append_bits(false, 99);
+    bm.append_bit(true);
+  }
+  REQUIRE_EQUAL(bm.containers().size(), 1u);
+  CHECK(bm.containers()[0].kind == kind::array);
+  CHECK(bm[99]);
+  CHECK(!bm[100]);
+  CHECK(bm[9999]);
+  MESSAGE("a long run forms a run container");
+  bm.append_bits(false, chunk - bm.size());
+  bm.append_bits(true, 50000);
+  REQUIRE_EQUAL(bm.containers().size(), 2u);
+  CHECK(bm.containers()[1].kind == kind::run);
+  CHECK(!bm[chunk - 1]);
+  CHECK(bm[chunk]);
+  CHECK(bm[chunk + 49999]);
+  MESSAGE("dense random bits form a bitset container");
+  bm.append_bits(false, 2 * chunk - bm.size());
+  std::mt19937_64 gen{42};
+  std::bernoulli_distribution coin{0.5};
+  auto ones = size_t{0};
+  for (size_t i = 0; i < chunk; ++i) {
+    auto bit = coin(gen);
+    ones += bit;
+    bm.append_bit(bit);
+  }
+  REQUIRE_EQUAL(bm.containers().size(), 3u);
+  CHECK(bm.containers()[2].kind == kind::bitset);
+  CHECK_EQUAL(rank(bm), 100 + 50000 + ones);
+  CHECK_EQUAL(rank(bm, 2 * chunk - 1), 100u + 50000u);
+  MESSAGE("long runs of 0-bits cost nothing");
+  bm.append_bits(false, 1ull << 40);
+  bm.append_bit(true);
+  CHECK_EQUAL(bm.containers().size(), 4u);
+  CHECK(bm[bm.size() - 1]);
+  CHECK_EQUAL(rank(bm), 100 + 50000 + ones + 1);
+  auto n = size_t{0};
+  for (auto bits : bit_range(bm))
+    n += bits.size();
+  CHECK_EQUAL(n, bm.size());
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  caf::binary_serializer sink{nullptr, buf};
+  CHECK_EQUAL(sink(bm), caf::none);
+  roaring_bitmap copy;
+  caf::binary_deserializer source{nullptr, buf};
+  CHECK_EQUAL(source(copy), caf::none);
+  CHECK(copy == bm);
+}
+
+TEST(Roaring type-erased operations) {
+  roaring_bitmap x;
+  x.append_bits(false, 10);
+  x.append_bits(true, 100);
+  x.append_bit(false);
+  x.append_bit(true);
+  roaring_bitmap y;
+  y.append_block(0xf0f0f0f0f0f0f0f0);
+  y.append_bits(true, 10);
+  auto expected = to_string(x & y);
+  ids lhs = x;
+  ids rhs = y;
+  auto result = lhs & rhs;
+  CHECK(caf::holds_alternative<roaring_bitmap>(result));
+  CHECK_EQUAL(to_string(result), expected);
+  CHECK_EQUAL(rank(result), rank(x & y));
+  lhs |= rhs;
+  CHECK(caf::holds_alternative<roaring_bitmap>(lhs));
+  CHECK_EQUAL(to_string(lhs), to_string(x | y));
+  lhs -= ids{roaring_bitmap{64, true}};
+  CHECK_EQUAL(to_string(lhs), to_string((x | y) - roaring_bitmap{64, true}));
+}
+
+namespace {
+
+/// Generates a random bitmap where every bit is 1 with probability *p*,
+/// resembling the result of a hash or string index lookup.
+template <class Bitmap>
+Bitmap make_random_bitmap(size_t n, double p, std::mt19937_64& gen) {
+  std::bernoulli_distribution coin{p};
+  Bitmap result;
+  for (size_t i = 0; i < n; ++i)
+    result.append_bit(coin(gen));
+  return result;
+}
+
+/// Generates a bitmap of runs of 1-bits with random lengths and gaps,
+/// resembling the result of a time range lookup.
+template <class Bitmap>
+Bitmap make_clustered_bitmap(size_t n, std::mt19937_64& gen) {
+  std::geometric_distribution<size_t> length{0.001};
+  Bitmap result;
+  auto bit = false;
+  while (result.size() < n) {
+    result.append_bits(bit, std::min(length(gen) + 1, n - result.size()));
+    bit = !bit;
+  }
+  return result;
+}
+
+template <class Bitmap>
+std::vector<Bitmap> make_query_results(size_t n) {
+  std::mt19937_64 gen{42};
+  return {
+    make_random_bitmap<Bitmap>(n, 0.001, gen),
+    make_random_bitmap<Bitmap>(n, 0.05, gen),
+    make_random_bitmap<Bitmap>(n, 0.3, gen),
+    make_clustered_bitmap<Bitmap>(n, gen),
+  };
+}
+
+template <class F>
+auto measure(F f) {
+  auto start = std::chrono::steady_clock::now();
+  auto result = f();
+  auto stop = std::chrono::steady_clock::now();
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+  return std::make_pair(std::move(result), us.count());
+}
+
+} // namespace <anonymous>
+
+// Compares EWAH and Roaring bitmaps on sets that resemble typical query
+// results, and verifies that both produce the same results along the way.
+TEST(Roaring vs EWAH comparison) {
+  constexpr size_t n = 1 << 20;
+  auto ewahs = make_query_results<ewah_bitmap>(n);
+  auto roarings = make_query_results<roaring_bitmap>(n);
+  const char* names[] = {"sparse", "medium", "dense", "clustered"};
+  for (size_t i = 0; i < ewahs.size(); ++i) {
+    for (size_t j = i; j < ewahs.size(); ++j) {
+      auto pair = std::string{names[i]} + " x " + names[j];
+      auto [ewah_and, ewah_and_us]
+        = measure([&] { return ewahs[i] & ewahs[j]; });
+      auto [roaring_and, roaring_and_us]
+        = measure([&] { return roarings[i] & roarings[j]; });
+      MESSAGE(pair << " AND: EWAH " << ewah_and_us << "us, Roaring "
+                   << roaring_and_us << "us");
+      CHECK_EQUAL(to_string(roaring_and), to_string(ewah_and));
+      auto [ewah_or, ewah_or_us]
+        = measure([&] { return ewahs[i] | ewahs[j]; });
+      auto [roaring_or, roaring_or_us]
+        = measure([&] { return roarings[i] | roarings[j]; });
+      MESSAGE(pair << " OR: EWAH " << ewah_or_us << "us, Roaring "
+                   << roaring_or_us << "us");
+      CHECK_EQUAL(to_string(roaring_or), to_string(ewah_or));
+    }
+    auto [ewah_rank, ewah_rank_us] = measure([&] { return rank(ewahs[i]); });
+    auto [roaring_rank, roaring_rank_us]
+      = measure([&] { return rank(roarings[i]); });
+    MESSAGE(names[i] << " rank: EWAH " << ewah_rank_us << "us, Roaring "
+                     << roaring_rank_us << "us");
+    CHECK_EQUAL(roaring_rank, ewah_rank);
+  }
+}
+
+// The specialized EWAH algorithms must produce the same encoding as the
+// generic block-wise algorithms, no matter which block kernels are active.
+TEST(EWAH block kernels) {
+  using detail::block_kernel_isa;
+  auto xs = make_query_results<ewah_bitmap>(100'000);
+  // Operands of different sizes exercise the padding of the shorter one.
+  for (auto& x : make_query_results<ewah_bitmap>(77'777))
+    xs.push_back(std::move(x));
+  auto and_op = [](auto x, auto y) { return x & y; };
+  auto or_op = [](auto x, auto y) { return x | y; };
+  auto xor_op = [](auto x, auto y) { return x ^ y; };
+  auto nand_op = [](auto x, auto y) { return x & ~y; };
+  auto original = detail::active_block_kernels();
+  for (auto isa : {block_kernel_isa::scalar, block_kernel_isa::sse42,
+                   block_kernel_isa::avx2}) {
+    if (!detail::select_block_kernels(isa))
+      continue;
+    MESSAGE("checking " << detail::to_string(isa) << " kernels");
+    for (auto& x : xs) {
+      for (auto& y : xs) {
+        CHECK_EQUAL(binary_and(x, y),
+                    (binary_eval<false, false>(x, y, and_op)));
+        CHECK_EQUAL(binary_or(x, y), (binary_eval<true, true>(x, y, or_op)));
+        CHECK_EQUAL(binary_xor(x, y), (binary_eval<true, true>(x, y, xor_op)));
+        CHECK_EQUAL(binary_nand(x, y),
+                    (binary_eval<true, false>(x, y, nand_op)));
+      }
+      auto expected = ewah_bitmap::size_type{0};
+      for (auto bits : bit_range(x))
+        expected += rank<1>(bits);
+      CHECK_EQUAL(rank<1>(x), expected);
+      CHECK_EQUAL(rank<0>(x), x.size() - expected);
+    }
+  }
+  detail::select_block_kernels(original);
+}
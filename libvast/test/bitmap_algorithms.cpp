@@ -33,3 +33,29 @@ TEST(is not subset) {
   CHECK(!is_subset(make_ids({{11, 21}}), make_ids({{10, 20}})));
   CHECK(!is_subset(make_ids({5, 15, 25}), make_ids({{10, 20}})));
 }
+
+TEST(nary merge) {
+  // Operands of different sizes, with runs and literal blocks that overlap
+  // in various ways.
+  auto xs = std::vector<ids>{
+    make_ids({{10, 20}, {100, 200}, 1000}, 2000),
+    make_ids({{15, 150}, 999, 1000, 1001}),
+    make_ids({5, 7, 11, 13, {17, 500}}, 1500),
+    make_ids({{0, 3000}}),
+    ids{},
+  };
+  auto fold = [&](auto op, size_t n) {
+    auto result = xs[0];
+    for (size_t i = 1; i < n; ++i)
+      result = op(result, xs[i]);
+    return result;
+  };
+  auto and_op = [](const ids& x, const ids& y) { return x & y; };
+  auto or_op = [](const ids& x, const ids& y) { return x | y; };
+  for (size_t n = 1; n <= xs.size(); ++n) {
+    MESSAGE("merging " << n << " operands");
+    auto first = xs.begin();
+    CHECK_EQUAL(nary_and(first, first + n), fold(and_op, n));
+    CHECK_EQUAL(nary_or(first, first + n), fold(or_op, n));
+  }
+}
@@ -114,3 +114,67 @@ TEST(MRU cache insertion) {
 }
 
 FIXTURE_SCOPE_END()
+
+namespace {
+
+struct string_size {
+  size_t operator()(const std::string& x) const noexcept {
+    return x.size();
+  }
+};
+
+struct two_queue_fixture {
+  two_queue_fixture() {
+    for (auto key : {1, 2, 3, 4})
+      CHECK(xs.emplace(key, std::string(10, 'x')).second);
+  }
+
+  detail::two_queue_cache<int, std::string, string_size> xs{40};
+};
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(two_queue_cache_tests, two_queue_fixture)
+
+TEST(2Q cache weight) {
+  CHECK_EQUAL(xs.size(), 4u);
+  CHECK_EQUAL(xs.weight(), 40u);
+  CHECK(xs.emplace(5, std::string(20, 'x')).second);
+  CHECK_EQUAL(xs.size(), 3u);
+  CHECK_EQUAL(xs.weight(), 40u);
+  CHECK_EQUAL(xs.count(1), 0u);
+  CHECK_EQUAL(xs.count(2), 0u);
+  CHECK_EQUAL(xs.stats().evictions, 2u);
+  // A single element may exceed the capacity on its own.
+  CHECK(xs.emplace(6, std::string(100, 'x')).second);
+  CHECK_EQUAL(xs.size(), 1u);
+  CHECK_EQUAL(xs.count(6), 1u);
+}
+
+TEST(2Q cache scan resistance) {
+  // Evicting 1 leaves a ghost behind, so that re-adding 1 marks it as
+  // frequently used.
+  CHECK(xs.emplace(5, std::string(10, 'x')).second);
+  CHECK_EQUAL(xs.count(1), 0u);
+  CHECK(xs.emplace(1, std::string(10, 'x')).second);
+  for (auto key = 100; key < 200; ++key)
+    xs.emplace(key, std::string(5, 'x'));
+  CHECK(xs.find(1) != xs.end());
+  CHECK(xs.find(2) == xs.end());
+  CHECK_EQUAL(xs.stats().hits, 1u);
+  CHECK_EQUAL(xs.stats().misses, 1u);
+  CHECK(xs.weight() <= xs.capacity());
+}
+
+TEST(2Q cache erasure) {
+  CHECK_EQUAL(xs.erase(3), 1u);
+  CHECK_EQUAL(xs.erase(3), 0u);
+  xs.erase(xs.begin());
+  CHECK_EQUAL(xs.size(), 2u);
+  CHECK_EQUAL(xs.weight(), 20u);
+  xs.clear();
+  CHECK(xs.empty());
+  CHECK_EQUAL(xs.weight(), 0u);
+}
+
+FIXTURE_SCOPE_END()
@@ -24,6 +24,7 @@
 #include "vast/detail/order.hpp"
 #include "vast/load.hpp"
 #include "vast/null_bitmap.hpp"
+#include "vast/roaring_bitmap.hpp"
 #include "vast/save.hpp"
 
 using namespace vast;
@@ -341,6 +342,32 @@ TEST(bitslice-coder 2) {
   CHECK_DECODE(greater_equal, 128, "000000001");
 }
 
+TEST(coders with roaring bitmaps) {
+  equality_coder<null_bitmap> e1{64};
+  equality_coder<roaring_bitmap> e2{64};
+  range_coder<null_bitmap> r1{64};
+  range_coder<roaring_bitmap> r2{64};
+  bitslice_coder<null_bitmap> b1{6};
+  bitslice_coder<roaring_bitmap> b2{6};
+  for (size_t i = 0; i < 1000; ++i) {
+    auto x = (i * 7919) % 64;
+    fill(e1, x);
+    fill(e2, x);
+    fill(r1, x);
+    fill(r2, x);
+    fill(b1, x);
+    fill(b2, x);
+  }
+  auto ops = {less, less_equal, equal, not_equal, greater, greater_equal};
+  for (size_t x = 0; x < 64; ++x) {
+    for (auto op : ops) {
+      CHECK_EQUAL(to_string(e2.decode(op, x)), to_string(e1.decode(op, x)));
+      CHECK_EQUAL(to_string(r2.decode(op, x)), to_string(r1.decode(op, x)));
+    }
+    CHECK_EQUAL(to_string(b2.decode(equal, x)), to_string(b1.decode(equal, x)));
+  }
+}
+
 TEST(uniform bases) {
   auto u = base::uniform(42, 10);
   auto is42 = [](auto x) { return x == 42; };
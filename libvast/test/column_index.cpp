@@ -18,9 +18,11 @@
 #include "vast/test/fixtures/actor_system_and_events.hpp"
 #include "vast/test/test.hpp"
 
+#include "vast/bitmap_algorithms.hpp"
 #include "vast/caf_table_slice.hpp"
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/filesystem.hpp"
 #include "vast/table_slice_builder.hpp"
 #include "vast/table_slice_column.hpp"
 #include "vast/type.hpp"
@@ -87,6 +89,60 @@ TEST(integer values) {
   CHECK_EQUAL(lookup(col, is4), make_ids({}, slice_size));
 }
 
+TEST(statistics persistence) {
+  integer_type column_type;
+  record_type layout{{"value", column_type}};
+  auto col
+    = unbox(make_column_index(sys, directory, column_type, caf::settings{}));
+  auto rows = make_rows(1, 2, 3, 1, 2, 3, 1, 1, 1);
+  auto slice = caf_table_slice::make(layout, rows);
+  col->add(table_slice_column{slice, 0});
+  auto verify = [&] {
+    auto& stats = col->statistics();
+    CHECK_EQUAL(stats.count(), rows.size());
+    CHECK_EQUAL(stats.nulls(), 0u);
+    CHECK_EQUAL(stats.distinct(), 3u);
+    CHECK_EQUAL(stats.min(), data{integer{1}});
+    CHECK_EQUAL(stats.max(), data{integer{3}});
+    auto hitters = stats.heavy_hitters();
+    REQUIRE(!hitters.empty());
+    CHECK_EQUAL(hitters[0].value, data{integer{1}});
+    auto is1 = curried(unbox(to<predicate>(":int == +1")));
+    auto x = unbox(col->selectivity(is1.op, make_view(is1.rhs)));
+    CHECK_GREATER(x, 0.5);
+  };
+  MESSAGE("verify statistics");
+  verify();
+  MESSAGE("persist and reload from disk");
+  REQUIRE_EQUAL(col->flush_to_disk(), caf::none);
+  CHECK(exists(col->statistics_filename()));
+  col.reset();
+  col = unbox(make_column_index(sys, directory, column_type, caf::settings{}));
+  MESSAGE("verify statistics again");
+  verify();
+}
+
+TEST(statistics with nulls) {
+  integer_type column_type;
+  record_type layout{{"value", column_type}};
+  auto col
+    = unbox(make_column_index(sys, directory, column_type, caf::settings{}));
+  auto rows = make_rows(1, caf::none, 2, caf::none, caf::none);
+  auto slice = caf_table_slice::make(layout, rows);
+  col->add(table_slice_column{slice, 0});
+  auto& stats = col->statistics();
+  CHECK_EQUAL(stats.count(), rows.size());
+  CHECK_EQUAL(stats.nulls(), 3u);
+  CHECK_EQUAL(stats.distinct(), 2u);
+  auto x = unbox(col->selectivity(relational_operator::equal,
+                                  make_data_view(caf::none)));
+  CHECK_EQUAL(x, 0.6);
+  MESSAGE("nulls also reach the value index");
+  auto is_nil = unbox(col->lookup(relational_operator::equal,
+                                  make_data_view(caf::none)));
+  CHECK_EQUAL(rank(is_nil), 3u);
+}
+
 TEST(zeek conn log) {
   MESSAGE("ingest originators from zeek conn log");
   auto row_type = zeek_conn_log_layout();
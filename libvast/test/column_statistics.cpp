@@ -0,0 +1,127 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE column_statistics
+
+#include "vast/column_statistics.hpp"
+
+#include "vast/test/test.hpp"
+
+#include "vast/concept/printable/stream.hpp"
+#include "vast/concept/printable/vast/data.hpp"
+#include "vast/load.hpp"
+#include "vast/save.hpp"
+
+#include <string>
+
+using namespace vast;
+
+namespace {
+
+column_statistics make_integers(integer first, integer last, size_t nils) {
+  column_statistics result;
+  for (auto i = first; i <= last; ++i)
+    result.add(make_data_view(i));
+  for (size_t i = 0; i < nils; ++i)
+    result.add(make_data_view(caf::none));
+  return result;
+}
+
+} // namespace
+
+TEST(counts and range) {
+  auto stats = make_integers(1, 100, 10);
+  CHECK_EQUAL(stats.count(), 110u);
+  CHECK_EQUAL(stats.nulls(), 10u);
+  CHECK_EQUAL(stats.min(), data{integer{1}});
+  CHECK_EQUAL(stats.max(), data{integer{100}});
+  CHECK_GREATER_EQUAL(stats.distinct(), 95u);
+  CHECK_LESS_EQUAL(stats.distinct(), 100u);
+}
+
+TEST(heavy hitters) {
+  column_statistics stats{2};
+  for (auto i = 0; i < 50; ++i) {
+    stats.add(make_data_view("foo"));
+    if (i < 30)
+      stats.add(make_data_view("bar"));
+    if (i < 20)
+      stats.add(make_data_view("x" + std::to_string(i)));
+  }
+  auto xs = stats.heavy_hitters();
+  REQUIRE_EQUAL(xs.size(), 2u);
+  CHECK_EQUAL(xs[0].value, data{"foo"});
+  CHECK_EQUAL(xs[1].value, data{"bar"});
+  // The counts are lower bounds that deviate by at most n / (k + 1).
+  CHECK_LESS_EQUAL(xs[0].count, 50u);
+  CHECK_GREATER_EQUAL(xs[0].count, 50u - 100u / 3);
+  auto frequent = unbox(stats.selectivity(equal, make_data_view("foo")));
+  auto rare = unbox(stats.selectivity(equal, make_data_view("x1")));
+  CHECK_GREATER(frequent, rare);
+}
+
+TEST(selectivity) {
+  auto stats = make_integers(1, 100, 10);
+  auto x = unbox(stats.selectivity(less, make_data_view(integer{51})));
+  CHECK_GREATER(x, 0.4);
+  CHECK_LESS(x, 0.5);
+  x = unbox(stats.selectivity(greater_equal, make_data_view(integer{51})));
+  CHECK_GREATER(x, 0.4);
+  CHECK_LESS(x, 0.5);
+  x = unbox(stats.selectivity(equal, make_data_view(integer{200})));
+  CHECK_EQUAL(x, 0.0);
+  x = unbox(stats.selectivity(not_equal, make_data_view(integer{200})));
+  CHECK_EQUAL(x, 1.0);
+  x = unbox(stats.selectivity(equal, make_data_view(caf::none)));
+  CHECK_EQUAL(x, 10.0 / 110);
+  CHECK(!stats.selectivity(match, make_data_view("foo")));
+  CHECK(!column_statistics{}.selectivity(equal, make_data_view(integer{1})));
+}
+
+TEST(merge) {
+  auto stats = make_integers(1, 50, 0);
+  stats.merge(make_integers(51, 100, 10));
+  CHECK_EQUAL(stats.count(), 110u);
+  CHECK_EQUAL(stats.nulls(), 10u);
+  CHECK_EQUAL(stats.min(), data{integer{1}});
+  CHECK_EQUAL(stats.max(), data{integer{100}});
+  CHECK_GREATER_EQUAL(stats.distinct(), 95u);
+  CHECK_LESS_EQUAL(stats.distinct(), 100u);
+}
+
+TEST(serialization) {
+  auto stats = make_integers(1, 100, 10);
+  for (auto i = 0; i < 20; ++i)
+    stats.add(make_data_view(integer{42}));
+  std::string buf;
+  REQUIRE_EQUAL(save(nullptr, buf, stats), caf::none);
+  column_statistics copy;
+  REQUIRE_EQUAL(load(nullptr, buf, copy), caf::none);
+  CHECK_EQUAL(copy.count(), stats.count());
+  CHECK_EQUAL(copy.nulls(), stats.nulls());
+  CHECK_EQUAL(copy.distinct(), stats.distinct());
+  CHECK_EQUAL(copy.min(), stats.min());
+  CHECK_EQUAL(copy.max(), stats.max());
+  auto xs = stats.heavy_hitters();
+  auto ys = copy.heavy_hitters();
+  REQUIRE_EQUAL(ys.size(), xs.size());
+  REQUIRE(!ys.empty());
+  CHECK_EQUAL(ys[0].value, data{integer{42}});
+  for (size_t i = 0; i < xs.size(); ++i) {
+    CHECK_EQUAL(ys[i].value, xs[i].value);
+    CHECK_EQUAL(ys[i].count, xs[i].count);
+  }
+  auto x = unbox(stats.selectivity(equal, make_data_view(integer{42})));
+  auto y = unbox(copy.selectivity(equal, make_data_view(integer{42})));
+  CHECK_EQUAL(x, y);
+}
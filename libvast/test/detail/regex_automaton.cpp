@@ -0,0 +1,120 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE regex_automaton
+
+#include "vast/detail/regex_automaton.hpp"
+
+#include "vast/test/test.hpp"
+
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace vast;
+using detail::regex_automaton;
+
+namespace {
+
+const std::vector<std::string> patterns = {
+  "",
+  "foo",
+  "f.o",
+  "[a-c]+x?",
+  "[^a-c]*",
+  "[\\d.]+",
+  "\\w+@\\w+\\.com",
+  "\\s*\\S+\\s*",
+  "^foo|bar$",
+  "(foo|bar)*baz",
+  "(?:ab){2,3}",
+  "a{2,}b{0,1}",
+  "(a*)*b",
+  "\\x41\\.\\?",
+  "https?://[a-z.]+/.*",
+};
+
+const std::vector<std::string> inputs = {
+  "",
+  "foo",
+  "fxo",
+  "abcx",
+  "dd",
+  "1.2.3",
+  "alice@example.com",
+  "  word  ",
+  "foobar",
+  "bar",
+  "foobarbaz",
+  "ababab",
+  "aaab",
+  "A.?",
+  "http://vast.io/docs",
+  "https://vast.io\n",
+};
+
+} // namespace
+
+TEST(agreement with std::regex) {
+  for (auto& pattern : patterns) {
+    auto rx = std::regex{pattern};
+    auto automaton = regex_automaton{pattern};
+    CHECK(automaton.native());
+    for (auto& input : inputs) {
+      CHECK_EQUAL(automaton.match(input), std::regex_match(input, rx));
+      CHECK_EQUAL(automaton.search(input), std::regex_search(input, rx));
+    }
+  }
+}
+
+TEST(literal prefix) {
+  CHECK_EQUAL(regex_automaton{"https?://.*"}.literal_prefix(), "http");
+  CHECK_EQUAL(regex_automaton{"\\.php$"}.literal_prefix(), ".php");
+  CHECK_EQUAL(regex_automaton{"foo|bar"}.literal_prefix(), "");
+  CHECK(!regex_automaton{"https://.*"}.match("http://vast.io"));
+  CHECK(regex_automaton{"\\.php"}.search("/index.php?q=1"));
+}
+
+TEST(fallback) {
+  MESSAGE("back references");
+  auto backref = regex_automaton{"(a+)b\\1"};
+  CHECK(!backref.native());
+  CHECK(backref.match("aabaa"));
+  CHECK(!backref.match("aaba"));
+  MESSAGE("word boundaries");
+  auto boundary = regex_automaton{"\\bfoo\\b"};
+  CHECK(!boundary.native());
+  CHECK(boundary.search("a foo b"));
+  CHECK(!boundary.search("afoob"));
+  MESSAGE("invalid patterns");
+  auto invalid = regex_automaton{"(foo"};
+  CHECK(!invalid.native());
+  auto threw = false;
+  try {
+    invalid.match("foo");
+  } catch (const std::regex_error&) {
+    threw = true;
+  }
+  CHECK(threw);
+}
+
+TEST(bounded state cache) {
+  // The DFA for this pattern has exponentially many states.
+  auto automaton = regex_automaton{"[ab]*a[ab]{12}"};
+  std::string input;
+  for (size_t i = 0; i < 100'000; ++i)
+    input += (i * 7919) % 3 == 0 ? 'a' : 'b';
+  CHECK_EQUAL(automaton.match(input), input[input.size() - 13] == 'a');
+  CHECK_LESS_EQUAL(automaton.dfa_states(),
+                   2 * regex_automaton::max_dfa_states);
+}
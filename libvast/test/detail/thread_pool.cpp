@@ -0,0 +1,65 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE thread_pool
+
+#include "vast/detail/thread_pool.hpp"
+
+#include "vast/test/test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace vast;
+using detail::thread_pool;
+
+TEST(inline execution) {
+  thread_pool pool{0};
+  CHECK_EQUAL(pool.size(), 0u);
+  auto caller = std::this_thread::get_id();
+  auto f = pool.submit([] { return std::this_thread::get_id(); });
+  CHECK(f.wait_for(std::chrono::seconds{0}) == std::future_status::ready);
+  CHECK(f.get() == caller);
+}
+
+TEST(concurrent execution) {
+  thread_pool pool{4};
+  CHECK_EQUAL(pool.size(), 4u);
+  std::atomic<int> counter = 0;
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i)
+    results.push_back(pool.submit([&counter, i] {
+      ++counter;
+      return i;
+    }));
+  auto sum = 0;
+  for (auto& f : results)
+    sum += f.get();
+  CHECK_EQUAL(counter.load(), 100);
+  CHECK_EQUAL(sum, 4950);
+}
+
+TEST(exceptions propagate through futures) {
+  thread_pool pool{1};
+  auto f = pool.submit([]() -> int { throw std::runtime_error{"boom"}; });
+  auto caught = false;
+  try {
+    f.get();
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  CHECK(caught);
+}
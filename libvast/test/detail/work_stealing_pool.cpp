@@ -0,0 +1,69 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE work_stealing_pool
+
+#include "vast/detail/work_stealing_pool.hpp"
+
+#include "vast/test/test.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace vast;
+using detail::work_stealing_pool;
+
+TEST(concurrent execution) {
+  std::atomic<int> counter = 0;
+  std::atomic<int> sum = 0;
+  {
+    work_stealing_pool pool{4};
+    CHECK_EQUAL(pool.size(), 4u);
+    for (int i = 0; i < 100; ++i)
+      pool.submit([&counter, &sum, i] {
+        ++counter;
+        sum += i;
+      });
+  }
+  CHECK_EQUAL(counter.load(), 100);
+  CHECK_EQUAL(sum.load(), 4950);
+}
+
+TEST(nested submission) {
+  std::atomic<int> counter = 0;
+  {
+    work_stealing_pool pool{2};
+    for (int i = 0; i < 10; ++i)
+      pool.submit([&] {
+        for (int j = 0; j < 10; ++j)
+          pool.submit([&] { ++counter; });
+      });
+  }
+  CHECK_EQUAL(counter.load(), 100);
+}
+
+TEST(idle threads steal work) {
+  std::atomic<int> counter = 0;
+  work_stealing_pool pool{2};
+  // All jobs go to the queue of the thread that runs the first job, which
+  // blocks until the other thread stole and ran all of them.
+  pool.submit([&] {
+    for (int i = 0; i < 10; ++i)
+      pool.submit([&] { ++counter; });
+    while (counter < 10)
+      std::this_thread::yield();
+  });
+  while (counter < 10)
+    std::this_thread::yield();
+  CHECK_GREATER_EQUAL(pool.steals(), 10u);
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE dictionary_index
+
+#include "vast/dictionary_index.hpp"
+
+#include "vast/test/test.hpp"
+
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/bitmap.hpp"
+#include "vast/load.hpp"
+#include "vast/save.hpp"
+#include "vast/value_index_factory.hpp"
+
+#include <caf/test/dsl.hpp>
+
+using namespace vast;
+using namespace std::string_literals;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    REQUIRE(idx.append(make_data_view("http://foo.com/a")));
+    REQUIRE(idx.append(make_data_view("http://bar.org")));
+    REQUIRE(idx.append(make_data_view("https://foo.com/b")));
+    REQUIRE(idx.append(make_data_view(caf::none)));
+    REQUIRE(idx.append(make_data_view("http://foo.com/a")));
+    REQUIRE(idx.append(make_data_view("http://foo.com/\nx"), 7));
+  }
+
+  std::string lookup(relational_operator op, data_view x) {
+    return to_string(unbox(idx.lookup(op, x)));
+  }
+
+  dictionary_index idx{string_type{}};
+};
+
+} // namespace
+
+FIXTURE_SCOPE(dictionary_index_tests, fixture)
+
+TEST(equality) {
+  CHECK_EQUAL(idx.cardinality(), 4u);
+  CHECK_EQUAL(lookup(equal, make_data_view("http://foo.com/a")), "10001000");
+  CHECK_EQUAL(lookup(not_equal, make_data_view("http://foo.com/a")),
+              "01110001");
+  CHECK_EQUAL(lookup(equal, make_data_view("nope")), "00000000");
+  CHECK_EQUAL(lookup(equal, make_data_view(caf::none)), "00010000");
+}
+
+TEST(membership) {
+  auto xs = vector{"http://bar.org"s, "nope"s, "https://foo.com/b"s};
+  CHECK_EQUAL(lookup(in, make_data_view(xs)), "01100000");
+  CHECK_EQUAL(lookup(not_in, make_data_view(xs)), "10001001");
+}
+
+TEST(substring) {
+  CHECK_EQUAL(lookup(ni, make_data_view("foo")), "10101001");
+  CHECK_EQUAL(lookup(not_ni, make_data_view("foo")), "01000000");
+}
+
+TEST(patterns) {
+  MESSAGE("prefix");
+  auto prefix = pattern{"http://foo.*"};
+  CHECK_EQUAL(lookup(match, make_data_view(prefix)), "10001000");
+  CHECK_EQUAL(lookup(not_match, make_data_view(prefix)), "01100001");
+  MESSAGE("arbitrary pattern");
+  auto pat = pattern{"https?://[a-z]+\\.com/.*"};
+  CHECK_EQUAL(lookup(match, make_data_view(pat)), "10101000");
+  MESSAGE("unsupported operator");
+  CHECK(!idx.lookup(less, make_data_view("foo")));
+}
+
+TEST(serialization) {
+  std::vector<char> buf;
+  REQUIRE_EQUAL(save(nullptr, buf, idx), caf::none);
+  dictionary_index idx2{string_type{}};
+  REQUIRE_EQUAL(load(nullptr, buf, idx2), caf::none);
+  auto x = "http://foo.com/a"s;
+  CHECK_EQUAL(to_string(unbox(idx2.lookup(equal, make_data_view(x)))),
+              "10001000");
+  x = "http://bar.org";
+  CHECK(idx2.append(make_data_view(x)));
+  CHECK_EQUAL(to_string(unbox(idx2.lookup(equal, make_data_view(x)))),
+              "010000001");
+}
+
+// The attribute #index=dictionary selects the dictionary_index implementation.
+TEST(factory construction) {
+  factory<value_index>::initialize();
+  auto t = string_type{}.attributes({{"index", "dictionary"}});
+  auto x = factory<value_index>::make(t, caf::settings{});
+  CHECK(dynamic_cast<dictionary_index*>(x.get()) != nullptr);
+  MESSAGE("non-string types ignore the attribute");
+  auto u = count_type{}.attributes({{"index", "dictionary"}});
+  x = factory<value_index>::make(u, caf::settings{});
+  REQUIRE(x != nullptr);
+  CHECK(dynamic_cast<dictionary_index*>(x.get()) == nullptr);
+}
+
+FIXTURE_SCOPE_END()
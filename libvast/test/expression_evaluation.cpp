@@ -195,4 +195,34 @@ TEST(evaluation - table slice) {
               make_ids({0, 2, 4}, 8));
 }
 
+TEST(evaluation - table slice columns) {
+  // The column-wise evaluation must agree with evaluating row by row.
+  auto row_wise = [](const table_slice& slice, const expression& expr) {
+    ids result;
+    result.append_bits(false, slice.offset());
+    for (size_t row = 0; row < slice.rows(); ++row)
+      result.append_bit(evaluate_at(slice, row, expr));
+    return result;
+  };
+  auto exprs = std::vector<std::string_view>{
+    "#timestamp < 2009-11-18+10:00:00",
+    "#type == \"zeek.conn\"",
+    "orig_h == 192.168.1.102",
+    "orig_h in 192.168.1.0/24 && !(resp_h in 192.168.1.0/24)",
+    "local_orig == T || duration > 10s",
+    "orig_bytes >= 100 && resp_bytes < 1000",
+    "service == \"dns\" || \"ssl\" in history",
+    "conn_state != \"SF\"",
+    "proto == \"udp\"",
+  };
+  for (auto& slice : zeek_conn_log_slices) {
+    auto layout = slice->layout();
+    for (auto expr : exprs) {
+      auto ast = unbox(to<expression>(expr));
+      auto tailored = unbox(caf::visit(type_resolver{layout}, ast));
+      CHECK_EQUAL(evaluate(*slice, tailored), row_wise(*slice, tailored));
+    }
+  }
+}
+
 FIXTURE_SCOPE_END()
@@ -21,7 +21,10 @@
 #include "vast/caf_table_slice_builder.hpp"
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/defaults.hpp"
 #include "vast/detail/overload.hpp"
+#include "vast/fbs/meta_index.hpp"
+#include "vast/fbs/utils.hpp"
 #include "vast/synopsis.hpp"
 #include "vast/synopsis_factory.hpp"
 #include "vast/table_slice.hpp"
@@ -109,7 +112,7 @@ struct fixture {
     for (size_t i = 0; i < num_partitions; ++i) {
       auto name = i % 2 == 0 ? "foo"s : "foobar"s;
       auto& part = mock_partitions.emplace_back(std::move(name), ids[i], i);
-      meta_idx.add(part.id, *part.slice);
+      meta_idx.add(part.id, part.slice);
     }
     MESSAGE("verify generated timestamps");
     {
@@ -208,8 +211,56 @@ TEST(attribute extractor - type) {
   CHECK_EQUAL(lookup("#type !~ /x/"), ids);
 }
 
+TEST(time bounds) {
+  for (size_t i = 0; i < num_partitions; ++i) {
+    auto x = meta_idx.bounds(ids[i]);
+    REQUIRE(x);
+    CHECK_EQUAL(x->first, epoch + std::chrono::seconds(25 * i));
+    CHECK_EQUAL(x->last, epoch + std::chrono::seconds(25 * i + 24));
+  }
+  CHECK(!meta_idx.bounds(uuid::nil()));
+}
+
+TEST(serialization) {
+  auto buf = unbox(fbs::wrap(meta_idx, fbs::file_identifier));
+  meta_index meta_idx2;
+  REQUIRE_EQUAL(fbs::unwrap<fbs::MetaIndex>(as_bytes(buf), meta_idx2),
+                caf::none);
+  MESSAGE("lookups must use the restored field catalog");
+  auto q1 = unbox(to<expression>("#type == \"foobar\""));
+  CHECK_EQUAL(meta_idx2.lookup(q1), meta_idx.lookup(q1));
+  auto q2 = unbox(to<expression>("#timestamp >= 1970-01-01+00:00:30.0"));
+  CHECK_EQUAL(meta_idx2.lookup(q2), slice(1, 4));
+}
+
 FIXTURE_SCOPE_END()
 
+TEST(meta index with many partitions) {
+  // Exceed the threshold for parallel synopsis evaluation multiple times.
+  auto n = 3 * defaults::system::meta_index_parallel_lookup_threshold + 1;
+  MESSAGE("add " << n << " partitions with a single bool column");
+  meta_index meta_idx;
+  auto layout = record_type{{"x", bool_type{}}}.name("test");
+  auto builder = caf_table_slice_builder::make(layout);
+  std::vector<uuid> trues;
+  std::vector<uuid> falses;
+  for (size_t i = 0; i < n; ++i) {
+    auto id = uuid::random();
+    CHECK(builder->add(make_data_view(i % 3 == 0)));
+    auto slice = builder->finish();
+    meta_idx.add(id, slice);
+    (i % 3 == 0 ? trues : falses).push_back(id);
+  }
+  std::sort(trues.begin(), trues.end());
+  std::sort(falses.begin(), falses.end());
+  auto lookup = [&](std::string_view expr) {
+    return meta_idx.lookup(unbox(to<expression>(expr)));
+  };
+  CHECK_EQUAL(lookup("x == T"), trues);
+  CHECK_EQUAL(lookup("x == F"), falses);
+  CHECK_EQUAL(lookup(":bool != F"), trues);
+}
+
 TEST(meta index with bool synopsis) {
   MESSAGE("generate slice data and add it to the meta index");
   meta_index meta_idx;
@@ -219,17 +270,17 @@ TEST(meta index with bool synopsis) {
   auto slice = builder->finish();
   REQUIRE(slice != nullptr);
   auto id1 = uuid::random();
-  meta_idx.add(id1, *slice);
+  meta_idx.add(id1, slice);
   CHECK(builder->add(make_data_view(false)));
   slice = builder->finish();
   REQUIRE(slice != nullptr);
   auto id2 = uuid::random();
-  meta_idx.add(id2, *slice);
+  meta_idx.add(id2, slice);
   CHECK(builder->add(make_data_view(caf::none)));
   slice = builder->finish();
   REQUIRE(slice != nullptr);
   auto id3 = uuid::random();
-  meta_idx.add(id3, *slice);
+  meta_idx.add(id3, slice);
   MESSAGE("test custom synopsis");
   auto lookup = [&](std::string_view expr) {
     return meta_idx.lookup(unbox(to<expression>(expr)));
@@ -16,6 +16,7 @@
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/pattern.hpp"
 #include "vast/pattern.hpp"
+#include "vast/view.hpp"
 
 #define SUITE pattern
 #include "vast/test/test.hpp"
@@ -44,6 +45,23 @@ TEST(functionality) {
   CHECK(p.search(str));
 }
 
+TEST(glob) {
+  auto p = pattern::glob("*.example.co?");
+  CHECK_EQUAL(p.string(), ".*\\.example\\.co.");
+  CHECK(p.match("www.example.com"));
+  CHECK(!p.match("www.exampleXcom"));
+}
+
+TEST(view) {
+  auto p = pattern{"https?://.*"};
+  auto v = make_view(p);
+  CHECK(v.match("https://vast.io"));
+  CHECK(!v.match("ftp://vast.io"));
+  auto w = pattern_view{std::string_view{"vast"}};
+  CHECK(w.search("https://vast.io"));
+  CHECK(materialize(v).match("http://vast.io"));
+}
+
 TEST(comparison with string) {
   auto rx = pattern{"foo.*baz"};
   CHECK("foobarbaz"sv == rx);
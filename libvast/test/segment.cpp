@@ -22,6 +22,10 @@
 #include <caf/binary_deserializer.hpp>
 #include <caf/binary_serializer.hpp>
 
+#include <limits>
+
+#include "vast/error.hpp"
+#include "vast/fbs/table_slice.hpp"
 #include "vast/ids.hpp"
 #include "vast/load.hpp"
 #include "vast/table_slice.hpp"
@@ -46,6 +50,43 @@ TEST(construction and querying) {
   CHECK_EQUAL(*slices[1], *zeek_conn_log_slices[2]);
 }
 
+TEST(compression) {
+  auto methods = std::vector<compression>{compression::lz4};
+  if (VAST_HAVE_ZSTD)
+    methods.push_back(compression::zstd);
+  segment_builder plain_builder;
+  for (auto& slice : zeek_conn_log_slices)
+    REQUIRE(!plain_builder.add(slice));
+  auto plain = plain_builder.finish();
+  for (auto method : methods) {
+    segment_builder builder{method};
+    for (auto& slice : zeek_conn_log_slices)
+      REQUIRE(!builder.add(slice));
+    auto x = builder.finish();
+    CHECK_LESS(x.chunk()->size(), plain.chunk()->size());
+    auto xs = x.lookup(make_ids({0, 6, 19, 21}));
+    REQUIRE(xs);
+    auto& slices = *xs;
+    REQUIRE_EQUAL(slices.size(), 2u);
+    CHECK_EQUAL(*slices[0], *zeek_conn_log_slices[0]);
+    CHECK_EQUAL(*slices[1], *zeek_conn_log_slices[2]);
+  }
+}
+
+TEST(oversized uncompressed slice) {
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<uint8_t> bytes(42);
+  auto data = builder.CreateVector(bytes);
+  fbs::TableSliceBuilder slice_builder{builder};
+  slice_builder.add_data(data);
+  slice_builder.add_compression(fbs::Compression::LZ4);
+  slice_builder.add_uncompressed_size(std::numeric_limits<uint64_t>::max());
+  builder.Finish(slice_builder.Finish());
+  auto flat_slice = fbs::GetTableSlice(builder.GetBufferPointer());
+  table_slice_ptr slice;
+  CHECK_EQUAL(unpack(*flat_slice, slice), ec::format_error);
+}
+
 TEST(serialization) {
   segment_builder builder;
   auto slice = zeek_conn_log_slices[0];
@@ -23,10 +23,13 @@
 #include "vast/concept/printable/vast/uuid.hpp"
 #include "vast/detail/narrow.hpp"
 #include "vast/ids.hpp"
+#include "vast/save.hpp"
 #include "vast/si_literals.hpp"
 #include "vast/table_slice.hpp"
 #include "vast/to_events.hpp"
 
+#include <caf/settings.hpp>
+
 using namespace vast;
 using namespace binary_byte_literals;
 
@@ -34,7 +37,7 @@ namespace {
 
 struct fixture : fixtures::deterministic_actor_system_and_events {
   fixture() {
-    store = segment_store::make(directory / "segments", 512_KiB, 2);
+    store = segment_store::make(directory / "segments", 512_KiB, 1_MiB);
     if (store == nullptr)
       FAIL("segment_store::make failed to allocate a segment store");
     segment_path = store->segment_path();
@@ -165,6 +168,77 @@ TEST(flushing filled store) {
   CHECK_EQUAL(segment_files(), expected_files);
 }
 
+TEST(watermark) {
+  auto& slices = zeek_conn_log_slices;
+  CHECK_EQUAL(store->watermark(), 0u);
+  put(slices);
+  CHECK_EQUAL(store->watermark(), slices.front()->offset());
+  store->flush();
+  CHECK_EQUAL(store->watermark(),
+              slices.back()->offset() + slices.back()->rows());
+}
+
+TEST(putting stored slices again) {
+  put_cold(zeek_conn_log_slices);
+  put(zeek_conn_log_slices);
+  CHECK_EQUAL(store->dirty(), false);
+  CHECK(deep_compare(zeek_conn_log_slices, get(everything)));
+  MESSAGE("skipped slices advance the watermark of a reopened store");
+  store = segment_store::make(directory / "segments", 512_KiB, 1_MiB);
+  REQUIRE(store != nullptr);
+  CHECK_EQUAL(store->watermark(), 0u);
+  put(zeek_conn_log_slices);
+  CHECK_EQUAL(store->dirty(), false);
+  auto& last = zeek_conn_log_slices.back();
+  CHECK_EQUAL(store->watermark(), last->offset() + last->rows());
+}
+
+TEST(compacting small segments) {
+  for (auto& slice : zeek_conn_log_slices)
+    put_cold({slice});
+  CHECK_EQUAL(segment_files().size(), 3u);
+  CHECK_GREATER(unbox(store->compact(1_MiB)), 0u);
+  CHECK_EQUAL(segment_files().size(), 1u);
+  CHECK(deep_compare(zeek_conn_log_slices, get(everything)));
+  CHECK_EQUAL(unbox(store->compact(1_MiB)), 0u);
+}
+
+TEST(compacting small segments in steps) {
+  for (auto& slice : zeek_conn_log_slices)
+    put_cold({slice});
+  MESSAGE("a tiny budget loads one segment per step");
+  CHECK_GREATER(unbox(store->compact(1)), 0u);
+  CHECK_EQUAL(segment_files().size(), 3u);
+  CHECK(deep_compare(zeek_conn_log_slices, get(everything)));
+  CHECK_GREATER(unbox(store->compact(1)), 0u);
+  CHECK_EQUAL(segment_files().size(), 3u);
+  MESSAGE("the step that loads the last segment merges");
+  CHECK_GREATER(unbox(store->compact(1)), 0u);
+  CHECK_EQUAL(segment_files().size(), 1u);
+  CHECK(deep_compare(zeek_conn_log_slices, get(everything)));
+  CHECK_EQUAL(unbox(store->compact(1)), 0u);
+}
+
+TEST(compaction yields to reclaiming space) {
+  for (auto& slice : zeek_conn_log_slices)
+    put_cold({slice});
+  CHECK_GREATER(unbox(store->compact(1)), 0u);
+  MESSAGE("rewrite a segment that the compaction already loaded");
+  REQUIRE_EQUAL(store->erase(make_ids({0})), caf::none);
+  CHECK_GREATER(unbox(store->reclaim(1_MiB)), 0u);
+  MESSAGE("abandon the stale merge and start over");
+  CHECK_GREATER(unbox(store->compact(1)), 0u);
+  CHECK_EQUAL(segment_files().size(), 3u);
+  while (unbox(store->compact(1)) > 0)
+    ; // nop
+  CHECK_EQUAL(segment_files().size(), 1u);
+  auto slices = get(everything);
+  size_t rows = 0;
+  for (auto& slice : slices)
+    rows += slice->rows();
+  CHECK_EQUAL(rows, zeek_conn_log.size() - 1);
+}
+
 TEST(querying empty segment store) {
   auto slices = get(everything);
   REQUIRE_EQUAL(slices.size(), 0u);
@@ -198,6 +272,21 @@ TEST(sessionized extraction on filled segment store) {
   CHECK_EQUAL(val(slices[1]).offset(), 16u);
 }
 
+TEST(sessionized extraction with prefetching) {
+  for (auto& slice : zeek_conn_log_slices)
+    put_cold({slice});
+  store->prefetch(2, 2);
+  auto session = store->extract(everything);
+  std::vector<table_slice_ptr> slices;
+  for (auto x = session->next(); x.engaged(); x = session->next())
+    slices.emplace_back(unbox(x));
+  CHECK(deep_compare(zeek_conn_log_slices, slices));
+  caf::settings status;
+  store->inspect_status(status);
+  CHECK_EQUAL(caf::get_or(status, "reads.segments", uint64_t{0}), 3u);
+  CHECK_EQUAL(caf::get_or(status, "reads.queue-depth", uint64_t{1}), 0u);
+}
+
 TEST(erase on empty segment store) {
   erase(make_ids({0, 6, 19, 21}));
   auto slices = get(everything);
@@ -228,6 +317,7 @@ TEST(erase cached segment) {
   CHECK_EQUAL(segment_files().size(), 1u);
   erase(everything);
   CHECK_EQUAL(get(everything).size(), 0u);
+  CHECK(unbox(store->reclaim(1_MiB)) > 0u);
   store = nullptr;
   CHECK_EQUAL(segment_files().size(), 0u);
 }
@@ -237,10 +327,51 @@ TEST(erase persisted segment) {
   CHECK_EQUAL(segment_files().size(), 1u);
   erase(everything);
   CHECK_EQUAL(get(everything).size(), 0u);
+  MESSAGE("tombstones hide erased events after restarting");
+  store = nullptr;
+  CHECK_EQUAL(segment_files().size(), 1u);
+  store = segment_store::make(directory / "segments", 512_KiB, 1_MiB);
+  REQUIRE(store != nullptr);
+  CHECK_EQUAL(get(everything).size(), 0u);
+  MESSAGE("reclaiming space removes the segment");
+  CHECK(unbox(store->reclaim(1_MiB)) > 0u);
+  CHECK_EQUAL(unbox(store->reclaim(1_MiB)), 0u);
   store = nullptr;
   CHECK_EQUAL(segment_files().size(), 0u);
 }
 
+TEST(stale tombstones after reclaiming space) {
+  for (auto& slice : zeek_conn_log_slices)
+    put_cold({slice});
+  auto num_events = [&] {
+    caf::settings status;
+    store->inspect_status(status);
+    return caf::get_or(status, "num-events", uint64_t{0});
+  };
+  erase(make_ids({0, 8}));
+  CHECK_EQUAL(num_events(), 18u);
+  MESSAGE("rewrite one segment only");
+  CHECK_GREATER(unbox(store->reclaim(1)), 0u);
+  CHECK_EQUAL(num_events(), 18u);
+  store = nullptr;
+  store = segment_store::make(directory / "segments", 512_KiB, 1_MiB);
+  REQUIRE(store != nullptr);
+  CHECK_EQUAL(num_events(), 18u);
+  MESSAGE("ignore tombstones of events that are already gone");
+  // This is the state after a crash between rewriting a segment and
+  // recording its removed tombstones.
+  auto tombstone_path = store->tombstone_path();
+  store = nullptr;
+  REQUIRE_EQUAL(save(nullptr, tombstone_path, make_ids({0, 8})), caf::none);
+  store = segment_store::make(directory / "segments", 512_KiB, 1_MiB);
+  REQUIRE(store != nullptr);
+  CHECK_EQUAL(num_events(), 18u);
+  uint64_t rows = 0;
+  for (auto& slice : get(everything))
+    rows += slice->rows();
+  CHECK_EQUAL(rows, 18u);
+}
+
 TEST(erase single slice from active segment) {
   put(zeek_conn_log_slices);
   erase(make_ids({{8, 16}}));
@@ -301,4 +432,18 @@ TEST(erase slice part from persisted segment) {
   CHECK_SLICE(slices[3], 2, 0);
 }
 
+TEST(reclaim slice part from persisted segment) {
+  put_cold(zeek_conn_log_slices);
+  erase(make_ids({{10, 14}}));
+  CHECK(unbox(store->reclaim(1_MiB)) > 0u);
+  store->clear_cache();
+  auto slices = get(everything);
+  REQUIRE_EQUAL(slices.size(), 4u);
+  CHECK_SLICE(slices[0], 0, 0);
+  CHECK_SLICE(slices[1], 1, 0, 2);
+  CHECK_SLICE(slices[2], 1, 6, 2);
+  CHECK_SLICE(slices[3], 2, 0);
+  CHECK_EQUAL(segment_files().size(), 1u);
+}
+
 FIXTURE_SCOPE_END()
@@ -23,9 +23,18 @@
 #include <caf/binary_serializer.hpp>
 
 #include "vast/bool_synopsis.hpp"
+#include "vast/caf_table_slice.hpp"
+#include "vast/config.hpp"
+#include "vast/msgpack_table_slice.hpp"
 #include "vast/synopsis_factory.hpp"
+#include "vast/table_slice_builder_factory.hpp"
+#include "vast/table_slice_column.hpp"
 #include "vast/time_synopsis.hpp"
 
+#if VAST_HAVE_ARROW
+#  include "vast/arrow_table_slice.hpp"
+#endif
+
 using namespace std::chrono_literals;
 using namespace vast;
 using namespace vast::test;
@@ -82,6 +91,44 @@ TEST(min-max synopsis) {
   verify(heterogeneous_view, {N, N, T, F, N, N, N, N, N, N, N, N});
 }
 
+TEST(column ingestion) {
+  using vast::time;
+  factory<synopsis>::initialize();
+  factory<table_slice_builder>::initialize();
+  auto layout
+    = record_type{{"ts", time_type{}}, {"flag", bool_type{}}}.name("test");
+  std::vector<caf::atom_value> impls{caf_table_slice::class_id,
+                                     msgpack_table_slice::class_id};
+#if VAST_HAVE_ARROW
+  impls.push_back(arrow_table_slice::class_id);
+#endif
+  for (auto impl : impls) {
+    MESSAGE("ingest columns of a " << to_string(impl) << " table slice");
+    auto builder = factory<table_slice_builder>::make(impl, layout);
+    REQUIRE_NOT_EQUAL(builder, nullptr);
+    CHECK(builder->add(make_data_view(epoch + 7s), make_data_view(false)));
+    CHECK(builder->add(make_data_view(caf::none), make_data_view(caf::none)));
+    CHECK(builder->add(make_data_view(epoch + 4s), make_data_view(false)));
+    CHECK(builder->add(make_data_view(epoch + 9s), make_data_view(false)));
+    auto slice = builder->finish();
+    REQUIRE_NOT_EQUAL(slice, nullptr);
+    for (size_t col = 0; col < slice->columns(); ++col) {
+      auto& t = layout.fields[col].type;
+      auto expected = factory<synopsis>::make(t, caf::settings{});
+      auto x = factory<synopsis>::make(t, caf::settings{});
+      REQUIRE_NOT_EQUAL(expected, nullptr);
+      REQUIRE_NOT_EQUAL(x, nullptr);
+      for (size_t row = 0; row < slice->rows(); ++row) {
+        auto y = slice->at(row, col);
+        if (!caf::holds_alternative<caf::none_t>(y))
+          expected->add(y);
+      }
+      x->add(table_slice_column{slice, col});
+      CHECK(*x == *expected);
+    }
+  }
+}
+
 FIXTURE_SCOPE(synopsis_tests, fixtures::deterministic_actor_system)
 
 TEST(serialization) {
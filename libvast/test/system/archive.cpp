@@ -44,11 +44,16 @@ struct fixture : fixtures::deterministic_actor_system_and_events {
   }
 
   std::vector<event> query(const ids& ids) {
-    bool done = false;
-    std::vector<event> result;
     self->send(a, ids);
     run();
-    self
+    return receive(self, ids);
+  }
+
+  /// Collects the results of a query from the mailbox of `receiver`.
+  std::vector<event> receive(scoped_actor& receiver, const ids& ids) {
+    bool done = false;
+    std::vector<event> result;
+    receiver
       ->do_receive(
         [&](vast::atom::done, const caf::error& err) {
           REQUIRE(!err);
@@ -99,4 +104,32 @@ TEST(archiving and querying) {
   self->send_exit(a, exit_reason::user_shutdown);
 }
 
+TEST(concurrent overlapping queries) {
+  MESSAGE("store every slice in a segment of its own and cache none");
+  auto b = self->spawn(system::archive, directory / "shared", 10, 1);
+  self->send(b, atom::exporter_v, self);
+  vast::detail::spawn_container_source(sys, zeek_conn_log_slices, b);
+  run();
+  scoped_actor other{sys};
+  other->send(b, atom::exporter_v, actor_cast<actor>(other));
+  run();
+  MESSAGE("query overlapping ids from two exporters at once");
+  auto xs = make_ids({{0, 10}});
+  auto ys = make_ids({{5, 20}});
+  self->send(b, xs);
+  other->send(b, ys);
+  run();
+  CHECK_EQUAL(receive(self, xs).size(), 10u);
+  CHECK_EQUAL(receive(other, ys).size(), 15u);
+  MESSAGE("both queries share one read of each of the three segments");
+  self->send(b, atom::status_v);
+  run();
+  self->receive([&](const caf::dictionary<caf::config_value>& status) {
+    CHECK_EQUAL(caf::get<uint64_t>(status, "store.reads.segments"), 3u);
+    CHECK_EQUAL(caf::get<uint64_t>(status, "store.cache.misses"), 3u);
+  });
+  self->send_exit(b, exit_reason::user_shutdown);
+  run();
+}
+
 FIXTURE_SCOPE_END()
@@ -0,0 +1,145 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE compactor
+
+#include "vast/system/compactor.hpp"
+
+#include "vast/test/fixtures/actor_system_and_events.hpp"
+#include "vast/test/test.hpp"
+
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/uuid.hpp"
+#include "vast/detail/spawn_container_source.hpp"
+#include "vast/filesystem.hpp"
+#include "vast/ids.hpp"
+#include "vast/system/archive.hpp"
+#include "vast/system/index.hpp"
+#include "vast/table_slice.hpp"
+#include "vast/uuid.hpp"
+
+#include <algorithm>
+
+using caf::after;
+using std::chrono_literals::operator""s;
+
+using namespace vast;
+
+namespace {
+
+static constexpr size_t max_partition_size = 20;
+
+struct fixture : fixtures::deterministic_actor_system_and_events {
+  fixture() {
+    archive = self->spawn(system::archive, directory / "archive", 10,
+                          1024 * 1024);
+    spawn_index();
+  }
+
+  ~fixture() {
+    anon_send_exit(archive, caf::exit_reason::user_shutdown);
+    anon_send_exit(index, caf::exit_reason::user_shutdown);
+    if (compactor)
+      anon_send_exit(compactor, caf::exit_reason::user_shutdown);
+  }
+
+  void spawn_index() {
+    index = self->spawn(system::index, directory / "index", max_partition_size,
+                        size_t{8}, size_t{4}, size_t{1});
+    run();
+  }
+
+  /// Stores every slice in a partition of its own by restarting the INDEX in
+  /// between, which writes the active partition to disk.
+  void ingest(const std::vector<table_slice_ptr>& slices) {
+    detail::spawn_container_source(sys, slices, archive);
+    run();
+    for (auto& slice : slices) {
+      detail::spawn_container_source(sys, std::vector{slice}, index);
+      run();
+      anon_send_exit(index, caf::exit_reason::user_shutdown);
+      run();
+      spawn_index();
+    }
+  }
+
+  system::index_state& state() {
+    return deref<caf::stateful_actor<system::index_state>>(index).state;
+  }
+
+  ids query(std::string_view expr) {
+    self->send(index, unbox(to<expression>(expr)));
+    run();
+    uint32_t hits = 0;
+    uint32_t scheduled = 0;
+    self->receive(
+      [&](const uuid&, uint32_t x, uint32_t y) {
+        hits = x;
+        scheduled = y;
+      },
+      after(0s) >> [&] { FAIL("INDEX did not respond to query"); });
+    REQUIRE_EQUAL(hits, scheduled);
+    ids result;
+    auto done = false;
+    while (!done)
+      self->receive([&](ids& sub_result) { result |= sub_result; },
+                    [&](atom::done) { done = true; },
+                    after(0s) >> [&] { FAIL("ran out of messages"); });
+    if (result.size() < zeek_conn_log.size())
+      result.append_bits(false, zeek_conn_log.size() - result.size());
+    return result;
+  }
+
+  caf::actor index;
+  system::archive_type archive;
+  caf::actor compactor;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(compactor_tests, fixture)
+
+TEST(merging small partitions) {
+  REQUIRE_EQUAL(zeek_conn_log_slices.size(), 3u);
+  ingest(zeek_conn_log_slices);
+  auto sources = state().meta_idx.partitions();
+  REQUIRE_EQUAL(sources.size(), 3u);
+  auto expected_result = make_ids({5, 6, 9, 11}, zeek_conn_log.size());
+  CHECK_EQUAL(query(":addr == 192.168.1.104"), expected_result);
+  MESSAGE("merge all partitions into one");
+  compactor = sys.spawn(system::compactor, caf::timespan{1s}, index,
+                        caf::actor_cast<caf::actor>(archive));
+  run();
+  self->send(compactor, atom::run_v);
+  run();
+  auto partitions = state().meta_idx.partitions();
+  REQUIRE_EQUAL(partitions.size(), 1u);
+  CHECK(std::find(sources.begin(), sources.end(), partitions[0])
+        == sources.end());
+  CHECK_EQUAL(query(":addr == 192.168.1.104"), expected_result);
+  CHECK_EQUAL(rank(query("#type == \"zeek.conn\"")), zeek_conn_log.size());
+  MESSAGE("remove the replaced partitions in the next round");
+  for (auto& source : sources)
+    CHECK(exists(directory / "index" / to_string(source)));
+  self->send(compactor, atom::run_v);
+  run();
+  for (auto& source : sources)
+    CHECK(!exists(directory / "index" / to_string(source)));
+  CHECK(exists(directory / "index" / to_string(partitions[0])));
+  MESSAGE("leave the merged partition alone");
+  CHECK(state().meta_idx.partitions() == partitions);
+}
+
+FIXTURE_SCOPE_END()
@@ -25,6 +25,7 @@
 #include "vast/detail/spawn_container_source.hpp"
 #include "vast/fwd.hpp"
 #include "vast/ids.hpp"
+#include "vast/si_literals.hpp"
 #include "vast/system/archive.hpp"
 #include "vast/system/index.hpp"
 #include "vast/table_slice.hpp"
@@ -36,6 +37,7 @@
 
 using namespace vast;
 using namespace system;
+using namespace vast::binary_byte_literals;
 
 using vast::expression;
 using vast::ids;
@@ -67,8 +69,8 @@ struct fixture : fixtures::deterministic_actor_system_and_events {
     index = self->spawn(system::index, directory / "index",
                         defaults::import::table_slice_size, 100, 3, 1);
     archive = self->spawn(system::archive, directory / "archive",
-                          defaults::system::segments,
-                          defaults::system::max_segment_size);
+                          1_MiB * defaults::system::segment_cache_size,
+                          1_MiB * defaults::system::max_segment_size);
     client = sys.spawn(mock_client);
     // Fill the INDEX with 400 rows from the Zeek conn log.
     detail::spawn_container_source(sys, take(zeek_full_conn_log_slices, 4),
@@ -18,6 +18,7 @@
 #include "vast/test/fixtures/actor_system_and_events.hpp"
 #include "vast/test/test.hpp"
 
+#include "vast/caf_table_slice_builder.hpp"
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
 #include "vast/concept/parseable/vast/uuid.hpp"
@@ -27,6 +28,7 @@
 #include "vast/expression.hpp"
 #include "vast/fwd.hpp"
 #include "vast/ids.hpp"
+#include "vast/query_options.hpp"
 #include "vast/system/index.hpp"
 #include "vast/table_slice.hpp"
 
@@ -56,7 +58,8 @@ struct mock_index_state {
 
 caf::behavior mock_index(caf::stateful_actor<mock_index_state>* self) {
   return {
-    [=](expression&) {
+    [=](expression&, query_options opts) {
+      CHECK(has_background_option(opts));
       auto& deltas = self->state.deltas;
       deltas = std::vector<ids>{
         make_ids({1, 3, 5}),    make_ids({7, 9, 11}),  make_ids({13, 15, 17}),
@@ -80,31 +83,51 @@ caf::behavior mock_index(caf::stateful_actor<mock_index_state>* self) {
 }
 
 struct mock_archive_state {
+  std::vector<table_slice_ptr> slices;
   ids hits;
   static inline constexpr const char* name = "mock-archive";
 };
 
 using mock_archive_actor = caf::stateful_actor<mock_archive_state>;
 
-caf::behavior mock_archive(mock_archive_actor* self) {
-  return {[=](atom::erase, ids hits) { self->state.hits = hits; }};
+caf::behavior
+mock_archive(mock_archive_actor* self, std::vector<table_slice_ptr> slices) {
+  self->state.slices = std::move(slices);
+  return {
+    [=](atom::exporter, const caf::actor&) {
+      // nop
+    },
+    [=](const ids& xs) {
+      auto hdl = caf::actor_cast<caf::actor>(self->current_sender());
+      for (auto& slice : self->state.slices)
+        for (auto& sub_slice : select(slice, xs))
+          self->send(hdl, sub_slice);
+      self->send(hdl, atom::done_v, caf::error{});
+    },
+    [=](atom::erase, ids hits) { self->state.hits = hits; },
+  };
 }
 
 struct fixture : fixtures::deterministic_actor_system_and_events {
   fixture() : query_id(unbox(to<uuid>(uuid_str))) {
-    archive = sys.spawn(mock_archive);
-    sched.run();
+    // nop
   }
 
   ~fixture() override {
     self->send_exit(aut, caf::exit_reason::user_shutdown);
     self->send_exit(index, caf::exit_reason::user_shutdown);
+    self->send_exit(archive, caf::exit_reason::user_shutdown);
+  }
+
+  void spawn_archive(std::vector<table_slice_ptr> slices) {
+    archive = sys.spawn(mock_archive, std::move(slices));
+    sched.run();
   }
 
-  // @pre index != nullptr
+  // @pre index != nullptr && archive != nullptr
   void spawn_aut(std::string query = "#time < 1 week ago") {
-    if (index == nullptr)
-      FAIL("cannot start AUT without INDEX");
+    if (index == nullptr || archive == nullptr)
+      FAIL("cannot start AUT without INDEX and ARCHIVE");
     aut = sys.spawn(vast::system::eraser, 6h, std::move(query), index, archive);
     sched.run();
   }
@@ -121,10 +144,12 @@ FIXTURE_SCOPE(eraser_tests, fixture)
 
 TEST(eraser on mock INDEX) {
   index = sys.spawn(mock_index);
+  // The mock INDEX reports hits beyond the 20 events in the ARCHIVE.
+  spawn_archive(zeek_conn_log_slices);
   spawn_aut();
   sched.trigger_timeouts();
   expect((atom::run), from(aut).to(aut));
-  expect((expression), from(aut).to(index));
+  expect((expression, query_options), from(aut).to(index));
   expect((uuid, uint32_t, uint32_t),
          from(index).to(aut).with(query_id, 7u, 3u));
   expect((ids), from(index).to(aut));
@@ -139,12 +164,17 @@ TEST(eraser on mock INDEX) {
   expect((uuid, uint32_t), from(aut).to(index).with(query_id, 1u));
   expect((ids), from(index).to(aut));
   expect((atom::done), from(index).to(aut));
+  expect((ids), from(aut).to(archive).with(make_ids({{1, 22}})));
+  while (allow((table_slice_ptr), from(archive).to(aut)))
+    ; // repeat
+  expect((atom::done, caf::error), from(archive).to(aut));
   expect((atom::erase, ids),
-         from(aut).to(archive).with(_, make_ids({{1, 22}})));
+         from(aut).to(archive).with(_, make_ids({{1, 20}})));
 }
 
 TEST(eraser on actual INDEX with Zeek conn logs) {
   auto slices = take(zeek_full_conn_log_slices, 4);
+  spawn_archive(slices);
   MESSAGE("spawn INDEX ingest 4 slices with 100 rows (= 1 partition) each");
   index = self->spawn(system::index, directory / "index",
                       defaults::import::table_slice_size, 100, taste_count, 1);
@@ -156,7 +186,7 @@ TEST(eraser on actual INDEX with Zeek conn logs) {
   spawn_aut(":addr == 192.168.1.104");
   sched.trigger_timeouts();
   expect((atom::run), from(aut).to(aut));
-  expect((expression), from(aut).to(index));
+  expect((expression, query_options), from(aut).to(index));
   expect((uuid, uint32_t, uint32_t), from(index).to(aut).with(_, 4u, 3u));
   sched.run_jobs_filtered(not_aut);
   while (allow((ids), from(_).to(aut)))
@@ -167,6 +197,10 @@ TEST(eraser on actual INDEX with Zeek conn logs) {
   while (allow((ids), from(_).to(aut)))
     ; // repeat
   expect((atom::done), from(_).to(aut));
+  expect((ids), from(aut).to(archive));
+  while (allow((table_slice_ptr), from(archive).to(aut)))
+    ; // repeat
+  expect((atom::done, caf::error), from(archive).to(aut));
   expect((atom::erase, ids), from(aut).to(archive));
   REQUIRE(!sched.has_job());
   // The magic number 133 was computed via:
@@ -177,4 +211,29 @@ TEST(eraser on actual INDEX with Zeek conn logs) {
   CHECK_EQUAL(rank(deref<mock_archive_actor>(archive).state.hits), 133u);
 }
 
+TEST(eraser keeps false positives of the INDEX) {
+  auto layout = record_type{
+    {"url", string_type{}.attributes({{"index", "trigram"}})},
+  }.name("test.url");
+  auto builder = caf_table_slice_builder::make(layout);
+  for (auto url : {"http://evil.com/login", "abc-bcd", "abcd-x", "zzz"})
+    REQUIRE(builder->add(make_data_view(url)));
+  auto slice = builder->finish();
+  REQUIRE(slice != nullptr);
+  slice.unshared().offset(0);
+  MESSAGE("spawn INDEX and ingest URLs into a trigram index");
+  index = self->spawn(system::index, directory / "index",
+                      defaults::import::table_slice_size, 100, taste_count, 1);
+  detail::spawn_container_source(sys, std::vector{slice}, index);
+  run();
+  spawn_archive({slice});
+  MESSAGE("run an aging cycle for a substring that only the third URL has");
+  // The trigram index also reports "abc-bcd", because it contains all
+  // trigrams of the needle.
+  spawn_aut("url ni \"abcd\"");
+  sched.trigger_timeouts();
+  run();
+  CHECK(deref<mock_archive_actor>(archive).state.hits == make_ids({2}));
+}
+
 FIXTURE_SCOPE_END()
@@ -61,10 +61,32 @@ ids select(const counts& xs, curried_predicate pred) {
   }
 }
 
-// Dummy actor representing an INDEXER for field `x`.
-caf::behavior dummy_indexer(counts xs) {
+// Dummy actor representing an INDEXER for field `x`. Records the lookups that
+// come with a set of candidates in `restricted_lookups`.
+caf::behavior
+dummy_indexer(counts xs, std::vector<curried_predicate>* restricted_lookups) {
   return {
-    [xs = std::move(xs)](curried_predicate pred) { return select(xs, pred); }};
+    [xs](curried_predicate pred) { return select(xs, pred); },
+    [xs, restricted_lookups](curried_predicate pred, const ids& candidates) {
+      restricted_lookups->push_back(pred);
+      return select(xs, pred) & candidates;
+    }};
+}
+
+// Like `dummy_indexer`, but also answers selectivity estimates from its
+// values, like an INDEXER with column statistics does.
+caf::behavior
+estimating_indexer(counts xs,
+                   std::vector<curried_predicate>* restricted_lookups) {
+  return {
+    [xs](curried_predicate pred) { return select(xs, pred); },
+    [xs, restricted_lookups](curried_predicate pred, const ids& candidates) {
+      restricted_lookups->push_back(pred);
+      return select(xs, pred) & candidates;
+    },
+    [xs](atom::statistics, const curried_predicate& pred) {
+      return static_cast<double>(rank(select(xs, pred))) / xs.size();
+    }};
 }
 
 struct fixture : fixtures::deterministic_actor_system_and_events {
@@ -73,19 +95,30 @@ struct fixture : fixtures::deterministic_actor_system_and_events {
     layout.fields.emplace_back("y", count_type{});
     layout.name("test");
     // Spin up our dummies.
+    spawn_indexers(dummy_indexer);
+  }
+
+  template <class Behavior>
+  void spawn_indexers(Behavior f) {
+    indexers.clear();
     auto& x_indexers= indexers["x"];
-    add_indexer(x_indexers, {12, 42, 42, 17, 42, 75, 38, 11, 10});
-    add_indexer(x_indexers, {42, 13, 17, 42, 99, 87, 23, 55, 11});
+    add_indexer(f, x_indexers, {12, 42, 42, 17, 42, 75, 38, 11, 10});
+    add_indexer(f, x_indexers, {42, 13, 17, 42, 99, 87, 23, 55, 11});
     auto& y_indexers= indexers["y"];
-    add_indexer(y_indexers, {10, 10, 10, 10, 42, 10, 10, 10, 42});
-    add_indexer(y_indexers, {10, 42, 10, 77, 42, 10, 10, 10, 10});
+    add_indexer(f, y_indexers, {10, 10, 10, 10, 42, 10, 10, 10, 42});
+    add_indexer(f, y_indexers, {10, 42, 10, 77, 42, 10, 10, 10, 10});
   }
 
   /// Maps predicates to a list of actors.
   std::map<std::string, std::vector<caf::actor>> indexers;
 
-  void add_indexer(std::vector<caf::actor>& container, counts data) {
-    container.emplace_back(sys.spawn(dummy_indexer, std::move(data)));
+  /// Stores the lookups that the evaluator restricted to candidates.
+  std::vector<curried_predicate> restricted_lookups;
+
+  template <class Behavior>
+  void add_indexer(Behavior f, std::vector<caf::actor>& container,
+                   counts data) {
+    container.emplace_back(sys.spawn(f, std::move(data), &restricted_lookups));
   }
 
   record_type layout;
@@ -158,6 +191,33 @@ TEST(conjunctions) {
   CHECK_QUERY("x == 75 && y == 77", ({}));
 }
 
+TEST(conjunctions with restricted lookups) {
+  MESSAGE("the more selective operand restricts the other one");
+  CHECK_QUERY("y != 10 && x == 42", ({1, 3, 4}));
+  CHECK_EQUAL(restricted_lookups.size(), 2u);
+  MESSAGE("no candidates left after the more selective operand");
+  restricted_lookups.clear();
+  CHECK_QUERY("y != 10 && x == 33", ({}));
+  CHECK_EQUAL(restricted_lookups.size(), 0u);
+}
+
+TEST(conjunctions with selectivity estimates) {
+  auto restricted_field = [&] {
+    REQUIRE_EQUAL(restricted_lookups.size(), 2u);
+    auto x = restricted_lookups[0].rhs;
+    CHECK(restricted_lookups[1].rhs == x);
+    return x;
+  };
+  MESSAGE("the heuristic cannot tell the operands apart");
+  CHECK_QUERY("x == 42 && y == 10", ({0, 1, 2, 3}));
+  CHECK(restricted_field() == data{vast::count{42}});
+  MESSAGE("the estimates of the INDEXER actors decide the order");
+  spawn_indexers(estimating_indexer);
+  restricted_lookups.clear();
+  CHECK_QUERY("x == 42 && y == 10", ({0, 1, 2, 3}));
+  CHECK(restricted_field() == data{vast::count{10}});
+}
+
 TEST(disjunctions) {
   MESSAGE("no hit on either side");
   CHECK_QUERY("x == 33 || y >= 99", ({}));
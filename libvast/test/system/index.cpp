@@ -24,15 +24,20 @@
 #include "vast/concept/printable/std/chrono.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/event.hpp"
+#include "vast/concept/printable/vast/uuid.hpp"
 #include "vast/detail/spawn_container_source.hpp"
 #include "vast/detail/spawn_generator_source.hpp"
 #include "vast/event.hpp"
+#include "vast/filesystem.hpp"
 #include "vast/fwd.hpp"
 #include "vast/ids.hpp"
 #include "vast/query_options.hpp"
+#include "vast/system/compactor.hpp"
 #include "vast/table_slice.hpp"
 #include "vast/table_slice_builder.hpp"
 
+#include <thread>
+
 using caf::after;
 using std::chrono_literals::operator""s;
 
@@ -173,6 +178,10 @@ TEST(iterable integer query result) {
   MESSAGE("collect results");
   auto result = receive_result(query_id, hits, scheduled);
   CHECK_EQUAL(result, expected_result);
+  MESSAGE("all partitions except the active one came from disk");
+  CHECK_EQUAL(state().loading.size(), 0u);
+  CHECK_EQUAL(state().load_stats.count, partitions - 1);
+  CHECK_EQUAL(state().load_stats.failed, 0u);
 }
 
 TEST(iterable zeek conn log query result) {
@@ -219,6 +228,259 @@ TEST(iterable zeek conn log query result) {
     CHECK_EQUAL(rank(result), 2u);
     CHECK_EQUAL(result, expected_result);
   }
+  MESSAGE("issue conjunction with a #type operand");
+  {
+    // The negation is the less selective operand, so its lookup is
+    // restricted to the candidates of the address operand.
+    auto expected_result = make_ids({5, 6, 9, 11});
+    auto [query_id, hits, scheduled] = query("#type != \"zeek.dns\" "
+                                             "&& :addr == 192.168.1.104");
+    auto result = receive_result(query_id, hits, scheduled);
+    align(expected_result, result);
+    CHECK_EQUAL(rank(result), rank(expected_result));
+    CHECK_EQUAL(result, expected_result);
+  }
+}
+
+TEST(column statistics) {
+  MESSAGE("ingest conn.log slices");
+  detail::spawn_container_source(sys, zeek_conn_log_slices, index);
+  run();
+  // Filling up the third partition seals the first two, whose INDEXER actors
+  // then report the statistics of their columns.
+  auto sealed = 2 * slice_size;
+  auto fqn = std::string{"zeek.conn.id.orig_h"};
+  auto verify = [&] {
+    auto rh = self->request(index, caf::infinite, atom::statistics_v, fqn);
+    run();
+    rh.receive(
+      [&](const column_statistics& stats) {
+        CHECK_EQUAL(stats.count(), sealed);
+        CHECK_EQUAL(stats.nulls(), 0u);
+        CHECK_GREATER(stats.distinct(), 0u);
+        CHECK_LESS_EQUAL(stats.distinct(), sealed);
+      },
+      [&](const caf::error& err) { FAIL(sys.render(err)); });
+  };
+  MESSAGE("merge the statistics of all sealed partitions");
+  verify();
+  MESSAGE("reject unknown columns");
+  auto rh = self->request(index, caf::infinite, atom::statistics_v,
+                          std::string{"zeek.conn.nope"});
+  run();
+  rh.receive(
+    [&](const column_statistics&) { FAIL("expected an error"); },
+    [&](const caf::error& err) { CHECK_EQUAL(err, ec::lookup_error); });
+  MESSAGE("persist and reload the statistics");
+  REQUIRE_EQUAL(state().flush_statistics(), caf::none);
+  anon_send_exit(index, caf::exit_reason::user_shutdown);
+  run();
+  index = self->spawn(system::index, directory / "index", slice_size,
+                      in_mem_partitions, taste_count, num_query_supervisors);
+  run();
+  verify();
+}
+
+TEST(replayed slices) {
+  auto& slices = zeek_conn_log_slices;
+  REQUIRE_EQUAL(slices.size(), 3u);
+  MESSAGE("ingest conn.log slices");
+  detail::spawn_container_source(sys, slices, index);
+  run();
+  MESSAGE("the first two partitions are persisted");
+  CHECK(state().is_persisted(*slices[0]));
+  CHECK(state().is_persisted(*slices[1]));
+  CHECK(!state().is_persisted(*slices[2]));
+  CHECK_EQUAL(state().watermark(), slices[2]->offset());
+  auto lookup = [&](uint32_t& hits) {
+    auto [query_id, num_hits, scheduled] = query(":addr == 192.168.1.104");
+    hits = num_hits;
+    auto result = receive_result(query_id, num_hits, scheduled);
+    if (result.size() < zeek_conn_log.size())
+      result.append_bits(false, zeek_conn_log.size() - result.size());
+    return result;
+  };
+  auto expected_result = make_ids({5, 6, 9, 11}, zeek_conn_log.size());
+  uint32_t hits = 0;
+  CHECK_EQUAL(lookup(hits), expected_result);
+  auto partitions = state().meta_idx.partitions().size();
+  MESSAGE("restart and replay all slices, like the IMPORTER after a crash");
+  anon_send_exit(index, caf::exit_reason::user_shutdown);
+  run();
+  index = self->spawn(system::index, directory / "index", slice_size,
+                      in_mem_partitions, taste_count, num_query_supervisors);
+  run();
+  MESSAGE("only partitions that confirmed persisting count as durable");
+  CHECK(state().is_persisted(*slices[1]));
+  CHECK(!state().is_persisted(*slices[2]));
+  CHECK_EQUAL(state().watermark(), slices[2]->offset());
+  detail::spawn_container_source(sys, slices, index);
+  run();
+  MESSAGE("the INDEX skips the replayed slices of persisted partitions");
+  REQUIRE(state().active != nullptr);
+  CHECK_EQUAL(state().active->first_id(), slices[2]->offset());
+  CHECK_EQUAL(state().meta_idx.partitions().size(), partitions + 1);
+  CHECK_EQUAL(lookup(hits), expected_result);
+}
+
+TEST(replacing partitions) {
+  MESSAGE("ingest conn.log slices");
+  detail::spawn_container_source(sys, zeek_conn_log_slices, index);
+  run();
+  REQUIRE(state().active != nullptr);
+  auto active = state().active->id();
+  auto persisted = state().meta_idx.partitions();
+  persisted.erase(std::remove(persisted.begin(), persisted.end(), active),
+                  persisted.end());
+  REQUIRE_EQUAL(persisted.size(), 2u);
+  auto source = persisted[0];
+  auto replace = [&](uuid x) {
+    system::compacted_partition replacement{uuid::random(), {x}, {}};
+    return state().replace_partitions(replacement);
+  };
+  MESSAGE("reject unknown partitions");
+  CHECK(!replace(uuid::random()));
+  MESSAGE("reject the active partition");
+  CHECK(!replace(active));
+  MESSAGE("reject partitions that are loading");
+  state().loading.emplace(source, system::index_state::partition_load{});
+  CHECK(!replace(source));
+  state().loading.erase(source);
+  MESSAGE("accept persisted partitions");
+  CHECK(replace(source));
+  auto known = state().meta_idx.partitions();
+  CHECK(std::find(known.begin(), known.end(), source) == known.end());
+  MESSAGE("keep replaced partitions on disk while queries use them");
+  auto source_dir = directory / "index" / to_string(source);
+  REQUIRE(exists(source_dir));
+  auto pin = state().pin({source});
+  state().remove_orphaned_partitions();
+  CHECK(exists(source_dir));
+  pin.reset();
+  CHECK(!state().is_pinned(source));
+  state().remove_orphaned_partitions();
+  CHECK(!exists(source_dir));
+  CHECK(exists(directory / "index" / to_string(persisted[1])));
+}
+
+TEST(pinning partitions of running queries) {
+  MESSAGE("ingest conn.log slices");
+  detail::spawn_container_source(sys, zeek_conn_log_slices, index);
+  run();
+  MESSAGE("queries pin their candidates until the workers finish");
+  CHECK(state().pinned_partitions->empty());
+  self->send(index, unbox(to<expression>(":addr == 192.168.1.104")));
+  sched.run_once();
+  CHECK(!state().pinned_partitions->empty());
+  run();
+  uuid query_id;
+  uint32_t hits = 0;
+  uint32_t scheduled = 0;
+  self->receive(
+    [&](uuid& x, uint32_t y, uint32_t z) {
+      query_id = x;
+      hits = y;
+      scheduled = z;
+    },
+    after(0s) >> [&] { FAIL("INDEX did not respond to query"); });
+  receive_result(query_id, hits, scheduled);
+  CHECK(state().worker_pins.empty());
+  CHECK(state().pinned_partitions->empty());
+}
+
+TEST(time ordered scheduling) {
+  MESSAGE("ingest conn.log slices");
+  detail::spawn_container_source(sys, zeek_conn_log_slices, index);
+  run();
+  auto& meta_idx = state().meta_idx;
+  auto expr = unbox(to<expression>("#type == \"zeek.conn\""));
+  auto candidates = meta_idx.lookup(expr);
+  REQUIRE_GREATER(candidates.size(), 1u);
+  auto bounds = [&](const uuid& id) { return unbox(meta_idx.bounds(id)); };
+  MESSAGE("newest partitions come first by default");
+  state().order_candidates(candidates, historical);
+  CHECK(std::is_sorted(candidates.begin(), candidates.end(),
+                       [&](const uuid& x, const uuid& y) {
+                         return bounds(x).last > bounds(y).last;
+                       }));
+  MESSAGE("oldest partitions come first on request");
+  state().order_candidates(candidates, historical + oldest_first);
+  CHECK(std::is_sorted(candidates.begin(), candidates.end(),
+                       [&](const uuid& x, const uuid& y) {
+                         return bounds(x).first < bounds(y).first;
+                       }));
+}
+
+FIXTURE_SCOPE_END()
+
+namespace {
+
+struct pooled_configuration : fixtures::test_configuration {
+  pooled_configuration() {
+    set("system.indexing-threads", 2);
+    // Repeated queries must see new data instead of cached results.
+    set("system.query-cache-size", 0);
+  }
+};
+
+/// Runs the INDEX on the default scheduler, because the threads of the
+/// indexing pool notify the INDEX from outside of the test coordinator.
+struct pooled_fixture : fixtures::filesystem, fixtures::events {
+  pooled_fixture() : sys{config}, self{sys, true} {
+    index = self->spawn(system::index, directory / "index", slice_size,
+                        in_mem_partitions, taste_count, num_query_supervisors);
+  }
+
+  ~pooled_fixture() {
+    self->send_exit(index, caf::exit_reason::user_shutdown);
+  }
+
+  ids query(std::string_view expr) {
+    ids result;
+    self->send(index, unbox(to<expression>(expr)));
+    self->receive(
+      [&](const uuid&, uint32_t hits, uint32_t scheduled) {
+        CHECK_EQUAL(hits, scheduled);
+      },
+      after(10s) >> [&] { FAIL("INDEX did not respond to query"); });
+    auto done = false;
+    while (!done)
+      self->receive([&](ids& sub_result) { result |= sub_result; },
+                    [&](atom::done) { done = true; },
+                    after(10s) >> [&] { FAIL("INDEX did not finish query"); });
+    return result;
+  }
+
+  pooled_configuration config;
+  caf::actor_system sys;
+  caf::scoped_actor self;
+  caf::actor index;
+};
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(pooled_index_tests, pooled_fixture)
+
+TEST(integer query result with indexing pool) {
+  MESSAGE("fill " << taste_count << " partitions through the indexing pool");
+  auto slices = std::vector<table_slice_ptr>(
+    alternating_integers_slices.begin(),
+    alternating_integers_slices.begin() + taste_count);
+  detail::spawn_container_source(sys, slices, index);
+  ids expected_result;
+  expected_result.append_bits(false, alternating_integers[0].id());
+  for (size_t i = 0; i < (slice_size * taste_count) / 2; ++i) {
+    expected_result.append_bit(false);
+    expected_result.append_bit(true);
+  }
+  MESSAGE("query half of the values until the pool indexed all slices");
+  auto deadline = steady_clock::now() + 10s;
+  auto result = query(":int == 1");
+  while (result != expected_result && steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(10ms);
+    result = query(":int == 1");
+  }
+  CHECK_EQUAL(result, expected_result);
 }
 
 FIXTURE_SCOPE_END()
@@ -0,0 +1,114 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE query_cache
+
+#include "vast/system/query_cache.hpp"
+
+#include "vast/test/test.hpp"
+
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/ids.hpp"
+
+using namespace vast;
+using namespace vast::system;
+
+namespace {
+
+expression expr(std::string_view str) {
+  return normalize(unbox(to<expression>(str)));
+}
+
+ids make_ids(std::initializer_list<id> xs) {
+  ids result;
+  for (auto x : xs) {
+    result.append_bits(false, x - result.size());
+    result.append_bit(true);
+  }
+  return result;
+}
+
+struct fixture {
+  fixture() {
+    x = expr(":addr == 10.0.0.1");
+    y = expr("#type == \"zeek.conn\"");
+    p0 = uuid::random();
+    p1 = uuid::random();
+  }
+
+  expression x;
+  expression y;
+  uuid p0;
+  uuid p1;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(query_cache_tests, fixture)
+
+TEST(disabled) {
+  query_cache cache;
+  CHECK(!cache.enabled());
+  cache.add(x, p0, make_ids({1, 2, 3}));
+  CHECK_EQUAL(cache.size(), 0u);
+  CHECK(cache.lookup(x, p0) == nullptr);
+}
+
+TEST(lookup) {
+  query_cache cache{1 << 20};
+  cache.add(x, p0, make_ids({1, 2, 3}));
+  cache.add(y, p0, make_ids({4}));
+  cache.add(x, p1, make_ids({5}));
+  CHECK_EQUAL(cache.size(), 3u);
+  CHECK(cache.contains(x, p1));
+  CHECK(!cache.contains(y, p1));
+  auto hits = cache.lookup(x, p0);
+  REQUIRE(hits != nullptr);
+  CHECK_EQUAL(*hits, make_ids({1, 2, 3}));
+  CHECK(cache.lookup(y, p1) == nullptr);
+  CHECK_EQUAL(cache.stats().hits, 1u);
+  CHECK_EQUAL(cache.stats().misses, 1u);
+  MESSAGE("replacing an entry");
+  cache.add(x, p0, make_ids({7}));
+  CHECK_EQUAL(cache.size(), 3u);
+  CHECK_EQUAL(*cache.lookup(x, p0), make_ids({7}));
+  MESSAGE("erasing a partition");
+  cache.erase(p0);
+  CHECK_EQUAL(cache.size(), 1u);
+  CHECK(cache.contains(x, p1));
+}
+
+TEST(eviction by memory) {
+  auto bm = make_ids({1, 2, 3});
+  auto n = memusage(bm);
+  query_cache cache{2 * n};
+  cache.add(x, p0, bm);
+  cache.add(y, p0, bm);
+  CHECK_EQUAL(cache.bytes(), 2 * n);
+  // Accessing the first entry makes the second one the eviction victim.
+  CHECK(cache.lookup(x, p0) != nullptr);
+  cache.add(x, p1, bm);
+  CHECK_EQUAL(cache.size(), 2u);
+  CHECK(cache.contains(x, p0));
+  CHECK(!cache.contains(y, p0));
+  CHECK(cache.contains(x, p1));
+  CHECK_EQUAL(cache.stats().evictions, 1u);
+  MESSAGE("shrinking the budget");
+  cache.max_bytes(n);
+  CHECK_EQUAL(cache.size(), 1u);
+  CHECK(cache.contains(x, p1));
+  CHECK_LESS_EQUAL(cache.bytes(), n);
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,125 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE query_scheduler
+
+#include "vast/system/query_scheduler.hpp"
+
+#include "vast/test/fixtures/actor_system.hpp"
+#include "vast/test/test.hpp"
+
+#include "vast/query_options.hpp"
+
+#include <caf/actor.hpp>
+#include <caf/event_based_actor.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace vast;
+using namespace vast::system;
+
+namespace {
+
+caf::behavior dummy_client(caf::event_based_actor*) {
+  return {
+    [](int) {
+      // nop
+    },
+  };
+}
+
+struct fixture : fixtures::deterministic_actor_system {
+  fixture() : scheduler({8, 2, 1}) {
+    alice = sys.spawn(dummy_client).address();
+    bob = sys.spawn(dummy_client).address();
+  }
+
+  void enqueue(const caf::actor_addr& client, query_priority prio,
+               uint32_t cost, std::string name) {
+    scheduler.enqueue(client, prio, cost, [this, name = std::move(name)] {
+      log.push_back(name);
+    });
+  }
+
+  void drain(size_t n = 0) {
+    for (size_t i = 0; !scheduler.empty() && (n == 0 || i < n); ++i)
+      scheduler.dequeue()();
+  }
+
+  query_scheduler scheduler;
+  caf::actor_addr alice;
+  caf::actor_addr bob;
+  std::vector<std::string> log;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(query_scheduler_tests, fixture)
+
+TEST(priority from query options) {
+  CHECK(priority(historical) == query_priority::interactive);
+  CHECK(priority(historical + batch) == query_priority::batch);
+  CHECK(priority(historical + background) == query_priority::background);
+}
+
+TEST(fair share between clients) {
+  MESSAGE("a broad query does not starve a later short one");
+  enqueue(alice, query_priority::interactive, 5, "a1");
+  enqueue(alice, query_priority::interactive, 5, "a2");
+  enqueue(alice, query_priority::interactive, 5, "a3");
+  enqueue(bob, query_priority::interactive, 1, "b1");
+  CHECK_EQUAL(scheduler.size(), 4u);
+  drain();
+  CHECK_EQUAL(log, (std::vector<std::string>{"a1", "b1", "a2", "a3"}));
+  auto& stats = scheduler.stats(query_priority::interactive);
+  CHECK_EQUAL(stats.admitted, 4u);
+  CHECK_EQUAL(stats.dispatched, 4u);
+  CHECK_EQUAL(stats.partitions, 16u);
+}
+
+TEST(weighted share between priorities) {
+  for (auto i = 0; i < 10; ++i)
+    enqueue(bob, query_priority::batch, 1, "batch");
+  for (auto i = 0; i < 10; ++i)
+    enqueue(alice, query_priority::interactive, 1, "interactive");
+  drain(10);
+  auto interactive = std::count(log.begin(), log.end(), "interactive");
+  CHECK_EQUAL(interactive, 8);
+  CHECK_EQUAL(scheduler.size(query_priority::interactive), 2u);
+  CHECK_EQUAL(scheduler.size(query_priority::batch), 8u);
+  MESSAGE("the remaining jobs still run");
+  drain();
+  CHECK(scheduler.empty());
+  CHECK_EQUAL(log.size(), 20u);
+}
+
+TEST(forget) {
+  enqueue(alice, query_priority::interactive, 5, "a1");
+  drain();
+  MESSAGE("alice keeps her usage while her query runs");
+  enqueue(bob, query_priority::interactive, 5, "b1");
+  enqueue(alice, query_priority::interactive, 5, "a2");
+  drain();
+  CHECK_EQUAL(log, (std::vector<std::string>{"b1", "a2"}));
+  MESSAGE("a new query of alice starts without usage");
+  log.clear();
+  scheduler.forget(alice);
+  enqueue(alice, query_priority::interactive, 5, "a3");
+  enqueue(bob, query_priority::interactive, 5, "b2");
+  drain();
+  CHECK_EQUAL(log, (std::vector<std::string>{"a3", "b2"}));
+}
+
+FIXTURE_SCOPE_END()
@@ -23,6 +23,7 @@
 #include "vast/expression.hpp"
 #include "vast/fwd.hpp"
 #include "vast/ids.hpp"
+#include "vast/system/cancellation_token.hpp"
 
 using namespace vast;
 
@@ -68,4 +69,29 @@ TEST(lookup) {
          from(sv).to(self).with(atom::worker_v, sv));
 }
 
+TEST(cancelled lookup) {
+  MESSAGE("spawn supervisor and evaluator");
+  auto sv = sys.spawn(system::query_supervisor, self);
+  run();
+  expect((caf::atom_value, caf::actor),
+         from(sv).to(self).with(atom::worker_v, sv));
+  auto e0 = sys.spawn(dummy_evaluator, make_ids({0, 2, 4}));
+  run();
+  MESSAGE("trigger supervisor with a cancelled query");
+  auto token = system::cancellation_token::make();
+  token.cancel();
+  system::query_map qm{{uuid::random(), {e0}}};
+  self->send(sv, unbox(to<expression>("x == 42")), std::move(qm), token, self);
+  run();
+  MESSAGE("the supervisor should neither ask the evaluator nor wait for it");
+  bool got_hits = false;
+  bool done = false;
+  while (!done)
+    self->receive([&](const ids&) { got_hits = true; },
+                  [&](atom::done) { done = true; });
+  CHECK(!got_hits);
+  expect((caf::atom_value, caf::actor),
+         from(sv).to(self).with(atom::worker_v, sv));
+}
+
 FIXTURE_SCOPE_END()
@@ -0,0 +1,119 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE trigram_index
+
+#include "vast/trigram_index.hpp"
+
+#include "vast/test/test.hpp"
+
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/bitmap.hpp"
+#include "vast/load.hpp"
+#include "vast/save.hpp"
+#include "vast/value_index_factory.hpp"
+
+#include <caf/test/dsl.hpp>
+
+using namespace vast;
+using namespace std::string_literals;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    REQUIRE(idx.append(make_data_view("http://evil.com/login")));
+    REQUIRE(idx.append(make_data_view("http://good.org/evil")));
+    REQUIRE(idx.append(make_data_view(caf::none)));
+    REQUIRE(idx.append(make_data_view("abc-bcd")));
+    REQUIRE(idx.append(make_data_view("ev")));
+  }
+
+  std::string lookup(relational_operator op, data_view x) {
+    return to_string(unbox(idx.lookup(op, x)));
+  }
+
+  trigram_index idx{string_type{}};
+};
+
+} // namespace
+
+TEST(trigram decomposition) {
+  CHECK_EQUAL(trigram_index::trigrams("ab").size(), 0u);
+  CHECK_EQUAL(trigram_index::trigrams("aaaa").size(), 1u);
+  CHECK_EQUAL(trigram_index::trigrams("abcd").size(), 2u);
+}
+
+TEST(required literals) {
+  using strings = std::vector<std::string>;
+  auto literals = [](std::string_view x) {
+    return trigram_index::required_literals(x);
+  };
+  CHECK_EQUAL(literals("foo.*bar"), (strings{"foo", "bar"}));
+  CHECK_EQUAL(literals("https?://evil\\.com/.*"),
+              (strings{"http", "://evil.com/"}));
+  CHECK_EQUAL(literals("a(bc)*def"), (strings{"a", "def"}));
+  CHECK_EQUAL(literals("ab+cd"), (strings{"ab", "bcd"}));
+  CHECK_EQUAL(literals("\\x41bcd"), (strings{"bcd"}));
+  CHECK_EQUAL(literals("abc|def"), strings{});
+}
+
+FIXTURE_SCOPE(trigram_index_tests, fixture)
+
+TEST(substring) {
+  CHECK_EQUAL(lookup(ni, make_data_view("evil")), "11000");
+  CHECK_EQUAL(lookup(ni, make_data_view("zzz")), "00000");
+  MESSAGE("candidates may contain false positives");
+  CHECK_EQUAL(lookup(ni, make_data_view("abcd")), "00010");
+  MESSAGE("short needles and negations are exact");
+  CHECK_EQUAL(lookup(ni, make_data_view("ev")), "11001");
+  CHECK_EQUAL(lookup(not_ni, make_data_view("evil")), "00011");
+}
+
+TEST(patterns) {
+  auto pat = pattern{"http://evil\\.com/.*"};
+  CHECK_EQUAL(lookup(match, make_data_view(pat)), "10000");
+  CHECK_EQUAL(lookup(equal, make_data_view(pat)), "10000");
+  CHECK_EQUAL(lookup(not_match, make_data_view(pat)), "11011");
+  MESSAGE("patterns without required literals match everything");
+  CHECK_EQUAL(lookup(match, make_data_view(pattern{"(foo|bar)"})), "11011");
+}
+
+TEST(equality and membership) {
+  CHECK_EQUAL(lookup(equal, make_data_view("ev")), "00001");
+  CHECK_EQUAL(lookup(not_equal, make_data_view("ev")), "11110");
+  auto xs = vector{"ev"s, "abc-bcd"s};
+  CHECK_EQUAL(lookup(in, make_data_view(xs)), "00011");
+  CHECK(!idx.lookup(less, make_data_view("foo")));
+}
+
+TEST(serialization) {
+  std::vector<char> buf;
+  REQUIRE_EQUAL(save(nullptr, buf, idx), caf::none);
+  trigram_index idx2{string_type{}};
+  REQUIRE_EQUAL(load(nullptr, buf, idx2), caf::none);
+  CHECK_EQUAL(idx2.cardinality(), idx.cardinality());
+  CHECK(idx2.append(make_data_view("more evil")));
+  CHECK_EQUAL(to_string(unbox(idx2.lookup(ni, make_data_view("evil")))),
+              "110001");
+}
+
+// The attribute #index=trigram selects the trigram_index implementation.
+TEST(factory construction) {
+  factory<value_index>::initialize();
+  auto t = string_type{}.attributes({{"index", "trigram"}});
+  auto x = factory<value_index>::make(t, caf::settings{});
+  CHECK(dynamic_cast<trigram_index*>(x.get()) != nullptr);
+}
+
+FIXTURE_SCOPE_END()
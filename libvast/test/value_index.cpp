@@ -25,6 +25,8 @@
 #include "vast/concept/parseable/vast/time.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/bitmap.hpp"
+#include "vast/fbs/utils.hpp"
+#include "vast/fbs/value_index.hpp"
 #include "vast/load.hpp"
 #include "vast/save.hpp"
 #include "vast/table_slice.hpp"
@@ -32,6 +34,9 @@
 
 #include <caf/test/dsl.hpp>
 
+#include <algorithm>
+#include <functional>
+
 using namespace vast;
 using namespace std::string_literals;
 
@@ -496,6 +501,80 @@ TEST(set) {
   CHECK_EQUAL(to_string(*idx2->lookup(ni, make_data_view(42))), "1001");
 }
 
+TEST(flatbuffers) {
+  auto roundtrip = [](const value_index& idx) {
+    auto chunk = unbox(fbs::wrap(idx, fbs::file_identifier));
+    auto flatbuf = fbs::as_flatbuffer<fbs::ValueIndex>(as_bytes(chunk));
+    REQUIRE(flatbuf != nullptr);
+    value_index_ptr result;
+    REQUIRE_EQUAL(unpack(*flatbuf, result, chunk), caf::none);
+    REQUIRE(result != nullptr);
+    return result;
+  };
+  auto check = [](const value_index& x, const value_index& y,
+                  relational_operator op, data_view d) {
+    CHECK_EQUAL(to_string(unbox(x.lookup(op, d))),
+                to_string(unbox(y.lookup(op, d))));
+  };
+  MESSAGE("arithmetic");
+  arithmetic_index<integer> ints{integer_type{}};
+  for (auto i : {-7, 42, 3, 42, 0, 1000})
+    REQUIRE(ints.append(make_data_view(integer{i})));
+  REQUIRE(ints.append(caf::none));
+  auto ints2 = roundtrip(ints);
+  for (auto op : {less, less_equal, equal, not_equal, greater_equal, greater})
+    check(ints, *ints2, op, make_data_view(integer{42}));
+  check(ints, *ints2, equal, caf::none);
+  MESSAGE("appending after unpacking");
+  REQUIRE(ints.append(make_data_view(integer{42})));
+  REQUIRE(ints2->append(make_data_view(integer{42})));
+  check(ints, *ints2, equal, make_data_view(integer{42}));
+  MESSAGE("string");
+  string_index strs{string_type{}};
+  for (auto x : {"foo", "bar", "foobar", "", "baz", "foo"})
+    REQUIRE(strs.append(make_data_view(x)));
+  auto strs2 = roundtrip(strs);
+  check(strs, *strs2, equal, make_data_view("foo"));
+  check(strs, *strs2, not_equal, make_data_view(""));
+  check(strs, *strs2, ni, make_data_view("ba"));
+  MESSAGE("subnet");
+  subnet_index subnets{subnet_type{}};
+  for (auto x : {"192.168.0.0/24", "10.0.0.0/8", "fe80::/10"})
+    REQUIRE(subnets.append(make_data_view(unbox(to<subnet>(x)))));
+  auto subnets2 = roundtrip(subnets);
+  auto sn = unbox(to<subnet>("10.0.0.0/8"));
+  check(subnets, *subnets2, equal, make_data_view(sn));
+  auto addr = unbox(to<address>("192.168.0.42"));
+  check(subnets, *subnets2, ni, make_data_view(addr));
+  MESSAGE("sequence");
+  sequence_index seqs{vector_type{string_type{}}};
+  vector xs{"foo", "bar"};
+  REQUIRE(seqs.append(make_data_view(xs)));
+  xs = {"baz"};
+  REQUIRE(seqs.append(make_data_view(xs)));
+  auto seqs2 = roundtrip(seqs);
+  check(seqs, *seqs2, ni, make_data_view("bar"));
+  MESSAGE("lookups fail after a bitmap fails to decode");
+  auto chunk = unbox(fbs::wrap(ints, fbs::file_identifier));
+  auto flatbuf = fbs::as_flatbuffer<fbs::ValueIndex>(as_bytes(chunk));
+  REQUIRE(flatbuf != nullptr);
+  std::function<void(const fbs::Coder&)> garble = [&](const fbs::Coder& x) {
+    if (auto bitmaps = x.bitmaps())
+      for (auto bm : *bitmaps)
+        if (auto data = bm->data())
+          std::fill_n(const_cast<uint8_t*>(data->data()), data->size(), 0xFF);
+    if (auto components = x.components())
+      for (auto component : *components)
+        garble(*component);
+  };
+  for (auto coder : *flatbuf->coders())
+    garble(*coder);
+  value_index_ptr garbled;
+  REQUIRE_EQUAL(unpack(*flatbuf, garbled, chunk), caf::none);
+  REQUIRE(garbled != nullptr);
+  CHECK(!garbled->lookup(equal, make_data_view(integer{42})));
+}
+
 TEST(none values - string) {
   auto idx = factory<value_index>::make(string_type{}, caf::settings{});
   REQUIRE_NOT_EQUAL(idx, nullptr);
@@ -546,6 +625,38 @@ TEST(none values - arithmetic) {
   CHECK_EQUAL(to_string(unbox(bm)), "00100");
 }
 
+TEST(restricted lookup) {
+  auto strings = factory<value_index>::make(string_type{}, caf::settings{});
+  REQUIRE_NOT_EQUAL(strings, nullptr);
+  REQUIRE(strings->append(make_data_view("foo")));
+  REQUIRE(strings->append(make_data_view("bar")));
+  REQUIRE(strings->append(make_data_view(caf::none)));
+  REQUIRE(strings->append(make_data_view("foo")));
+  REQUIRE(strings->append(make_data_view("baz")));
+  REQUIRE(strings->append(make_data_view("foo")));
+  auto candidates = make_ids({{0, 2}, {4, 6}}, 6);
+  auto bm = strings->lookup(equal, make_data_view("foo"), candidates);
+  CHECK_EQUAL(to_string(unbox(bm)), "100001");
+  bm = strings->lookup(not_equal, make_data_view("foo"), candidates);
+  CHECK_EQUAL(to_string(unbox(bm)), "010010");
+  bm = strings->lookup(equal, make_data_view(caf::none), candidates);
+  CHECK_EQUAL(to_string(unbox(bm)), "000000");
+  bm = strings->lookup(equal, make_data_view("foo"), make_ids({}, 6));
+  CHECK_EQUAL(to_string(unbox(bm)), "000000");
+  address_index addresses{address_type{}};
+  for (auto x : {"10.0.0.1", "10.0.0.2", "10.0.0.1", "10.0.0.1"})
+    REQUIRE(addresses.append(make_data_view(unbox(to<address>(x)))));
+  candidates = make_ids({{1, 3}}, 4);
+  auto x = unbox(to<address>("10.0.0.1"));
+  bm = addresses.lookup(equal, make_data_view(x), candidates);
+  CHECK_EQUAL(to_string(unbox(bm)), "0010");
+  auto y = unbox(to<subnet>("10.0.0.0/24"));
+  bm = addresses.lookup(in, make_data_view(y), candidates);
+  CHECK_EQUAL(to_string(unbox(bm)), "0110");
+  bm = addresses.lookup(not_in, make_data_view(y), candidates);
+  CHECK_EQUAL(to_string(unbox(bm)), "0000");
+}
+
 // This test uncovered a regression that ocurred when computing the rank of a
 // bitmap representing conn.log events. The culprit was the EWAH bitmap
 // encoding, because swapping out ewah_bitmap for null_bitmap in address_index
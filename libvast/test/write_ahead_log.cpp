@@ -0,0 +1,143 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#define SUITE write_ahead_log
+
+#include "vast/write_ahead_log.hpp"
+
+#include "vast/test/test.hpp"
+
+#include "vast/test/fixtures/actor_system_and_events.hpp"
+
+#include "vast/si_literals.hpp"
+#include "vast/table_slice.hpp"
+
+#include <fstream>
+
+using namespace vast;
+using namespace binary_byte_literals;
+
+namespace {
+
+struct fixture : fixtures::deterministic_actor_system_and_events {
+  fixture() {
+    wal_dir = directory / "wal";
+  }
+
+  /// Appends all slices to a fresh log that seals a file after each slice
+  /// when `max_file_size` is 1.
+  void append(const std::vector<table_slice_ptr>& slices,
+              size_t max_file_size) {
+    auto wal = unbox(write_ahead_log::make(wal_dir, max_file_size));
+    for (auto& slice : slices)
+      if (auto err = wal->append(slice))
+        FAIL("append failed: " << err);
+    if (auto err = wal->rotate())
+      FAIL("rotate failed: " << err);
+  }
+
+  /// Replays the log in `wal_dir`.
+  std::vector<table_slice_ptr> replay() {
+    std::vector<table_slice_ptr> result;
+    auto wal = unbox(write_ahead_log::make(wal_dir, 1_MiB));
+    auto n = unbox(
+      wal->replay([&](table_slice_ptr x) { result.push_back(std::move(x)); }));
+    CHECK_EQUAL(n, result.size());
+    return result;
+  }
+
+  /// @returns all log files.
+  std::vector<path> log_files() {
+    std::vector<path> result;
+    for (auto file : vast::directory{wal_dir})
+      if (file.is_regular_file())
+        result.emplace_back(std::move(file));
+    return result;
+  }
+
+  path wal_dir;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(write_ahead_log_tests, fixture)
+
+TEST(replay) {
+  append(zeek_conn_log_slices, 1_MiB);
+  CHECK_EQUAL(log_files().size(), 1u);
+  auto xs = replay();
+  REQUIRE_EQUAL(xs.size(), zeek_conn_log_slices.size());
+  for (size_t i = 0; i < xs.size(); ++i) {
+    CHECK_EQUAL(xs[i]->offset(), zeek_conn_log_slices[i]->offset());
+    CHECK(*xs[i] == *zeek_conn_log_slices[i]);
+  }
+}
+
+TEST(torn tail) {
+  append(zeek_conn_log_slices, 1_MiB);
+  auto files = log_files();
+  REQUIRE_EQUAL(files.size(), 1u);
+  auto size = unbox(file_size(files[0]));
+  {
+    // Simulate a crash in the middle of writing the header of a record.
+    std::ofstream out{files[0].str(), std::ios::app | std::ios::binary};
+    out << "torn";
+  }
+  CHECK_EQUAL(replay().size(), zeek_conn_log_slices.size());
+  CHECK_EQUAL(unbox(file_size(files[0])), size);
+}
+
+TEST(corrupted record) {
+  append(zeek_conn_log_slices, 1_MiB);
+  auto files = log_files();
+  REQUIRE_EQUAL(files.size(), 1u);
+  {
+    // Flip a byte in the payload of the last record.
+    std::fstream io{files[0].str(),
+                    std::ios::in | std::ios::out | std::ios::binary};
+    io.seekp(-1, std::ios::end);
+    io.put('\xff');
+  }
+  CHECK_EQUAL(replay().size(), zeek_conn_log_slices.size() - 1);
+  CHECK_EQUAL(replay().size(), zeek_conn_log_slices.size() - 1);
+}
+
+TEST(truncate) {
+  auto& slices = zeek_conn_log_slices;
+  append(slices, 1);
+  CHECK_EQUAL(log_files().size(), slices.size());
+  auto wal = unbox(write_ahead_log::make(wal_dir, 1_MiB));
+  CHECK_EQUAL(wal->sealed_files(), slices.size());
+  MESSAGE("keep files with IDs at or above the watermark");
+  CHECK_EQUAL(wal->truncate(slices[1]->offset() - 1), caf::none);
+  CHECK_EQUAL(wal->sealed_files(), slices.size());
+  MESSAGE("remove files below the watermark");
+  CHECK_EQUAL(wal->truncate(slices[2]->offset()), caf::none);
+  CHECK_EQUAL(wal->sealed_files(), 1u);
+  CHECK_EQUAL(log_files().size(), 1u);
+  auto xs = replay();
+  REQUIRE_EQUAL(xs.size(), 1u);
+  CHECK(*xs[0] == *slices[2]);
+  MESSAGE("keep the newest file while its end is unknown");
+  auto end = slices[2]->offset() + slices[2]->rows();
+  CHECK_EQUAL(wal->truncate(end), caf::none);
+  CHECK_EQUAL(wal->sealed_files(), 1u);
+  MESSAGE("remove the newest file after replaying it");
+  wal = unbox(write_ahead_log::make(wal_dir, 1_MiB));
+  CHECK_EQUAL(unbox(wal->replay([](table_slice_ptr) {})), 1u);
+  CHECK_EQUAL(wal->truncate(end), caf::none);
+  CHECK_EQUAL(wal->sealed_files(), 0u);
+  CHECK(log_files().empty());
+}
+
+FIXTURE_SCOPE_END()
@@ -15,6 +15,7 @@
 
 #include "vast/bloom_filter_parameters.hpp"
 #include "vast/bloom_filter_synopsis.hpp"
+#include "vast/table_slice_column.hpp"
 
 #include <caf/config_value.hpp>
 #include <caf/settings.hpp>
@@ -23,8 +24,22 @@
 #include <vast/detail/assert.hpp>
 #include <vast/logger.hpp>
 
+#include <vector>
+
 namespace vast {
 
+namespace detail {
+
+/// Decodes all non-null values of an Arrow-backed address column into *xs*.
+/// @param x The column to decode.
+/// @param xs The buffer to append the addresses to.
+/// @returns `false` if *x* is not backed by an Arrow address array, in which
+///          case *xs* remains unchanged.
+bool decode_arrow_addresses(const table_slice_column& x,
+                            std::vector<address>& xs);
+
+} // namespace detail
+
 /// A synopsis for IP addresses.
 template <class HashFunction>
 class address_synopsis final
@@ -39,6 +54,25 @@ public:
     VAST_ASSERT(caf::holds_alternative<address_type>(this->type()));
   }
 
+  using super::add;
+
+  void add(const table_slice_column& x) override {
+    VAST_ASSERT(x.slice != nullptr);
+    // Arrow slices store addresses contiguously, so we decode them in one go
+    // and hash them in a tight loop.
+    std::vector<address> xs;
+    if (detail::decode_arrow_addresses(x, xs)) {
+      for (auto& addr : xs)
+        this->bloom_filter_.add(addr);
+      return;
+    }
+    // Other slices decode the column once; we then hash every address without
+    // going through the virtual `add` per value.
+    x.slice->for_each_in_column(x.column, [this](data_view y) {
+      this->bloom_filter_.add(caf::get<view<address>>(y));
+    });
+  }
+
   bool equals(const synopsis& other) const noexcept override {
     if (typeid(other) != typeid(address_synopsis))
       return false;
@@ -67,7 +67,15 @@ public:
 
   caf::error deserialize(caf::deserializer& source) override;
 
-  void append_column_to_index(size_type col, value_index& idx) const override;
+  void
+  append_column_to_index(size_type col, value_index& idx,
+                         column_statistics* stats = nullptr) const override;
+
+  void for_each_in_column(
+    size_type col, const std::function<void(data_view)>& f) const override;
+
+  ids evaluate_column(size_type col, relational_operator op,
+                      const data& rhs) const override;
 
   caf::atom_value implementation_id() const noexcept override;
 
@@ -19,6 +19,7 @@
 #include "vast/bitmap_base.hpp"
 #include "vast/ewah_bitmap.hpp"
 #include "vast/null_bitmap.hpp"
+#include "vast/roaring_bitmap.hpp"
 #include "vast/wah_bitmap.hpp"
 
 #include "vast/detail/operators.hpp"
@@ -37,7 +38,8 @@ public:
   using types = caf::detail::type_list<
     ewah_bitmap,
     null_bitmap,
-    wah_bitmap
+    wah_bitmap,
+    roaring_bitmap
   >;
 
   using variant = caf::detail::tl_apply_t<types, caf::variant>;
@@ -109,7 +111,8 @@ private:
   using range_variant = caf::variant<
     ewah_bitmap_range,
     null_bitmap_range,
-    wah_bitmap_range
+    wah_bitmap_range,
+    roaring_bitmap_range
   >;
 
   range_variant range_;
@@ -117,6 +120,36 @@ private:
 
 bitmap_bit_range bit_range(const bitmap& bm);
 
+// -- algorithms ---------------------------------------------------------------
+//
+// The following overloads dispatch to the specialized algorithms of the
+// concrete bitmap type when both operands have the same type, and fall back
+// to the generic block-wise algorithms otherwise.
+
+/// @relates bitmap
+bitmap binary_and(const bitmap& lhs, const bitmap& rhs);
+
+/// @relates bitmap
+bitmap binary_or(const bitmap& lhs, const bitmap& rhs);
+
+/// @relates bitmap
+bitmap binary_xor(const bitmap& lhs, const bitmap& rhs);
+
+/// @relates bitmap
+bitmap binary_nand(const bitmap& lhs, const bitmap& rhs);
+
+/// @relates bitmap
+template <bool Bit = true>
+bitmap::size_type rank(const bitmap& bm) {
+  return caf::visit([](const auto& x) { return rank<Bit>(x); }, bm);
+}
+
+/// @relates bitmap
+template <bool Bit = true>
+bitmap::size_type rank(const bitmap& bm, bitmap::size_type i) {
+  return caf::visit([=](const auto& x) { return rank<Bit>(x, i); }, bm);
+}
+
 } // namespace vast
 
 namespace caf {
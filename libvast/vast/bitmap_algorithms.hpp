@@ -14,9 +14,13 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <queue>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <caf/error.hpp>
 
@@ -41,6 +45,21 @@ struct eval_result_type {
 template <class T, class U>
 using eval_result_type_t = typename eval_result_type<T, U>::type;
 
+/// Accesses an element of a bitmap range, which holds either bitmaps or
+/// pointers to bitmaps.
+template <class T>
+const auto& deref_bitmap(const T& x) {
+  if constexpr (std::is_pointer_v<T>)
+    return *x;
+  else
+    return x;
+}
+
+/// The bitmap type of an element in a bitmap range.
+template <class Iterator>
+using range_bitmap_type = std::remove_cv_t<std::remove_pointer_t<
+  typename std::iterator_traits<Iterator>::value_type>>;
+
 } // namespace detail
 
 /// Applies a bitwise operation on two immutable bitmaps, writing the result
@@ -180,6 +199,138 @@ auto nary_eval(Iterator begin, Iterator end, Operation op) {
   return bitmap_type{};
 }
 
+/// Computes the conjunction (*Bit = false*) or disjunction (*Bit = true*) of
+/// multiple bitmaps in a single pass over the run structure of all inputs,
+/// without materializing intermediate results.
+///
+/// The algorithm keeps one cursor per input in a min-heap ordered by the end
+/// position of the cursor's current bit sequence. Between two consecutive
+/// end positions, the sequence of each input is fixed. If any of them is a
+/// run of *Bit*, the output is a run of *Bit* until the longest such run
+/// ends, and the algorithm skips over the sequences of all other inputs up to
+/// that point. If all of them are runs of *!Bit*, the output is a run of
+/// *!Bit*. Otherwise the output is the combination of the literal blocks.
+/// Exhausted inputs count as runs of 0, and the result has the size of the
+/// longest input, just like with the pairwise algorithms.
+/// @tparam Bit The bit that dominates the result, i.e., `false` for AND and
+///             `true` for OR.
+/// @param begin The beginning of the range of bitmaps or bitmap pointers.
+/// @param end The end of the range of bitmaps or bitmap pointers.
+/// @returns The conjunction or disjunction of the bitmaps *[begin,end)*.
+template <bool Bit, class Iterator>
+auto nary_merge(Iterator begin, Iterator end) {
+  using bitmap_type = detail::range_bitmap_type<Iterator>;
+  using range_type = decltype(bit_range(std::declval<const bitmap_type&>()));
+  using bits_type = typename bitmap_type::bits_type;
+  using word_type = typename bits_type::word_type;
+  using size_type = typename bitmap_type::size_type;
+  struct cursor {
+    range_type range;
+    bits_type bits;
+    size_type offset;
+    size_type slot;
+  };
+  static constexpr auto npos = std::numeric_limits<size_type>::max();
+  std::vector<cursor> cursors;
+  auto max_size = size_type{0};
+  for (; begin != end; ++begin) {
+    auto& bm = detail::deref_bitmap(*begin);
+    max_size = std::max(max_size, bm.size());
+    cursors.push_back(cursor{bit_range(bm), {}, 0, npos});
+  }
+  // The heap contains pairs of (end position, cursor index).
+  using entry = std::pair<size_type, size_t>;
+  std::priority_queue<entry, std::vector<entry>, std::greater<entry>> heap;
+  // The number of cursors in a run of the dominating bit, and the position
+  // up to which the result consists of the dominating bit.
+  size_t dominating = 0;
+  auto dominating_end = size_type{0};
+  // The number of exhausted cursors.
+  size_t exhausted = 0;
+  // The indices of the cursors that currently point to a literal block.
+  std::vector<size_t> literals;
+  auto activate = [&](size_t i) {
+    auto& c = cursors[i];
+    if (c.range.done()) {
+      ++exhausted;
+      return;
+    }
+    c.bits = c.range.get();
+    auto last = c.offset + c.bits.size();
+    if (!c.bits.is_run()) {
+      c.slot = literals.size();
+      literals.push_back(i);
+    } else if (static_cast<bool>(c.bits.data()) == Bit) {
+      ++dominating;
+      dominating_end = std::max(dominating_end, last);
+    }
+    heap.emplace(last, i);
+  };
+  auto deactivate = [&](size_t i) {
+    auto& c = cursors[i];
+    if (!c.bits.is_run()) {
+      // Swap-remove the cursor from the literals.
+      cursors[literals.back()].slot = c.slot;
+      literals[c.slot] = literals.back();
+      literals.pop_back();
+      c.slot = npos;
+    } else if (static_cast<bool>(c.bits.data()) == Bit) {
+      --dominating;
+    }
+  };
+  for (size_t i = 0; i < cursors.size(); ++i)
+    activate(i);
+  bitmap_type result;
+  auto pos = size_type{0};
+  while (!heap.empty()) {
+    // Exhausted inputs behave like an infinite run of 0s, which dominates a
+    // conjunction.
+    if constexpr (!Bit)
+      if (exhausted > 0)
+        break;
+    auto next = heap.top().first;
+    if (dominating > 0) {
+      // The result is known until the longest dominating run ends, so we can
+      // skip over the sequences of all other cursors until then.
+      next = dominating_end;
+      result.append_bits(Bit, next - pos);
+    } else if (literals.empty()) {
+      result.append_bits(!Bit, next - pos);
+    } else {
+      auto n = next - pos;
+      VAST_ASSERT(n <= word_type::width);
+      auto data = Bit ? word_type::none : word_type::all;
+      for (auto i : literals) {
+        auto& c = cursors[i];
+        auto x = c.bits.data() >> (pos - c.offset);
+        data = Bit ? data | x : data & x;
+      }
+      result.append(bits_type{data, n});
+    }
+    VAST_ASSERT(next > pos);
+    pos = next;
+    // Advance all cursors whose current sequence ends here, skipping over
+    // sequences that end before the new position. A cursor may then point to
+    // a sequence that began before the new position.
+    while (!heap.empty() && heap.top().first <= pos) {
+      auto i = heap.top().second;
+      heap.pop();
+      deactivate(i);
+      auto& c = cursors[i];
+      c.offset += c.bits.size();
+      c.range.next();
+      while (!c.range.done() && c.offset + c.range.get().size() <= pos) {
+        c.offset += c.range.get().size();
+        c.range.next();
+      }
+      activate(i);
+    }
+  }
+  VAST_ASSERT(result.size() == pos);
+  result.append_bits(false, max_size - pos);
+  return result;
+}
+
 template <class LHS, class RHS>
 auto binary_and(const LHS& lhs, const RHS& rhs) {
   auto op = [](auto x, auto y) { return x & y; };
@@ -210,16 +361,47 @@ auto binary_nor(const LHS& lhs, const RHS& rhs) {
   return binary_eval<true, true>(lhs, rhs, op);
 }
 
+/// Computes the conjunction of multiple bitmaps.
+/// @param begin The beginning of the range of bitmaps or bitmap pointers.
+/// @param end The end of the range of bitmaps or bitmap pointers.
+/// @returns The bitwise AND of the bitmaps *[begin,end)*.
+/// @note Unlike `nary_or`, this folds the operands pairwise with `binary_and`.
+///       The intermediate results of a conjunction quickly turn into runs of
+///       0s, so the fold beats `nary_merge<false>` except for operands with
+///       fewer than about one 1-bit per thousand bits.
 template <class Iterator>
 auto nary_and(Iterator begin, Iterator end) {
-  auto op = [](auto x, auto y) { return x & y; };
-  return nary_eval(begin, end, op);
+  using bitmap_type = detail::range_bitmap_type<Iterator>;
+  using detail::deref_bitmap;
+  if (begin == end)
+    return bitmap_type{};
+  auto result = bitmap_type{deref_bitmap(*begin)};
+  while (++begin != end)
+    result = binary_and(result, deref_bitmap(*begin));
+  return result;
 }
 
+/// Computes the disjunction of multiple bitmaps.
+/// @param begin The beginning of the range of bitmaps or bitmap pointers.
+/// @param end The end of the range of bitmaps or bitmap pointers.
+/// @returns The bitwise OR of the bitmaps *[begin,end)*.
+/// @note For two operands, this falls back to `binary_or`, which may have a
+///       specialized implementation for the bitmap type.
 template <class Iterator>
 auto nary_or(Iterator begin, Iterator end) {
-  auto op = [](auto x, auto y) { return x | y; };
-  return nary_eval(begin, end, op);
+  using bitmap_type = detail::range_bitmap_type<Iterator>;
+  using detail::deref_bitmap;
+  switch (std::distance(begin, end)) {
+    case 0:
+      return bitmap_type{};
+    case 1:
+      return bitmap_type{deref_bitmap(*begin)};
+    case 2:
+      return bitmap_type{
+        binary_or(deref_bitmap(*begin), deref_bitmap(*std::next(begin)))};
+    default:
+      return nary_merge<true>(begin, end);
+  }
 }
 
 template <class Iterator>
@@ -119,6 +119,12 @@ public:
     return coder_;
   }
 
+  /// Accesses the underlying coder of the bitmap index.
+  /// @returns The coder of this bitmap index.
+  coder_type& coder() {
+    return coder_;
+  }
+
   friend bool operator==(const bitmap_index& x, const bitmap_index& y) {
     return x.coder_ == y.coder_;
   }
@@ -36,6 +36,8 @@ public:
     // nop
   }
 
+  using synopsis::add;
+
   void add(data_view x) override {
     bloom_filter_.add(caf::get<view<T>>(x));
   }
@@ -24,6 +24,8 @@ public:
 
   void add(data_view x) override;
 
+  void add(const table_slice_column& x) override;
+
   caf::optional<bool> lookup(relational_operator op,
                              data_view rhs) const override;
 
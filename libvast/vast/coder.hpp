@@ -15,7 +15,10 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <functional>
 #include <limits>
+#include <mutex>
 #include <vector>
 #include <type_traits>
 
@@ -29,6 +32,78 @@
 
 namespace vast {
 
+namespace detail {
+
+/// Keeps track of the bitmaps of a coder that have not been decoded yet, e.g.,
+/// after loading a value index from a memory-mapped file. Decoding happens
+/// under a lock, because concurrent lookups may access the same coder.
+template <class Bitmap>
+class deferred_bitmaps {
+public:
+  /// Decodes the bitmap with a given index.
+  using loader = std::function<void(size_t, Bitmap&)>;
+
+  deferred_bitmaps() = default;
+
+  deferred_bitmaps(const deferred_bitmaps& other) {
+    *this = other;
+  }
+
+  deferred_bitmaps& operator=(const deferred_bitmaps& other) {
+    if (this != &other) {
+      std::scoped_lock guard{mtx_, other.mtx_};
+      f_ = other.f_;
+      pending_ = other.pending_;
+      remaining_ = other.remaining_.load();
+    }
+    return *this;
+  }
+
+  /// Defers decoding of *n* bitmaps until their first access.
+  /// @param n The number of bitmaps.
+  /// @param f The function that decodes a single bitmap.
+  void reset(size_t n, loader f) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    pending_.assign(n, true);
+    remaining_ = n;
+    f_ = n > 0 ? std::move(f) : nullptr;
+  }
+
+  /// Decodes *x*, the bitmap with index *i*, unless that happened before.
+  /// @returns *x*
+  Bitmap& load(size_t i, Bitmap& x) {
+    if (remaining_ == 0)
+      return x;
+    std::lock_guard<std::mutex> guard{mtx_};
+    if (remaining_ > 0 && pending_[i]) {
+      pending_[i] = false;
+      f_(i, x);
+      // Release the loader, and thereby the buffer it references, as soon as
+      // there is nothing left to decode.
+      if (remaining_ == 1) {
+        f_ = nullptr;
+        pending_.clear();
+      }
+      --remaining_;
+    }
+    return x;
+  }
+
+  /// Decodes all bitmaps in *xs* that have not been decoded yet.
+  void load(std::vector<Bitmap>& xs) {
+    for (size_t i = 0; remaining_ > 0 && i < xs.size(); ++i)
+      load(i, xs[i]);
+  }
+
+private:
+  mutable std::mutex mtx_;
+  loader f_;
+  std::vector<bool> pending_;
+  std::atomic<size_t> remaining_ = 0;
+};
+
+} // namespace detail
+
 /// The concept class for bitmap coders. A coder offers two basic primitives:
 /// encoding and decoding of (one or more) values into bitmap storage. The
 /// decoding step is a function of specific relational operator, as supported
@@ -99,22 +174,22 @@ public:
 
   bitmap_type& bitmap_at(size_t index) {
     VAST_ASSERT(index == 0);
-    return bitmap_;
+    return materialize();
   }
 
   const bitmap_type& bitmap_at(size_t index) const {
     VAST_ASSERT(index == 0);
-    return bitmap_;
+    return materialize();
   }
 
   void encode(value_type x, size_type n = 1) {
     VAST_ASSERT(Bitmap::max_size - size() >= n);
-    bitmap_.append_bits(x, n);
+    materialize().append_bits(x, n);
   }
 
   Bitmap decode(relational_operator op, value_type x) const {
     VAST_ASSERT(op == equal || op == not_equal);
-    auto result = bitmap_;
+    auto result = materialize();
     if ((x && op == equal) || (!x && op == not_equal))
       return result;
     result.flip();
@@ -122,32 +197,44 @@ public:
   }
 
   void skip(size_type n) {
-    bitmap_.append_bits(0, n);
+    materialize().append_bits(0, n);
   }
 
   void append(const singleton_coder& other) {
-    bitmap_.append(other.bitmap_);
+    materialize().append(other.materialize());
   }
 
   size_type size() const {
-    return bitmap_.size();
+    return materialize().size();
   }
 
   const Bitmap& storage() const {
-    return bitmap_;
+    return materialize();
+  }
+
+  /// Defers decoding of the bitmap until its first access.
+  /// @param f The function that decodes the bitmap.
+  void defer(typename detail::deferred_bitmaps<Bitmap>::loader f) {
+    bitmap_ = {};
+    deferred_.reset(1, std::move(f));
   }
 
   friend bool operator==(const singleton_coder& x, const singleton_coder& y) {
-    return x.bitmap_ == y.bitmap_;
+    return x.materialize() == y.materialize();
   }
 
   template <class Inspector>
   friend auto inspect(Inspector&f, singleton_coder& sc) {
-    return f(sc.bitmap_);
+    return f(sc.materialize());
   }
 
 private:
-  Bitmap bitmap_;
+  Bitmap& materialize() const {
+    return deferred_.load(0, bitmap_);
+  }
+
+  mutable Bitmap bitmap_;
+  mutable detail::deferred_bitmaps<Bitmap> deferred_;
 };
 
 template <class Bitmap>
@@ -174,21 +261,34 @@ public:
   }
 
   auto& storage() const {
-    return bitmaps_;
+    return materialize();
+  }
+
+  /// Defers decoding of the bitmaps until their first access.
+  /// @param size The number of entries in the coder.
+  /// @param n The number of bitmaps.
+  /// @param f The function that decodes a single bitmap.
+  void defer(size_type size, size_t n,
+             typename detail::deferred_bitmaps<Bitmap>::loader f) {
+    size_ = size;
+    bitmaps_.assign(n, Bitmap{});
+    deferred_.reset(n, std::move(f));
   }
 
   friend bool operator==(const vector_coder& x, const vector_coder& y) {
-    return x.size_ == y.size_ && x.bitmaps_ == y.bitmaps_;
+    return x.size_ == y.size_ && x.materialize() == y.materialize();
   }
 
   template <class Inspector>
   friend auto inspect(Inspector& f, vector_coder& ec) {
-    return f(ec.size_, ec.bitmaps_);
+    return f(ec.size_, ec.materialize());
   }
 
 protected:
   void append(const vector_coder& other, bool bit) {
     VAST_ASSERT(bitmaps_.size() == other.bitmaps_.size());
+    materialize();
+    other.materialize();
     for (auto i = 0u; i < bitmaps_.size(); ++i) {
       bitmaps_[i].append_bits(bit, this->size() - bitmaps_[i].size());
       bitmaps_[i].append(other.bitmaps_[i]);
@@ -196,8 +296,27 @@ protected:
     size_ += other.size_;
   }
 
+  /// Decodes a single bitmap if it has not been accessed before.
+  Bitmap& materialize(size_t i) const {
+    return deferred_.load(i, bitmaps_[i]);
+  }
+
+  /// Decodes the bitmaps in *[first, last)* that have not been accessed
+  /// before.
+  void materialize(size_t first, size_t last) const {
+    for (auto i = first; i < last; ++i)
+      materialize(i);
+  }
+
+  /// Decodes all bitmaps that have not been accessed before.
+  std::vector<Bitmap>& materialize() const {
+    deferred_.load(bitmaps_);
+    return bitmaps_;
+  }
+
   size_type size_;
   mutable std::vector<Bitmap> bitmaps_;
+  mutable detail::deferred_bitmaps<Bitmap> deferred_;
 };
 
 /// Encodes each value in its own bitmap.
@@ -213,7 +332,7 @@ public:
   using super::super;
 
   bitmap_type& lazy_bitmap_at(size_t index) const {
-    auto& result = this->bitmaps_[index];
+    auto& result = this->materialize(index);
     result.append_bits(false, this->size_ - result.size());
     return result;
   }
@@ -243,12 +362,14 @@ public:
       case less: {
         if (x == 0)
           return Bitmap{this->size_, false};
+        this->materialize(0, x);
         auto f = this->bitmaps_.begin();
         auto result = nary_or(f, f + x);
         result.append_bits(false, this->size_ - result.size());
         return result;
       }
       case less_equal: {
+        this->materialize(0, x + 1);
         auto f = this->bitmaps_.begin();
         auto result = nary_or(f, f + x + 1);
         result.append_bits(false, this->size_ - result.size());
@@ -262,6 +383,7 @@ public:
         return result;
       }
       case greater_equal: {
+        this->materialize(x, this->bitmaps_.size());
         auto result = nary_or(this->bitmaps_.begin() + x, this->bitmaps_.end());
         result.append_bits(false, this->size_ - result.size());
         return result;
@@ -269,6 +391,7 @@ public:
       case greater: {
         if (x >= this->bitmaps_.size() - 1)
           return Bitmap{this->size_, false};
+        this->materialize(x + 1, this->bitmaps_.size());
         auto f = this->bitmaps_.begin();
         auto l = this->bitmaps_.end();
         auto result = nary_or(f + x + 1, l);
@@ -301,7 +424,7 @@ public:
   using super::super;
 
   bitmap_type& lazy_bitmap_at(size_t index) const {
-    auto& result = this->bitmaps_[index];
+    auto& result = this->materialize(index);
     result.append_bits(true, this->size_ - result.size());
     return result;
   }
@@ -387,7 +510,7 @@ public:
   using super::super;
 
   bitmap_type& lazy_bitmap_at(size_t index) const {
-    auto& result = this->bitmaps_[index];
+    auto& result = this->materialize(index);
     result.append_bits(false, this->size_ - result.size());
     return result;
   }
@@ -409,6 +532,7 @@ public:
 
   // RangeEval-Opt for the special case with uniform base 2.
   Bitmap decode(relational_operator op, value_type x) const {
+    this->materialize();
     switch (op) {
       default:
         break;
@@ -436,11 +560,25 @@ public:
       }
       case equal:
       case not_equal: {
-        auto result = Bitmap{this->size_, true};
+        // The operands are either the bitmaps themselves or their complements,
+        // which we must materialize first.
+        std::vector<Bitmap> complements;
+        complements.reserve(this->bitmaps_.size());
+        std::vector<const Bitmap*> operands;
+        operands.reserve(this->bitmaps_.size());
         for (auto i = 0u; i < this->bitmaps_.size(); ++i) {
           auto& bm = this->bitmaps_[i];
-          result &= (((x >> i) & 1) ? ~bm : bm);
+          if ((x >> i) & 1) {
+            complements.push_back(~bm);
+            operands.push_back(&complements.back());
+          } else {
+            operands.push_back(&bm);
+          }
         }
+        // Without any slices, every value matches. Otherwise, the bitmaps
+        // don't cover the positions beyond their size, which thus remain 0.
+        auto result = nary_and(operands.begin(), operands.end());
+        result.append_bits(operands.empty(), this->size_ - result.size());
         if (op == not_equal)
           result.flip();
         return result;
@@ -450,10 +588,12 @@ public:
         if (x == 0)
           break;
         x = ~x;
-        auto result = Bitmap{this->size_, false};
+        std::vector<const Bitmap*> operands;
         for (auto i = 0u; i < this->bitmaps_.size(); ++i)
           if (((x >> i) & 1) == 0)
-            result |= this->bitmaps_[i];
+            operands.push_back(&this->bitmaps_[i]);
+        auto result = nary_or(operands.begin(), operands.end());
+        result.append_bits(false, this->size_ - result.size());
         if (op == in)
           result.flip();
         return result;
@@ -546,6 +686,10 @@ public:
     return coders_;
   }
 
+  auto& storage() {
+    return coders_;
+  }
+
   friend bool operator==(const multi_level_coder& x,
                          const multi_level_coder& y) {
     return x.base_ == y.base_ && x.coders_ == y.coders_;
@@ -653,9 +797,11 @@ private:
       bitmap_type> {
     VAST_ASSERT(op == equal || op == not_equal);
     base_.decompose(x, xs_);
-    auto result = coders[0].decode(equal, xs_[0]);
-    for (auto i = 1u; i < base_.size(); ++i)
-      result &= coders[i].decode(equal, xs_[i]);
+    std::vector<bitmap_type> components;
+    components.reserve(base_.size());
+    for (auto i = 0u; i < base_.size(); ++i)
+      components.push_back(coders[i].decode(equal, xs_[i]));
+    auto result = nary_and(components.begin(), components.end());
     if (op == not_equal || op == not_in)
       result.flip();
     return result;
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "vast/bitmap.hpp"
+#include "vast/column_statistics.hpp"
 #include "vast/event.hpp"
 #include "vast/expression.hpp"
 #include "vast/filesystem.hpp"
@@ -63,7 +64,7 @@ public:
 
   // -- properties -------------------------------------------------------------
 
-  /// Adds an event to the index.
+  /// Adds an event to the index and updates the column statistics.
   /// @pre `init()` was called previously.
   void add(const table_slice_column& x);
 
@@ -71,11 +72,32 @@ public:
   /// @pre `init()` was called previously.
   caf::expected<bitmap> lookup(relational_operator op, data_view rhs);
 
+  /// Queries event IDs among `candidates` that fulfill the given predicate.
+  /// @pre `init()` was called previously.
+  caf::expected<bitmap>
+  lookup(relational_operator op, data_view rhs, const ids& candidates);
+
   /// @returns the file name for loading and storing the index.
   const path& filename() const {
     return filename_;
   }
 
+  /// @returns the file name for loading and storing the column statistics.
+  path statistics_filename() const {
+    return filename_ + ".stats";
+  }
+
+  /// @returns the statistics of all values added to this column.
+  const column_statistics& statistics() const {
+    return stats_;
+  }
+
+  /// Estimates the fraction of events that fulfill the given predicate from
+  /// the column statistics.
+  /// @returns the estimate or `caf::none` if the statistics are inconclusive.
+  caf::optional<double> selectivity(relational_operator op,
+                                    data_view rhs) const;
+
   /// Serializes or deserializes a column index.
   template <class Inspector>
   friend auto inspect(Inspector& f, column_index& x) {
@@ -106,6 +128,7 @@ protected:
   // -- member variables -------------------------------------------------------
 
   value_index_ptr idx_;
+  column_statistics stats_;
   bool has_skip_attribute_;
   type index_type_;
   caf::settings index_opts_;
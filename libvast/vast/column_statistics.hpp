@@ -0,0 +1,117 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/data.hpp"
+#include "vast/detail/hyperloglog.hpp"
+#include "vast/operator.hpp"
+#include "vast/view.hpp"
+
+#include <caf/config_value.hpp>
+#include <caf/dictionary.hpp>
+#include <caf/optional.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vast {
+
+/// Summarizes the distribution of the values in a column: the number of
+/// values and nils, an estimate of the number of distinct values, the
+/// smallest and largest value, and the most frequent values.
+class column_statistics {
+public:
+  /// The number of frequent values to track by default.
+  static constexpr size_t default_heavy_hitters = 10;
+
+  /// A frequent value with a lower bound of its number of occurrences.
+  struct heavy_hitter {
+    uint64_t digest;
+    data value;
+    uint64_t count;
+
+    template <class Inspector>
+    friend auto inspect(Inspector& f, heavy_hitter& x) {
+      return f(x.digest, x.value, x.count);
+    }
+  };
+
+  /// Constructs empty statistics.
+  /// @param k The maximum number of frequent values to track.
+  explicit column_statistics(size_t k = default_heavy_hitters);
+
+  /// Adds a value to the statistics.
+  /// @param x The value in the internal representation of the column.
+  void add(data_view x);
+
+  /// Combines the statistics of another column into these statistics, e.g.,
+  /// to summarize the same column across multiple partitions.
+  /// @param other The statistics to merge.
+  void merge(const column_statistics& other);
+
+  /// @returns the number of values, including nils.
+  uint64_t count() const noexcept {
+    return count_;
+  }
+
+  /// @returns the number of nils.
+  uint64_t nulls() const noexcept {
+    return nulls_;
+  }
+
+  /// @returns the estimated number of distinct non-nil values.
+  uint64_t distinct() const noexcept;
+
+  /// @returns the smallest value or nil if there is no ordered value.
+  const data& min() const noexcept {
+    return min_;
+  }
+
+  /// @returns the largest value or nil if there is no ordered value.
+  const data& max() const noexcept {
+    return max_;
+  }
+
+  /// @returns the most frequent values, sorted by descending count.
+  std::vector<heavy_hitter> heavy_hitters() const;
+
+  /// Estimates the fraction of values that satisfy a predicate.
+  /// @param op The operator of the predicate.
+  /// @param x The value of the predicate in the internal representation.
+  /// @returns the estimated selectivity in *[0, 1]* or `caf::none` if the
+  ///          statistics do not allow for an estimate.
+  caf::optional<double> selectivity(relational_operator op, data_view x) const;
+
+  /// @returns a human-readable summary for status reports.
+  caf::dictionary<caf::config_value> status() const;
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, column_statistics& x) {
+    return f(x.count_, x.nulls_, x.distinct_, x.min_, x.max_, x.k_, x.top_);
+  }
+
+private:
+  uint64_t count_ = 0;
+  uint64_t nulls_ = 0;
+  detail::hyperloglog distinct_;
+  data min_;
+  data max_;
+  size_t k_;
+
+  /// The counters of the Misra-Gries summary for frequent values.
+  std::vector<heavy_hitter> top_;
+};
+
+} // namespace vast
@@ -24,8 +24,26 @@ namespace vast {
 enum class compression : int8_t {
   null      = 0,
   lz4       = 1,
+  zstd      = 2,
 };
 
+/// @returns an upper bound for the compressed output.
+/// @param method The compression algorithm.
+/// @param size The size of the uncompressed input.
+size_t compress_bound(compression method, size_t size);
+
+/// Compresses a contiguous byte sequence.
+/// @param method The compression algorithm.
+/// @returns the number of bytes written to *out*, or 0 on failure.
+size_t compress(compression method, const char* in, size_t in_size, char* out,
+                size_t out_size);
+
+/// Uncompresses a contiguous byte sequence.
+/// @param method The compression algorithm that produced *in*.
+/// @returns the number of bytes written to *out*, or 0 on failure.
+size_t uncompress(compression method, const char* in, size_t in_size,
+                  char* out, size_t out_size);
+
 /// The LZ4 compression algorithm.
 namespace lz4 {
 
@@ -40,5 +58,21 @@ size_t compress(const char* in, size_t in_size, char* out, size_t out_size);
 size_t uncompress(const char* in, size_t in_size, char* out, size_t out_size);
 
 } // namespace lz4
+
+/// The Zstandard compression algorithm. All functions fail if VAST was built
+/// without Zstandard support, i.e., `VAST_HAVE_ZSTD` is 0.
+namespace zstd {
+
+/// @returns an upper bound for the compressed output.
+/// @param size The size of the uncompressed input.
+size_t compress_bound(size_t size);
+
+/// Compresses a contiguous byte sequence.
+size_t compress(const char* in, size_t in_size, char* out, size_t out_size);
+
+/// Uncompresses a contiguous byte sequence.
+size_t uncompress(const char* in, size_t in_size, char* out, size_t out_size);
+
+} // namespace zstd
 } // namespace vast
 
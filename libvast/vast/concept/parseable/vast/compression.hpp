@@ -0,0 +1,50 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/compression.hpp"
+#include "vast/concept/parseable/core.hpp"
+
+namespace vast {
+
+struct compression_parser : parser<compression_parser> {
+  using attribute = compression;
+
+  template <class Iterator>
+  bool parse(Iterator& f, const Iterator& l, unused_type) const {
+    using namespace parser_literals;
+    auto p = "null"_p | "lz4" | "zstd";
+    return p(f, l, unused);
+  }
+
+  template <class Iterator>
+  bool parse(Iterator& f, const Iterator& l, compression& x) const {
+    using namespace parser_literals;
+    // clang-format off
+    auto p
+      = ( "null"_p ->* [] { return compression::null; }
+        | "lz4"_p ->* [] { return compression::lz4; }
+        | "zstd"_p ->* [] { return compression::zstd; }
+        );
+    // clang-format on
+    return p(f, l, x);
+  }
+};
+
+template <>
+struct parser_registry<compression> {
+  using type = compression_parser;
+};
+
+} // namespace vast
@@ -33,7 +33,10 @@ struct access::parser<pattern> : vast::parser<access::parser<pattern>> {
 
   template <class Iterator>
   bool parse(Iterator& f, const Iterator& l, pattern& a) const {
-    return pattern_parser{}(f, l, a.str_);
+    if (!pattern_parser{}(f, l, a.str_))
+      return false;
+    a.compile();
+    return true;
   }
 };
 
@@ -329,6 +329,9 @@ constexpr std::string_view db_directory = "vast.db";
 /// Interval between two aging cycles.
 constexpr caf::timespan aging_frequency = std::chrono::hours{24};
 
+/// Interval between two compaction rounds.
+constexpr caf::timespan compaction_interval = std::chrono::minutes{10};
+
 /// Maximum number of events per INDEX partition.
 constexpr size_t max_partition_size = 1'048'576; // 1_Mi
 
@@ -338,18 +341,80 @@ constexpr size_t max_in_mem_partitions = 10;
 /// Number of immediately scheduled INDEX partitions.
 constexpr size_t taste_partitions = 5;
 
+/// Number of threads for loading INDEX partitions from disk.
+constexpr size_t partition_loaders = 4;
+
+/// Number of threads for indexing the columns of new INDEX partitions. Zero
+/// spawns one INDEXER actor per column instead.
+constexpr size_t indexing_threads = 0;
+
+/// Number of consecutive columns of a layout that form one task for the
+/// indexing threads.
+constexpr size_t indexing_task_columns = 16;
+
+/// Maximum number of table slices per partition that wait for the indexing
+/// threads before the INDEX applies back pressure.
+constexpr size_t indexing_backlog = 32;
+
+/// Maximum memory of the INDEX query result cache in MiB.
+constexpr size_t query_cache_size = 64;
+
+/// Minimum number of synopses per thread when the meta index evaluates a
+/// predicate in parallel.
+constexpr size_t meta_index_parallel_lookup_threshold = 4096;
+
 /// Maximum number of concurrent INDEX queries.
 constexpr size_t num_query_supervisors = 10;
 
-/// Number of cached ARCHIVE segments.
-constexpr size_t segments = 10;
+/// Relative share of INDEX workers for interactive queries.
+constexpr uint32_t interactive_query_weight = 8;
+
+/// Relative share of INDEX workers for batch queries.
+constexpr uint32_t batch_query_weight = 2;
+
+/// Relative share of INDEX workers for background queries such as aging.
+constexpr uint32_t background_query_weight = 1;
+
+/// Maximum size of cached ARCHIVE segments in MB.
+constexpr size_t segment_cache_size = 1024;
 
 /// Maximum size of ARCHIVE segments in MB.
 constexpr size_t max_segment_size = 128;
 
+/// Maximum size of a table slice after decompression in MB. Table slices are
+/// much smaller than segments, so a larger size indicates corrupt data.
+constexpr size_t max_table_slice_size = max_segment_size;
+
+/// Compression algorithm for the table slices in ARCHIVE segments, one of
+/// `null`, `lz4`, or `zstd`.
+constexpr std::string_view segment_compression = "lz4";
+
+/// Number of I/O threads for loading ARCHIVE segments in the background.
+constexpr size_t archive_io_threads = 2;
+
+/// Maximum number of segment loads in flight for a single ARCHIVE lookup.
+constexpr size_t archive_prefetch = 4;
+
+/// Maximum rate in MiB/s at which the ARCHIVE rewrites segments to free the
+/// space of erased events.
+constexpr size_t reclaim_rate = 16;
+
+/// Interval between two checks of the ARCHIVE for erased events to reclaim.
+constexpr caf::timespan reclaim_interval = std::chrono::seconds{1};
+
 /// Number of initial IDs to request in the IMPORTER.
 constexpr size_t initially_requested_ids = 128;
 
+/// Whether the IMPORTER logs incoming table slices to a write-ahead log.
+constexpr bool write_ahead_log = false;
+
+/// Maximum size of IMPORTER write-ahead log files in MiB.
+constexpr size_t write_ahead_log_file_size = 64;
+
+/// Interval between two syncs of the IMPORTER write-ahead log.
+constexpr caf::timespan write_ahead_log_sync_interval
+  = std::chrono::milliseconds{100};
+
 /// Rate at which telemetry data is sent to the ACCOUNTANT.
 constexpr std::chrono::milliseconds telemetry_rate = std::chrono::milliseconds{
   1000};
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <limits>
 #include <numeric>
 #include <type_traits>
 
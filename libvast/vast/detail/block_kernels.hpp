@@ -0,0 +1,67 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Vectorized kernels that operate on contiguous arrays of 64-bit blocks, as
+/// they occur in the literal runs of compressed bitmaps. The implementation is
+/// selected once at runtime based on the capabilities of the executing CPU,
+/// with a portable scalar fallback.
+
+namespace vast::detail {
+
+/// The instruction sets for which block kernels exist.
+enum class block_kernel_isa { scalar, sse42, avx2 };
+
+/// @returns the instruction set of the currently active block kernels.
+block_kernel_isa active_block_kernels();
+
+/// Overrides the runtime selection of the block kernels, e.g., to measure the
+/// speedup over the scalar fallback.
+/// @param isa The instruction set to use.
+/// @returns `false` if the CPU does not support *isa*.
+bool select_block_kernels(block_kernel_isa isa);
+
+/// @returns a human-readable name of *isa*.
+const char* to_string(block_kernel_isa isa);
+
+/// Computes `out[i] = x[i] & y[i]` for all *i* in *[0, n)*.
+/// @pre *out* does not partially overlap with *x* or *y*.
+void blocks_and(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                size_t n);
+
+/// Computes `out[i] = x[i] | y[i]` for all *i* in *[0, n)*.
+/// @pre *out* does not partially overlap with *x* or *y*.
+void blocks_or(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n);
+
+/// Computes `out[i] = x[i] ^ y[i]` for all *i* in *[0, n)*.
+/// @pre *out* does not partially overlap with *x* or *y*.
+void blocks_xor(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                size_t n);
+
+/// Computes `out[i] = x[i] & ~y[i]` for all *i* in *[0, n)*.
+/// @pre *out* does not partially overlap with *x* or *y*.
+void blocks_and_not(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                    size_t n);
+
+/// Computes `out[i] = ~x[i]` for all *i* in *[0, n)*.
+/// @pre *out* does not partially overlap with *x*.
+void blocks_not(const uint64_t* x, uint64_t* out, size_t n);
+
+/// Computes the total number of 1-bits in *[xs, xs + n)*.
+uint64_t blocks_popcount(const uint64_t* xs, size_t n);
+
+} // namespace vast::detail
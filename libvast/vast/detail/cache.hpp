@@ -14,10 +14,12 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <unordered_map>
 #include <type_traits>
+#include <utility>
 
 #include <caf/meta/load_callback.hpp>
 
@@ -278,5 +280,291 @@ struct mru {
   }
 };
 
+/// Assigns every cache element the same weight, which bounds the number of
+/// elements in a cache.
+struct unit_weight {
+  template <class T>
+  size_t operator()(const T&) const noexcept {
+    return 1;
+  }
+};
+
+/// A scan-resistant cache that bounds the total weight of its elements, e.g.,
+/// their size in bytes, and evicts according to the *2Q* algorithm by Johnson
+/// and Shasha. New elements enter a FIFO queue that may occupy a quarter of
+/// the capacity before it has to give way. Evicting an element from the FIFO
+/// queue leaves its key behind in a ghost queue, and an element that returns
+/// while its key is still a ghost enters the main LRU queue. Thus, a single
+/// pass over many elements only displaces other elements of the FIFO queue,
+/// but not the working set in the LRU queue.
+template <class Key, class Value, class Weight = unit_weight>
+class two_queue_cache {
+public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<const Key, Value>;
+  using iterator = typename std::list<value_type>::iterator;
+  using const_iterator = typename std::list<value_type>::const_iterator;
+
+  /// Computes the weight of an element.
+  using weight_function = Weight;
+
+  /// Counts cache accesses.
+  struct statistics {
+    uint64_t hits = 0;      ///< Number of successful lookups.
+    uint64_t misses = 0;    ///< Number of unsuccessful lookups.
+    uint64_t evictions = 0; ///< Number of evicted elements.
+  };
+
+  /// Constructs a 2Q cache with a maximum total weight.
+  /// @param capacity The maximum total weight of all elements.
+  /// @param weigh The function that computes the weight of a value.
+  /// @pre `capacity > 0`
+  explicit two_queue_cache(size_t capacity, weight_function weigh = {})
+    : capacity_{capacity}, weigh_{std::move(weigh)} {
+    VAST_ASSERT(capacity_ > 0);
+  }
+
+  // The split between both queues refers into `xs_`.
+  two_queue_cache(const two_queue_cache&) = delete;
+
+  two_queue_cache& operator=(const two_queue_cache&) = delete;
+
+  // -- capacity -------------------------------------------------------------
+
+  /// @returns the maximum total weight of all elements.
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /// Adjusts the capacity and evicts elements if the cache exceeds the new
+  /// capacity.
+  /// @param c the new capacity.
+  /// @pre `c > 0`
+  void capacity(size_t c) {
+    VAST_ASSERT(c > 0);
+    capacity_ = c;
+    shrink(xs_.end());
+    forget_ghosts();
+  }
+
+  /// @returns the total weight of all elements.
+  size_t weight() const {
+    return weight_;
+  }
+
+  /// @returns the number of elements in the cache.
+  size_t size() const {
+    return xs_.size();
+  }
+
+  /// @returns `true` iff the cache holds no elements.
+  bool empty() const {
+    return xs_.empty();
+  }
+
+  /// @returns the access counters.
+  const statistics& stats() const {
+    return stats_;
+  }
+
+  // -- iterators -----------------------------------------------------------
+
+  /// The iteration order visits the FIFO queue from the oldest element first,
+  /// and then the LRU queue from the least recently used element first.
+  auto begin() {
+    return xs_.begin();
+  }
+
+  auto begin() const {
+    return xs_.begin();
+  }
+
+  auto end() {
+    return xs_.end();
+  }
+
+  auto end() const {
+    return xs_.end();
+  }
+
+  // -- modifiers -----------------------------------------------------------
+
+  /// Inserts a fresh element. Evicts other elements until the total weight
+  /// fits into the capacity again, but always keeps the new element.
+  /// @param x The key-value pair to insert.
+  /// @returns An pair of an iterator and boolean flag that indicates whether
+  ///          the element has been added successfully.
+  template <class T>
+  auto insert(T&& x)
+  -> std::enable_if_t<
+    std::is_same_v<std::decay_t<T>, value_type>,
+    std::pair<iterator, bool>
+  > {
+    if (auto i = tracker_.find(x.first); i != tracker_.end()) {
+      access(i->second);
+      return {i->second.pos, false};
+    }
+    auto w = weigh_(x.second);
+    auto frequent = false;
+    if (auto g = ghosts_.find(x.first); g != ghosts_.end()) {
+      ghost_weight_ -= g->second->second;
+      ghost_queue_.erase(g->second);
+      ghosts_.erase(g);
+      frequent = true;
+    }
+    iterator j;
+    if (frequent) {
+      j = xs_.insert(xs_.end(), std::forward<T>(x));
+      if (lru_ == xs_.end())
+        lru_ = j;
+    } else {
+      j = xs_.insert(lru_, std::forward<T>(x));
+      fifo_weight_ += w;
+    }
+    weight_ += w;
+    tracker_.emplace(j->first, slot{j, w, frequent});
+    shrink(j);
+    return {j, true};
+  }
+
+  template <class... Ts>
+  std::pair<iterator, bool> emplace(Ts&&... xs) {
+    return insert(value_type{std::forward<Ts>(xs)...});
+  }
+
+  /// Removes an element for a given key without remembering it as ghost.
+  /// @param x The key to remove.
+  /// @returns The number of elements removed.
+  size_t erase(const key_type& x) {
+    auto i = tracker_.find(x);
+    if (i == tracker_.end())
+      return 0;
+    remove(i);
+    return 1;
+  }
+
+  /// Removes an element without remembering it as ghost.
+  void erase(iterator i) {
+    auto j = tracker_.find(i->first);
+    VAST_ASSERT(j != tracker_.end());
+    remove(j);
+  }
+
+  /// Removes all elements and ghosts from the cache.
+  void clear() {
+    xs_.clear();
+    lru_ = xs_.end();
+    tracker_.clear();
+    ghosts_.clear();
+    ghost_queue_.clear();
+    weight_ = 0;
+    fifo_weight_ = 0;
+    ghost_weight_ = 0;
+  }
+
+  // -- lookup --------------------------------------------------------------
+
+  /// Retrieves an element and counts the access as hit or miss.
+  /// @param x The key to lookup.
+  /// @returns an iterator to the element or `end()`.
+  iterator find(const key_type& x) {
+    auto i = tracker_.find(x);
+    if (i == tracker_.end()) {
+      ++stats_.misses;
+      return xs_.end();
+    }
+    ++stats_.hits;
+    access(i->second);
+    return i->second.pos;
+  }
+
+  /// Checks whether the cache holds an element without accessing it.
+  /// @param x The key to lookup.
+  /// @returns The number of elements for *x*.
+  size_t count(const key_type& x) const {
+    return tracker_.count(x);
+  }
+
+private:
+  struct slot {
+    iterator pos;
+    size_t weight;
+    bool frequent;
+  };
+
+  using ghost_list = std::list<std::pair<Key, size_t>>;
+
+  /// Moves an element of the LRU queue to its back. Elements of the FIFO
+  /// queue stay in place, because a second access shortly after the first
+  /// one does not indicate frequent use.
+  void access(slot& x) {
+    if (!x.frequent)
+      return;
+    if (x.pos == lru_)
+      ++lru_;
+    xs_.splice(xs_.end(), xs_, x.pos);
+    if (lru_ == xs_.end())
+      lru_ = x.pos;
+  }
+
+  /// Evicts elements except for *keep* until the cache fits its capacity.
+  void shrink(iterator keep) {
+    while (weight_ > capacity_ && size() > 1) {
+      // Drain the FIFO queue only while it exceeds its share of the capacity,
+      // unless there is nothing else to evict.
+      auto fifo_first = xs_.begin() != lru_ && xs_.begin() != keep;
+      auto lru_first = lru_ != xs_.end() && lru_ != keep;
+      auto from_fifo = fifo_first
+                       && (fifo_weight_ > capacity_ / 4 || !lru_first);
+      auto i = tracker_.find(from_fifo ? xs_.begin()->first : lru_->first);
+      VAST_ASSERT(i != tracker_.end());
+      if (from_fifo) {
+        ghost_queue_.emplace_back(i->first, i->second.weight);
+        ghosts_.emplace(i->first, std::prev(ghost_queue_.end()));
+        ghost_weight_ += i->second.weight;
+      }
+      remove(i);
+      ++stats_.evictions;
+    }
+    forget_ghosts();
+  }
+
+  /// Limits the ghosts to half the capacity.
+  void forget_ghosts() {
+    while (ghost_weight_ > capacity_ / 2 && !ghost_queue_.empty()) {
+      auto& [key, weight] = ghost_queue_.front();
+      ghost_weight_ -= weight;
+      ghosts_.erase(key);
+      ghost_queue_.pop_front();
+    }
+  }
+
+  void remove(typename std::unordered_map<Key, slot>::iterator i) {
+    auto& x = i->second;
+    if (x.pos == lru_)
+      ++lru_;
+    if (!x.frequent)
+      fifo_weight_ -= x.weight;
+    weight_ -= x.weight;
+    xs_.erase(x.pos);
+    tracker_.erase(i);
+  }
+
+  /// Holds the FIFO queue in `[begin(), lru_)` and the LRU queue in
+  /// `[lru_, end())`.
+  std::list<value_type> xs_;
+  iterator lru_ = xs_.end();
+  std::unordered_map<key_type, slot> tracker_;
+  ghost_list ghost_queue_;
+  std::unordered_map<key_type, typename ghost_list::iterator> ghosts_;
+  size_t capacity_;
+  weight_function weigh_;
+  size_t weight_ = 0;
+  size_t fifo_weight_ = 0;
+  size_t ghost_weight_ = 0;
+  statistics stats_;
+};
+
 } // namespace vast::detail
 
@@ -0,0 +1,62 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vast::detail {
+
+/// A HyperLogLog sketch that estimates the number of distinct elements in a
+/// multiset from their 64-bit hash digests.
+class hyperloglog {
+public:
+  /// The default precision, which yields a standard error of about 1.6%
+  /// with 4 KiB of registers.
+  static constexpr uint8_t default_precision = 12;
+
+  /// Constructs an empty sketch.
+  /// @param precision The number of hash bits that select a register.
+  /// @pre `precision >= 4 && precision <= 18`
+  explicit hyperloglog(uint8_t precision = default_precision);
+
+  /// Adds an element to the sketch.
+  /// @param digest The hash digest of the element.
+  void add(uint64_t digest) noexcept;
+
+  /// Combines the elements of another sketch into this one.
+  /// @param other The sketch to merge.
+  /// @returns `false` if *other* uses a different precision.
+  bool merge(const hyperloglog& other) noexcept;
+
+  /// @returns the estimated number of distinct elements.
+  uint64_t estimate() const noexcept;
+
+  /// @returns the precision of the sketch.
+  uint8_t precision() const noexcept {
+    return precision_;
+  }
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, hyperloglog& x) {
+    return f(x.precision_, x.registers_);
+  }
+
+private:
+  uint8_t precision_;
+  std::vector<uint8_t> registers_;
+};
+
+} // namespace vast::detail
@@ -0,0 +1,134 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vast::detail {
+
+/// A regular expression engine for the ECMAScript syntax of `pattern`. The
+/// automaton compiles a pattern into a Thompson NFA and constructs the states
+/// of the equivalent DFA lazily while matching, so that every input byte costs
+/// a single table lookup once the DFA is warm. A literal prefix of the pattern
+/// serves as a prefilter that rejects or skips input without entering the
+/// automaton.
+///
+/// Constructs that a finite automaton cannot express, such as back references,
+/// lookaheads, and word boundaries, make the automaton fall back to
+/// `std::regex`. So do invalid patterns, such that matching them throws the
+/// same `std::regex_error` as before.
+///
+/// All member functions are safe to call concurrently.
+class regex_automaton {
+public:
+  /// The maximum number of cached DFA states per matching mode. When the cache
+  /// is full, it starts from scratch.
+  static constexpr size_t max_dfa_states = 1024;
+
+  /// The maximum number of NFA states, which bounds the expansion of counted
+  /// repetitions.
+  static constexpr size_t max_nfa_states = 1 << 16;
+
+  /// Compiles a pattern.
+  /// @param pattern The regular expression in ECMAScript syntax.
+  explicit regex_automaton(std::string_view pattern);
+
+  regex_automaton(const regex_automaton&) = delete;
+
+  regex_automaton& operator=(const regex_automaton&) = delete;
+
+  /// Matches a string against the pattern.
+  /// @param str The string to match.
+  /// @returns `true` if the pattern matches exactly *str*.
+  bool match(std::string_view str) const;
+
+  /// Searches the pattern in a string.
+  /// @param str The string to search.
+  /// @returns `true` if the pattern matches inside *str*.
+  bool search(std::string_view str) const;
+
+  /// @returns `true` if the automaton handles the pattern itself instead of
+  /// falling back to `std::regex`.
+  bool native() const;
+
+  /// @returns the literal string that every match begins with.
+  std::string_view literal_prefix() const;
+
+  /// @returns the number of currently cached DFA states.
+  size_t dfa_states() const;
+
+private:
+  using byte_set = std::bitset<256>;
+
+  struct nfa_state {
+    enum kind_type { byte, split, begin, end, accept };
+    kind_type kind;
+    byte_set bytes;
+    uint32_t out = 0;
+    uint32_t out2 = 0;
+  };
+
+  using nfa_set = std::vector<uint32_t>;
+
+  struct dfa_state {
+    nfa_set nfa;
+    std::array<int32_t, 256> next;
+    bool accepting;
+    bool accepting_at_end;
+  };
+
+  struct dfa {
+    std::vector<dfa_state> states;
+    std::map<nfa_set, int32_t> ids;
+    int32_t start = -1;
+    int32_t restart = -1;
+    size_t generation = 0;
+  };
+
+  struct node;
+  class parser;
+
+  uint32_t add(nfa_state x);
+
+  uint32_t compile(const node& x, uint32_t next);
+
+  nfa_set closure(nfa_set xs, bool at_start, bool at_end) const;
+
+  int32_t add(dfa& d, nfa_set xs) const;
+
+  int32_t step(dfa& d, bool unanchored, int32_t s, unsigned char c) const;
+
+  bool run(dfa& d, bool unanchored, std::string_view str, bool at_start) const;
+
+  std::string source_;
+  std::vector<nfa_state> nfa_;
+  uint32_t start_ = 0;
+  nfa_set restart_;
+  std::string prefix_;
+  std::optional<std::regex> fallback_;
+  mutable std::mutex mutex_;
+  mutable dfa anchored_;
+  mutable dfa unanchored_;
+};
+
+} // namespace vast::detail
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vast::detail {
+
+/// A fixed-size pool of threads for running blocking work, e.g., file I/O,
+/// outside of the actor scheduler.
+class thread_pool {
+public:
+  /// Spawns the worker threads.
+  /// @param size The number of threads. A pool without threads runs each job
+  ///             immediately within `submit`.
+  explicit thread_pool(size_t size);
+
+  /// Discards all jobs that did not start yet and joins all threads.
+  ~thread_pool();
+
+  thread_pool(const thread_pool&) = delete;
+
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  /// Schedules a job for execution.
+  /// @param f The function to run on one of the worker threads.
+  /// @returns a future for the result of *f*.
+  template <class F>
+  auto submit(F f) -> std::future<std::invoke_result_t<F>> {
+    using result_type = std::invoke_result_t<F>;
+    // std::function requires copyable targets, hence the extra indirection.
+    auto task = std::make_shared<std::packaged_task<result_type()>>(
+      std::move(f));
+    auto result = task->get_future();
+    enqueue([task = std::move(task)] { (*task)(); });
+    return result;
+  }
+
+  /// @returns the number of worker threads.
+  size_t size() const noexcept {
+    return threads_.size();
+  }
+
+private:
+  void enqueue(std::function<void()> job);
+
+  void run();
+
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> jobs_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+};
+
+} // namespace vast::detail
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vast::detail {
+
+/// A fixed-size pool of threads where each thread owns a queue of jobs. A
+/// thread runs the most recent job of its own queue first and steals the
+/// oldest job of another thread once its own queue runs dry.
+class work_stealing_pool {
+public:
+  /// A unit of work.
+  using job = std::function<void()>;
+
+  /// Spawns the worker threads.
+  /// @param size The number of threads.
+  /// @pre `size > 0`
+  explicit work_stealing_pool(size_t size);
+
+  /// Runs all pending jobs to completion and joins all threads.
+  ~work_stealing_pool();
+
+  work_stealing_pool(const work_stealing_pool&) = delete;
+
+  work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+  /// Schedules a job for execution. Jobs submitted from a worker thread go to
+  /// the queue of that thread, all others get distributed round-robin.
+  /// @param f The function to run on one of the worker threads.
+  void submit(job f);
+
+  /// @returns the number of worker threads.
+  size_t size() const noexcept {
+    return threads_.size();
+  }
+
+  /// @returns the number of jobs that did not start yet.
+  size_t pending() const noexcept {
+    return pending_;
+  }
+
+  /// @returns the number of jobs that ran on another thread than the one
+  ///          they were queued at.
+  uint64_t steals() const noexcept {
+    return steals_;
+  }
+
+private:
+  struct queue {
+    std::mutex mtx;
+    std::deque<job> jobs;
+  };
+
+  bool pop(size_t i, job& f);
+
+  bool steal(size_t i, job& f);
+
+  void run(size_t i);
+
+  std::vector<std::unique_ptr<queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> pending_ = 0;
+  std::atomic<size_t> next_ = 0;
+  std::atomic<uint64_t> steals_ = 0;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+};
+
+} // namespace vast::detail
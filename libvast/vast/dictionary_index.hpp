@@ -0,0 +1,74 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/ewah_bitmap.hpp"
+#include "vast/value_index.hpp"
+#include "vast/view.hpp"
+
+#include <caf/deserializer.hpp>
+#include <caf/expected.hpp>
+#include <caf/serializer.hpp>
+#include <caf/settings.hpp>
+
+#include <functional>
+#include <map>
+#include <string>
+
+namespace vast {
+
+/// An index for strings that maps every distinct value to the bitmap of its
+/// positions. The values form a sorted dictionary, which answers equality and
+/// membership queries with a single lookup per value, prefix patterns with a
+/// range scan, and all other patterns and substring searches by testing each
+/// distinct value once instead of once per position. The index is a good fit
+/// for long strings, such as URIs or user agents, with a moderate number of
+/// distinct values. Choose it per field with the attribute
+/// `#index=dictionary`.
+class dictionary_index : public value_index {
+public:
+  /// Constructs a dictionary index.
+  /// @param t An instance of `string_type`.
+  /// @param opts Runtime context for index parameterization.
+  explicit dictionary_index(vast::type t, caf::settings opts = {});
+
+  /// @returns the number of distinct values in the index.
+  size_t cardinality() const;
+
+  caf::error serialize(caf::serializer& sink) const override;
+
+  caf::error deserialize(caf::deserializer& source) override;
+
+private:
+  using dictionary_type = std::map<std::string, ewah_bitmap, std::less<>>;
+
+  bool append_impl(data_view x, id pos) override;
+
+  caf::expected<ids>
+  lookup_impl(relational_operator op, data_view x) const override;
+
+  /// Computes the union of the bitmaps of all values in a range of the
+  /// dictionary that satisfy a predicate.
+  /// @param first The first dictionary entry to consider.
+  /// @param last The end of the range.
+  /// @param pred The predicate on the values.
+  /// @param negate Whether to flip the result.
+  /// @returns The union of the bitmaps, padded to the size of the index.
+  template <class Iterator, class Predicate>
+  ids collect(Iterator first, Iterator last, Predicate pred, bool negate) const;
+
+  dictionary_type dictionary_;
+};
+
+} // namespace vast
@@ -85,6 +85,8 @@ enum class ec : uint8_t {
   silent,
   /// Insufficient memory.
   out_of_memory,
+  /// The operation was abandoned because its query got cancelled.
+  cancelled,
   /// No error; number of error codes.
   ec_count,
 };
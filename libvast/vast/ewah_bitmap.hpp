@@ -104,6 +104,11 @@ public:
 
   const block_vector& blocks() const;
 
+  /// @returns the number of 1-bits in the bitmap.
+  /// @note Counts clean words via their markers and the dirty words with
+  ///       vectorized population counts.
+  size_type cardinality() const;
+
   // -- modifiers ------------------------------------------------------------
 
   void append_bit(bool bit);
@@ -112,6 +117,13 @@ public:
 
   void append_block(block_type bits, size_type n = word_type::width);
 
+  /// Appends a sequence of full blocks. This is equivalent to, but faster
+  /// than, calling `append_block` for each block.
+  /// @param xs The blocks to append.
+  /// @param n The number of blocks in *xs*.
+  /// @pre `size() % word_type::width == 0`
+  void append_blocks(const block_type* xs, size_type n);
+
   void flip();
 
   // -- concepts -------------------------------------------------------------
@@ -138,6 +150,32 @@ private:
   size_type num_bits_ = 0;
 };
 
+// -- algorithms ---------------------------------------------------------------
+//
+// The following overloads take precedence over the generic block-wise
+// algorithms. They walk the runs of clean and dirty words of both operands in
+// lockstep, so that clean runs combine in constant time and overlapping dirty
+// runs go through the vectorized kernels in `vast/detail/block_kernels.hpp`.
+
+/// @relates ewah_bitmap
+ewah_bitmap binary_and(const ewah_bitmap& lhs, const ewah_bitmap& rhs);
+
+/// @relates ewah_bitmap
+ewah_bitmap binary_or(const ewah_bitmap& lhs, const ewah_bitmap& rhs);
+
+/// @relates ewah_bitmap
+ewah_bitmap binary_xor(const ewah_bitmap& lhs, const ewah_bitmap& rhs);
+
+/// @relates ewah_bitmap
+ewah_bitmap binary_nand(const ewah_bitmap& lhs, const ewah_bitmap& rhs);
+
+/// @relates ewah_bitmap
+template <bool Bit = true>
+ewah_bitmap::size_type rank(const ewah_bitmap& bm) {
+  auto n = bm.cardinality();
+  return Bit ? n : bm.size() - n;
+}
+
 class ewah_bitmap_range
   : public bit_range_base<ewah_bitmap_range, ewah_bitmap::block_type> {
 public:
@@ -16,6 +16,7 @@
 #include "vast/detail/assert.hpp"
 #include "vast/error.hpp"
 #include "vast/expression.hpp"
+#include "vast/ids.hpp"
 #include "vast/offset.hpp"
 #include "vast/operator.hpp"
 #include "vast/time.hpp"
@@ -225,6 +226,43 @@ struct table_slice_row_evaluator {
   relational_operator op_;
 };
 
+/// Evaluates an entire table slice over a [resolved](@ref type_extractor)
+/// expression, one column at a time. Every predicate maps to a single pass
+/// over the referenced column via table_slice::evaluate_column, and the
+/// connectives combine the resulting bitmaps.
+struct table_slice_column_evaluator {
+  explicit table_slice_column_evaluator(const table_slice& slice);
+
+  ids operator()(caf::none_t);
+  ids operator()(const conjunction& c);
+  ids operator()(const disjunction& d);
+  ids operator()(const negation& n);
+  ids operator()(const predicate& p);
+  ids operator()(const attribute_extractor& e, const data& d);
+  ids operator()(const key_extractor&, const data&);
+  ids operator()(const type_extractor&, const data&);
+  ids operator()(const data_extractor& e, const data& d);
+
+  template <class T>
+  ids operator()(const data& d, const T& x) {
+    return (*this)(x, d);
+  }
+
+  template <class T, class U>
+  ids operator()(const T&, const U&) {
+    return none();
+  }
+
+  /// @returns a bitmap where no row of the slice is selected.
+  ids none() const;
+
+  /// @returns a bitmap where all rows of the slice are selected.
+  ids all() const;
+
+  const table_slice& slice_;
+  relational_operator op_;
+};
+
 /// Evaluates a single row of a table slice over a [resolved](@ref
 /// type_extractor) expression.
 /// @param slice The table slice for evaluation.
@@ -240,6 +278,7 @@ bool evaluate_at(const table_slice& slice, size_t row, const expression& expr);
 /// @param slice The table slice for evaluation.
 /// @param expr A resolved expression for evaluating all rows in `slice`.
 /// @returns a bitmap containing all IDs of matching rows.
+/// @relates table_slice_column_evaluator
 ids evaluate(const table_slice& slice, const expression& expr);
 
 /// Checks whether a [resolved](@ref type_extractor) expression matches a given
@@ -237,6 +237,10 @@ public:
   /// @returns `true` on success.
   bool write(const void* source, size_t size, size_t* put = nullptr);
 
+  /// Flushes all written bytes from the OS buffers to the storage device.
+  /// @returns `true` on success.
+  bool sync();
+
   /// Seeks the file forward.
   /// @param bytes The number of bytes to seek forward relative to the current
   ///              position.
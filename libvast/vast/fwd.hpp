@@ -37,6 +37,7 @@ class caf_table_slice;
 class caf_table_slice_builder;
 class chunk;
 class column_index;
+class column_statistics;
 class command;
 class data;
 class event;
@@ -62,10 +63,12 @@ class type;
 class uuid;
 class value;
 class value_index;
+class write_ahead_log;
 
 namespace system {
 
 class application;
+class cancellation_token;
 class configuration;
 class default_application;
 class export_command;
@@ -106,12 +109,15 @@ struct record_type;
 struct set_type;
 struct string_type;
 struct subnet_type;
+struct table_slice_column;
 struct time_type;
 struct type_extractor;
 struct vector_type;
 
 namespace system {
 
+struct compacted_partition;
+struct compaction_candidates;
 struct component_state_map;
 struct component_map_entry;
 struct component_map;
@@ -210,6 +216,8 @@ CAF_BEGIN_TYPE_ID_BLOCK(vast, caf::first_custom_type_id)
   VAST_ADD_ATOM(accept, "accept")
   VAST_ADD_ATOM(announce, "announce")
   VAST_ADD_ATOM(batch, "batch")
+  VAST_ADD_ATOM(checkpoint, "checkpoint")
+  VAST_ADD_ATOM(compact, "compact")
   VAST_ADD_ATOM(continuous, "continuous")
   VAST_ADD_ATOM(cpu, "cpu")
   VAST_ADD_ATOM(data, "data")
@@ -243,6 +251,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(vast, caf::first_custom_type_id)
   VAST_ADD_ATOM(publish, "publish")
   VAST_ADD_ATOM(query, "query")
   VAST_ADD_ATOM(read, "read")
+  VAST_ADD_ATOM(reclaim, "reclaim")
   VAST_ADD_ATOM(replicate, "replicate")
   VAST_ADD_ATOM(request, "request")
   VAST_ADD_ATOM(response, "response")
@@ -271,6 +280,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(vast, caf::first_custom_type_id)
   VAST_ADD_ATOM(accountant, "accountant")
   VAST_ADD_ATOM(archive, "archive")
   VAST_ADD_ATOM(candidate, "candidate")
+  VAST_ADD_ATOM(compactor, "compactor")
   VAST_ADD_ATOM(eraser, "eraser")
   VAST_ADD_ATOM(exporter, "exporter")
   VAST_ADD_ATOM(follower, "follower")
@@ -296,6 +306,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(vast, caf::first_custom_type_id)
 
   VAST_ADD_TYPE_ID((vast::attribute_extractor))
   VAST_ADD_TYPE_ID((vast::bitmap))
+  VAST_ADD_TYPE_ID((vast::column_statistics))
   VAST_ADD_TYPE_ID((vast::conjunction))
   VAST_ADD_TYPE_ID((vast::curried_predicate))
   VAST_ADD_TYPE_ID((vast::data))
@@ -306,6 +317,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(vast, caf::first_custom_type_id)
   VAST_ADD_TYPE_ID((vast::expression))
   VAST_ADD_TYPE_ID((vast::invocation))
   VAST_ADD_TYPE_ID((vast::key_extractor))
+  VAST_ADD_TYPE_ID((vast::meta_index))
   VAST_ADD_TYPE_ID((vast::negation))
   VAST_ADD_TYPE_ID((vast::path))
   VAST_ADD_TYPE_ID((vast::predicate))
@@ -317,6 +329,9 @@ CAF_BEGIN_TYPE_ID_BLOCK(vast, caf::first_custom_type_id)
   VAST_ADD_TYPE_ID((vast::type_extractor))
   VAST_ADD_TYPE_ID((vast::uuid))
 
+  VAST_ADD_TYPE_ID((vast::system::cancellation_token))
+  VAST_ADD_TYPE_ID((vast::system::compacted_partition))
+  VAST_ADD_TYPE_ID((vast::system::compaction_candidates))
   VAST_ADD_TYPE_ID((vast::system::component_map))
   VAST_ADD_TYPE_ID((vast::system::component_map_entry))
   VAST_ADD_TYPE_ID((vast::system::performance_report))
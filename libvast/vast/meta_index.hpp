@@ -17,10 +17,13 @@
 #include "vast/fwd.hpp"
 #include "vast/qualified_record_field.hpp"
 #include "vast/synopsis.hpp"
+#include "vast/time.hpp"
 #include "vast/type.hpp"
 #include "vast/uuid.hpp"
 
 #include <caf/fwd.hpp>
+#include <caf/meta/load_callback.hpp>
+#include <caf/optional.hpp>
 #include <caf/settings.hpp>
 
 #include <functional>
@@ -36,17 +39,42 @@ namespace vast {
 /// data. The meta index may return false positives but never false negatives.
 class meta_index {
 public:
+  /// The range of event timestamps in a partition.
+  struct time_bounds {
+    time first; ///< The oldest timestamp.
+    time last;  ///< The newest timestamp.
+  };
+
   /// Adds all data from a table slice belonging to a given partition to the
   /// index.
   /// @param slice The table slice to extract data from.
   /// @param partition The partition ID that *slice* belongs to.
-  void add(const uuid& partition, const table_slice& slice);
+  void add(const uuid& partition, const table_slice_ptr& slice);
 
   /// Retrieves the list of candidate partition IDs for a given expression.
   /// @param expr The expression to lookup.
   /// @returns A vector of UUIDs representing candidate partitions.
   std::vector<uuid> lookup(const expression& expr) const;
 
+  /// Retrieves the range of event timestamps in a partition from the synopses
+  /// of all columns with the `#timestamp` attribute.
+  /// @param partition The partition ID.
+  /// @returns the time bounds of *partition* or `none` if the meta index has
+  ///          no timestamps for it.
+  caf::optional<time_bounds> bounds(const uuid& partition) const;
+
+  /// @returns the sorted IDs of all partitions in the index.
+  std::vector<uuid> partitions() const;
+
+  /// Removes all synopses of a partition.
+  /// @param partition The partition ID.
+  void erase(const uuid& partition);
+
+  /// Adds the synopses of all partitions in another meta index, replacing
+  /// existing synopses of the same partitions.
+  /// @param other The meta index to take the synopses from.
+  void merge(const meta_index& other);
+
   /// Gets the options for the synopsis factory.
   /// @returns A reference to the synopsis options.
   caf::settings& factory_options();
@@ -56,7 +84,12 @@ public:
   // Allow debug printing meta_index instances.
   template <class Inspector>
   friend auto inspect(Inspector& f, meta_index& x) {
-    return f(x.synopsis_options_, x.synopses_);
+    auto load = [&]() -> caf::error {
+      x.rebuild_catalog();
+      return caf::none;
+    };
+    return f(x.synopsis_options_, x.synopses_,
+             caf::meta::load_callback(load));
   }
 
 private:
@@ -64,9 +97,30 @@ private:
   using partition_synopsis
     = std::unordered_map<qualified_record_field, synopsis_ptr>;
 
+  /// Refers to the synopsis of a column in a single partition.
+  using catalog_entry = std::pair<uuid, synopsis_ptr>;
+
+  /// Maps each column to its synopses across all partitions. This inverts
+  /// `synopses_` such that a predicate needs to match against every column
+  /// only once instead of once per partition.
+  using field_catalog
+    = std::unordered_map<qualified_record_field, std::vector<catalog_entry>>;
+
+  /// Recomputes the catalog from the per-partition synopses.
+  void rebuild_catalog();
+
+  /// Evaluates a predicate against a list of synopses, possibly in parallel.
+  /// @returns the sorted IDs of all partitions whose synopsis does not rule
+  ///          out a match.
+  std::vector<uuid> probe(const std::vector<const catalog_entry*>& entries,
+                          relational_operator op, const data& rhs) const;
+
   /// Maps a partition ID to the synopses for that partition.
   std::unordered_map<uuid, partition_synopsis> synopses_;
 
+  /// The inverted index over `synopses_`.
+  field_catalog catalog_;
+
   /// Settings for the synopsis factory.
   caf::settings synopsis_options_;
 };
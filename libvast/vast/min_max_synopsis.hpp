@@ -33,13 +33,12 @@ public:
     // nop
   }
 
+  using synopsis::add;
+
   void add(data_view x) override {
     auto y = caf::get_if<view<T>>(&x);
     VAST_ASSERT(y != nullptr);
-    if (*y < min_)
-      min_ = *y;
-    if (*y > max_)
-      max_ = *y;
+    update(*y, *y);
   }
 
   caf::optional<bool> lookup(relational_operator op,
@@ -98,6 +97,15 @@ public:
     return max_;
   }
 
+protected:
+  /// Widens the range of the synopsis to include `[lo, hi]`.
+  void update(T lo, T hi) {
+    if (lo < min_)
+      min_ = lo;
+    if (hi > max_)
+      max_ = hi;
+  }
+
 private:
   bool lookup_impl(relational_operator op, const T x) const {
     // Let *min* and *max* constitute the LHS of the lookup operation and *rhs*
@@ -70,7 +70,15 @@ public:
   caf::error load(vast::chunk_ptr chunk) override;
 
   void
-  append_column_to_index(size_type col, vast::value_index& idx) const override;
+  append_column_to_index(size_type col, vast::value_index& idx,
+                         column_statistics* stats = nullptr) const override;
+
+  void for_each_in_column(size_type col,
+                          const std::function<void(vast::data_view)>& f)
+    const override;
+
+  vast::ids evaluate_column(size_type col, vast::relational_operator op,
+                            const vast::data& rhs) const override;
 
   caf::atom_value implementation_id() const noexcept override;
 
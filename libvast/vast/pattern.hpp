@@ -13,21 +13,34 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
+#include <caf/error.hpp>
+#include <caf/meta/load_callback.hpp>
+
 #include "vast/detail/operators.hpp"
 
 namespace vast {
 
 struct access;
 class json;
+class pattern_view;
+
+namespace detail {
+
+class regex_automaton;
 
-/// A regular expression.
+} // namespace detail
+
+/// A regular expression. The pattern compiles into an automaton once, which
+/// all copies of the pattern share.
 class pattern : detail::totally_ordered<pattern>,
                 detail::addable<pattern>,
                 detail::orable<pattern>,
                 detail::andable<pattern> {
   friend access;
+  friend pattern_view;
 
 public:
   /// Constructs a pattern from a glob expression. A glob expression consists
@@ -89,13 +102,21 @@ public:
 
   template <class Inspector>
   friend auto inspect(Inspector& f, pattern& p) {
-    return f(p.str_);
+    auto load = [&]() -> caf::error {
+      p.compile();
+      return caf::none;
+    };
+    return f(p.str_, caf::meta::load_callback(load));
   }
 
   friend bool convert(const pattern& p, json& j);
 
 private:
+  /// Compiles the automaton for the current pattern string.
+  void compile();
+
   std::string str_;
+  std::shared_ptr<const detail::regex_automaton> automaton_;
 };
 
 } // namespace vast
@@ -23,7 +23,10 @@ namespace vast {
 enum class query_options : uint32_t {
   none = 0x00,
   historical = 0x01,
-  continuous = 0x02
+  continuous = 0x02,
+  oldest_first = 0x04,
+  batch = 0x08,
+  background = 0x10
 };
 
 /// Concatenates two query options.
@@ -37,6 +40,9 @@ constexpr query_options no_query_options = query_options::none;
 constexpr query_options historical = query_options::historical;
 constexpr query_options continuous = query_options::continuous;
 constexpr query_options unified = historical + continuous;
+constexpr query_options oldest_first = query_options::oldest_first;
+constexpr query_options batch = query_options::batch;
+constexpr query_options background = query_options::background;
 
 constexpr bool has_query_option(query_options haystack, query_options needle) {
   return (static_cast<uint32_t>(haystack) & static_cast<uint32_t>(needle)) != 0;
@@ -50,6 +56,22 @@ constexpr bool has_continuous_option(query_options opts) {
   return has_query_option(opts, continuous);
 }
 
+/// Historical queries evaluate the most recent partitions first unless this
+/// option is set.
+constexpr bool has_oldest_first_option(query_options opts) {
+  return has_query_option(opts, oldest_first);
+}
+
+/// Batch queries yield INDEX workers to interactive queries.
+constexpr bool has_batch_option(query_options opts) {
+  return has_query_option(opts, batch);
+}
+
+/// Background queries, such as aging, yield INDEX workers to all others.
+constexpr bool has_background_option(query_options opts) {
+  return has_query_option(opts, background);
+}
+
 constexpr bool has_unified_option(query_options opts) {
   return has_query_option(opts, historical)
          && has_query_option(opts, continuous);
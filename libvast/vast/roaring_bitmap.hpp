@@ -0,0 +1,240 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/bitmap_base.hpp"
+
+#include "vast/detail/operators.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace vast {
+
+class roaring_bitmap_range;
+
+/// A bitmap in the style of *Roaring* (Chambi et al., 2016). The bitmap
+/// partitions the bit positions into chunks of 2^16 bits, keyed by the upper
+/// bits of a position. Only chunks with at least one 1-bit have a container,
+/// which picks the most compact of three representations:
+///
+/// 1. *array*: the sorted 16-bit offsets of all 1-bits,
+/// 2. *bitset*: an uncompressed sequence of 2^16 bits,
+/// 3. *run*: the sorted intervals of 1-bits.
+///
+/// Unlike the run-length encoded bitmaps, a Roaring bitmap offers random
+/// access in logarithmic time and performs well on sparse or randomly
+/// distributed 1-bits. Long runs of 0-bits are free, but complementing a
+/// bitmap materializes a container for every chunk.
+///
+/// The implementation maintains the following invariants:
+///
+/// 1. Containers are sorted by key and no container is empty.
+/// 2. All 1-bits have a position less than `size()`.
+class roaring_bitmap : public bitmap_base<roaring_bitmap>,
+                       detail::equality_comparable<roaring_bitmap> {
+  friend roaring_bitmap_range;
+
+public:
+  /// The number of bits per container.
+  static constexpr size_type container_bits = size_type{1} << 16;
+
+  /// The number of blocks of a bitset container.
+  static constexpr size_type container_blocks
+    = container_bits / word_type::width;
+
+  /// The maximum cardinality of an array container.
+  static constexpr uint32_t max_array_cardinality = 4096;
+
+  /// The representation of a single container.
+  enum class container_kind : uint8_t { array, bitset, run };
+
+  /// The 1-bits of a chunk of `container_bits` bits.
+  struct container : detail::equality_comparable<container> {
+    /// The position of the first bit in the chunk, divided by
+    /// `container_bits`.
+    size_type key = 0;
+
+    /// The number of 1-bits in the container.
+    uint32_t cardinality = 0;
+
+    /// The representation of the 1-bits.
+    container_kind kind = container_kind::array;
+
+    /// For array containers, the sorted offsets of all 1-bits. For run
+    /// containers, consecutive pairs of first and last offset of a run.
+    std::vector<uint16_t> values;
+
+    /// For bitset containers, the `container_blocks` blocks of the chunk.
+    std::vector<block_type> blocks;
+
+    friend bool operator==(const container& x, const container& y);
+
+    template <class Inspector>
+    friend auto inspect(Inspector& f, container& x) {
+      return f(x.key, x.cardinality, x.kind, x.values, x.blocks);
+    }
+  };
+
+  using container_vector = std::vector<container>;
+
+  roaring_bitmap() = default;
+
+  explicit roaring_bitmap(size_type n, bool bit = false);
+
+  // -- inspectors -----------------------------------------------------------
+
+  bool empty() const;
+
+  size_type size() const;
+
+  const container_vector& containers() const;
+
+  /// @returns the number of 1-bits in the bitmap.
+  size_type cardinality() const;
+
+  /// Counts the 1-bits in the range *[0, i]*.
+  /// @param i The position up to and including where to count.
+  /// @returns The number of 1-bits in *[0, i]*.
+  /// @pre `i < size()`
+  size_type cardinality(size_type i) const;
+
+  // -- element access -------------------------------------------------------
+
+  /// Accesses the *i*-th bit in logarithmic time.
+  /// @param i The index into the bitmap.
+  /// @returns `true` iff bit *i* is 1.
+  /// @pre `i < size()`
+  bool operator[](size_type i) const;
+
+  // -- modifiers ------------------------------------------------------------
+
+  void append_bit(bool bit);
+
+  void append_bits(bool bit, size_type n);
+
+  void append_block(block_type bits, size_type n = word_type::width);
+
+  void flip();
+
+  // -- bitwise operations ---------------------------------------------------
+
+  roaring_bitmap& operator&=(const roaring_bitmap& other);
+
+  roaring_bitmap& operator|=(const roaring_bitmap& other);
+
+  roaring_bitmap& operator^=(const roaring_bitmap& other);
+
+  roaring_bitmap& operator-=(const roaring_bitmap& other);
+
+  // -- concepts -------------------------------------------------------------
+
+  friend bool operator==(const roaring_bitmap& x, const roaring_bitmap& y);
+
+  friend roaring_bitmap
+  binary_and(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  friend roaring_bitmap
+  binary_or(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  friend roaring_bitmap
+  binary_xor(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  friend roaring_bitmap
+  binary_nand(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, roaring_bitmap& bm) {
+    return f(bm.containers_, bm.num_bits_);
+  }
+
+private:
+  /// Returns the container for the chunk at the end of the bitmap, creating
+  /// it if necessary.
+  container& tail(size_type key);
+
+  /// Merges the containers of two bitmaps. Containers with the same key go
+  /// through `f`, all others are kept only if the corresponding flag is set.
+  template <bool KeepLhs, bool KeepRhs, class Combine>
+  static roaring_bitmap
+  merge(const roaring_bitmap& lhs, const roaring_bitmap& rhs, Combine f);
+
+  container_vector containers_;
+  size_type num_bits_ = 0;
+};
+
+// -- algorithms ---------------------------------------------------------------
+//
+// The following overloads take precedence over the generic block-wise
+// algorithms and operate container by container instead.
+
+/// @relates roaring_bitmap
+roaring_bitmap binary_and(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+/// @relates roaring_bitmap
+roaring_bitmap binary_or(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+/// @relates roaring_bitmap
+roaring_bitmap binary_xor(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+/// @relates roaring_bitmap
+roaring_bitmap
+binary_nand(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+/// @relates roaring_bitmap
+template <bool Bit = true>
+roaring_bitmap::size_type rank(const roaring_bitmap& bm) {
+  auto n = bm.cardinality();
+  return Bit ? n : bm.size() - n;
+}
+
+/// @relates roaring_bitmap
+template <bool Bit = true>
+roaring_bitmap::size_type
+rank(const roaring_bitmap& bm, roaring_bitmap::size_type i) {
+  auto n = bm.cardinality(i);
+  return Bit ? n : i + 1 - n;
+}
+
+class roaring_bitmap_range
+  : public bit_range_base<roaring_bitmap_range, roaring_bitmap::block_type> {
+public:
+  using word_type = roaring_bitmap::word_type;
+
+  roaring_bitmap_range() = default;
+
+  explicit roaring_bitmap_range(const roaring_bitmap& bm);
+
+  void next();
+  bool done() const;
+
+private:
+  void scan();
+
+  /// Positions the range at the container for `pos_`, if one exists, and
+  /// materializes its blocks.
+  /// @returns `true` iff a container exists for `pos_`.
+  bool seek();
+
+  const roaring_bitmap* bm_ = nullptr;
+  roaring_bitmap::container_vector::const_iterator container_;
+  std::vector<roaring_bitmap::block_type> blocks_;
+  roaring_bitmap::size_type key_ = word_type::npos;
+  roaring_bitmap::size_type pos_ = 0;
+  bool done_ = true;
+};
+
+roaring_bitmap_range bit_range(const roaring_bitmap& bm);
+
+} // namespace vast
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "vast/aliases.hpp"
+#include "vast/compression.hpp"
 #include "vast/fbs/segment.hpp"
 #include "vast/fbs/table_slice.hpp"
 #include "vast/segment.hpp"
@@ -32,7 +33,10 @@ namespace vast {
 class segment_builder {
 public:
   /// Constructs a segment builder.
-  segment_builder();
+  /// @param method The compression algorithm for the data of each table
+  ///               slice. Compressing every slice on its own allows for
+  ///               decompressing only the slices that a lookup needs.
+  explicit segment_builder(compression method = compression::null);
 
   /// Adds a table slice to the segment.
   /// @returns An error if adding the table slice failed.
@@ -65,7 +69,13 @@ public:
   /// Resets the builder state to start with a new segment.
   void reset();
 
+  /// @returns the compression algorithm for table slices.
+  compression method() const noexcept {
+    return method_;
+  }
+
 private:
+  compression method_;
   uuid id_;
   vast::id min_table_slice_offset_;
   uint64_t num_events_;
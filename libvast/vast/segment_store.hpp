@@ -20,10 +20,16 @@
 #include "vast/segment.hpp"
 #include "vast/segment_builder.hpp"
 #include "vast/store.hpp"
+#include "vast/time.hpp"
 #include "vast/uuid.hpp"
 
 #include "vast/detail/cache.hpp"
 #include "vast/detail/range_map.hpp"
+#include "vast/detail/thread_pool.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace vast {
 
@@ -38,10 +44,13 @@ public:
   /// Constructs a segment store.
   /// @param dir The directory where to store state.
   /// @param max_segment_size The maximum segment size in bytes.
-  /// @param in_memory_segments The number of semgents to cache in memory.
-  /// @pre `max_segment_size > 0`
+  /// @param max_cache_size The maximum size of the segments to cache in
+  ///                       memory in bytes.
+  /// @param method The compression algorithm for new segments.
+  /// @pre `max_segment_size > 0 && max_cache_size > 0`
   static segment_store_ptr make(path dir, size_t max_segment_size,
-                                size_t in_memory_segments);
+                                size_t max_cache_size,
+                                compression method = compression::null);
 
   ~segment_store();
 
@@ -52,6 +61,11 @@ public:
     return dir_ / "segments";
   }
 
+  /// @returns the path for storing the IDs of erased events.
+  path tombstone_path() const {
+    return dir_ / "tombstones";
+  }
+
   /// @returns whether the store has no unwritten data pending.
   bool dirty() const noexcept {
     return builder_.table_slice_bytes() != 0;
@@ -74,22 +88,48 @@ public:
     cache_.clear();
   }
 
+  // -- prefetching ------------------------------------------------------------
+
+  /// Loads segments for extraction sessions ahead of time on a pool of I/O
+  /// threads, so that reading and decoding the next candidates overlaps with
+  /// shipping the results of the current one.
+  /// @param threads The number of I/O threads.
+  /// @param max_in_flight The maximum number of segment loads in flight per
+  ///                      extraction session; 0 disables prefetching.
+  void prefetch(size_t threads, size_t max_in_flight);
+
   // -- implementation of store ------------------------------------------------
 
   error put(table_slice_ptr xs) override;
 
   std::unique_ptr<store::lookup> extract(const ids& xs) const override;
 
+  /// Erases events from the active segment right away, and records
+  /// tombstones for events in persisted segments.
   caf::error erase(const ids& xs) override;
 
+  /// Rewrites persisted segments without the events that have tombstones.
+  caf::expected<uint64_t> reclaim(uint64_t max_bytes) override;
+
   caf::expected<std::vector<table_slice_ptr>> get(const ids& xs) override;
 
   caf::error flush() override;
 
+  id watermark() const override;
+
+  /// Merges a run of adjacent persisted segments that are each smaller than
+  /// half the maximum segment size into a single segment. Loads the segments
+  /// of the run over multiple calls and writes the merged segment in the call
+  /// that loads the last one.
+  caf::expected<uint64_t> compact(uint64_t max_bytes) override;
+
   void inspect_status(caf::settings& dict) override;
 
+  void append_report(system::report& r) const override;
+
 private:
-  segment_store(path dir, uint64_t max_segment_size, size_t in_memory_segments);
+  segment_store(path dir, uint64_t max_segment_size, size_t max_cache_size,
+                compression method);
 
   // -- utility functions ------------------------------------------------------
 
@@ -103,6 +143,13 @@ private:
   caf::error select_segments(const ids& selection,
                              std::vector<uuid>& candidates) const;
 
+  /// Removes events from a segment or the segment-under-construction.
+  /// @param seg The segment to erase from.
+  /// @param xs The IDs of the events to erase.
+  /// @returns The number of erased events.
+  template <class Segment>
+  uint64_t erase_from(Segment& seg, const ids& xs);
+
   /// Drops an entire segment and erases its content from disk.
   /// @param x The segment to drop.
   /// @returns The number of events in `x`.
@@ -124,14 +171,55 @@ private:
 
   uint64_t num_events_ = 0;
 
+  /// One past the highest ID added to the store.
+  id next_ = 0;
+
   /// Maps event IDs to candidate segments.
   detail::range_map<id, uuid> segments_;
 
+  /// The IDs of erased events that persisted segments still contain.
+  ids tombstones_;
+
+  /// Weighs cached segments by their size in bytes.
+  struct segment_size {
+    size_t operator()(const segment& x) const noexcept {
+      return x.chunk()->size();
+    }
+  };
+
   /// Optimizes access times into segments by keeping some segments in memory.
-  mutable detail::cache<uuid, segment> cache_;
+  mutable detail::two_queue_cache<uuid, segment, segment_size> cache_;
 
   /// Serializes table slices into contiguous chunks of memory.
   segment_builder builder_;
+
+  /// Reads and decodes segments for extraction sessions in the background.
+  std::unique_ptr<detail::thread_pool> readers_;
+
+  /// The state of a merge that spans multiple calls to `compact`.
+  struct compaction {
+    /// The segments of the run that still need loading together with their
+    /// first ID, in reverse order.
+    std::vector<std::pair<uuid, id>> pending;
+
+    /// The loaded segments of the run.
+    std::vector<segment> sources;
+  };
+
+  compaction compaction_;
+
+  /// The maximum number of segment loads in flight per extraction session.
+  size_t max_in_flight_ = 0;
+
+  /// Accumulates statistics about segment loads of extraction sessions.
+  struct read_statistics {
+    size_t in_flight = 0;
+    uint64_t segments = 0;
+    uint64_t bytes = 0;
+    duration time{0};
+  };
+
+  mutable read_statistics reads_;
 };
 
 } // namespace vast
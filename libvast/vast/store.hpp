@@ -17,7 +17,9 @@
 
 #include <caf/expected.hpp>
 
+#include "vast/aliases.hpp"
 #include "vast/fwd.hpp"
+#include "vast/system/report.hpp"
 
 namespace vast {
 
@@ -48,11 +50,17 @@ public:
   /// @relates lookup
   virtual std::unique_ptr<lookup> extract(const ids& xs) const = 0;
 
-  /// Erases events from the store.
+  /// Erases events from the store. Implementations may hide the events from
+  /// lookups right away and free their space only in `reclaim`.
   /// @param xs The set of IDs to erase.
   /// @returns No error on success.
   virtual caf::error erase(const ids& xs) = 0;
 
+  /// Frees the space of erased events.
+  /// @param max_bytes The amount of data to process before returning.
+  /// @returns the number of processed bytes.
+  virtual caf::expected<uint64_t> reclaim(uint64_t max_bytes) = 0;
+
   /// Retrieves a set of events.
   /// @param xs The IDs for the events to retrieve.
   /// @returns The table slice according to *xs*.
@@ -62,8 +70,22 @@ public:
   /// @returns No error on success.
   virtual caf::error flush() = 0;
 
+  /// @returns an ID such that all previously added events below it are
+  ///          persistent.
+  virtual id watermark() const = 0;
+
+  /// Merges small units of storage into larger ones. Large merges span
+  /// multiple calls.
+  /// @param max_bytes The amount of data to process before returning.
+  /// @returns the number of processed bytes, which is zero if nothing
+  ///          qualified.
+  virtual caf::expected<uint64_t> compact(uint64_t max_bytes) = 0;
+
   /// Fills `dict` with implementation-specific status information.
   virtual void inspect_status(caf::settings& dict) = 0;
+
+  /// Appends implementation-specific metrics for the accountant to `r`.
+  virtual void append_report(system::report& r) const;
 };
 
 } // namespace vast
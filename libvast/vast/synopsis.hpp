@@ -46,6 +46,14 @@ public:
   /// @pre `type_check(type(), x)`
   virtual void add(data_view x) = 0;
 
+  /// Adds all non-null values of a table slice column. The default
+  /// implementation dispatches to `add(data_view)` for every value; concrete
+  /// synopses should override it with a traversal that avoids the virtual call
+  /// per value.
+  /// @param x The column to process.
+  /// @pre `type_check(type(), x.slice->layout().fields[x.column].type)`
+  virtual void add(const table_slice_column& x);
+
   /// Tests whether a predicate matches. The synopsis is implicitly the LHS of
   /// the predicate.
   /// @param op The operator of the predicate.
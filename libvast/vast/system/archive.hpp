@@ -17,6 +17,7 @@
 #include "vast/ids.hpp"
 #include "vast/store.hpp"
 #include "vast/system/accountant.hpp"
+#include "vast/system/cancellation_token.hpp"
 #include "vast/system/instrumentation.hpp"
 
 #include <caf/fwd.hpp>
@@ -26,10 +27,10 @@
 #include <caf/typed_event_based_actor.hpp>
 
 #include <chrono>
+#include <deque>
 #include <memory>
 #include <queue>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -47,39 +48,72 @@ using receiver_type = caf::typed_actor<
 using archive_type = caf::typed_actor<
   caf::reacts_to<caf::stream<table_slice_ptr>>,
   caf::reacts_to<atom::exporter, caf::actor>,
+  caf::reacts_to<atom::exporter, caf::actor, cancellation_token>,
   caf::reacts_to<ids>,
   caf::reacts_to<ids, receiver_type>,
-  caf::reacts_to<ids, receiver_type, uint64_t>,
+  caf::reacts_to<atom::extract>,
+  caf::reacts_to<atom::extract, uint64_t>,
   caf::replies_to<atom::status>::with<caf::dictionary<caf::config_value>>,
   caf::reacts_to<atom::telemetry>,
-  caf::reacts_to<atom::erase, ids>
+  caf::reacts_to<atom::erase, ids>,
+  caf::replies_to<atom::checkpoint>::with<id>,
+  caf::reacts_to<atom::compact>,
+  caf::reacts_to<atom::reclaim>
 >;
 // clang-format on
 
 /// @relates archive
 struct archive_state {
+  /// A requester whose ids the current extraction session retrieves.
+  struct participant {
+    receiver_type requester;
+    ids xs;
+  };
+
   void send_report();
+
+  /// Starts a session that extracts the oldest pending ids of all requesters
+  /// at once, so that overlapping requests share loading and decoding of each
+  /// segment.
   void next_session();
+
+  /// @returns whether `exporter` registered itself and did not cancel its
+  /// query since.
+  bool is_active(const caf::actor_addr& exporter) const;
+
+  /// Drops all pending work for an exporter.
+  void drop(const caf::actor_addr& exporter);
+
   archive_type::stateful_pointer<archive_state> self;
   std::unique_ptr<vast::store> store;
   std::unique_ptr<vast::store::lookup> session;
+  std::vector<participant> participants;
   uint64_t session_id = 0;
-  std::queue<receiver_type> requesters;
+  /// Whether a message to start the next session is on its way. Requests
+  /// that arrive before it join that session.
+  bool session_scheduled = false;
+  std::deque<receiver_type> requesters;
   std::unordered_map<caf::actor_addr, std::queue<ids>> unhandled_ids;
-  std::unordered_set<caf::actor_addr> active_exporters;
+  std::unordered_map<caf::actor_addr, cancellation_token> active_exporters;
   vast::system::measurement measurement;
   accountant_type accountant;
+  /// Limits the rate of rewriting segments after erasing events in bytes per
+  /// second.
+  uint64_t reclaim_rate = 0;
+  /// Whether a compaction of the store continues in steps.
+  bool compacting = false;
   static inline const char* name = "archive";
 };
 
 /// Stores event batches and answers queries for ID sets.
 /// @param self The actor handle.
 /// @param dir The root directory of the archive.
-/// @param capacity The number of segments to cache in memory.
+/// @param max_cache_size The maximum size of the segments to cache in memory
+///                       in bytes.
 /// @param max_segment_size The maximum segment size in bytes.
 /// @pre `max_segment_size > 0`
 archive_type::behavior_type
 archive(archive_type::stateful_pointer<archive_state> self, path dir,
-        size_t capacity, size_t max_segment_size);
+        size_t max_cache_size, size_t max_segment_size);
 
 } // namespace vast::system
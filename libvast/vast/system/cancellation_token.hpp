@@ -0,0 +1,88 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <caf/error.hpp>
+#include <caf/meta/load_callback.hpp>
+#include <caf/meta/type_name.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace vast::system {
+
+/// A shared flag that tells all actors working on a query to abandon it. All
+/// copies of a token observe a cancellation, no matter which copy triggered
+/// it. A default-constructed token is inert and never gets cancelled, which
+/// keeps cancellation optional for callers.
+class cancellation_token {
+public:
+  // -- constructors, destructors, and assignment operators --------------------
+
+  cancellation_token() = default;
+
+  /// @returns a new token that is not cancelled.
+  static cancellation_token make();
+
+  // -- properties -------------------------------------------------------------
+
+  /// @returns whether the token supports cancellation.
+  explicit operator bool() const noexcept {
+    return flag_ != nullptr;
+  }
+
+  /// @returns whether any copy of the token got cancelled.
+  bool cancelled() const noexcept {
+    return flag_ != nullptr && flag_->load(std::memory_order_relaxed);
+  }
+
+  // -- operations -------------------------------------------------------------
+
+  /// Cancels the token and all of its copies. Does nothing for inert tokens.
+  void cancel() const noexcept {
+    if (flag_ != nullptr)
+      flag_->store(true, std::memory_order_relaxed);
+  }
+
+  // -- concepts ---------------------------------------------------------------
+
+  /// Transfers only the current state. Cancellation therefore does not
+  /// propagate between a token and its deserialized copy.
+  template <class Inspector>
+  friend typename Inspector::result_type
+  inspect(Inspector& f, cancellation_token& x) {
+    // 0 = inert, 1 = active, 2 = cancelled
+    uint8_t state;
+    if constexpr (Inspector::reads_state) {
+      state = x.flag_ == nullptr ? 0 : x.cancelled() ? 2 : 1;
+      return f(caf::meta::type_name("cancellation_token"), state);
+    } else {
+      static_assert(Inspector::writes_state);
+      auto cb = [&]() -> caf::error {
+        x = state == 0 ? cancellation_token{} : make();
+        if (state == 2)
+          x.cancel();
+        return caf::none;
+      };
+      return f(caf::meta::type_name("cancellation_token"), state,
+               caf::meta::load_callback(cb));
+    }
+  }
+
+private:
+  std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+} // namespace vast::system
@@ -0,0 +1,143 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/filesystem.hpp"
+#include "vast/fwd.hpp"
+#include "vast/ids.hpp"
+#include "vast/meta_index.hpp"
+#include "vast/uuid.hpp"
+
+#include <caf/actor.hpp>
+#include <caf/meta/type_name.hpp>
+#include <caf/settings.hpp>
+#include <caf/stateful_actor.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace vast::system {
+
+/// The persisted partitions of an INDEX as input for compaction.
+struct compaction_candidates {
+  /// The base directory of the INDEX.
+  path dir;
+
+  /// The maximum number of events per partition.
+  uint64_t max_partition_size = 0;
+
+  /// The IDs of all persisted partitions that are not in use.
+  std::vector<uuid> partitions;
+
+  /// The options for the synopsis factory of the meta index.
+  caf::settings synopsis_options;
+};
+
+/// @relates compaction_candidates
+template <class Inspector>
+auto inspect(Inspector& f, compaction_candidates& x) {
+  return f(caf::meta::type_name("compaction_candidates"), x.dir,
+           x.max_partition_size, x.partitions, x.synopsis_options);
+}
+
+/// A new partition on disk that holds all events of a set of smaller ones.
+struct compacted_partition {
+  /// The ID of the new partition.
+  uuid id;
+
+  /// The IDs of the partitions that the new partition replaces.
+  std::vector<uuid> sources;
+
+  /// The synopses of the new partition.
+  meta_index synopses;
+};
+
+/// @relates compacted_partition
+template <class Inspector>
+auto inspect(Inspector& f, compacted_partition& x) {
+  return f(caf::meta::type_name("compacted_partition"), x.id, x.sources,
+           x.synopses);
+}
+
+/// State of the COMPACTOR actor.
+struct compactor_state {
+  // -- member types -----------------------------------------------------------
+
+  /// The part of the partition meta data relevant for picking candidates.
+  struct partition_summary {
+    id first;        ///< The smallest ID in the partition.
+    id last;         ///< One past the largest ID in the partition.
+    uint64_t events; ///< The number of events in the partition.
+  };
+
+  // -- member functions -------------------------------------------------------
+
+  /// Triggers compaction at the ARCHIVE and asks the INDEX for candidates.
+  void run();
+
+  /// Picks adjacent small partitions and requests their events from the
+  /// ARCHIVE.
+  void plan(compaction_candidates xs);
+
+  /// Writes a new partition for the events in `slices` and offers it to the
+  /// INDEX as replacement for `sources`.
+  void build();
+
+  /// Ends the current round.
+  void finish();
+
+  // -- member variables -------------------------------------------------------
+
+  /// Pointer to the parent actor.
+  caf::stateful_actor<compactor_state>* self;
+
+  /// The time between two compaction rounds.
+  caf::timespan interval;
+
+  /// Points to the INDEX whose partitions we merge.
+  caf::actor index;
+
+  /// Points to the ARCHIVE that merges its segments and delivers events.
+  caf::actor archive;
+
+  /// Caches the summaries of persisted partitions, which never change.
+  std::unordered_map<uuid, partition_summary> summaries;
+
+  /// The candidates of the current round.
+  compaction_candidates candidates;
+
+  /// The partitions that the current round merges.
+  std::vector<uuid> sources;
+
+  /// Collects the events of `sources` until the ARCHIVE delivered all.
+  std::vector<table_slice_ptr> slices;
+
+  /// Whether a round is in progress.
+  bool busy = false;
+
+  /// Name of the COMPACTOR actor.
+  static inline const char* name = "compactor";
+};
+
+/// Periodically merges small segments in `archive` and small partitions in
+/// `index` into larger ones.
+/// @param interval The time between two compaction rounds.
+/// @param index A handle to the INDEX.
+/// @param archive A handle to the ARCHIVE.
+caf::behavior
+compactor(caf::stateful_actor<compactor_state>* self, caf::timespan interval,
+          caf::actor index, caf::actor archive);
+
+} // namespace vast::system
@@ -13,16 +13,21 @@
 
 #pragma once
 
+#include "vast/expression.hpp"
 #include "vast/fwd.hpp"
 #include "vast/ids.hpp"
 #include "vast/system/query_processor.hpp"
+#include "vast/type.hpp"
 
 #include <string>
+#include <unordered_map>
 
 namespace vast::system {
 
 /// Periodically queries the INDEX with a configurable expression and erases
-/// all hits from the ARCHIVE.
+/// all hits from the ARCHIVE. Because some indexes answer with a superset of
+/// the matching events, the ERASER checks the hits against the events in the
+/// ARCHIVE before erasing them.
 class eraser_state : public system::query_processor {
 public:
   // -- member types -----------------------------------------------------------
@@ -50,6 +55,15 @@ protected:
   void process_end_of_hits() override;
 
 private:
+  // -- implementation details ------------------------------------------------
+
+  /// Fetches the events for `hits_` from the ARCHIVE and erases the ones that
+  /// match the query.
+  void verify_hits();
+
+  /// Adds the rows of `slice` that match the query to `verified_`.
+  void verify(const table_slice& slice);
+
   // -- member variables -------------------------------------------------------
 
   /// Configures the time between two query executions.
@@ -64,9 +78,18 @@ private:
   /// Points to the ARCHIVE that needs periodic pruning.
   caf::actor archive_;
 
+  /// The expression of the current aging cycle.
+  expression expr_;
+
+  /// Caches the expression tailored to the layouts of the current cycle.
+  std::unordered_map<type, expression> checkers_;
+
   /// Collects hits until all deltas arrived.
   ids hits_;
 
+  /// Collects the hits that match the query according to the ARCHIVE.
+  ids verified_;
+
   /// Keeps track whether we were triggered remotely and need to send a
   /// confirmation message and suppress the delayed message.
   caf::response_promise promise_;
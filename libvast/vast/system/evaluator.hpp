@@ -17,6 +17,7 @@
 #include "vast/expression.hpp"
 #include "vast/ids.hpp"
 #include "vast/offset.hpp"
+#include "vast/system/cancellation_token.hpp"
 #include "vast/system/index_common.hpp"
 #include "vast/table_slice_column.hpp"
 #include "vast/uuid.hpp"
@@ -34,9 +35,27 @@ namespace vast::system {
 struct evaluator_state {
   using predicate_hits_map = std::map<offset, std::pair<size_t, ids>>;
 
+  /// The lookups for one operand of a top-level conjunction.
+  struct stage {
+    /// The index of the operand in the conjunction.
+    size_t operand;
+
+    /// The estimated fraction of events that satisfy the operand.
+    double selectivity;
+
+    /// The lookups for all predicates of the operand.
+    evaluation_triples triples;
+  };
+
   evaluator_state(caf::event_based_actor* self);
 
-  void init(caf::actor client, expression expr, caf::response_promise promise);
+  void init(caf::actor client, expression expr, caf::response_promise promise,
+            cancellation_token token = {});
+
+  /// Responds to the COLLECTOR and ignores all outstanding INDEXER results if
+  /// the query got cancelled.
+  /// @returns whether the evaluator abandoned its query.
+  bool abandon();
 
   /// Updates `predicate_hits` and may trigger re-evaluation of the expression
   /// tree.
@@ -56,9 +75,35 @@ struct evaluator_state {
   /// Returns the `predicate_hits` entry for `pred` or `nullptr`.
   predicate_hits_map::mapped_type* hits_for(const offset& position);
 
+  /// Sends the lookups for a set of predicates to their INDEXER actors.
+  /// @param triples The lookups to send.
+  /// @param candidates Restricts the lookups to these IDs if not `nullptr`.
+  void schedule(const evaluation_triples& triples, const ids* candidates);
+
+  /// Orders the stages by their selectivity and starts the first one.
+  void start_stages();
+
+  /// Starts the next stage with the IDs that satisfy all completed operands
+  /// as candidates, or skips all remaining stages if no candidate is left.
+  void next_stage();
+
+  /// Stores the number of selectivity estimates that did not arrive yet.
+  size_t pending_estimates = 0;
+
   /// Stores the number of requests that did not receive a response yet.
   size_t pending_responses = 0;
 
+  /// Stores the number of requests of the running stage that did not receive
+  /// a response yet.
+  size_t stage_responses = 0;
+
+  /// Stores the stages of a top-level conjunction that did not start yet, in
+  /// reverse execution order. Empty when evaluating all predicates at once.
+  std::vector<stage> stages;
+
+  /// Stores the operands of a top-level conjunction whose stages completed.
+  std::vector<size_t> completed_operands;
+
   /// Stores hits per predicate in the expression.
   predicate_hits_map predicate_hits;
 
@@ -77,12 +122,36 @@ struct evaluator_state {
   /// Allows us to respond to the COLLECTOR after finishing a lookup.
   caf::response_promise promise;
 
+  /// Receives `(atom::store, partition_id, expr, hits)` after a complete
+  /// evaluation if set, which allows the INDEX to cache the result.
+  caf::actor hits_listener;
+
+  /// Identifies the evaluated partition for the `hits_listener`.
+  uuid partition_id = uuid::nil();
+
+  /// Stores whether all INDEXER actors delivered a result.
+  bool complete = true;
+
+  /// Signals that the client lost interest in the query.
+  cancellation_token token;
+
+  /// Stores whether the evaluator stopped working on a cancelled query.
+  bool abandoned = false;
+
   /// Gives this actor a recognizable name in logging output.
   static inline const char* name = "evaluator";
 };
 
+/// Estimates the fraction of events that satisfy a predicate when the
+/// INDEXER has no column statistics to base an estimate on.
+double estimate_selectivity(const curried_predicate& pred);
+
 /// Wraps a query expression in an actor. Upon receiving hits from INDEXER
 /// actors, re-evaluates the expression and relays new hits to its sinks.
+/// For a conjunction, the evaluator asks the INDEXER actors for selectivity
+/// estimates, looks up the most selective operand first, and restricts the
+/// lookups for the remaining operands to its hits. The estimates take one
+/// additional round trip, which other expressions do not pay.
 /// @pre `!eval.empty()`
 caf::behavior evaluator(caf::stateful_actor<evaluator_state>* self,
                         expression expr, evaluation_triples eval);
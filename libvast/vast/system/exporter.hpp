@@ -26,6 +26,7 @@
 
 #include "vast/system/accountant.hpp"
 #include "vast/system/archive.hpp"
+#include "vast/system/cancellation_token.hpp"
 #include "vast/system/query_status.hpp"
 
 namespace vast::system {
@@ -60,6 +61,10 @@ struct exporter_state {
   /// Stores hits from the INDEX.
   ids hits;
 
+  /// Stores hits that arrived while the client had all results it asked for.
+  /// We look them up in the ARCHIVE once the client requests more.
+  ids deferred_hits;
+
   /// Caches tailored candidate checkers.
   std::unordered_map<type, expression> checkers;
 
@@ -79,6 +84,10 @@ struct exporter_state {
   /// Stores the query ID we receive from the INDEX.
   uuid id;
 
+  /// Tells the INDEX, its EVALUATOR actors, and the ARCHIVE to abandon all
+  /// work for this query once the EXPORTER terminates.
+  cancellation_token token = cancellation_token::make();
+
   /// Stores the user-defined export query.
   expression expr;
 };
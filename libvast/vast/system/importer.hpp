@@ -15,11 +15,14 @@
 
 #include "vast/aliases.hpp"
 #include "vast/data.hpp"
+#include "vast/defaults.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/system/accountant.hpp"
 #include "vast/system/archive.hpp"
 #include "vast/system/instrumentation.hpp"
 #include "vast/system/type_registry.hpp"
+#include "vast/time.hpp"
+#include "vast/write_ahead_log.hpp"
 
 #include <caf/event_based_actor.hpp>
 #include <caf/stateful_actor.hpp>
@@ -90,6 +93,14 @@ struct importer_state {
   /// @returns various status metrics.
   caf::dictionary<caf::config_value> status() const;
 
+  /// Appends a table slice with its final IDs to the write-ahead log and
+  /// schedules the next sync.
+  void log(const table_slice_ptr& x);
+
+  /// Removes write-ahead log files that the ARCHIVE and all INDEX actors
+  /// persisted in the meantime.
+  void checkpoint();
+
   /// The active id block.
   id_block current;
 
@@ -108,6 +119,22 @@ struct importer_state {
   /// Stores all actor handles of connected INDEX actors.
   std::vector<caf::actor> index_actors;
 
+  /// The most recently registered ARCHIVE.
+  archive_type archive;
+
+  /// Keeps incoming table slices until ARCHIVE and INDEX persisted them, if
+  /// enabled.
+  write_ahead_log_ptr wal;
+
+  /// Interval between two syncs of the write-ahead log.
+  duration sync_interval = defaults::system::write_ahead_log_sync_interval;
+
+  /// Whether a sync of the write-ahead log is scheduled.
+  bool sync_scheduled = false;
+
+  /// Whether we wait for the watermarks of ARCHIVE and INDEX.
+  bool checkpointing = false;
+
   accountant_type accountant;
 
   /// Name of this actor in log events.
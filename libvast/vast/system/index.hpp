@@ -13,22 +13,35 @@
 
 #pragma once
 
+#include "vast/column_statistics.hpp"
 #include "vast/detail/flat_lru_cache.hpp"
 #include "vast/detail/stable_map.hpp"
+#include "vast/detail/thread_pool.hpp"
+#include "vast/detail/work_stealing_pool.hpp"
 #include "vast/expression.hpp"
 #include "vast/fwd.hpp"
 #include "vast/meta_index.hpp"
+#include "vast/query_options.hpp"
 #include "vast/system/accountant.hpp"
+#include "vast/system/cancellation_token.hpp"
 #include "vast/system/indexer_stage_driver.hpp"
 #include "vast/system/partition.hpp"
+#include "vast/system/query_cache.hpp"
+#include "vast/system/query_scheduler.hpp"
 #include "vast/system/query_supervisor.hpp"
 #include "vast/system/spawn_indexer.hpp"
 #include "vast/uuid.hpp"
 
 #include <caf/actor.hpp>
 #include <caf/behavior.hpp>
+#include <caf/expected.hpp>
 #include <caf/fwd.hpp>
+#include <caf/timespan.hpp>
 
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -73,18 +86,57 @@ struct index_state {
                                                       partition_lookup,
                                                       partition_factory>;
 
+  /// Keeps partitions on disk while a query may still evaluate them. Shared
+  /// by all copies of the state of a query.
+  using partition_pin = std::shared_ptr<const std::vector<uuid>>;
+
   /// Stores context information for unfinished queries.
   struct lookup_state {
     /// Issued query.
     expression expr;
 
-    /// Unscheduled partitions.
+    /// Unscheduled partitions in scheduling order.
     std::vector<uuid> partitions;
+
+    /// The normalized query for accessing the query cache.
+    expression cache_key;
+
+    /// Signals that the client lost interest in the query.
+    cancellation_token token;
+
+    /// Determines the share of INDEX workers for the query.
+    query_priority priority = query_priority::interactive;
+
+    /// Keeps the candidate partitions on disk until the query finishes.
+    partition_pin pin;
   };
 
   /// Stores evaluation metadata for pending partitions.
   using pending_query_map = detail::stable_map<uuid, evaluation_triples>;
 
+  /// Tracks a partition while a loader thread reads its meta data.
+  struct partition_load {
+    /// The partition to materialize once the meta data is available.
+    partition_ptr part;
+
+    /// The meta data as read by the loader thread.
+    std::future<caf::expected<partition::meta_data>> meta_data;
+
+    /// The point in time when the INDEX scheduled the load.
+    std::chrono::steady_clock::time_point start;
+
+    /// Functions to call once the partition is resident.
+    std::vector<std::function<void()>> continuations;
+  };
+
+  /// Accumulates statistics about loading partitions from disk.
+  struct load_statistics {
+    uint64_t count = 0;     ///< Number of completed loads.
+    uint64_t failed = 0;    ///< Number of failed loads.
+    caf::timespan total{0}; ///< Accumulated load latency.
+    caf::timespan max{0};   ///< Highest load latency.
+  };
+
   /// Accumulates statistics for a given layout.
   struct layout_statistics {
     uint64_t count; ///< Number of events indexed.
@@ -117,6 +169,9 @@ struct index_state {
   /// Persists the state to disk.
   caf::error flush_statistics();
 
+  /// Persists the IDs of all events in persisted partitions.
+  caf::error flush_persisted_ids();
+
   /// Persists the state to disk.
   caf::error flush_to_disk();
 
@@ -125,16 +180,37 @@ struct index_state {
   /// Returns the file name for saving or loading statistics.
   path statistics_filename() const;
 
+  /// Returns the file name for saving or loading column statistics.
+  path column_statistics_filename() const;
+
   /// Returns the file name for saving or loading the meta index.
   path meta_index_filename() const;
 
+  /// Returns the file name for saving or loading the persisted IDs.
+  path persisted_ids_filename() const;
+
   /// @returns whether there's an idle worker available.
   bool worker_available();
 
   /// Takes the next worker from the idle workers stack and returns it.
-  /// @pre `has_worker()`
+  /// @pre `worker_available()`
   caf::actor next_worker();
 
+  /// Puts an idle worker onto the idle workers stack and hands it to the next
+  /// waiting query, if any.
+  void release_worker(caf::actor worker);
+
+  /// Lets a slice of a query wait for an idle worker.
+  /// @param client The actor that receives the results of the query.
+  /// @param prio The priority class of the query.
+  /// @param cost The number of partitions to evaluate.
+  /// @param f Evaluates the slice, taking a worker with `next_worker`.
+  void schedule(const caf::actor_addr& client, query_priority prio,
+                uint32_t cost, query_scheduler::job f);
+
+  /// Runs waiting queries while idle workers are available.
+  void dispatch();
+
   /// @returns various status metrics.
   caf::dictionary<caf::config_value> status() const;
 
@@ -160,14 +236,79 @@ struct index_state {
   ///          partition matches.
   partition* find_unpersisted(const uuid& id);
 
-  /// Prepares a subset of partitions from the lookup_state for evaluation.
+  /// @returns whether the partition is available without reading from disk.
+  bool is_resident(const uuid& id);
+
+  /// @returns an ID such that all events below it are persistent, i.e., the
+  ///          first ID of the oldest partition that still waits for its
+  ///          INDEXER actors, or the end of `persisted_ids` if there is none.
+  id watermark() const;
+
+  /// @returns whether the partition no longer changes, which is a
+  ///          prerequisite for caching query results.
+  bool is_persisted(const uuid& id);
+
+  /// @returns whether a persisted partition already contains events of the
+  ///          table slice, e.g., when the IMPORTER replays its write-ahead log.
+  bool is_persisted(const table_slice& slice) const;
+
+  /// Adds the IDs of a partition to `persisted_ids`.
+  void add_persisted_ids(const partition& part);
+
+  /// Prevents `remove_orphaned_partitions` from deleting partitions.
+  /// @param ids The partitions to keep.
+  /// @returns a pin that keeps the partitions until its last copy is gone.
+  partition_pin pin(std::vector<uuid> ids);
+
+  /// @returns whether a query may still evaluate the partition.
+  bool is_pinned(const uuid& id) const;
+
+  /// Deletes the directories of partitions that are no longer part of the
+  /// meta index, e.g., after compaction replaced them. Skips partitions that
+  /// queries may still read from.
+  void remove_orphaned_partitions();
+
+  /// Replaces persisted partitions with a compacted one.
+  /// @param x The compacted partition, already written to disk.
+  /// @returns whether the INDEX took over *x*, which fails if any of the
+  ///          replaced partitions is unknown or in use by the INDEX.
+  bool replace_partitions(compacted_partition& x);
+
+  /// Sorts candidate partitions by the timestamps of their events, with the
+  /// newest partitions first. Partitions without timestamps come last, and
+  /// resident partitions precede others with the same timestamps.
+  /// @param xs The candidate partitions.
+  /// @param opts The query options, to select oldest-first order.
+  void order_candidates(std::vector<uuid>& xs, query_options opts);
+
+  /// @returns the partitions among the next `num_partitions` candidates of
+  ///          the lookup_state that require loading from disk.
+  std::vector<uuid>
+  cold_partitions(const lookup_state& lookup, uint32_t num_partitions);
+
+  /// Reads partitions from disk on the loader threads without blocking the
+  /// INDEX and calls `f` once all of them are resident.
+  /// @param ids The partitions to load.
+  /// @param f The continuation, called immediately if `ids` is empty.
+  void load_partitions(const std::vector<uuid>& ids, std::function<void()> f);
+
+  /// Materializes a partition after a loader thread read its meta data and
+  /// runs all continuations that wait for it.
+  void handle_loaded_partition(const uuid& id);
+
+  /// Prepares a subset of partitions from the lookup_state for evaluation in
+  /// scheduling order. Loads candidates synchronously that are not resident,
+  /// so callers should go through `cold_partitions` and `load_partitions`
+  /// first.
   pending_query_map
   build_query_map(lookup_state& lookup, uint32_t num_partitions);
 
-  /// Spawns one evaluator for each partition.
+  /// Spawns one evaluator for each partition, or an actor that replays the
+  /// hits from the query cache.
   /// @returns a query map for passing to INDEX workers over the spawned
   ///          EVALUATOR actors.
-  query_map launch_evaluators(pending_query_map pqm, expression expr);
+  query_map launch_evaluators(pending_query_map pqm,
+                              const lookup_state& lookup);
 
   /// Adds a new flush listener.
   void add_flush_listener(caf::actor listener);
@@ -175,6 +316,10 @@ struct index_state {
   /// Sends a notification to all listeners and clears the listeners list.
   void notify_flush_listeners();
 
+  /// Sends metrics about the query cache and the query scheduler to the
+  /// ACCOUNTANT.
+  void send_report();
+
   // -- member variables -------------------------------------------------------
 
   /// Pointer to the parent actor.
@@ -192,16 +337,24 @@ struct index_state {
   /// The maximum number of events per partition.
   size_t max_partition_size;
 
-  /// The number of partitions to schedule immediately for each query.
+  /// The number of partitions to schedule immediately for each query, which
+  /// is also the size of the slices that compete for workers.
   uint32_t taste_partitions;
 
-  /// Allows the index to multiplex between waiting for ready workers and
-  /// queries.
-  caf::behavior has_worker;
+  /// Decides which query receives the next idle worker.
+  query_scheduler scheduler;
 
   /// Maps query IDs to pending lookup state.
   std::unordered_map<uuid, lookup_state> pending;
 
+  /// Counts the pins per partition. Shared with the pins, which may outlive
+  /// the state.
+  std::shared_ptr<std::unordered_map<uuid, size_t>> pinned_partitions
+    = std::make_shared<std::unordered_map<uuid, size_t>>();
+
+  /// Keeps the partitions of the queries that busy workers evaluate.
+  std::unordered_map<caf::actor, partition_pin> worker_pins;
+
   /// Caches idle workers.
   std::vector<caf::actor> idle_workers;
 
@@ -231,6 +384,31 @@ struct index_state {
   /// Statistics about processed data.
   statistics stats;
 
+  /// The IDs of all events in persisted partitions.
+  ids persisted_ids;
+
+  /// Value statistics per column, combined over all partitions. Keyed by the
+  /// fully-qualified name of the column.
+  std::unordered_map<std::string, column_statistics> column_stats;
+
+  /// Partitions that are currently being loaded from disk.
+  std::unordered_map<uuid, partition_load> loading;
+
+  /// Statistics about partition loads.
+  load_statistics load_stats;
+
+  /// Caches the hits of recent queries for persisted partitions.
+  query_cache result_cache;
+
+  /// Indexes the columns of new partitions if set, replacing the INDEXER
+  /// actors. Declared late to finish all indexing tasks before destroying the
+  /// partitions.
+  std::unique_ptr<detail::work_stealing_pool> indexing_pool;
+
+  /// Reads partition meta data from disk. Declared last to join the loader
+  /// threads before destroying any other member.
+  std::unique_ptr<detail::thread_pool> loaders;
+
   /// Name of the INDEX actor.
   static inline const char* name = "index";
 };
@@ -247,7 +425,13 @@ auto inspect(Inspector& f, index_state::statistics& x) {
   return f(x.layouts);
 }
 
-/// Indexes events in horizontal partitions.
+/// Indexes events in horizontal partitions. Queries arrive either as plain
+/// expression or together with query options, and evaluate the partitions
+/// with the newest events first unless the options say otherwise. The options
+/// also select a priority class, according to which the queries share the
+/// INDEX workers. The INDEX also combines the value statistics that INDEXER
+/// actors report per column and answers `(atom::statistics, fqn)` with the
+/// result.
 /// @param dir The directory of the index.
 /// @param max_partition_size The maximum number of events per partition.
 /// @param in_mem_partitions The maximum number of partitions to hold in memory.
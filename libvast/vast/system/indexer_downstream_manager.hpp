@@ -68,6 +68,12 @@ public:
 
   int32_t max_capacity() const noexcept override;
 
+  /// Sets the maximum number of slices per partition that may wait for the
+  /// indexing pool. Zero means that the INDEX uses no indexing pool.
+  void pool_capacity(int32_t x) noexcept {
+    pool_capacity_ = x;
+  }
+
   // Verbose naming because `register` is a keyword.
   void register_partition(partition* p);
 
@@ -92,9 +98,12 @@ private:
 
   void emit_batches_impl(bool force_underfull);
 
+  void emit_to_pool(partition& p);
+
   set_type partitions;
   set_type pending_partitions;
   bool closing = false;
+  int32_t pool_capacity_ = 0;
 };
 
 } // namespace vast::system
@@ -18,14 +18,18 @@
 #include "vast/ids.hpp"
 #include "vast/qualified_record_field.hpp"
 #include "vast/system/instrumentation.hpp"
+#include "vast/system/pooled_indexer.hpp"
 #include "vast/table_slice_column.hpp"
 #include "vast/type.hpp"
 #include "vast/uuid.hpp"
 
 #include <caf/event_based_actor.hpp>
+#include <caf/expected.hpp>
 #include <caf/stream_slot.hpp>
 
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace vast::system {
 
@@ -67,6 +71,10 @@ public:
     /// A buffer to avoid overloading the indexer.
     /// Only used during ingestion.
     std::vector<table_slice_column> buf;
+
+    /// The column when the indexing pool fills it instead of an INDEXER. The
+    /// partition lazily spawns a `pooled_indexer` for queries in this case.
+    pooled_column_ptr column;
   };
 
   // -- constructors, destructors, and assignment operators --------------------
@@ -86,6 +94,16 @@ public:
   /// @returns an error if I/O operations fail.
   caf::error init();
 
+  /// Materializes the partition layouts from previously loaded meta data.
+  /// @param x The meta data as returned by `load_meta_data`.
+  void init(meta_data x);
+
+  /// Reads the meta data of a partition without touching any actor state,
+  /// which allows for calling this function from any thread.
+  /// @param file The file name as returned by `meta_file`.
+  /// @returns the meta data or an error if I/O operations fail.
+  static caf::expected<meta_data> load_meta_data(const path& file);
+
   /// Persists the partition layouts to disk.
   /// @returns an error if I/O operations fail.
   caf::error flush_to_disk();
@@ -107,6 +125,11 @@ public:
     return capacity_;
   }
 
+  /// @returns the smallest ID in this partition, or `max_id` if empty.
+  vast::id first_id() const noexcept {
+    return first_id_;
+  }
+
   /// @returns a record type containing all columns of this partition.
   // TODO: Should this be renamed to layout()?
   record_type combined_type() const;
@@ -127,6 +150,21 @@ public:
   /// Adds a slice to the partition.
   void add(table_slice_ptr slice);
 
+  /// @returns whether the indexing pool fills the columns of this partition
+  ///          instead of one INDEXER per column.
+  bool pooled() const noexcept;
+
+  /// Hands a slice from the inbound buffer over to the indexing pool.
+  /// @pre `pooled()`
+  void index_in_pool(const table_slice_ptr& slice);
+
+  /// @returns the highest number of slices that wait for the indexing pool in
+  ///          any column range of this partition.
+  size_t pool_backlog() const noexcept;
+
+  /// Persists all columns after the indexing pool processed all slices.
+  void seal();
+
   /// Gets the INDEXER at position in the layout.
   caf::actor& indexer_at(size_t position);
 
@@ -165,8 +203,15 @@ public:
   /// Remaining capacity in this partition.
   size_t capacity_;
 
+  /// The smallest ID in this partition.
+  vast::id first_id_ = max_id;
+
   std::vector<table_slice_ptr> inbound_;
 
+  /// The column ranges for each layout when using the indexing pool.
+  std::unordered_map<record_type, std::vector<std::shared_ptr<column_range>>>
+    ranges_;
+
   friend struct index_state;
   friend class indexer_downstream_manager;
 };
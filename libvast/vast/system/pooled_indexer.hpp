@@ -0,0 +1,115 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/column_index.hpp"
+#include "vast/fwd.hpp"
+#include "vast/uuid.hpp"
+
+#include <caf/actor.hpp>
+#include <caf/behavior.hpp>
+#include <caf/event_based_actor.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vast::detail {
+
+class work_stealing_pool;
+
+} // namespace vast::detail
+
+namespace vast::system {
+
+/// A column index that the threads of the indexing pool fill while actors
+/// query it concurrently.
+struct pooled_column {
+  /// Guards all other members.
+  std::mutex mtx;
+
+  /// The index for the column.
+  column_index_ptr col;
+
+  /// The fully-qualified name of the column.
+  std::string fqn;
+
+  /// The number of column ranges that did not finish indexing this column.
+  size_t writers = 0;
+};
+
+/// @relates pooled_column
+using pooled_column_ptr = std::shared_ptr<pooled_column>;
+
+/// Consecutive columns of a layout in one partition, the unit of work for the
+/// indexing pool. A range indexes its slices strictly in order of arrival,
+/// while different ranges make progress in parallel.
+class column_range : public std::enable_shared_from_this<column_range> {
+public:
+  /// @param pool The threads that run the indexing tasks.
+  /// @param index The INDEX actor to notify.
+  /// @param partition_id The ID of the partition that owns the columns.
+  /// @param first The position of the first column in the layout.
+  /// @param columns The columns at positions `first` and following.
+  column_range(detail::work_stealing_pool& pool, caf::actor index,
+               uuid partition_id, size_t first,
+               std::vector<pooled_column_ptr> columns);
+
+  /// Queues a slice for indexing. Sends `atom::progress` to the INDEX after
+  /// the queue runs empty.
+  /// @pre `!sealed()`
+  void add(table_slice_ptr slice);
+
+  /// Persists all columns after indexing all queued slices. Sends the column
+  /// statistics and `atom::done` to the INDEX afterwards, just like an
+  /// INDEXER at the end of its stream.
+  void seal();
+
+  /// @returns the number of slices that wait for indexing.
+  size_t backlog() const noexcept {
+    return backlog_;
+  }
+
+private:
+  void schedule();
+
+  void run();
+
+  void finish();
+
+  detail::work_stealing_pool& pool_;
+  caf::actor index_;
+  uuid partition_id_;
+  size_t first_;
+  std::vector<pooled_column_ptr> columns_;
+  std::atomic<size_t> backlog_ = 0;
+  std::mutex mtx_;
+  std::deque<table_slice_ptr> queue_;
+  bool scheduled_ = false;
+  bool sealed_ = false;
+};
+
+/// Answers queries for a column that the indexing pool fills. Takes the place
+/// of an INDEXER for partitions that do not use one actor per column.
+/// @param self The actor handle.
+/// @param column The shared column.
+/// @returns the behavior of the actor.
+caf::behavior pooled_indexer(caf::event_based_actor* self,
+                             pooled_column_ptr column);
+
+} // namespace vast::system
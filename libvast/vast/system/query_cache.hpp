@@ -0,0 +1,134 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/expression.hpp"
+#include "vast/ids.hpp"
+#include "vast/uuid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace vast::system {
+
+/// Caches the hits of query expressions per partition. Evicts the least
+/// recently used entries once the memory of all cached bitmaps exceeds a
+/// budget. Callers must only add results for partitions that no longer
+/// change, and should normalize expressions before using them as key.
+class query_cache {
+public:
+  // -- member types -----------------------------------------------------------
+
+  /// Identifies a cached result.
+  struct key {
+    expression expr;
+    uuid partition;
+
+    friend bool operator==(const key& x, const key& y) {
+      return x.partition == y.partition && x.expr == y.expr;
+    }
+  };
+
+  /// Counts cache accesses.
+  struct statistics {
+    uint64_t hits = 0;      ///< Number of successful lookups.
+    uint64_t misses = 0;    ///< Number of unsuccessful lookups.
+    uint64_t evictions = 0; ///< Number of evicted entries.
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// @param max_bytes The memory budget for the cached bitmaps. A budget of 0
+  ///                  disables the cache.
+  explicit query_cache(size_t max_bytes = 0);
+
+  // -- properties -------------------------------------------------------------
+
+  /// @returns whether the cache accepts entries.
+  bool enabled() const noexcept {
+    return max_bytes_ > 0;
+  }
+
+  /// @returns the memory budget for the cached bitmaps.
+  size_t max_bytes() const noexcept {
+    return max_bytes_;
+  }
+
+  /// Changes the memory budget and evicts entries that exceed it.
+  void max_bytes(size_t x);
+
+  /// @returns the approximate memory of all cached bitmaps.
+  size_t bytes() const noexcept {
+    return bytes_;
+  }
+
+  /// @returns the number of cached results.
+  size_t size() const noexcept {
+    return entries_.size();
+  }
+
+  /// @returns the access counters.
+  const statistics& stats() const noexcept {
+    return stats_;
+  }
+
+  /// @returns whether a result for `expr` and `partition` exists, without
+  ///          counting it as an access.
+  bool contains(const expression& expr, const uuid& partition) const;
+
+  // -- operations -------------------------------------------------------------
+
+  /// Retrieves a result and marks it as recently used.
+  /// @returns the cached hits or `nullptr`.
+  const ids* lookup(const expression& expr, const uuid& partition);
+
+  /// Adds or replaces a result. Discards results that exceed the memory
+  /// budget on their own.
+  void add(expression expr, uuid partition, ids hits);
+
+  /// Removes all results for a partition.
+  void erase(const uuid& partition);
+
+private:
+  struct entry {
+    key k;
+    ids hits;
+    size_t bytes;
+  };
+
+  struct key_hash {
+    size_t operator()(const key& x) const;
+  };
+
+  using entry_list = std::list<entry>;
+
+  void remove(entry_list::iterator i);
+
+  void shrink();
+
+  size_t max_bytes_;
+  size_t bytes_ = 0;
+  statistics stats_;
+  entry_list entries_; // Most recently used first.
+  std::unordered_map<key, entry_list::iterator, key_hash> index_;
+};
+
+/// Approximates the memory a bitmap occupies.
+/// @relates query_cache
+size_t memusage(const ids& xs);
+
+} // namespace vast::system
@@ -0,0 +1,149 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/query_options.hpp"
+
+#include <caf/actor_addr.hpp>
+#include <caf/timespan.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+
+namespace vast::system {
+
+/// The classes of queries that compete for INDEX workers.
+enum class query_priority : uint8_t {
+  /// Lookups that an analyst waits for.
+  interactive,
+  /// Broad queries whose results nobody waits for.
+  batch,
+  /// Maintenance queries such as aging.
+  background,
+};
+
+/// The number of query priority classes.
+constexpr size_t num_query_priorities = 3;
+
+/// @returns the priority class that the query options select.
+/// @relates query_priority
+query_priority priority(query_options opts);
+
+/// @relates query_priority
+const char* to_string(query_priority x);
+
+/// Decides which query receives the next idle INDEX worker. The INDEX
+/// evaluates the partitions of a query in slices of `taste_partitions`, and
+/// every slice competes anew for a worker, which keeps a broad query from
+/// starving short lookups. Each priority class receives a share of the
+/// evaluated partitions according to its weight, and within a class the
+/// client with the fewest evaluated partitions goes first.
+class query_scheduler {
+public:
+  // -- member types -----------------------------------------------------------
+
+  /// Evaluates a slice of a query. Expected to take an idle worker.
+  using job = std::function<void()>;
+
+  using clock = std::chrono::steady_clock;
+
+  /// The relative share of each priority class.
+  using weights_type = std::array<uint32_t, num_query_priorities>;
+
+  /// Accumulates statistics for a priority class.
+  struct statistics {
+    uint64_t admitted = 0;       ///< Number of enqueued jobs.
+    uint64_t dispatched = 0;     ///< Number of dequeued jobs.
+    uint64_t partitions = 0;     ///< Number of partitions of dequeued jobs.
+    caf::timespan total_wait{0}; ///< Accumulated queueing delay.
+    caf::timespan max_wait{0};   ///< Highest queueing delay.
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// @param weights The relative share of each priority class.
+  /// @pre all weights are greater than zero.
+  explicit query_scheduler(weights_type weights);
+
+  // -- properties -------------------------------------------------------------
+
+  /// @returns whether no job waits for a worker.
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  /// @returns the number of jobs that wait for a worker.
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  /// @returns the number of jobs of a priority class that wait for a worker.
+  size_t size(query_priority prio) const;
+
+  /// @returns the relative share of a priority class.
+  uint32_t weight(query_priority prio) const;
+
+  /// @returns the statistics of a priority class.
+  const statistics& stats(query_priority prio) const;
+
+  // -- operations -------------------------------------------------------------
+
+  /// Adds a job to the queue of a client.
+  /// @param client The actor that receives the results of the job.
+  /// @param prio The priority class of the job.
+  /// @param cost The number of partitions the job evaluates.
+  /// @param f The job.
+  void enqueue(const caf::actor_addr& client, query_priority prio,
+               uint32_t cost, job f);
+
+  /// Removes the next job according to the fair-share policy and charges its
+  /// cost to its client and priority class.
+  /// @pre `!empty()`
+  job dequeue();
+
+  /// Discards the accounting for a client without queued jobs, e.g., after
+  /// its query completed.
+  void forget(const caf::actor_addr& client);
+
+private:
+  struct entry {
+    uint64_t seq;
+    uint32_t cost;
+    clock::time_point enqueued;
+    job f;
+  };
+
+  struct client_state {
+    std::deque<entry> jobs;
+    uint64_t usage = 0;
+  };
+
+  struct priority_class {
+    uint32_t weight = 1;
+    double vtime = 0; ///< Charged partitions divided by the weight.
+    size_t size = 0;
+    std::unordered_map<caf::actor_addr, client_state> clients;
+    statistics stats;
+  };
+
+  std::array<priority_class, num_query_priorities> classes_;
+  size_t size_ = 0;
+  uint64_t next_seq_ = 0;
+};
+
+} // namespace vast::system
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include "vast/compression.hpp"
 #include "vast/fbs/table_slice.hpp"
 #include "vast/fwd.hpp"
 #include "vast/table_slice_header.hpp"
@@ -24,6 +25,7 @@
 #include <caf/ref_counted.hpp>
 
 #include <cstddef>
+#include <functional>
 #include <limits>
 #include <string_view>
 #include <vector>
@@ -132,7 +134,34 @@ public:
   // -- visitation -------------------------------------------------------------
 
   /// Appends all values in column `col` to `idx`.
-  virtual void append_column_to_index(size_type col, value_index& idx) const;
+  /// @param col The column offset.
+  /// @param idx The index to append to.
+  /// @param stats If not `nullptr`, also receives all values of the column,
+  ///              including nulls, in the same pass.
+  virtual void append_column_to_index(size_type col, value_index& idx,
+                                      column_statistics* stats = nullptr) const;
+
+  /// Applies a function to all non-null values in column `col`. The default
+  /// implementation dispatches to `at` for every row; implementations should
+  /// override it to decode the column only once.
+  /// @param col The column offset.
+  /// @param f The function to apply to every value.
+  /// @pre `col < columns()`
+  virtual void
+  for_each_in_column(size_type col,
+                     const std::function<void(data_view)>& f) const;
+
+  /// Evaluates a predicate for all values in column `col`, i.e., checks
+  /// `x op rhs` for every value `x` in the column. The default implementation
+  /// dispatches to `at` for every row; implementations should override it with
+  /// a direct traversal of their column representation where possible.
+  /// @param col The column offset.
+  /// @param op The relational operator of the predicate.
+  /// @param rhs The right-hand side of the predicate.
+  /// @returns the IDs of all rows that satisfy the predicate.
+  /// @pre `col < columns()`
+  virtual ids
+  evaluate_column(size_type col, relational_operator op, const data& rhs) const;
 
   // -- properties -------------------------------------------------------------
 
@@ -216,14 +245,19 @@ private:
 /// Packs a table slice into a flatbuffer.
 /// @param builder The builder to pack *x* into.
 /// @param x The table slice to pack.
+/// @param method The compression algorithm for the binary data of *x*. Data
+///               that does not shrink remains uncompressed.
 /// @returns The flatbuffer offset in *builder*.
 caf::expected<flatbuffers::Offset<fbs::TableSliceBuffer>>
-pack(flatbuffers::FlatBufferBuilder& builder, table_slice_ptr x);
+pack(flatbuffers::FlatBufferBuilder& builder, table_slice_ptr x,
+     compression method = compression::null);
 
-/// Unpacks a table slice from a flatbuffer.
+/// Unpacks a table slice from a flatbuffer, decompressing its data if needed.
 /// @param x The flatbuffer to unpack.
 /// @param y The target to unpack *x* into.
-/// @returns An error iff the operation fails.
+/// @returns An error iff the operation fails, in particular `ec::format_error`
+///          if the uncompressed size exceeds
+///          `defaults::system::max_table_slice_size`.
 caf::error unpack(const fbs::TableSlice& x, table_slice_ptr& y);
 
 /// Constructs table slices filled with random content for testing purposes.
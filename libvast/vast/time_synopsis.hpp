@@ -22,6 +22,10 @@ class time_synopsis final : public min_max_synopsis<time> {
 public:
   time_synopsis(vast::type x);
 
+  using min_max_synopsis<time>::add;
+
+  void add(const table_slice_column& x) override;
+
   bool equals(const synopsis& other) const noexcept override;
 };
 
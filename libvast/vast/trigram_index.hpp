@@ -0,0 +1,99 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/ewah_bitmap.hpp"
+#include "vast/value_index.hpp"
+#include "vast/view.hpp"
+
+#include <caf/deserializer.hpp>
+#include <caf/expected.hpp>
+#include <caf/serializer.hpp>
+#include <caf/settings.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vast {
+
+/// An index for strings that accelerates substring and pattern queries with a
+/// posting list for every trigram, i.e., every sequence of three consecutive
+/// bytes. A lookup intersects the posting lists of all trigrams that a match
+/// must contain, which yields a *superset* of the matching positions. The
+/// candidate checks of the EXPORTER and the ERASER then weed out the false
+/// positives.
+/// Equality, membership, and negated lookups go through an embedded
+/// `string_index` and remain exact. Choose the index per field with the
+/// attribute `#index=trigram`.
+class trigram_index : public value_index {
+public:
+  /// The trigram of three consecutive bytes, packed into the lower 24 bits.
+  using trigram_type = uint32_t;
+
+  /// Constructs a trigram index.
+  /// @param t An instance of `string_type`.
+  /// @param opts Runtime context for index parameterization.
+  explicit trigram_index(vast::type t, caf::settings opts = {});
+
+  /// Computes the distinct trigrams of a string.
+  /// @param str The string to decompose.
+  /// @returns The sorted trigrams of *str*.
+  static std::vector<trigram_type> trigrams(std::string_view str);
+
+  /// Extracts the literal substrings that every match of a regular expression
+  /// must contain. The extraction is conservative: constructs it does not
+  /// understand, such as alternations, groups, and character classes, do not
+  /// contribute any substrings.
+  /// @param pattern The regular expression.
+  /// @returns The required substrings of *pattern*.
+  static std::vector<std::string> required_literals(std::string_view pattern);
+
+  /// @returns the number of distinct trigrams in the index.
+  size_t cardinality() const;
+
+  caf::error serialize(caf::serializer& sink) const override;
+
+  caf::error deserialize(caf::deserializer& source) override;
+
+private:
+  using postings_type = std::map<trigram_type, ewah_bitmap>;
+
+  bool append_impl(data_view x, id pos) override;
+
+  caf::expected<ids>
+  lookup_impl(relational_operator op, data_view x) const override;
+
+  caf::error pack_impl(value_index_packer& f) const override;
+
+  caf::error unpack_impl(value_index_unpacker& f) override;
+
+  /// Computes the positions of all values that contain every given trigram.
+  /// @param xs The trigrams to intersect.
+  /// @returns The candidate positions, or all positions if *xs* is empty.
+  ids candidates(const std::vector<trigram_type>& xs) const;
+
+  /// Delegates a lookup to the exact index.
+  caf::expected<ids> exact_lookup(relational_operator op, data_view x) const;
+
+  /// @returns all positions of the index.
+  ids everything() const;
+
+  string_index exact_;
+  postings_type postings_;
+};
+
+} // namespace vast
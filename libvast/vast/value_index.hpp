@@ -26,6 +26,7 @@
 #include "vast/ids.hpp"
 #include "vast/type.hpp"
 #include "vast/value_index_factory.hpp"
+#include "vast/value_index_packer.hpp"
 #include "vast/view.hpp"
 
 #include <caf/deserializer.hpp>
@@ -70,9 +71,20 @@ public:
   /// type determines validity of other values.
   /// @param op The relation operator.
   /// @param x The value to lookup.
-  /// @returns The result of the lookup or an error upon failure.
+  /// @returns The result of the lookup or an error upon failure, including a
+  ///          failure to decode a bitmap of an unpacked index.
   caf::expected<ids> lookup(relational_operator op, data_view x) const;
 
+  /// Looks up data under a relational operator for a subset of IDs only,
+  /// e.g., the rows that satisfy the other operands of a conjunction.
+  /// @param op The relation operator.
+  /// @param x The value to lookup.
+  /// @param candidates The IDs of interest.
+  /// @returns The result of the lookup restricted to *candidates* or an error
+  ///          upon failure.
+  caf::expected<ids> lookup(relational_operator op, data_view x,
+                            const ids& candidates) const;
+
   /// Merges another value index with this one.
   /// @param other The value index to merge.
   /// @returns `true` on success.
@@ -99,15 +111,46 @@ protected:
   const ewah_bitmap& none() const;
 
 private:
+  friend value_index_packer;
+  friend value_index_unpacker;
+
   virtual bool append_impl(data_view x, id pos) = 0;
 
   virtual caf::expected<ids>
   lookup_impl(relational_operator op, data_view x) const = 0;
 
+  /// Performs a lookup for a subset of IDs. The result may contain 1-bits
+  /// outside of *candidates*. The default implementation falls back to
+  /// `lookup_impl`; indexes that intersect multiple bitmaps can start from
+  /// the candidates instead and stop early when nothing remains.
+  virtual caf::expected<ids>
+  restricted_lookup_impl(relational_operator op, data_view x,
+                         const ids& candidates) const;
+
+  /// Applies the nil semantics to the result of a lookup with a non-nil value.
+  caf::expected<ids> finish_lookup(relational_operator op,
+                                   caf::expected<ids> result) const;
+
+  /// @returns the first error that occurred while decoding a bitmap of an
+  ///          unpacked index.
+  caf::error decode_error() const;
+
+  /// Passes the members of the index to a flatbuffers packer, akin to
+  /// `serialize`. The default implementation stores the index in CAF binary
+  /// form. Indexes that consist of bitmap indexes pass them individually,
+  /// which allows for decoding their bitmaps on first access.
+  virtual caf::error pack_impl(value_index_packer& f) const;
+
+  /// Restores the members passed to the packer in `pack_impl`.
+  virtual caf::error unpack_impl(value_index_unpacker& f);
+
   ewah_bitmap mask_;         ///< The position of all values excluding nil.
   ewah_bitmap none_;         ///< The positions of nil values.
   const vast::type type_;    ///< The type of this index.
   const caf::settings opts_; ///< Runtime context with additional parameters.
+
+  /// Tracks the deferred decoding of bitmaps after unpacking.
+  std::shared_ptr<detail::decode_status> decode_status_;
 };
 
 /// @relates value_index
@@ -122,6 +165,21 @@ caf::error inspect(caf::serializer& sink, const value_index_ptr& x);
 /// @relates value_index
 caf::error inspect(caf::deserializer& source, value_index_ptr& x);
 
+// -- flatbuffer ---------------------------------------------------------------
+
+/// @relates value_index
+caf::expected<flatbuffers::Offset<fbs::ValueIndex>>
+pack(flatbuffers::FlatBufferBuilder& builder, const value_index& x);
+
+/// Unpacks a value index without decoding its bitmaps, which happens on first
+/// access instead.
+/// @param x The packed value index.
+/// @param y The unpacked value index.
+/// @param chunk The chunk that contains *x*, e.g., a memory-mapped file.
+/// @relates value_index
+caf::error unpack(const fbs::ValueIndex& x, value_index_ptr& y,
+                  chunk_ptr chunk);
+
 namespace detail {
 
 template <class Index, class Sequence>
@@ -295,6 +353,14 @@ private:
     return caf::visit(f, d);
   };
 
+  caf::error pack_impl(value_index_packer& f) const override {
+    return f(bmi_);
+  }
+
+  caf::error unpack_impl(value_index_unpacker& f) override {
+    return f(bmi_);
+  }
+
   bitmap_index_type bmi_;
 };
 
@@ -323,6 +389,18 @@ private:
   caf::expected<ids>
   lookup_impl(relational_operator op, data_view x) const override;
 
+  caf::expected<ids>
+  restricted_lookup_impl(relational_operator op, data_view x,
+                         const ids& candidates) const override;
+
+  /// Implements both lookup variants, where *candidates* may be `nullptr`.
+  caf::expected<ids> lookup_string(relational_operator op, data_view x,
+                                   const ids* candidates) const;
+
+  caf::error pack_impl(value_index_packer& f) const override;
+
+  caf::error unpack_impl(value_index_unpacker& f) override;
+
   size_t max_length_;
   length_bitmap_index length_;
   std::vector<char_bitmap_index> chars_;
@@ -345,6 +423,10 @@ private:
   caf::expected<ids>
   lookup_impl(relational_operator op, data_view x) const override;
 
+  caf::error pack_impl(value_index_packer& f) const override;
+
+  caf::error unpack_impl(value_index_unpacker& f) override;
+
   index index_;
 };
 
@@ -366,6 +448,18 @@ private:
   caf::expected<ids>
   lookup_impl(relational_operator op, data_view x) const override;
 
+  caf::expected<ids>
+  restricted_lookup_impl(relational_operator op, data_view x,
+                         const ids& candidates) const override;
+
+  /// Implements both lookup variants, where *candidates* may be `nullptr`.
+  caf::expected<ids> lookup_address(relational_operator op, data_view x,
+                                    const ids* candidates) const;
+
+  caf::error pack_impl(value_index_packer& f) const override;
+
+  caf::error unpack_impl(value_index_unpacker& f) override;
+
   std::array<byte_index, 16> bytes_;
   type_index v4_;
 };
@@ -387,6 +481,10 @@ private:
   caf::expected<ids>
   lookup_impl(relational_operator op, data_view x) const override;
 
+  caf::error pack_impl(value_index_packer& f) const override;
+
+  caf::error unpack_impl(value_index_unpacker& f) override;
+
   address_index network_;
   prefix_index length_;
 };
@@ -418,6 +516,10 @@ private:
   caf::expected<ids>
   lookup_impl(relational_operator op, data_view x) const override;
 
+  caf::error pack_impl(value_index_packer& f) const override;
+
+  caf::error unpack_impl(value_index_unpacker& f) override;
+
   number_index num_;
   protocol_index proto_;
 };
@@ -0,0 +1,302 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/bitmap_index.hpp"
+#include "vast/chunk.hpp"
+#include "vast/coder.hpp"
+#include "vast/error.hpp"
+#include "vast/fbs/value_index.hpp"
+#include "vast/fwd.hpp"
+#include "vast/logger.hpp"
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/error.hpp>
+#include <caf/expected.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include <flatbuffers/flatbuffers.h>
+
+namespace vast {
+
+namespace detail {
+
+template <class T>
+struct is_bitmap_index : std::false_type {};
+
+template <class T, class Coder, class Binner>
+struct is_bitmap_index<bitmap_index<T, Coder, Binner>> : std::true_type {};
+
+template <class T>
+struct is_bitmap_index_sequence : std::false_type {};
+
+template <class T>
+struct is_bitmap_index_sequence<std::vector<T>> : is_bitmap_index<T> {};
+
+template <class T, size_t N>
+struct is_bitmap_index_sequence<std::array<T, N>> : is_bitmap_index<T> {};
+
+/// Records the first error that occurs while decoding the bitmaps of an
+/// unpacked value index on first access.
+class decode_status {
+public:
+  void fail(caf::error err) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    if (!error_)
+      error_ = std::move(err);
+  }
+
+  caf::error error() const {
+    std::lock_guard<std::mutex> guard{mtx_};
+    return error_;
+  }
+
+private:
+  mutable std::mutex mtx_;
+  caf::error error_;
+};
+
+} // namespace detail
+
+/// Stores a value index in the layout of `fbs::ValueIndex`. Value indexes
+/// pass their members to the packer like to an inspector. Bitmap indexes,
+/// sequences of bitmap indexes, and nested value indexes get stored such that
+/// each bitmap can be decoded separately; all other members end up in CAF
+/// binary form.
+class value_index_packer {
+public:
+  /// Packs a value index along with its nested indexes.
+  /// @param builder The builder to append the index to.
+  /// @param x The value index to pack.
+  /// @param with_header Whether to include the type and options of *x*.
+  /// @returns The offset of the packed index.
+  static caf::expected<flatbuffers::Offset<fbs::ValueIndex>>
+  pack(flatbuffers::FlatBufferBuilder& builder, const value_index& x,
+       bool with_header = true);
+
+  explicit value_index_packer(flatbuffers::FlatBufferBuilder& builder);
+
+  template <class... Ts>
+  caf::error operator()(const Ts&... xs) {
+    return caf::error::eval([&] { return apply(xs); }...);
+  }
+
+  /// @returns the sink for the state that is not stored in a coder.
+  caf::serializer& state();
+
+private:
+  template <class T>
+  caf::error apply(const T& x) {
+    if constexpr (detail::is_bitmap_index<T>::value) {
+      auto coder = pack_coder(x.coder());
+      if (!coder)
+        return coder.error();
+      coders_.push_back(*coder);
+      return caf::none;
+    } else if constexpr (detail::is_bitmap_index_sequence<T>::value) {
+      std::vector<flatbuffers::Offset<fbs::Coder>> components;
+      components.reserve(x.size());
+      for (auto& bmi : x) {
+        auto component = pack_coder(bmi.coder());
+        if (!component)
+          return component.error();
+        components.push_back(*component);
+      }
+      coders_.push_back(finish_coder(0, {}, components));
+      return caf::none;
+    } else if constexpr (std::is_base_of_v<value_index, T>) {
+      return apply_index(x);
+    } else {
+      return state_(x);
+    }
+  }
+
+  caf::error apply_index(const value_index& x);
+
+  template <class Coder>
+  caf::expected<flatbuffers::Offset<fbs::Coder>> pack_coder(const Coder& x) {
+    std::vector<flatbuffers::Offset<fbs::Bitmap>> bitmaps;
+    std::vector<flatbuffers::Offset<fbs::Coder>> components;
+    if constexpr (is_multi_level_coder<Coder>::value) {
+      for (auto& component : x.storage()) {
+        auto offset = pack_coder(component);
+        if (!offset)
+          return offset.error();
+        components.push_back(*offset);
+      }
+    } else if constexpr (is_singleton_coder<Coder>::value) {
+      auto offset = pack_bitmap(x.storage());
+      if (!offset)
+        return offset.error();
+      bitmaps.push_back(*offset);
+    } else {
+      for (auto& bm : x.storage()) {
+        auto offset = pack_bitmap(bm);
+        if (!offset)
+          return offset.error();
+        bitmaps.push_back(*offset);
+      }
+    }
+    return finish_coder(x.size(), bitmaps, components);
+  }
+
+  template <class Bitmap>
+  caf::expected<flatbuffers::Offset<fbs::Bitmap>>
+  pack_bitmap(const Bitmap& x) {
+    std::vector<char> buffer;
+    caf::binary_serializer sink{nullptr, buffer};
+    if (auto err = sink(x))
+      return err;
+    return finish_bitmap(buffer);
+  }
+
+  flatbuffers::Offset<fbs::Bitmap>
+  finish_bitmap(const std::vector<char>& buffer);
+
+  flatbuffers::Offset<fbs::Coder>
+  finish_coder(uint64_t size,
+               const std::vector<flatbuffers::Offset<fbs::Bitmap>>& bitmaps,
+               const std::vector<flatbuffers::Offset<fbs::Coder>>& components);
+
+  flatbuffers::FlatBufferBuilder& builder_;
+  std::vector<flatbuffers::Offset<fbs::Coder>> coders_;
+  std::vector<flatbuffers::Offset<fbs::ValueIndex>> children_;
+  std::vector<char> state_buffer_;
+  caf::binary_serializer state_;
+};
+
+/// Restores a value index from the layout of `fbs::ValueIndex`. The bitmaps
+/// of the index remain in the underlying buffer until their first access.
+/// @relates value_index_packer
+class value_index_unpacker {
+public:
+  /// Unpacks a value index that includes type and options.
+  /// @param x The packed value index.
+  /// @param chunk The chunk that contains *x*. The unpacked index keeps a
+  ///        reference to it as long as there are bitmaps left to decode.
+  /// @returns The unpacked index.
+  static caf::expected<value_index_ptr>
+  unpack(const fbs::ValueIndex& x, chunk_ptr chunk);
+
+  /// Unpacks a value index into an existing instance.
+  /// @param x The packed value index.
+  /// @param y The value index of the same type and options as *x*.
+  /// @param chunk The chunk that contains *x*.
+  /// @returns An error on failure.
+  static caf::error
+  unpack(const fbs::ValueIndex& x, value_index& y, chunk_ptr chunk);
+
+  value_index_unpacker(const fbs::ValueIndex& x, chunk_ptr chunk);
+
+  template <class... Ts>
+  caf::error operator()(Ts&... xs) {
+    return caf::error::eval([&] { return apply(xs); }...);
+  }
+
+  /// @returns the source for the state that is not stored in a coder.
+  caf::deserializer& state();
+
+private:
+  template <class T>
+  caf::error apply(T& x) {
+    if constexpr (detail::is_bitmap_index<T>::value) {
+      auto coder = next_coder();
+      if (!coder)
+        return coder.error();
+      return unpack_coder(**coder, x.coder());
+    } else if constexpr (detail::is_bitmap_index_sequence<T>::value) {
+      auto coder = next_coder();
+      if (!coder)
+        return coder.error();
+      auto components = (*coder)->components();
+      auto n = components ? components->size() : 0;
+      if constexpr (std::is_same_v<T, std::vector<typename T::value_type>>)
+        x.resize(n);
+      else if (n != x.size())
+        return make_error(ec::format_error, "bitmap index count mismatch");
+      for (size_t i = 0; i < n; ++i)
+        if (auto err = unpack_coder(*components->Get(i), x[i].coder()))
+          return err;
+      return caf::none;
+    } else if constexpr (std::is_base_of_v<value_index, T>) {
+      return apply_index(x);
+    } else {
+      return state_(x);
+    }
+  }
+
+  caf::error apply_index(value_index& x);
+
+  caf::expected<const fbs::Coder*> next_coder();
+
+  template <class Coder>
+  caf::error unpack_coder(const fbs::Coder& x, Coder& y) {
+    if constexpr (is_multi_level_coder<Coder>::value) {
+      auto& components = y.storage();
+      auto n = x.components() ? x.components()->size() : 0;
+      if (n != components.size())
+        return make_error(ec::format_error, "coder component count mismatch");
+      for (size_t i = 0; i < n; ++i)
+        if (auto err = unpack_coder(*x.components()->Get(i), components[i]))
+          return err;
+      return caf::none;
+    } else {
+      auto bitmaps = x.bitmaps();
+      auto n = bitmaps ? bitmaps->size() : 0;
+      // The loader holds on to the chunk until the coder has decoded its last
+      // bitmap. A failure leaves the bitmap empty, so the index reports the
+      // error for all lookups from then on.
+      auto f = [chunk = chunk_, bitmaps,
+                status = status_](size_t i, typename Coder::bitmap_type& bm) {
+        if (auto err = unpack_bitmap(*bitmaps->Get(i), bm)) {
+          VAST_ERROR_ANON(__func__, "failed to decode bitmap:", err);
+          status->fail(std::move(err));
+        }
+      };
+      if constexpr (is_singleton_coder<Coder>::value) {
+        if (n != 1)
+          return make_error(ec::format_error, "singleton coder needs 1 bitmap");
+        y.defer(std::move(f));
+      } else {
+        y.defer(x.size(), n, std::move(f));
+      }
+      return caf::none;
+    }
+  }
+
+  template <class Bitmap>
+  static caf::error unpack_bitmap(const fbs::Bitmap& x, Bitmap& y) {
+    if (x.data() == nullptr)
+      return make_error(ec::format_error, "missing bitmap data");
+    auto data = reinterpret_cast<const char*>(x.data()->data());
+    caf::binary_deserializer source{nullptr, data, x.data()->size()};
+    return source(y);
+  }
+
+  const fbs::ValueIndex& index_;
+  chunk_ptr chunk_;
+  std::shared_ptr<detail::decode_status> status_;
+  size_t next_coder_ = 0;
+  size_t next_child_ = 0;
+  caf::binary_deserializer state_;
+};
+
+} // namespace vast
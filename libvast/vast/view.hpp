@@ -97,6 +97,7 @@ public:
 
 private:
   std::string_view pattern_;
+  const detail::regex_automaton* automaton_ = nullptr;
 };
 
 /// @relates pattern_view
@@ -0,0 +1,152 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include "vast/aliases.hpp"
+#include "vast/filesystem.hpp"
+#include "vast/fwd.hpp"
+
+#include <caf/expected.hpp>
+#include <caf/fwd.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace vast {
+
+/// @relates write_ahead_log
+using write_ahead_log_ptr = std::unique_ptr<write_ahead_log>;
+
+/// An append-only log of table slices that makes freshly imported events
+/// durable before the ARCHIVE and INDEX persist them.
+///
+/// The log consists of a sequence of files, each named after the first ID it
+/// contains. Every record carries its payload size and an xxhash64 checksum:
+///
+///     [uint32 size][uint64 checksum][size bytes of serialized table slice]
+///
+/// Appending does not synchronize with the storage device; callers batch
+/// multiple appends before calling `sync`. A file becomes sealed once it
+/// exceeds the maximum file size, and sealed files get removed via `truncate`
+/// after all of their IDs became durable elsewhere.
+class write_ahead_log {
+public:
+  // -- member types -----------------------------------------------------------
+
+  /// Receives the table slices of intact records during replay.
+  using replay_function = std::function<void(table_slice_ptr)>;
+
+  /// The number of bytes preceding the payload of every record.
+  static constexpr size_t header_size = sizeof(uint32_t) + sizeof(uint64_t);
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// Opens the write-ahead log in a directory.
+  /// @param dir The directory that holds the log files.
+  /// @param max_file_size The size in bytes after which a log file is sealed.
+  /// @pre `max_file_size > 0`
+  static caf::expected<write_ahead_log_ptr> make(path dir,
+                                                 size_t max_file_size);
+
+  ~write_ahead_log();
+
+  // -- properties -------------------------------------------------------------
+
+  /// @returns the directory of the log files.
+  const path& dir() const noexcept {
+    return dir_;
+  }
+
+  /// @returns the number of sealed log files.
+  size_t sealed_files() const noexcept {
+    return sealed_.size();
+  }
+
+  /// @returns whether appended records still wait for `sync`.
+  bool dirty() const noexcept {
+    return dirty_;
+  }
+
+  // -- operations -------------------------------------------------------------
+
+  /// Reads all intact records from the sealed files in order of their IDs.
+  /// Stops reading a file at the first torn or corrupted record and cuts it
+  /// off, since everything behind it was never acknowledged by `sync`.
+  /// Afterwards, `truncate` knows where the newest sealed file ends.
+  /// @param f The function to call for every table slice.
+  /// @returns the number of replayed table slices.
+  caf::expected<size_t> replay(const replay_function& f);
+
+  /// Appends a table slice to the active log file.
+  /// @param x The table slice with its final ID offset.
+  /// @returns an error if writing the record failed.
+  caf::error append(const table_slice_ptr& x);
+
+  /// Writes all appended records through to the storage device.
+  /// @returns an error if synchronizing failed.
+  caf::error sync();
+
+  /// Seals the active log file, if any.
+  /// @returns an error if synchronizing or closing the active file failed.
+  caf::error rotate();
+
+  /// Removes all sealed log files that contain only IDs below a watermark.
+  /// Keeps the newest sealed file if neither `append` nor `replay` revealed
+  /// where it ends.
+  /// @param watermark The smallest ID that is not yet durable elsewhere.
+  /// @returns an error if removing a file failed.
+  caf::error truncate(id watermark);
+
+  /// Fills `dict` with status information.
+  void inspect_status(caf::settings& dict) const;
+
+private:
+  write_ahead_log(path dir, size_t max_file_size);
+
+  /// Registers all existing log files as sealed.
+  caf::error register_files();
+
+  path dir_;
+  size_t max_file_size_;
+
+  /// The first ID and path of every sealed file, in ascending order.
+  std::vector<std::pair<id, path>> sealed_;
+
+  /// The file that receives new records.
+  file active_;
+
+  /// The first ID in the active file.
+  id active_first_ = invalid_id;
+
+  /// One past the last ID in the active file.
+  id active_end_ = invalid_id;
+
+  /// One past the last ID in the newest sealed file.
+  id sealed_end_ = invalid_id;
+
+  /// The number of bytes in the active file.
+  size_t active_size_ = 0;
+
+  /// Whether the active file received records since the last `sync`.
+  bool dirty_ = false;
+
+  /// Scratch space for serializing records.
+  std::vector<char> buffer_;
+};
+
+} // namespace vast
@@ -25,6 +25,9 @@ namespace fixtures {
 test_configuration::test_configuration() {
   std::string log_file = "vast-unit-test.log";
   set("logger.file-name", log_file);
+  // Load partitions on the INDEX actor itself so that the test coordinator
+  // sees all messages caused by a query.
+  set("system.partition-loaders", 0);
   // Always begin with an empy log file.
   if (vast::exists(log_file))
     vast::rm(log_file);
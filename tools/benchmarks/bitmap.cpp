@@ -0,0 +1,166 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+// Measures EWAH bitmap operations with the generic block-wise algorithms and
+// with the specialized algorithms for each block kernel the CPU supports, as
+// well as n-ary conjunctions of sparse and dense bitmaps.
+//
+// usage: vast-bench-bitmap [bits] [repetitions]
+
+#include "vast/detail/block_kernels.hpp"
+#include "vast/ewah_bitmap.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace vast;
+
+namespace {
+
+// Creates a bitmap where each bit is 1 with the given probability.
+ewah_bitmap make_random(size_t n, double density, std::mt19937_64& gen) {
+  std::bernoulli_distribution bit{density};
+  ewah_bitmap result;
+  for (size_t i = 0; i < n; ++i)
+    result.append_bit(bit(gen));
+  return result;
+}
+
+// Creates a bitmap like `make_random`, but appends the gaps between 1-bits as
+// runs, which is much faster for sparse bitmaps.
+ewah_bitmap make_gaps(size_t n, double density, std::mt19937_64& gen) {
+  std::geometric_distribution<size_t> gap{density};
+  ewah_bitmap result;
+  while (result.size() < n) {
+    result.append_bits(false, std::min(gap(gen), n - result.size()));
+    if (result.size() < n)
+      result.append_bit(true);
+  }
+  return result;
+}
+
+// Creates a bitmap of alternating runs, interspersed with noisy regions.
+ewah_bitmap make_clustered(size_t n, std::mt19937_64& gen) {
+  std::geometric_distribution<size_t> length{0.001};
+  std::bernoulli_distribution noisy{0.3};
+  ewah_bitmap result;
+  auto bit = false;
+  while (result.size() < n) {
+    auto k = std::min(length(gen) + 1, n - result.size());
+    if (noisy(gen))
+      for (size_t i = 0; i < k; ++i)
+        result.append_bit(gen() & 1);
+    else
+      result.append_bits(bit, k);
+    bit = !bit;
+  }
+  return result;
+}
+
+template <class F>
+double measure(size_t repetitions, F f) {
+  auto start = steady_clock::now();
+  for (size_t i = 0; i < repetitions; ++i)
+    f();
+  auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+  return elapsed.count() / 1e3 / repetitions;
+}
+
+// Prevents the compiler from optimizing away a computation.
+volatile size_t sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+  size_t n = argc > 1 ? std::stoul(argv[1]) : 1 << 24;
+  size_t repetitions = argc > 2 ? std::stoul(argv[2]) : 20;
+  std::mt19937_64 gen{42};
+  std::vector<std::pair<std::string, ewah_bitmap>> inputs;
+  inputs.emplace_back("sparse", make_random(n, 0.001, gen));
+  inputs.emplace_back("medium", make_random(n, 0.05, gen));
+  inputs.emplace_back("dense", make_random(n, 0.5, gen));
+  inputs.emplace_back("clustered", make_clustered(n, gen));
+  auto and_op = [](auto x, auto y) { return x & y; };
+  auto or_op = [](auto x, auto y) { return x | y; };
+  std::cout << std::setw(12) << "kernels" << std::setw(12) << "input"
+            << std::setw(12) << "AND [us]" << std::setw(12) << "OR [us]"
+            << std::setw(12) << "rank [us]" << std::endl;
+  auto print = [&](const char* kernels, const std::string& input, double x,
+                   double y, double z) {
+    std::cout << std::setw(12) << kernels << std::setw(12) << input
+              << std::fixed << std::setprecision(1) << std::setw(12) << x
+              << std::setw(12) << y << std::setw(12) << z << std::endl;
+  };
+  // Combine each input with the dense one, which consists of dirty words only
+  // and thus maximizes the work for the block kernels.
+  auto& y = inputs[2].second;
+  // The baseline goes through the generic bit-range iteration.
+  for (auto& [name, x] : inputs) {
+    auto t_and = measure(repetitions, [&] {
+      sink = binary_eval<false, false>(x, y, and_op).size();
+    });
+    auto t_or = measure(repetitions, [&] {
+      sink = binary_eval<true, true>(x, y, or_op).size();
+    });
+    auto t_rank = measure(repetitions, [&] {
+      auto result = ewah_bitmap::size_type{0};
+      for (auto bits : bit_range(x))
+        result += rank<1>(bits);
+      sink = result;
+    });
+    print("generic", name, t_and, t_or, t_rank);
+  }
+  using detail::block_kernel_isa;
+  for (auto isa : {block_kernel_isa::scalar, block_kernel_isa::sse42,
+                   block_kernel_isa::avx2}) {
+    if (!detail::select_block_kernels(isa))
+      continue;
+    for (auto& [name, x] : inputs) {
+      auto t_and = measure(repetitions, [&] { sink = (x & y).size(); });
+      auto t_or = measure(repetitions, [&] { sink = (x | y).size(); });
+      auto t_rank = measure(repetitions, [&] { sink = rank<1>(x); });
+      print(detail::to_string(isa), name, t_and, t_or, t_rank);
+    }
+  }
+  // Compare the pairwise fold of nary_and with a single-pass merge for
+  // conjunctions of independent operands.
+  std::cout << std::endl
+            << std::setw(12) << "density" << std::setw(12) << "operands"
+            << std::setw(12) << "fold [us]" << std::setw(12) << "merge [us]"
+            << std::endl;
+  for (auto density : {1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 0.5}) {
+    for (size_t k : {3, 8, 64}) {
+      std::vector<ewah_bitmap> xs;
+      for (size_t i = 0; i < k; ++i)
+        xs.push_back(make_gaps(n, density, gen));
+      auto t_fold = measure(repetitions, [&] {
+        sink = nary_and(xs.begin(), xs.end()).size();
+      });
+      auto t_merge = measure(repetitions, [&] {
+        sink = nary_merge<false>(xs.begin(), xs.end()).size();
+      });
+      std::cout << std::defaultfloat << std::setw(12) << density
+                << std::setw(12) << k << std::fixed << std::setprecision(1)
+                << std::setw(12) << t_fold << std::setw(12) << t_merge
+                << std::endl;
+    }
+  }
+  return EXIT_SUCCESS;
+}
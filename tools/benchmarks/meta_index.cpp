@@ -0,0 +1,107 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+// Measures the latency of meta index lookups as a function of the number of
+// partitions.
+//
+// usage: vast-bench-meta-index [max-partitions] [rows-per-partition]
+
+#include "vast/caf_table_slice_builder.hpp"
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/expression.hpp"
+#include "vast/factory.hpp"
+#include "vast/meta_index.hpp"
+#include "vast/synopsis_factory.hpp"
+#include "vast/table_slice.hpp"
+#include "vast/uuid.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace vast;
+
+namespace {
+
+constexpr size_t repetitions = 10;
+
+record_type make_layout() {
+  return record_type{{"ts", time_type{}.attributes({{"timestamp"}})},
+                     {"addr", address_type{}},
+                     {"flag", bool_type{}}}
+    .name("bench");
+}
+
+// Creates a slice whose timestamps and addresses are unique per partition.
+table_slice_ptr make_slice(const record_type& layout, size_t partition,
+                           size_t rows) {
+  auto builder = caf_table_slice_builder::make(layout);
+  for (size_t row = 0; row < rows; ++row) {
+    auto i = partition * rows + row;
+    auto ts = vast::time{} + seconds{i};
+    auto bytes = static_cast<uint32_t>(i);
+    auto addr = address::v4(&bytes);
+    builder->add(make_data_view(ts));
+    builder->add(make_data_view(addr));
+    builder->add(make_data_view(row % 2 == 0));
+  }
+  return builder->finish();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  size_t max_partitions = argc > 1 ? std::stoul(argv[1]) : 65'536;
+  size_t rows = argc > 2 ? std::stoul(argv[2]) : 100;
+  factory<synopsis>::initialize();
+  auto layout = make_layout();
+  meta_index meta_idx;
+  put(meta_idx.factory_options(), "max-partition-size", rows);
+  auto queries = std::vector<std::string>{
+    "#timestamp >= 1970-01-01+00:00:00.0",
+    "addr == 0.0.1.0",
+    "flag == T && addr in 10.0.0.0/8",
+    ":time < 1970-01-01+00:10:00.0 || #type == \"bench\"",
+  };
+  std::vector<expression> exprs;
+  for (auto& query : queries) {
+    auto expr = to<expression>(query);
+    if (!expr) {
+      std::cerr << "failed to parse query: " << query << std::endl;
+      return EXIT_FAILURE;
+    }
+    exprs.push_back(std::move(*expr));
+  }
+  std::cout << std::setw(12) << "partitions" << std::setw(14) << "latency [us]"
+            << "  query\n";
+  size_t partitions = 0;
+  for (size_t n = 1'024; n <= max_partitions; n *= 2) {
+    for (; partitions < n; ++partitions)
+      meta_idx.add(uuid::random(), make_slice(layout, partitions, rows));
+    for (size_t i = 0; i < exprs.size(); ++i) {
+      auto start = steady_clock::now();
+      for (size_t j = 0; j < repetitions; ++j)
+        meta_idx.lookup(exprs[i]);
+      auto elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+      std::cout << std::setw(12) << n << std::setw(14)
+                << elapsed.count() / repetitions << "  " << queries[i]
+                << std::endl;
+    }
+  }
+  return EXIT_SUCCESS;
+}
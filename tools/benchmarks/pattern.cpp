@@ -0,0 +1,129 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+// Compares the automaton behind `pattern` with `std::regex` on URI and domain
+// patterns. The column "regex/call" reflects the previous implementation of
+// `pattern`, which constructed a `std::regex` for every match.
+//
+// usage: vast-bench-pattern [inputs] [repetitions]
+
+#include "vast/detail/regex_automaton.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace vast;
+
+namespace {
+
+std::vector<std::string> make_domains(size_t n, std::mt19937_64& gen) {
+  const char* labels[] = {"www", "mail", "cdn", "api", "login", "static"};
+  const char* names[] = {"example", "google", "tenzir", "evil", "wikipedia",
+                         "github", "amazon", "cloudflare"};
+  const char* tlds[] = {"com", "org", "net", "io", "de"};
+  std::vector<std::string> result;
+  result.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    auto x = std::string{labels[gen() % std::size(labels)]} + '.'
+             + names[gen() % std::size(names)] + std::to_string(gen() % 100)
+             + '.' + tlds[gen() % std::size(tlds)];
+    result.push_back(std::move(x));
+  }
+  return result;
+}
+
+std::vector<std::string> make_uris(const std::vector<std::string>& domains,
+                                   std::mt19937_64& gen) {
+  const char* paths[] = {"/index.html", "/admin/login.php", "/api/v1/users",
+                         "/static/js/app.js", "/search?q=evil+things",
+                         "/wp-admin/admin-ajax.php"};
+  std::vector<std::string> result;
+  result.reserve(domains.size());
+  for (auto& domain : domains)
+    result.push_back((gen() % 2 ? "https://" : "http://") + domain
+                     + paths[gen() % std::size(paths)]);
+  return result;
+}
+
+template <class F>
+double measure(const std::vector<std::string>& inputs, size_t repetitions,
+               F f) {
+  auto start = steady_clock::now();
+  for (size_t i = 0; i < repetitions; ++i)
+    for (auto& x : inputs)
+      f(x);
+  auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+  return static_cast<double>(elapsed.count()) / repetitions / inputs.size();
+}
+
+// Prevents the compiler from optimizing away a computation.
+volatile size_t sink;
+
+} // namespace
+
+int main(int argc, char** argv) {
+  size_t n = argc > 1 ? std::stoul(argv[1]) : 10'000;
+  size_t repetitions = argc > 2 ? std::stoul(argv[2]) : 3;
+  std::mt19937_64 gen{42};
+  auto domains = make_domains(n, gen);
+  auto uris = make_uris(domains, gen);
+  struct benchmark {
+    const char* pattern;
+    bool search;
+    const std::vector<std::string>* inputs;
+  };
+  std::vector<benchmark> benchmarks = {
+    {R"(.*\.evil[0-9]+\.com)", false, &domains},
+    {R"((www|mail)\.[a-z]+[0-9]*\.(com|org))", false, &domains},
+    {R"(https?://[a-z0-9.]+/(wp-)?admin/.*)", false, &uris},
+    {R"(https://login\..*)", false, &uris},
+    {R"(evil)", true, &uris},
+    {R"(\.php$)", true, &uris},
+  };
+  std::cout << std::left << std::setw(42) << "pattern" << std::right
+            << std::setw(8) << "mode" << std::setw(14) << "regex/call"
+            << std::setw(14) << "regex" << std::setw(14) << "automaton"
+            << "  [ns/input]" << std::endl;
+  for (auto& [pattern, search, inputs] : benchmarks) {
+    auto rx = std::regex{pattern};
+    auto automaton = detail::regex_automaton{pattern};
+    auto apply = [search = search](const auto& re, const std::string& x) {
+      return search ? std::regex_search(x, re) : std::regex_match(x, re);
+    };
+    size_t hits = 0;
+    auto t_per_call = measure(*inputs, 1, [&](const std::string& x) {
+      hits += apply(std::regex{pattern}, x);
+    });
+    auto t_regex = measure(*inputs, repetitions, [&](const std::string& x) {
+      hits += apply(rx, x);
+    });
+    auto t_automaton
+      = measure(*inputs, repetitions, [&](const std::string& x) {
+          hits += search ? automaton.search(x) : automaton.match(x);
+        });
+    sink = hits;
+    std::cout << std::left << std::setw(42) << pattern << std::right
+              << std::setw(8) << (search ? "search" : "match") << std::fixed
+              << std::setprecision(1) << std::setw(14) << t_per_call
+              << std::setw(14) << t_regex << std::setw(14) << t_automaton
+              << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+// Measures the compression ratio of ARCHIVE segments and the throughput of
+// segment lookups for each compression algorithm.
+//
+// usage: vast-bench-segment [zeek-log] [slice-size]
+//
+// Reads a Zeek log from standard input by default, e.g., for the integration
+// datasets: gunzip -c integration/data/zeek/conn.log.gz | vast-bench-segment
+
+#include "vast/compression.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/compression.hpp"
+#include "vast/defaults.hpp"
+#include "vast/detail/make_io_stream.hpp"
+#include "vast/error.hpp"
+#include "vast/factory.hpp"
+#include "vast/format/zeek.hpp"
+#include "vast/ids.hpp"
+#include "vast/segment.hpp"
+#include "vast/segment_builder.hpp"
+#include "vast/table_slice.hpp"
+#include "vast/table_slice_builder_factory.hpp"
+#include "vast/table_slice_factory.hpp"
+
+#include <caf/settings.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+using namespace vast;
+
+namespace {
+
+constexpr size_t repetitions = 10;
+
+// Selects roughly one percent of all events, scattered over the segment.
+ids make_sparse_selection(id end) {
+  std::mt19937_64 gen{42};
+  std::uniform_int_distribution<id> dist{0, end - 1};
+  ids result;
+  std::vector<id> xs(end / 100 + 1);
+  for (auto& x : xs)
+    x = dist(gen);
+  std::sort(xs.begin(), xs.end());
+  xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+  for (auto x : xs) {
+    result.append_bits(false, x - result.size());
+    result.append_bits(true, 1);
+  }
+  return result;
+}
+
+// @returns the number of events per second when looking up `selection`.
+double lookup_throughput(const segment& seg, const ids& selection) {
+  size_t events = 0;
+  auto start = steady_clock::now();
+  for (size_t i = 0; i < repetitions; ++i) {
+    auto slices = seg.lookup(selection);
+    if (!slices) {
+      std::cerr << "lookup failed: " << render(slices.error()) << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    for (auto& slice : *slices)
+      events += slice->rows();
+  }
+  auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start);
+  return events / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string input = argc > 1 ? argv[1] : "-";
+  size_t slice_size = argc > 2 ? std::stoul(argv[2])
+                               : defaults::import::table_slice_size;
+  factory<table_slice>::initialize();
+  factory<table_slice_builder>::initialize();
+  auto in = detail::make_input_stream(input, false);
+  if (!in) {
+    std::cerr << "failed to open " << input << ": " << render(in.error())
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::vector<table_slice_ptr> slices;
+  format::zeek::reader reader{defaults::import::table_slice_type,
+                              caf::settings{}, std::move(*in)};
+  auto add = [&](table_slice_ptr x) {
+    x.unshared().offset(slices.empty() ? 0
+                                       : slices.back()->offset()
+                                           + slices.back()->rows());
+    slices.push_back(std::move(x));
+  };
+  auto [err, events] = reader.read(std::numeric_limits<size_t>::max(),
+                                   slice_size, add);
+  if (err && err != ec::end_of_input) {
+    std::cerr << "failed to read input: " << render(err) << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (events == 0) {
+    std::cerr << "got no events" << std::endl;
+    return EXIT_FAILURE;
+  }
+  auto everything = ids{};
+  everything.append_bits(true, events);
+  auto sparse = make_sparse_selection(events);
+  std::cout << events << " events in " << slices.size() << " slices\n"
+            << std::setw(6) << "codec" << std::setw(12) << "bytes"
+            << std::setw(8) << "ratio" << std::setw(12) << "build [ms]"
+            << std::setw(16) << "full [ev/s]" << std::setw(16)
+            << "sparse [ev/s]" << std::endl;
+  auto methods = std::vector<compression>{compression::null, compression::lz4};
+  if (VAST_HAVE_ZSTD)
+    methods.push_back(compression::zstd);
+  size_t uncompressed = 0;
+  for (auto method : methods) {
+    auto start = steady_clock::now();
+    segment_builder builder{method};
+    for (auto& slice : slices)
+      if (auto add_err = builder.add(slice)) {
+        std::cerr << "failed to add slice: " << render(add_err) << std::endl;
+        return EXIT_FAILURE;
+      }
+    auto seg = builder.finish();
+    auto build_time = duration_cast<milliseconds>(steady_clock::now() - start);
+    auto bytes = seg.chunk()->size();
+    if (method == compression::null)
+      uncompressed = bytes;
+    std::cout << std::setw(6) << to_string(method) << std::setw(12) << bytes
+              << std::setw(8) << std::fixed << std::setprecision(2)
+              << static_cast<double>(uncompressed) / bytes << std::setw(12)
+              << build_time.count() << std::setw(16) << std::setprecision(0)
+              << lookup_throughput(seg, everything) << std::setw(16)
+              << lookup_throughput(seg, sparse) << std::endl;
+  }
+  return EXIT_SUCCESS;
+}